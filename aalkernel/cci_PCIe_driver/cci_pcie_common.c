@@ -174,7 +174,7 @@ void  destroy_ccidevice(struct ccip_device *pccidev)
    // Destroy the FME device
    if(NULL != ccip_dev_to_fme_dev(pccidev)) {
       PVERBOSE("Freeing FME Memory\n");
-      kosal_kfree(ccip_dev_to_fme_dev(pccidev),sizeof(struct fme_device ) );
+      ccip_destroy_fme_mmio_dev(ccip_dev_to_fme_dev(pccidev));
    }
 
    // Remove ourselves from any lists
@@ -269,6 +269,8 @@ cci_flush_all_wsids(struct cci_PIPsession *psess)
       if( WSM_TYPE_VIRTUAL == wsidp->m_type){
          if( NULL== cci_aaldev_pci_dev(pdev) ) {
             kosal_free_contiguous_mem((btAny)wsidp->m_id, wsidp->m_size);
+         }else if( 0 != wsidp->m_numa ) {
+            kosal_free_dma_node( ccip_dev_pci_dev(pdev), (btAny)wsidp->m_id, wsidp->m_size, wsidp->m_dmahandle);
          }else{
             kosal_free_dma_coherent( ccip_dev_pci_dev(pdev), (btAny)wsidp->m_id, wsidp->m_size, wsidp->m_dmahandle);
          }
@@ -277,7 +279,7 @@ cci_flush_all_wsids(struct cci_PIPsession *psess)
          PVERBOSE("Done Freeing PWS with id 0x%llx.\n",pwsid_to_wsidHandle(wsidp));
       }
 
-      kosal_list_del_init(&wsidp->m_list);
+      aalsess_del_ws(wsidp->m_list);
 
       ccidrv_freewsid(wsidp);
    } // end list_for_each_entry
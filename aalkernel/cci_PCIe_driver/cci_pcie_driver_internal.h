@@ -384,10 +384,11 @@ extern void ccidrv_exitDriver(void);
 
 extern struct ccidrv_session * ccidrv_session_create(btPID );
 extern btInt ccidrv_session_destroy(struct ccidrv_session * );
-extern struct aal_wsid *find_wsid( const struct ccidrv_session *,
+extern struct aal_wsid *find_wsid( struct ccidrv_session *,
                                    btWSID);
 extern struct aal_wsid * ccidrv_valwsid(btWSID);
 extern btInt ccidrv_freewsid(struct aal_wsid *pwsid);
+extern void ccidrv_putwsid(struct aal_wsid *pwsid);
 extern struct aal_wsid* ccidrv_getwsid( struct aal_device *pdev,
                                         unsigned long long id);
 extern btInt
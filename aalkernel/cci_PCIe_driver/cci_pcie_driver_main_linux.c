@@ -1040,7 +1040,7 @@ ERR:
      pci_release_region(pcidev, 0);
 
      if(NULL != ccip_dev_to_fme_dev(pccipdev)) {
-         kosal_kfree(ccip_dev_to_fme_dev(pccipdev),sizeof(struct fme_device ) );
+         ccip_destroy_fme_mmio_dev(ccip_dev_to_fme_dev(pccipdev));
      }
      ccip_fmedev_kvp_afu_mmio(pccipdev) = NULL;
 
@@ -69,6 +69,7 @@
 #include "aalsdk/kernel/kosal.h"
 #include "aalsdk/kernel/aalbus.h"
 #include "aalsdk/kernel/ccipdriver.h"
+#include "cci_pcie_driver_wsid.h"
 
 #if 0
 #define DEV_NAME          "aalui"
@@ -99,8 +100,7 @@ struct um_driver {
    kosal_semaphore          m_sem;
 
    /* list of allocated wsids */
-   kosal_semaphore          wsid_list_sem;
-   kosal_list_head          wsid_list_head;
+   struct ccidrv_wsid_table wsid_table;
 };
 
 //=============================================================================
@@ -133,6 +133,10 @@ struct ccidrv_session {
    // Pid of process associated with this session
    btPID                      m_pid;
 
+#if defined( __AAL_LINUX__ )
+   // Event ring shared with user mode. Allocated on first mmap().
+   struct ccipui_evtring     *m_evtring;
+#endif // __AAL_LINUX__
 };
 
 
@@ -72,6 +72,9 @@
 
 #include "cci_pcie_driver_umapi.h"
 #include "ccipdrv-events.h"
+#if defined( __AAL_LINUX__ )
+# include <linux/vmalloc.h>
+#endif // __AAL_LINUX__
 
 // Prototypes
 struct ccidrv_session * ccidrv_session_create(btPID );
@@ -156,6 +159,10 @@ struct ccidrv_session * ccidrv_session_create(btPID pid)
    // Record the process that opened us
    psession->m_pid = pid;
 
+#if defined( __AAL_LINUX__ )
+   psession->m_evtring = NULL;
+#endif // __AAL_LINUX__
+
    return psession;
 }
 
@@ -226,6 +233,15 @@ int ccidrv_session_destroy(struct ccidrv_session * psess)
     kosal_list_del(&psess->m_sessions);
     kosal_sem_put( &umDriver.m_qsem);
 
+#if defined( __AAL_LINUX__ )
+    // No device can post to the ring now. The file is being released, so
+    //  no user mapping of it remains either.
+    if ( NULL != psess->m_evtring ) {
+       vfree(psess->m_evtring);
+       psess->m_evtring = NULL;
+    }
+#endif // __AAL_LINUX__
+
     kosal_sem_put(&psess->m_sem);
     kosal_kfree(psess, sizeof(struct ccidrv_session));
 
@@ -305,6 +321,15 @@ ccidrv_messageHandler( struct ccidrv_session  *psess,
       //  message on the queue without returning the actual message
       //--------------------------------------
       UIDRV_IOCTL_CASE(AALUID_IOCTL_GETMSG_DESC) {
+#if defined( __AAL_LINUX__ )
+         // Events in the ring are older than any on the queue. Have the
+         //  caller drain the ring first.
+         if ( ( NULL != psess->m_evtring ) && !ccipui_evtring_empty(psess->m_evtring) ) {
+            PTRACEOUT_INT(-EAGAIN);
+            return -EAGAIN;
+         }
+#endif // __AAL_LINUX__
+
          // Make sure there is a message to be had
          if ( _aal_q_empty(&psess->m_eventq) ) {
             PTRACEOUT_INT(-EAGAIN);
@@ -717,7 +742,9 @@ process_bind_request(struct ccidrv_session  *psess,
              goto UNBIND_DONE;
          }
 
-         // Update the owner's list
+         // Update the owner's list. This takes the owner off our device list,
+         //  which find_wsid() walks under the session semaphore.
+         kosal_sem_get_user_alertable( &psess->m_sem );
          if ( unlikely( !dev_removeOwner(pdev, psess->m_pid) ) ) {
             PERR("Failed to update owner\n");
             unbindcmplt = ccipdrv_event_Unbindcmplt_create(uid_errnumNotDeviceOwner, preq);
@@ -725,6 +752,7 @@ process_bind_request(struct ccidrv_session  *psess,
          } else {
             unbindcmplt = ccipdrv_event_Unbindcmplt_create(uid_errnumOK, preq);
          }
+         kosal_sem_put( &psess->m_sem );
          ret = 0;
       } goto UNBIND_DONE; // case reqid_UID_UnBind
 
@@ -849,6 +877,52 @@ ccidrv_marshal_upstream_message( struct ccipui_ioctlreq *preq,
    return ret;
 } // ccidrv_process_message
 
+#if defined( __AAL_LINUX__ )
+//=============================================================================
+// Name: ccidrv_evtring_post
+// Description: Copy an event into the session's shared event ring
+// Interface: private
+// Inputs: psess - session, with m_sem held
+//         eventp - event
+// Outputs: true if the event was posted and destroyed, false if the caller
+//          must enqueue it instead.
+// Comments: The ring is only used while the event queue is empty, so that
+//           events reach user mode in order.
+//=============================================================================
+static btBool
+ccidrv_evtring_post(struct ccidrv_session *psess,
+                    struct aal_q_item     *eventp)
+{
+   struct ccipdrv_event_afu_response_event *pevt = qip_to_ui_evtp_afuresponse(eventp);
+   struct ccipui_evtslot                   *pslot;
+
+   if ( ( NULL == psess->m_evtring ) ||
+        !_aal_q_empty(&psess->m_eventq) ||
+        ( QI_LEN(eventp) > CCIPUI_EVTRING_PAYLOAD_MAX ) ) {
+      return false;
+   }
+
+   pslot = ccipui_evtring_produce(psess->m_evtring);
+   if ( NULL == pslot ) {
+      PDEBUG("Event ring full\n");
+      return false;
+   }
+
+   pslot->hdr.id      = (uid_msgIDs_e)QI_QID(eventp);
+   pslot->hdr.errcode = pevt->m_errnum;
+   pslot->hdr.handle  = pevt->m_devhandle;
+   pslot->hdr.context = pevt->m_context;
+   pslot->hdr.tranID  = pevt->m_tranID;
+   pslot->hdr.size    = QI_LEN(eventp);
+   memcpy(pslot->payload, pevt->m_payload, (size_t)pslot->hdr.size);
+
+   ccipui_evtring_publish(psess->m_evtring);
+
+   ccipdrv_event_afuresponse_destroy(pevt);
+   return true;
+}
+#endif // __AAL_LINUX__
+
 //=============================================================================
 // Name: ccidrv_sendevent
 // Description: Implements the PIP UI driver message handler
@@ -877,8 +951,15 @@ ccidrv_sendevent(struct aaldev_ownerSession * pOwnerSession,
       if ( kosal_sem_get_user_alertable(&psess->m_sem) ) { /* FIXME */ }
       PDEBUG("Waking Up AIA with event\n");
 
+#if defined( __AAL_LINUX__ )
+      // Post to the shared ring if we can, else enqueue for GETMSG
+      if ( !ccidrv_evtring_post(psess, eventp) ) {
+         _aal_q_enqueue(eventp, &psess->m_eventq);
+      }
+#else
       // Enqueue the completion event
       _aal_q_enqueue(eventp, &psess->m_eventq);
+#endif // __AAL_LINUX__
 
       // Unblock select() calls.
       kosal_wake_up_interruptible( &psess->m_waitq);
@@ -913,8 +994,6 @@ ccidrv_sendevent(struct aaldev_ownerSession * pOwnerSession,
 struct aal_wsid* ccidrv_getwsid(struct aal_device *pdev,
                                 unsigned long long id)
 {
-   static btUnsigned64bitInt     nextWSID = 1;
-
    struct aal_wsid * pwsid = NULL;
    int status;
 
@@ -930,8 +1009,15 @@ struct aal_wsid* ccidrv_getwsid(struct aal_device *pdev,
       return NULL;
    }
 
-   /* get list manipulation semaphore */
-   status = kosal_sem_get_krnl_alertable(&umDriver.wsid_list_sem);
+   pwsid->m_device = pdev;
+   pwsid->m_owner  = NULL;
+   pwsid->m_id = id;
+   pwsid->m_numa = 0;
+   kosal_list_init(&pwsid->m_list);
+   kosal_list_init(&pwsid->m_alloc_list);
+
+   /* assign a handle and add to the allocated table */
+   status = ccidrv_wsid_table_add(&umDriver.wsid_table, pwsid);
    if (0 != status) {
       DPRINTF (UIDRV_DBG_FILE, ": couldn't add WSID to alloc_list\n");
 #ifdef __i386__
@@ -942,29 +1028,48 @@ struct aal_wsid* ccidrv_getwsid(struct aal_device *pdev,
       return NULL;
    }
 
-   // Check the WSID for roll over. This gives us a very large number of WSIDs before
-   //   roll over.
-   if( 0 == wsid_to_wsidHandle(nextWSID) ){
-      nextWSID = 1;
-   }
+   PDEBUG(": Created WSID Handle %llx for device id %llx \n", pwsid->m_handle, id);
 
-   pwsid->m_device = pdev;
-   pwsid->m_handle = wsid_to_wsidHandle(nextWSID);
-   pwsid->m_id = id;
-   kosal_list_init(&pwsid->m_list);
-   kosal_list_init(&pwsid->m_alloc_list);
-
-   PDEBUG(": Created WSID %llu [Handle %llx] for device id %llx \n", nextWSID, pwsid->m_handle, id);
-
-   /* add to allocated list */
-   kosal_list_add_head(&pwsid->m_alloc_list, &umDriver.wsid_list_head);
+   return pwsid;
+}
 
-   nextWSID++;
+#if defined( __AAL_LINUX__ )
+//=============================================================================
+// Name: ccidrv_freewsid_rcu
+// Description: Frees a WSID object once no RCU reader can still see it
+// Interface: private
+// Inputs: head - aal_wsid::m_rcu
+// Outputs: none.
+// Comments:
+//=============================================================================
+static void ccidrv_freewsid_rcu(kosal_rcu_head *head)
+{
+   struct aal_wsid *pwsid = kosal_container_of(head, struct aal_wsid, m_rcu);
+#ifdef __i386__
+   free_page(pwsid);
+#else
+   kosal_kfree(pwsid, sizeof(struct aal_wsid));
+#endif
+}
+#endif // __AAL_LINUX__
 
-   /* release semaphore */
-   kosal_sem_put(&umDriver.wsid_list_sem);
+/** @brief drop a reference to a WSID object, freeing it with the last
+ * @param[in] pwsid pointer to WSID object returned by ccidrv_valwsid() or
+ * find_wsid(). */
+void ccidrv_putwsid(struct aal_wsid *pwsid)
+{
+   if (!ccidrv_wsid_put(pwsid)) {
+      return;
+   }
 
-   return pwsid;
+#if defined( __AAL_LINUX__ )
+   /* lockless lookups may still be looking at it */
+   kosal_call_rcu(&pwsid->m_rcu, ccidrv_freewsid_rcu);
+#elif defined( __i386__ )
+   free_page(pwsid);
+#else
+   kosal_kfree(pwsid, sizeof(struct aal_wsid));
+#endif
 }
 
 
@@ -972,7 +1077,10 @@ struct aal_wsid* ccidrv_getwsid(struct aal_device *pdev,
  * @param[in] pwsid pointer to WSID object to free.
  * @return zero if successful, -EINTR if couldn't get list manipulation
  * lock, -EINVAL if workspace ID appears to be invalid, -EBUSY if still
- * on an ownership list */
+ * on an ownership list
+ *
+ * The object itself is freed once the references of any lookups still
+ * using it are dropped. */
 btInt ccidrv_freewsid(struct aal_wsid *pwsid)
 {
    int status;
@@ -989,23 +1097,14 @@ btInt ccidrv_freewsid(struct aal_wsid *pwsid)
       return -EBUSY;
    }
 
-   /* search for the provided wsid on the known list */
-   if (NULL ==  ccidrv_valwsid( pwsid_to_wsidHandle(pwsid) )) {
-      return -EINVAL;
-   }
-
-   status = kosal_sem_get_krnl_alertable(&umDriver.wsid_list_sem);
+   /* unlink the wsid, failing if it is not in the table */
+   status = ccidrv_wsid_table_remove(&umDriver.wsid_table, pwsid);
    if (0 != status) {
       return status;
    }
-   kosal_list_del(&pwsid->m_alloc_list);
-   kosal_sem_put(&umDriver.wsid_list_sem);
 
-#ifdef __i386__
-   free_page(pwsid);
-#else
-   kosal_kfree(pwsid, sizeof(struct aal_wsid *));
-#endif
+   /* drop the table's reference */
+   ccidrv_putwsid(pwsid);
 
    return 0;
 }
@@ -1044,12 +1143,12 @@ int ccidrv_flush_eventqueue(  struct ccidrv_session *psess)
 // Name: ccidrv_valwsid
 /** @brief check if a provided wsid is on the list of known allocated wsids
  * @param[in] wsidHandle handle to workspace to validate
- * @return zero on success
- * grab the list lock, walk the list, and compare pointers. */
+ * @return the wsid, or NULL if it is not allocated
+ * hashed lookup in umDriver.wsid_table. The wsid is returned with a
+ * reference the caller drops with ccidrv_putwsid(). */
 //=============================================================================
 struct aal_wsid *ccidrv_valwsid(btWSID wsidHandle)
 {
-   int status;
    struct aal_wsid *listwsid_p;
 
    if( 0 == wsidHandle) {
@@ -1057,31 +1156,19 @@ struct aal_wsid *ccidrv_valwsid(btWSID wsidHandle)
       return NULL;
    }
 
-   status = kosal_sem_get_krnl_alertable(&umDriver.wsid_list_sem);
-   if (0 != status) {
-      PERR(": couldn't get list semaphore\n");
-      kosal_sem_put(&umDriver.wsid_list_sem);
-      return NULL;
+   listwsid_p = ccidrv_wsid_table_lookup(&umDriver.wsid_table, wsidHandle);
+   if (NULL == listwsid_p) {
+      PINFO(": wsid %llu not on list\n", wsidHandle);
    }
 
-   kosal_list_for_each_entry(listwsid_p, &umDriver.wsid_list_head, m_alloc_list, struct aal_wsid) {
-      if (listwsid_p->m_handle == wsidHandle) {
-         kosal_sem_put(&umDriver.wsid_list_sem);
-         return listwsid_p;
-      }
-   }
-
-   kosal_sem_put(&umDriver.wsid_list_sem);
-
-   PINFO(": wsid %llu not on list\n", wsidHandle);
-
-   return NULL;
+   return listwsid_p;
 }
 
 /** @brief search for a given wsid in the provided uidrv_session
  * @param[in] ccidrv_sess_p pointer to uidrv session to dig through
  * @param[in] wsidHandle to workspace ID to check
- * @return NULL if pointer is not found, wsid_p if it is
+ * @return NULL if pointer is not found, wsid_p if it is, with a reference
+ * the caller drops with ccidrv_putwsid()
  *
  * both input pointers are assumed already to be non-NULL.
  *
@@ -1089,17 +1176,17 @@ struct aal_wsid *ccidrv_valwsid(btWSID wsidHandle)
  * even leaked out of the workspace manager?  shouldn't everything out here be
  * manipulated through completely opaque workspace IDs (long long int)?
  */
-struct aal_wsid *find_wsid( const struct ccidrv_session *ccidrv_sess_p,
+struct aal_wsid *find_wsid( struct ccidrv_session *ccidrv_sess_p,
                             btWSID wsidHandle)
 {
-   const struct aaldev_owner *owner_p;
-   const struct aaldev_ownerSession *ownersess_p;
-   struct aal_wsid *cur_wsid_p = NULL;
+   struct aal_wsid *wsid_p;
+   int              owned;
 
    PDEBUG("Looking for WSID Handle %llx\n", wsidHandle);
 
    /* start by checking if the passed wsid is even valid */
-   if (NULL == ccidrv_valwsid(wsidHandle)) {
+   wsid_p = ccidrv_valwsid(wsidHandle);
+   if (NULL == wsid_p) {
       PERR("WSID Invalid\n");
       return NULL;
    }
@@ -1107,32 +1194,29 @@ struct aal_wsid *find_wsid( const struct ccidrv_session *ccidrv_sess_p,
    /* if this session is not associated with a device, don't bother checking
     * ownership of the wsid, since there may not be any.  */
    if (kosal_list_is_empty(&ccidrv_sess_p->m_devicelist)) {
-      return ccidrv_valwsid(wsidHandle);
+      return wsid_p;
    }
 
    /* if this session is associated with a device, (IE m_devicelist is not
     * empty,) then any wsid we handle needs to be on one of our device's
     * ownership lists, otherwise we shouldn't be touching it.
     *
-    * struct ccidrv_session contains list head of
-    *   struct aaldev_owner which contains
-    *     struct aaldev_ownerSession which contains the list head of
-    *       struct aal_wsid */
-  PVERBOSE("looking at list head %p for wsid %llx\n", &(ccidrv_sess_p->m_devicelist), wsidHandle );
-   kosal_list_for_each_entry(owner_p, &(ccidrv_sess_p->m_devicelist), m_devicelist, struct aaldev_owner) {
-      PVERBOSE("examining owner_p %p\n", owner_p);
-      ownersess_p = &(owner_p->m_sess);
-
-      kosal_list_for_each_entry(cur_wsid_p, &(ownersess_p->m_wshead), m_list, struct aal_wsid) {
-         if (cur_wsid_p->m_handle == wsidHandle) {
-            PVERBOSE("  wsid ID %lld at %p found\n",cur_wsid_p->m_handle, cur_wsid_p);
-            return cur_wsid_p;
-         }
-      }
+    * The session semaphore keeps our device list from changing. */
+   if ( kosal_sem_get_krnl_alertable(&ccidrv_sess_p->m_sem) ) {
+      ccidrv_putwsid(wsid_p);
+      return NULL;
+   }
+   owned = ccidrv_wsid_owned_by(wsid_p, &ccidrv_sess_p->m_devicelist);
+   kosal_sem_put(&ccidrv_sess_p->m_sem);
+
+   if ( owned ) {
+      PVERBOSE("  wsid ID %lld at %p found\n", wsid_p->m_handle, wsid_p);
+      return wsid_p;
    }
 
    PVERBOSE("wsid %llu NOT found on any owner lists\n", wsidHandle);
 
+   ccidrv_putwsid(wsid_p);
    return NULL;
 }
 
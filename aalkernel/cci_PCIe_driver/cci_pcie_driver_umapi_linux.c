@@ -71,6 +71,7 @@
 
 #include "cci_pcie_driver_umapi_linux.h"
 #include "cci_pcie_driver_internal.h"
+#include <linux/vmalloc.h>
 //#include "cciui-events.h"
 //#include "aalsdk/kernel/aalui-events.h"
 
@@ -80,6 +81,12 @@
 // Major device number to use for the device nodes
 btInt majornum = 0;
 
+// Requests (header + payload) up to CCIDRV_IOCTL_STACK_SIZE bytes are handled on
+//  the stack, up to CCIDRV_IOCTL_CACHE_SIZE bytes from ccidrv_ioctl_cache.
+#define CCIDRV_IOCTL_STACK_SIZE   256
+#define CCIDRV_IOCTL_CACHE_SIZE   2048
+static struct kmem_cache *ccidrv_ioctl_cache = NULL;
+
 //////////////////////////////////////////////////////////////////////////////////////
 
 
@@ -194,8 +201,13 @@ ccidrv_initUMAPI(void)
    kosal_list_init(&umDriver.m_sessq);
    kosal_mutex_init(&umDriver.m_sem);
 
-   kosal_mutex_init(&umDriver.wsid_list_sem);
-   kosal_list_init(&umDriver.wsid_list_head);
+   ccidrv_wsid_table_init(&umDriver.wsid_table);
+
+   // Not fatal if this fails. ccidrv_ioctl() falls back to kosal_kmalloc().
+   ccidrv_ioctl_cache = kmem_cache_create("ccidrv_ioctl", CCIDRV_IOCTL_CACHE_SIZE, 0, 0, NULL);
+   if ( NULL == ccidrv_ioctl_cache ) {
+      PERR("Failed to create ioctl buffer cache\n");
+   }
 
    PDEBUG("Allocating major number for \"%s\"\n",devname);
 
@@ -203,6 +215,10 @@ ccidrv_initUMAPI(void)
 
    if ( res < 0 ) {
       PERR("Failed to allocate major device number for \"%s\"\n", devname);
+      if ( NULL != ccidrv_ioctl_cache ) {
+         kmem_cache_destroy(ccidrv_ioctl_cache);
+         ccidrv_ioctl_cache = NULL;
+      }
       return res;
    }
 
@@ -233,6 +249,10 @@ ccidrv_initUMAPI(void)
       cdev_del(&thisDriver.m_cdev);
       class_destroy(thisDriver.m_class);
       unregister_chrdev_region(thisDriver.m_devtype, 1);
+      if ( NULL != ccidrv_ioctl_cache ) {
+         kmem_cache_destroy(ccidrv_ioctl_cache);
+         ccidrv_ioctl_cache = NULL;
+      }
       return res;
 
 }
@@ -258,6 +278,13 @@ void ccidrv_exitUMAPI(void)
    class_destroy(thisDriver.m_class);
    unregister_chrdev_region(thisDriver.m_devtype, 1);
 
+   // Wait for any WSIDs still queued for freeing by ccidrv_freewsid().
+   kosal_rcu_barrier();
+
+   if ( NULL != ccidrv_ioctl_cache ) {
+      kmem_cache_destroy(ccidrv_ioctl_cache);
+      ccidrv_ioctl_cache = NULL;
+   }
 }
 
 //=============================================================================
@@ -270,13 +297,57 @@ void ccidrv_exitUMAPI(void)
 //=============================================================================
 //=============================================================================
 
+//=============================================================================
+// Name: ccidrv_ioctl_getbuf
+// Description: Get a buffer for an ioctl request and its response
+// Interface: private
+// Inputs: size - header + payload size
+//         stackbuf - caller's on-stack buffer of CCIDRV_IOCTL_STACK_SIZE bytes
+// Outputs: The buffer, or NULL.
+// Comments: The request is processed in place, so one buffer serves as both
+//           request and response. Small messages use the caller's stack,
+//           medium ones come from ccidrv_ioctl_cache and only large ones
+//           go to kosal_kmalloc().
+//=============================================================================
+static struct ccipui_ioctlreq *ccidrv_ioctl_getbuf(btWSSize size, void *stackbuf)
+{
+   if ( size <= CCIDRV_IOCTL_STACK_SIZE ) {
+      return (struct ccipui_ioctlreq *)stackbuf;
+   }
+   if ( ( size <= CCIDRV_IOCTL_CACHE_SIZE ) && ( NULL != ccidrv_ioctl_cache ) ) {
+      return (struct ccipui_ioctlreq *)kmem_cache_alloc(ccidrv_ioctl_cache, GFP_KERNEL);
+   }
+   return (struct ccipui_ioctlreq *)kosal_kmalloc(size);
+}
+
+//=============================================================================
+// Name: ccidrv_ioctl_putbuf
+// Description: Release a buffer from ccidrv_ioctl_getbuf()
+// Interface: private
+//=============================================================================
+static void ccidrv_ioctl_putbuf(struct ccipui_ioctlreq *pbuf, btWSSize size, void *stackbuf)
+{
+   if ( (void *)pbuf == stackbuf ) {
+      return;
+   }
+   if ( ( size <= CCIDRV_IOCTL_CACHE_SIZE ) && ( NULL != ccidrv_ioctl_cache ) ) {
+      kmem_cache_free(ccidrv_ioctl_cache, pbuf);
+      return;
+   }
+   kosal_kfree(pbuf, size);
+}
+
 //=============================================================================
 // Name: aalccidrv_ioctl
 // Description: Implements the ioctl system call
 // Interface: public
 // Inputs: .
 // Outputs: none.
-// Comments: Entry point for all requests from user space
+// Comments: Entry point for all requests from user space.
+//           AALUID_IOCTL_SENDMSG_DIRECT is AALUID_IOCTL_SENDMSG with the
+//           payload in a separate user buffer described by a
+//           ccipui_directpayload; the response payload is written back there.
+//           One with an empty payload only reports that the command exists.
 //=============================================================================
 #if HAVE_UNLOCKED_IOCTL
 long ccidrv_ioctl(struct file *file,
@@ -295,11 +366,16 @@ int ccidrv_ioctl(struct inode *inode,
    // Generic variables
    int                     ret=0;
    struct ccipui_ioctlreq  req;                       // User IOCTL header
-
-   struct ccipui_ioctlreq *pfullrequest      = NULL;  // Full message with var data
+   struct ccipui_directpayload direct;                // Payload descriptor for AALUID_IOCTL_SENDMSG_DIRECT
+   union {
+      struct ccipui_ioctlreq hdr;
+      btByte                 raw[CCIDRV_IOCTL_STACK_SIZE];
+   }                       stackbuf;                  // Holds small messages
+
+   struct ccipui_ioctlreq *pmsg              = NULL;  // Full message with var data. Response is built in place.
+   btByte __user          *upayload          = NULL;  // User payload, read for the request and written for the response
    btWSSize                FullRequestSize   = 0;     // Size of the user buffer (header + payload)
    btWSSize                Outbufsize        = 0;     // Size of usable return payload buffer
-   struct ccipui_ioctlreq *pfullresponse     = NULL;  // Buffer to put return response if any.
 
    ASSERT(NULL != psess );
    if ( NULL == psess ) {
@@ -315,6 +391,27 @@ int ccidrv_ioctl(struct inode *inode,
       return -EFAULT;
    }
 
+   if ( AALUID_IOCTL_SENDMSG_DIRECT == cmd ) {
+      // A request with no descriptor is a probe for SENDMSG_DIRECT and does nothing.
+      //  A driver without SENDMSG_DIRECT fails it, as it does any unknown command.
+      if ( 0 == aalui_ioctlPayloadSize(&req) ) {
+         return 0;
+      }
+      // The payload is only a descriptor of the real one
+      if ( sizeof(direct) != aalui_ioctlPayloadSize(&req) ) {
+         PERR("Bad direct payload descriptor size: %" PRIu64 "\n", aalui_ioctlPayloadSize(&req));
+         return -EINVAL;
+      }
+      if ( copy_from_user(&direct, (void *)(arg + sizeof(req)), sizeof(direct)) ) {
+         return -EFAULT;
+      }
+      upayload = (btByte __user *)(uintptr_t)direct.addr;
+      req.size = direct.size;
+      cmd      = AALUID_IOCTL_SENDMSG;
+   } else {
+      upayload = (btByte __user *)(arg + sizeof(req));
+   }
+
    // Total user buffer size is the size of the header structure ccipui_ioctlreq + payload size
    FullRequestSize = (sizeof(struct ccipui_ioctlreq)) + aalui_ioctlPayloadSize(&req);
 
@@ -324,75 +421,55 @@ int ccidrv_ioctl(struct inode *inode,
       return -EINVAL;
    }
 
-   // If there is a payload then allocate a bige enough buffer and copy it in.
-   if ( FullRequestSize > sizeof(struct ccipui_ioctlreq) ) {
+   pmsg = ccidrv_ioctl_getbuf(FullRequestSize, &stackbuf);
+   ASSERT(NULL != pmsg);
+   if ( NULL == pmsg ) {
+      PERR("Unable to allocate memory \n");
+      return -ENOMEM;
+   }
 
+   // Header was already read. Read the payload, if any. GETMSG's payload is only
+   //  room for the event, so there is nothing to read.
+   *pmsg = req;
+   if ( ( 0 != aalui_ioctlPayloadSize(&req) ) && ( AALUID_IOCTL_GETMSG != cmd ) ) {
       PINFO("UIDRV is reading message with payload of size %" PRIu64 "\n", aalui_ioctlPayloadSize(&req));
-      pfullrequest = (struct ccipui_ioctlreq *) kosal_kzmalloc(FullRequestSize);
-
-      // Read whole message
-      if ( copy_from_user(pfullrequest, (void *)arg, FullRequestSize) ) {
-         kosal_kfree(pfullrequest, FullRequestSize);
+      if ( copy_from_user(aalui_ioctlPayload(pmsg), upayload, (size_t)aalui_ioctlPayloadSize(&req)) ) {
+         ccidrv_ioctl_putbuf(pmsg, FullRequestSize, &stackbuf);
          return -EFAULT;
       }
-
-   } else {
-      //Header is all there is. No need to read it again. Just point to req earlier.
-      pfullrequest = &req;
-   }
-
-   // Allocate a temporary buffer for the response. Note that for simplicity the payload
-   //   of the original request will be used for the response as well. I.e., The response buffer
-   //   is the same size as the request buffer.  The response will be copied over the original
-   //   user mode request.
-   //-------------------------------------------------------------------------------------------
-   pfullresponse = (struct ccipui_ioctlreq *) kosal_kzmalloc(FullRequestSize);
-   ASSERT(NULL != pfullresponse);
-   if ( NULL == pfullresponse ) {
-      if ( &req != pfullrequest ) {
-         kosal_kfree(pfullrequest, FullRequestSize);
-      }
-      PERR("Unable to allocate memory \n");
-      ret = -ENOMEM;
-      return ret;
    }
 
    // Limit on response payload.  This will be changed by the request processor to the actual return size
    //  or zero if no response data.
    Outbufsize = aalui_ioctlPayloadSize(&req);
 
-   *pfullresponse = req;   // Copy the original header for the response and change as needed
-   // Pass the message to OS independent processing. Note that some functions that don't return a
-   // payload use only the request header to return their data. So the whole response buffer must be passed.
+   // Pass the message to OS independent processing. The response is written over the
+   //  request: handlers consume the request before they fill in the response, and the
+   //  user mode request and response payloads share a layout (see e.g.
+   //  BufferAllocateTransaction). Note that some functions that don't return a payload
+   //  use only the request header to return their data.
    ret = ccidrv_messageHandler(psess,
                                cmd,
-                               pfullrequest,
+                               pmsg,
                                FullRequestSize,
-                               pfullresponse,                       // Pointer to output response
+                               pmsg,                                // Pointer to output response
                                &Outbufsize);                        // Outbuf buffer size
 
    if ( 0 == ret ) {
 
-      btWSSize FullResponseSize = sizeof(struct ccipui_ioctlreq) + Outbufsize;
-
       // Copy the Response back.
-      PINFO("UIDRV is writing %" PRIu64 "-byte response message with payload of size %" PRIu64 " bytes with %llx\n", FullResponseSize, pfullresponse->size, (btWSID)(*pfullresponse->payload));
-      ret = copy_to_user((void*)arg, pfullresponse, FullResponseSize);
+      PINFO("UIDRV is writing response message with payload of size %" PRIu64 " bytes\n", Outbufsize);
+      if ( copy_to_user((void *)arg, pmsg, sizeof(struct ccipui_ioctlreq)) ||
+           ( ( 0 != Outbufsize ) && copy_to_user(upayload, aalui_ioctlPayload(pmsg), (size_t)Outbufsize) ) ) {
+         ret = -EFAULT;
+      }
 
    } else {
       PDEBUG("ccidrv_messageHandler failed\n");
       ret = -EINVAL;
    }
 
-   // Free response buffer
-   if ( NULL != pfullresponse ) {
-      kosal_kfree(pfullresponse, FullRequestSize);
-   }
-
-   // Free message copy if it had a payload
-   if ( &req != pfullrequest ) {
-      kosal_kfree(pfullrequest, FullRequestSize);
-   }
+   ccidrv_ioctl_putbuf(pmsg, FullRequestSize, &stackbuf);
 
    return ret;
 }
@@ -472,9 +549,10 @@ unsigned int ccidrv_poll ( struct file *file, poll_table *wait )
    // Put session's waitq in the poll table
    poll_wait ( file, &psess->m_waitq, wait );
 
-   // If there is a request on the queue wakeup sleeper
+   // If there is a request on the queue or the ring wakeup sleeper
    if (kosal_sem_get_krnl_alertable( &psess->m_sem )) { /* FIXME */ }
-   if( !_aal_q_empty(&psess->m_eventq) ){
+   if( !_aal_q_empty(&psess->m_eventq) ||
+       ( ( NULL != psess->m_evtring ) && !ccipui_evtring_empty(psess->m_evtring) ) ){
       DPRINTF( UIDRV_DBG_FILE, ": Message available. Waking sleepers\n" );
       mask |= POLLPRI;  // Device request completion
    }
@@ -495,6 +573,49 @@ unsigned int ccidrv_poll ( struct file *file, poll_table *wait )
 //=============================================================================
 
 
+//=============================================================================
+// Name: ccidrv_mmap_evtring
+// Description: Map the session's event ring
+// Interface: private
+// Inputs: psess - session
+//         vma - mapping at CCIPUI_EVTRING_MMAP_OFFSET
+// Outputs: 0 on success, else an error
+// Comments: The ring is allocated on first use. Until then every event
+//           goes to the event queue.
+//=============================================================================
+static int
+ccidrv_mmap_evtring(struct ccidrv_session *psess, struct vm_area_struct *vma)
+{
+   struct ccipui_evtring *pring;
+   int                    ret;
+
+   if ( (vma->vm_end - vma->vm_start) > PAGE_ALIGN(sizeof(struct ccipui_evtring)) ) {
+      DPRINTF( UIDRV_DBG_MMAP, "Event ring mapping too large\n");
+      return -EINVAL;
+   }
+
+   if ( kosal_sem_get_krnl_alertable(&psess->m_sem) ) {
+      return -ERESTARTSYS;
+   }
+
+   if ( NULL == psess->m_evtring ) {
+      // vmalloc_user() zeroes the memory and makes it mappable.
+      pring = (struct ccipui_evtring *)vmalloc_user(sizeof(struct ccipui_evtring));
+      if ( NULL == pring ) {
+         kosal_sem_put(&psess->m_sem);
+         return -ENOMEM;
+      }
+      ccipui_evtring_init(pring);
+      psess->m_evtring = pring;
+   }
+
+   ret = remap_vmalloc_range(vma, psess->m_evtring, 0);
+   kosal_sem_put(&psess->m_sem);
+
+   DPRINTF( UIDRV_DBG_MMAP, "Mmap event ring %s.\n", (0 == ret) ? "Success" : "Failed");
+   return ret;
+}
+
 //=============================================================================
 // Name: ccidrv_mmap
 // Description: mmap system call
@@ -518,18 +639,18 @@ ccidrv_mmap  (struct file *file, struct vm_area_struct *vma)
    PTRACEIN;
    PVERBOSE("In UIDRV  MMAP\n");
 
-   //////////////////////////////////////////////////////////////////////////////////
-   if(vma->vm_pgoff == 0 ) {
-      DPRINTF( UIDRV_DBG_MMAP, "Invalid WSID\n");
-      goto failed;
-   }
-
    /* session information is squirreled away in our private data */
    psess = (struct ccidrv_session *) file->private_data;
    if (NULL == psess) {
       DPRINTF( UIDRV_DBG_MMAP, "Invalid session\n");
       goto failed;
    }
+
+   //////////////////////////////////////////////////////////////////////////////////
+   // Offset 0 is never a WSID. It maps the event ring.
+   if(vma->vm_pgoff == CCIPUI_EVTRING_MMAP_OFFSET ) {
+      return ccidrv_mmap_evtring(psess, vma);
+   }
    PDEBUG("WSID offset %lu  handle is %llx\n",vma->vm_pgoff, pgoff_to_wsidHandle(vma->vm_pgoff));
 
    /* check wsidp vs known list of wsids */
@@ -596,9 +717,13 @@ ccidrv_mmap  (struct file *file, struct vm_area_struct *vma)
        goto failed;
    }
    DPRINTF( UIDRV_DBG_MMAP, "Mmap WS Success.\n");
+   ccidrv_putwsid(wsidp);
    return 0;
 
 failed:
+   if (NULL != wsidp) {
+      ccidrv_putwsid(wsidp);
+   }
    return -EINVAL;
 
 }
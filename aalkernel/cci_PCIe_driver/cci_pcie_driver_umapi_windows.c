@@ -180,8 +180,7 @@ ccidrv_initUMAPI( WDFDEVICE hDevice )
    kosal_list_init( &umDriver.m_sessq );
    kosal_mutex_init( &umDriver.m_sem );
 
-   kosal_mutex_init( &umDriver.wsid_list_sem );
-   kosal_list_init( &umDriver.wsid_list_head );
+   ccidrv_wsid_table_init(&umDriver.wsid_table);
 
    return status;
 }
@@ -0,0 +1,293 @@
+//******************************************************************************
+// This  file  is  provided  under  a  dual BSD/GPLv2  license.  When using or
+//         redistributing this file, you may do so under either license.
+//
+//                            GPL LICENSE SUMMARY
+//
+//  Copyright(c) 2016, Intel Corporation.
+//
+//  This program  is  free software;  you  can redistribute it  and/or  modify
+//  it  under  the  terms of  version 2 of  the GNU General Public License  as
+//  published by the Free Software Foundation.
+//
+//  This  program  is distributed  in the  hope that it  will  be useful,  but
+//  WITHOUT   ANY   WARRANTY;   without   even  the   implied   warranty    of
+//  MERCHANTABILITY  or  FITNESS  FOR  A  PARTICULAR  PURPOSE.  See  the   GNU
+//  General Public License for more details.
+//
+//  The  full  GNU  General Public License is  included in  this  distribution
+//  in the file called README.GPLV2-LICENSE.TXT.
+//
+//  Contact Information:
+//  Henry Mitchel, henry.mitchel at intel.com
+//  77 Reed Rd., Hudson, MA  01749
+//
+//                                BSD LICENSE
+//
+//  Copyright(c) 2016, Intel Corporation.
+//
+//  Redistribution and  use  in source  and  binary  forms,  with  or  without
+//  modification,  are   permitted  provided  that  the  following  conditions
+//  are met:
+//
+//    * Redistributions  of  source  code  must  retain  the  above  copyright
+//      notice, this list of conditions and the following disclaimer.
+//    * Redistributions in  binary form  must  reproduce  the  above copyright
+//      notice,  this  list of  conditions  and  the  following disclaimer  in
+//      the   documentation   and/or   other   materials   provided  with  the
+//      distribution.
+//    * Neither   the  name   of  Intel  Corporation  nor  the  names  of  its
+//      contributors  may  be  used  to  endorse  or promote  products derived
+//      from this software without specific prior written permission.
+//
+//  THIS  SOFTWARE  IS  PROVIDED  BY  THE  COPYRIGHT HOLDERS  AND CONTRIBUTORS
+//  "AS IS"  AND  ANY  EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING,  BUT  NOT
+//  LIMITED  TO, THE  IMPLIED WARRANTIES OF  MERCHANTABILITY  AND FITNESS  FOR
+//  A  PARTICULAR  PURPOSE  ARE  DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT
+//  OWNER OR CONTRIBUTORS BE LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,
+//  SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL   DAMAGES  (INCLUDING,   BUT   NOT
+//  LIMITED  TO,  PROCUREMENT  OF  SUBSTITUTE GOODS  OR SERVICES; LOSS OF USE,
+//  DATA,  OR PROFITS;  OR BUSINESS INTERRUPTION)  HOWEVER  CAUSED  AND ON ANY
+//  THEORY  OF  LIABILITY,  WHETHER  IN  CONTRACT,  STRICT LIABILITY,  OR TORT
+//  (INCLUDING  NEGLIGENCE  OR OTHERWISE) ARISING  IN ANY WAY  OUT  OF THE USE
+//  OF  THIS  SOFTWARE, EVEN IF ADVISED  OF  THE  POSSIBILITY  OF SUCH DAMAGE.
+//******************************************************************************
+//****************************************************************************
+//****************************************************************************
+/// @file cci_pcie_driver_wsid.h
+/// @brief  Workspace ID lookup table for the CCI driver.
+/// @ingroup aalkernel_ccip
+/// @verbatim
+//        FILE: cci_pcie_driver_wsid.h
+//     CREATED: 10/18/2016
+//
+// PURPOSE:   Hash table of allocated workspace IDs, keyed by the WSID handle
+//            passed to user mode. Writers (allocate, free) are serialized by
+//            the table semaphore. On Linux, lookups are lockless under RCU and
+//            removed entries are freed after a grace period; elsewhere they
+//            take the semaphore. A lookup returns the wsid with a reference
+//            held, so it stays valid after the read side ends.
+//
+//            Only kOSAL list, semaphore, RCU and reference count primitives
+//            are used, so the table can be built outside the driver against
+//            shims of those (see swtest gtCCIDrvWSID.cpp).
+// HISTORY:
+// COMMENTS:
+// WHEN:          WHO:     WHAT:
+// 10/18/2016              Initial version.
+// 10/19/2016              Lookups take a reference. Added owner check.
+// 10/19/2016              Owner check compares against the caller's own
+//                         owner sessions instead of following m_owner.
+//****************************************************************************///
+#ifndef __AALKERNEL_CCI_PCIE_DRIVER_WSID_H__
+#define __AALKERNEL_CCI_PCIE_DRIVER_WSID_H__
+#include "aalsdk/kernel/kosal.h"
+#include "aalsdk/kernel/aalwsservice.h"
+#include "aalsdk/kernel/iaaldevice.h"
+#include "aalsdk/kernel/aalbus-device.h"
+
+
+#define CCIDRV_WSID_HASH_BITS    10
+#define CCIDRV_WSID_HASH_SIZE    (1 << CCIDRV_WSID_HASH_BITS)
+
+//=============================================================================
+// Name: ccidrv_wsid_table
+// Description: Hash table of allocated aal_wsid objects, chained through
+//              aal_wsid::m_alloc_list.
+//=============================================================================
+struct ccidrv_wsid_table {
+   kosal_semaphore          m_sem;         // Serializes add and remove
+   btUnsigned64bitInt       m_nextWSID;    // Next WSID to hand out
+   kosal_list_head          m_buckets[CCIDRV_WSID_HASH_SIZE];
+};
+
+//=============================================================================
+// Name: ccidrv_wsid_hash
+// Description: Bucket index for a WSID handle
+// Comments: Handles are sequential counters shifted left (see
+//           wsid_to_wsidHandle()), so the low bits carry no information.
+//           A multiplicative hash spreads every bit into the index.
+//=============================================================================
+static inline btUnsigned32bitInt ccidrv_wsid_hash(btWSID wsidHandle)
+{
+   return (btUnsigned32bitInt)( ( (btUnsigned64bitInt)wsidHandle * 0x9E3779B97F4A7C15ULL ) >> ( 64 - CCIDRV_WSID_HASH_BITS ) );
+}
+
+//=============================================================================
+// Name: ccidrv_wsid_table_init
+// Description: Initialize an empty table
+//=============================================================================
+static inline void ccidrv_wsid_table_init(struct ccidrv_wsid_table *ptable)
+{
+   int i;
+
+   kosal_mutex_init(&ptable->m_sem);
+   ptable->m_nextWSID = 1;
+   for ( i = 0 ; i < CCIDRV_WSID_HASH_SIZE ; ++i ) {
+      kosal_list_init(&ptable->m_buckets[i]);
+   }
+}
+
+//=============================================================================
+// Name: ccidrv_wsid_table_add
+// Description: Assign the next WSID handle to a wsid and add it to the table
+// Inputs: ptable - table
+//         pwsid - wsid to add
+// Outputs: 0 on success, else the error from the semaphore
+// Comments: The caller must have initialized every other field of pwsid.
+//           Once linked, the object is visible to lockless readers. The
+//           table holds its first reference.
+//=============================================================================
+static inline int ccidrv_wsid_table_add(struct ccidrv_wsid_table *ptable,
+                                        struct aal_wsid *pwsid)
+{
+   int status = kosal_sem_get_krnl_alertable(&ptable->m_sem);
+   if ( 0 != status ) {
+      return status;
+   }
+
+   // Check the WSID for roll over. This gives us a very large number of WSIDs before
+   //   roll over.
+   if ( 0 == wsid_to_wsidHandle(ptable->m_nextWSID) ) {
+      ptable->m_nextWSID = 1;
+   }
+   pwsid->m_handle = wsid_to_wsidHandle(ptable->m_nextWSID);
+   ptable->m_nextWSID++;
+   kosal_refcount_set(&pwsid->m_refs, 1);
+
+#if defined( __AAL_LINUX__ )
+   kosal_list_add_head_rcu(&pwsid->m_alloc_list,
+                           &ptable->m_buckets[ccidrv_wsid_hash(pwsid->m_handle)]);
+#else
+   kosal_list_add_head(&pwsid->m_alloc_list,
+                       &ptable->m_buckets[ccidrv_wsid_hash(pwsid->m_handle)]);
+#endif
+   kosal_sem_put(&ptable->m_sem);
+   return 0;
+}
+
+//=============================================================================
+// Name: ccidrv_wsid_table_lookup
+// Description: Find a wsid by handle
+// Inputs: ptable - table
+//         wsidHandle - handle passed up to user mode
+// Outputs: The wsid, or NULL if no such handle is allocated.
+// Comments: The wsid is returned with a reference, which the caller drops
+//           with ccidrv_wsid_put() once done with it. A wsid being removed
+//           whose last reference is already gone is not found.
+//=============================================================================
+static inline struct aal_wsid *ccidrv_wsid_table_lookup(struct ccidrv_wsid_table *ptable,
+                                                        btWSID wsidHandle)
+{
+   kosal_list_head *phead = &ptable->m_buckets[ccidrv_wsid_hash(wsidHandle)];
+   struct aal_wsid *pwsid = NULL;
+   struct aal_wsid *pcur;
+
+#if defined( __AAL_LINUX__ )
+   kosal_rcu_read_lock();
+   kosal_list_for_each_entry_rcu(pcur, phead, m_alloc_list, struct aal_wsid) {
+#else
+   if ( 0 != kosal_sem_get_krnl_alertable(&ptable->m_sem) ) {
+      return NULL;
+   }
+   kosal_list_for_each_entry(pcur, phead, m_alloc_list, struct aal_wsid) {
+#endif
+      if ( pcur->m_handle == wsidHandle ) {
+         if ( kosal_refcount_inc_not_zero(&pcur->m_refs) ) {
+            pwsid = pcur;
+         }
+         break;
+      }
+   }
+#if defined( __AAL_LINUX__ )
+   kosal_rcu_read_unlock();
+#else
+   kosal_sem_put(&ptable->m_sem);
+#endif
+
+   return pwsid;
+}
+
+//=============================================================================
+// Name: ccidrv_wsid_table_remove
+// Description: Unlink a wsid from the table
+// Inputs: ptable - table
+//         pwsid - wsid to remove
+// Outputs: 0 on success, -EINVAL if pwsid is not in the table, else the
+//          error from the semaphore
+// Comments: On success the table's reference passes to the caller, to drop
+//           with ccidrv_wsid_put().
+//=============================================================================
+static inline int ccidrv_wsid_table_remove(struct ccidrv_wsid_table *ptable,
+                                           struct aal_wsid *pwsid)
+{
+   kosal_list_head *phead = &ptable->m_buckets[ccidrv_wsid_hash(pwsid->m_handle)];
+   struct aal_wsid *pcur;
+   int status = kosal_sem_get_krnl_alertable(&ptable->m_sem);
+   if ( 0 != status ) {
+      return status;
+   }
+
+   status = -EINVAL;
+   kosal_list_for_each_entry(pcur, phead, m_alloc_list, struct aal_wsid) {
+      if ( pcur == pwsid ) {
+#if defined( __AAL_LINUX__ )
+         kosal_list_del_rcu(&pwsid->m_alloc_list);
+#else
+         kosal_list_del(&pwsid->m_alloc_list);
+#endif
+         status = 0;
+         break;
+      }
+   }
+
+   kosal_sem_put(&ptable->m_sem);
+   return status;
+}
+
+//=============================================================================
+// Name: ccidrv_wsid_put
+// Description: Drop a reference taken by ccidrv_wsid_table_lookup(), or the
+//              table's, passed on by ccidrv_wsid_table_remove()
+// Inputs: pwsid - wsid
+// Outputs: Non-zero if that was the last reference. The caller then frees
+//          pwsid; on Linux through kosal_call_rcu() on pwsid->m_rcu, as
+//          lockless readers may still see it.
+//=============================================================================
+static inline int ccidrv_wsid_put(struct aal_wsid *pwsid)
+{
+   return kosal_refcount_dec_and_test(&pwsid->m_refs);
+}
+
+//=============================================================================
+// Name: ccidrv_wsid_owned_by
+// Description: Whether a wsid is on the workspace list of one of a session's
+//              owner sessions
+// Inputs: pwsid - wsid
+//         pdevicelist - the session's device list (aaldev_owner::m_devicelist)
+// Outputs: Non-zero if so.
+// Comments: aalsess_add_ws() records the owner session in pwsid->m_owner and
+//           aalsess_del_ws() clears it. The caller holds the lock that keeps
+//           pdevicelist from changing. m_owner is only compared with owner
+//           sessions on that list, never followed, as it may name another
+//           session's owner that is being freed.
+//=============================================================================
+static inline int ccidrv_wsid_owned_by(const struct aal_wsid *pwsid,
+                                       kosal_list_head *pdevicelist)
+{
+   const struct aaldev_ownerSession *powner = pwsid->m_owner;
+   struct aaldev_owner *pdevowner;
+
+   if ( NULL == powner ) {
+      return 0;
+   }
+   kosal_list_for_each_entry(pdevowner, pdevicelist, m_devicelist, struct aaldev_owner) {
+      if ( &pdevowner->m_sess == powner ) {
+         return 1;
+      }
+   }
+   return 0;
+}
+
+
+#endif // __AALKERNEL_CCI_PCIE_DRIVER_WSID_H__
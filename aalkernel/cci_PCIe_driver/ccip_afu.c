@@ -411,6 +411,16 @@ CommandHandler(struct aaldev_ownerSession *pownerSess,
                Message->m_errcode = uid_errnumNoMem;
                break;
             }
+         }else if( 0 != preq->ahmreq.u.wksp.m_numa ) {
+            // Caller asked for memory local to a given NUMA node.
+            krnl_virt = kosal_alloc_dma_node( ccip_dev_pci_dev(pdev),
+                                              preq->ahmreq.u.wksp.m_size,
+                                              (int)preq->ahmreq.u.wksp.m_numa - 1,
+                                              &iova);
+            if (NULL == krnl_virt) {
+               Message->m_errcode = uid_errnumNoMem;
+               break;
+            }
          }else{
             krnl_virt = kosal_alloc_dma_coherent( ccip_dev_pci_dev(pdev), preq->ahmreq.u.wksp.m_size, &iova);
             if (NULL == krnl_virt) {
@@ -431,6 +441,9 @@ CommandHandler(struct aaldev_ownerSession *pownerSess,
 
          wsidp->m_size = preq->ahmreq.u.wksp.m_size;
          wsidp->m_type = WSM_TYPE_VIRTUAL;
+         if( NULL != cci_aaldev_pci_dev(pdev) ) {
+            wsidp->m_numa = preq->ahmreq.u.wksp.m_numa;
+         }
          PDEBUG("Creating Physical WSID %p.\n", wsidp);
 
          // Add the new wsid onto the session
@@ -494,6 +507,7 @@ CommandHandler(struct aaldev_ownerSession *pownerSess,
             PDEBUG( "Workspace free failed due to bad WS type. Should be %d but received %d\n",WSM_TYPE_VIRTUAL,
                   wsidp->m_type);
 
+            ccidrv_putwsid(wsidp);
             Message->m_errcode = uid_errnumBadParameter;
             break;
          }
@@ -501,13 +515,16 @@ CommandHandler(struct aaldev_ownerSession *pownerSess,
          krnl_virt = (btVirtAddr)wsidp->m_id;
          if( NULL== cci_aaldev_pci_dev(pdev) ) {
             kosal_free_contiguous_mem(krnl_virt, wsidp->m_size);
+         }else if( 0 != wsidp->m_numa ) {
+            kosal_free_dma_node( ccip_dev_pci_dev(pdev), krnl_virt, wsidp->m_size, wsidp->m_dmahandle);
          }else{
             kosal_free_dma_coherent( ccip_dev_pci_dev(pdev), krnl_virt, wsidp->m_size, wsidp->m_dmahandle);
          }
 
          // remove the wsid from the device and destroy
-         kosal_list_del_init(&wsidp->m_list);
+         aalsess_del_ws(wsidp->m_list);
          ccidrv_freewsid(wsidp);
+         ccidrv_putwsid(wsidp);
 
          PVERBOSE("Sending the WKSP Free event.\n");
          Message->m_errcode = uid_errnumOK;
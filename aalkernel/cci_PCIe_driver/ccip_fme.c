@@ -184,6 +184,8 @@ CommandHandler(struct aaldev_ownerSession *pownerSess,
          struct ccidrvreq *preq = (struct ccidrvreq *)pmsg->payload;
          struct aalui_WSMEvent WSID;
          struct aal_wsid   *wsidp            = NULL;
+         btPhysAddr         physptr          = 0;
+         btWSSize           size             = 0;
 
          if ( !cci_aaldev_allow_map_mmior_space(pdev) ) {
             PERR("Failed ccipdrv_getMMIOR map Permission\n");
@@ -195,7 +197,19 @@ CommandHandler(struct aaldev_ownerSession *pownerSess,
          //------------------------------------------------------------
          // Create the WSID object and add to the list for this session
          //------------------------------------------------------------
-         if ( WSID_MAP_MMIOR != preq->ahmreq.u.wksp.m_wsid ) {
+         if ( WSID_MAP_MMIOR == preq->ahmreq.u.wksp.m_wsid ) {
+            physptr = cci_aaldev_phys_afu_mmio(pdev);
+            size    = cci_aaldev_len_afu_mmio(pdev);
+         }
+#if defined( __AAL_LINUX__ )
+         else if ( ( WSID_MAP_PERFSNAP == preq->ahmreq.u.wksp.m_wsid ) &&
+                   ( NULL != ccip_fme_perfsnap(cci_aaldev_pfme(pdev)) ) ) {
+            // Kernel memory; mapped by ccip_perfmon_mmap(), not by address.
+            physptr = 0;
+            size    = PAGE_ALIGN(sizeof(struct ccipui_perfsnap));
+         }
+#endif // __AAL_LINUX__
+         else {
             PERR("Failed ccipdrv_getMMIOR map Parameter\n");
 
             PERR("Bad WSID on ccipdrv_getMMIORmap\n");
@@ -222,8 +236,8 @@ CommandHandler(struct aaldev_ownerSession *pownerSess,
          // Set up the return payload
          WSID.evtID           = uid_wseventMMIOMap;
          WSID.wsParms.wsid    = pwsid_to_wsidHandle(wsidp);
-         WSID.wsParms.physptr = cci_aaldev_phys_afu_mmio(pdev);
-         WSID.wsParms.size    = cci_aaldev_len_afu_mmio(pdev);
+         WSID.wsParms.physptr = physptr;
+         WSID.wsParms.size    = size;
 
          // Make this atomic. Check the original response buffer size for room
          if(respBufSize >= sizeof(struct aalui_WSMEvent)){
@@ -587,6 +601,11 @@ struct fme_device * get_fme_mmio_dev(btVirtAddr pkvp_fme_mmio )
       goto ERR;
    }
 
+   // Performance counters are still read directly if this fails.
+   if( 0 != ccip_perfmon_cache_init(pfme_dev) ){
+      PERR("Performance counter snapshots will not be cached\n");
+   }
+
    PTRACEOUT_INT(res);
    return pfme_dev;
 
@@ -606,6 +625,7 @@ struct fme_device * get_fme_mmio_dev(btVirtAddr pkvp_fme_mmio )
 void ccip_destroy_fme_mmio_dev(struct fme_device *pfme_dev)
 {
    PVERBOSE("Destroying fme_device");
+   ccip_perfmon_cache_free(pfme_dev);
    kosal_kfree(pfme_dev,sizeof(struct fme_device));
 }
 
@@ -112,6 +112,16 @@ struct fme_device
    struct pr_program_context    *m_pr_program_context;
    struct cci_aal_device        *m_power_aaldev;
 
+#if defined( __AAL_LINUX__ )
+   // Performance counter snapshot cache, shared read-only with user mode
+   struct ccipui_perfsnap       *m_perfsnap;         // NULL if disabled
+   kosal_semaphore               m_perfsnap_sem;     // Serializes snapshot writers
+   kosal_work_queue              m_perfsnap_wq;
+   struct kosal_work_object      m_perfsnap_wobj;
+   btBool                        m_perfsnap_running; // Refresh worker queued
+   btBool                        m_perfsnap_stop;
+#endif // __AAL_LINUX__
+
 }; // end struct fme_device
 
 #define ccip_fme_dev_board_type(pdev)         ((pdev)->m_boardtype)
@@ -144,6 +154,10 @@ struct fme_device
 
 #define ccip_dev_fme_pwraal_dev(pdev)            ((pdev)->m_power_aaldev)
 
+#if defined( __AAL_LINUX__ )
+#define ccip_fme_perfsnap(pdev)                  ((pdev)->m_perfsnap)
+#endif // __AAL_LINUX__
+
 /// @brief   Get the FPGA Management Engine Device Object.
 ///
 /// @param[in] fme_device fme device pointer.
@@ -76,7 +76,7 @@
 
 #include "aalsdk/kernel/ccipdriver.h"
 #include "ccipdrv-events.h"
-#include "ccip_perfmon.h"
+#include "ccip_perfmon_linux.h"
 #include "aalsdk/kernel/ccip_defs.h"
 #include "ccip_fme.h"
 #include "cci_pcie_driver_PIPsession.h"
@@ -191,6 +191,7 @@ cci_mmap(struct aaldev_ownerSession *pownerSess,
             case WSID_CSRMAP_READAREA:
             case WSID_MAP_MMIOR:
             case WSID_MAP_UMSG:
+            case WSID_MAP_PERFSNAP:
             break;
          default:
             PERR("Attempt to map invalid WSID type %d\n", (int) wsidp->m_id);
@@ -248,6 +249,20 @@ cci_mmap(struct aaldev_ownerSession *pownerSess,
          return 0;
       }
 
+      if ( WSID_MAP_PERFSNAP == wsidp->m_id )
+      {
+         if ( ( cci_dev_FME != cci_aaldev_type(pdev) ) || ( NULL == cci_aaldev_pfme(pdev) ) ) {
+            PERR("Denying request to map performance counter snapshots for device 0x%p.\n", pdev);
+            goto ERROR;
+         }
+
+         res = ccip_perfmon_mmap(cci_aaldev_pfme(pdev), pvma);
+         if ( unlikely(0 != res) ) {
+            goto ERROR;
+         }
+         return 0;
+      }
+
       if ( WSID_MAP_UMSG == wsidp->m_id )
       {
          if ( !cci_aaldev_allow_map_umsg_space(pdev) ) {
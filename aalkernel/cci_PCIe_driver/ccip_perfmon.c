@@ -585,7 +585,7 @@ bt32bitInt get_perfmon_counters(struct fme_device* pfme_dev,
    pPerfCounter->num_counters.value=PERF_MONITOR_COUNT;
    pPerfCounter->num_counters.value=PERF_MONITOR_VERSION;
 
-   res= get_perfmonitor_snapshot(pfme_dev,pPerfCounter);
+   res= get_perfmonitor_cached(pfme_dev,pPerfCounter);
 
    PTRACEOUT_INT(res);
    return res;
@@ -145,6 +145,36 @@ bt32bitInt update_cache_event_counters(bt32bitInt event_code ,
 bt32bitInt get_perfmon_counters(struct fme_device* pfme_dev,
                                 struct CCIP_PERF_COUNTERS* pPerfCounter);
 
+#if defined( __AAL_LINUX__ )
+/// Name:    ccip_perfmon_cache_init
+/// @brief   set up the performance counter snapshot cache
+///
+/// @param[in] pfme_dev fme device pointer.
+/// @return    error code. The FME is usable without the cache.
+bt32bitInt ccip_perfmon_cache_init(struct fme_device *pfme_dev);
+
+/// Name:    ccip_perfmon_cache_free
+/// @brief   stop the snapshot worker and free the snapshot cache
+///
+/// @param[in] pfme_dev fme device pointer.
+/// @return    no return value
+void ccip_perfmon_cache_free(struct fme_device *pfme_dev);
+
+/// Name:    get_perfmonitor_cached
+/// @brief   get the latest snapshot of performance counters, taking a new
+///          one only if it is older than perfmon_interval
+///
+/// @param[in] pfme_dev fme device pointer.
+/// @param[in] pPerf performance counters pointer
+/// @return    error code
+bt32bitInt get_perfmonitor_cached(struct fme_device *pfme_dev,
+                                  struct CCIP_PERF_COUNTERS* pPerf);
+#else
+# define ccip_perfmon_cache_init(pfme_dev)         0
+# define ccip_perfmon_cache_free(pfme_dev)
+# define get_perfmonitor_cached(pfme_dev, pPerf)   get_perfmonitor_snapshot(pfme_dev, pPerf)
+#endif // __AAL_LINUX__
+
 /// Name:    update_vtd_event_counters
 /// @brief   get VT-D performance counters
 ///
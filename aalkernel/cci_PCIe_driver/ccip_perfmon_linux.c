@@ -72,6 +72,15 @@
 
 #include "ccip_perfmon_linux.h"
 #include "ccip_fme.h"
+#include <linux/vmalloc.h>
+
+//
+// Performance counter snapshot cache. Readers within perfmon_interval ms of
+//  the latest snapshot share it rather than freezing the counters again.
+//
+static uint perfmon_interval = 100;
+MODULE_PARM_DESC(perfmon_interval, "Minimum ms between performance counter snapshots. 0 disables the snapshot cache");
+module_param    (perfmon_interval, uint, S_IRUGO);
 
 
 ///============================================================================
@@ -94,7 +103,7 @@ static ssize_t perf_monitor_attrib_show_hr(struct device *pdev,
      return (snprintf(buf,PAGE_SIZE,"%d\n",0));
    }
 
-   get_perfmonitor_snapshot(pfme_dev, &perf_mon);
+   get_perfmonitor_cached(pfme_dev, &perf_mon);
 
    return (snprintf(buf,PAGE_SIZE,   "%s : %lu \n"
                                      "%s : %lu \n"
@@ -158,7 +167,7 @@ static ssize_t perf_monitor_attrib_show_bin(struct device *pdev,
       return (snprintf(buf,PAGE_SIZE,"%d\n",0));
    }
 
-   get_perfmonitor_snapshot(pfme_dev, &perf_mon);
+   get_perfmonitor_cached(pfme_dev, &perf_mon);
 
    return (snprintf(buf, PAGE_SIZE,  "%lu  "
                                     "%lu  "
@@ -267,28 +276,272 @@ ERR:
 
 
 
+///============================================================================
+/// Name: perfsnap_now
+/// @brief Timestamp for snapshots, CLOCK_MONOTONIC ns.
+///============================================================================
+static inline btUnsigned64bitInt perfsnap_now(void)
+{
+   return (btUnsigned64bitInt)ktime_to_ns(ktime_get());
+}
+
+///============================================================================
+/// Name: perfsnap_stale
+/// @brief Whether a new snapshot is due.
+///
+/// @param[in] pfme_dev - fme device pointer
+/// @param[in] pbuf - latest snapshot.
+/// @param[in] gen - its generation, 0 if none.
+/// @return    true if the latest snapshot is missing or too old
+///============================================================================
+static inline btBool perfsnap_stale(struct fme_device *pfme_dev,
+                                    struct ccipui_perfsnap_buf *pbuf,
+                                    btUnsigned64bitInt gen)
+{
+   return ( 0 == gen ) ||
+          ( perfsnap_now() - pbuf->tstamp >= (btUnsigned64bitInt)ccip_fme_perfsnap(pfme_dev)->interval * NSEC_PER_MSEC );
+}
+
+///============================================================================
+/// Name: perfsnap_refresh
+/// @brief Takes and publishes a new snapshot. Called with m_perfsnap_sem held.
+///
+/// @param[in] pfme_dev - fme device pointer
+/// @param[in] pPerf - counters to read into. Names are left alone.
+/// @return    error code
+///============================================================================
+static bt32bitInt perfsnap_refresh(struct fme_device *pfme_dev,
+                                   struct CCIP_PERF_COUNTERS *pPerf)
+{
+   struct ccipui_perfsnap_buf *pbuf = ccipui_perfsnap_next(ccip_fme_perfsnap(pfme_dev));
+   struct PERFCOUNTER_EVENT   *pevt = (struct PERFCOUNTER_EVENT *)pPerf;
+   bt32bitInt                  res  = 0;
+   unsigned                    i;
+
+   // CCIP_PERF_COUNTERS is an array of PERFCOUNTER_EVENT in all but name.
+   //  Counters the FME lacks (VT-d without an IOMMU) read as 0.
+   for ( i = 0 ; i < CCIPUI_PERFSNAP_VALUES ; ++i ) {
+      pevt[i].value = 0;
+   }
+
+   res = get_perfmonitor_snapshot(pfme_dev, pPerf);
+   if ( 0 != res ) {
+      return res;
+   }
+
+   pbuf->tstamp = perfsnap_now();
+   for ( i = 0 ; i < CCIPUI_PERFSNAP_VALUES ; ++i ) {
+      pbuf->values[i] = pevt[i].value;
+   }
+   ccipui_perfsnap_publish(ccip_fme_perfsnap(pfme_dev));
+
+   return res;
+}
+
+///============================================================================
+/// Name: perfsnap_callback
+/// @brief Worker queue callback. Keeps the mapped snapshot page current.
+///
+/// @param[in] pwork  work queue object pointer.
+/// @return    no return value
+///============================================================================
+static void perfsnap_callback(struct kosal_work_object *pwork)
+{
+   struct fme_device        *pfme_dev = kosal_get_object_containing(pwork, struct fme_device, m_perfsnap_wobj);
+   struct CCIP_PERF_COUNTERS perf_mon;
+
+   kosal_sem_get_krnl(&pfme_dev->m_perfsnap_sem);
+
+   if ( pfme_dev->m_perfsnap_stop ) {
+      pfme_dev->m_perfsnap_running = false;
+      kosal_sem_put(&pfme_dev->m_perfsnap_sem);
+      return;
+   }
+
+   perfsnap_refresh(pfme_dev, &perf_mon);
+
+   kosal_queue_delayed_work(pfme_dev->m_perfsnap_wq,
+                            &pfme_dev->m_perfsnap_wobj,
+                            ccip_fme_perfsnap(pfme_dev)->interval);
+
+   kosal_sem_put(&pfme_dev->m_perfsnap_sem);
+}
+
+///============================================================================
+/// Name: ccip_perfmon_cache_init
+/// @brief set up the performance counter snapshot cache
+///
+/// @param[in] pfme_dev - fme device pointer
+/// @return    error code
+///============================================================================
+bt32bitInt ccip_perfmon_cache_init(struct fme_device *pfme_dev)
+{
+   struct ccipui_perfsnap *psnap = NULL;
+   bt32bitInt              res   = 0;
+
+   PTRACEIN;
 
+   kosal_mutex_init(&pfme_dev->m_perfsnap_sem);
+   ccip_fme_perfsnap(pfme_dev)   = NULL;
+   pfme_dev->m_perfsnap_wq       = NULL;
+   pfme_dev->m_perfsnap_running  = false;
+   pfme_dev->m_perfsnap_stop     = false;
 
+   if ( 0 == perfmon_interval ) {
+      PVERBOSE("Performance counter snapshot cache disabled\n");
+      goto DONE;
+   }
 
+   psnap = (struct ccipui_perfsnap *)vmalloc_user(PAGE_ALIGN(sizeof(struct ccipui_perfsnap)));
+   if ( NULL == psnap ) {
+      PERR("Unable to allocate performance counter snapshot cache\n");
+      res = -ENOMEM;
+      goto DONE;
+   }
 
+   pfme_dev->m_perfsnap_wq = kosal_create_workqueue("PerfmonSnapshot", NULL);
+   if ( NULL == pfme_dev->m_perfsnap_wq ) {
+      PERR("Failed to create performance counter snapshot work queue\n");
+      vfree(psnap);
+      res = -ENOMEM;
+      goto DONE;
+   }
+   KOSAL_INIT_WORK(&pfme_dev->m_perfsnap_wobj, perfsnap_callback);
 
+   ccipui_perfsnap_init(psnap, perfmon_interval);
+   ccip_fme_perfsnap(pfme_dev) = psnap;
 
+DONE:
+   PTRACEOUT_INT(res);
+   return res;
+}
 
+///============================================================================
+/// Name: ccip_perfmon_cache_free
+/// @brief stop the snapshot worker and free the snapshot cache
+///
+/// @param[in] pfme_dev - fme device pointer
+/// @return    no return value
+///============================================================================
+void ccip_perfmon_cache_free(struct fme_device *pfme_dev)
+{
+   if ( NULL == ccip_fme_perfsnap(pfme_dev) ) {
+      return;
+   }
 
+   kosal_sem_get_krnl(&pfme_dev->m_perfsnap_sem);
+   pfme_dev->m_perfsnap_stop = true;
+   kosal_cancel_workqueue(&pfme_dev->m_perfsnap_wobj.workobj);
+   kosal_sem_put(&pfme_dev->m_perfsnap_sem);
 
+   // Waits for a callback already running; it sees m_perfsnap_stop.
+   kosal_destroy_workqueue(pfme_dev->m_perfsnap_wq);
+   pfme_dev->m_perfsnap_wq = NULL;
 
+   // Pages still mapped by user mode hold their own references.
+   vfree(ccip_fme_perfsnap(pfme_dev));
+   ccip_fme_perfsnap(pfme_dev) = NULL;
+}
 
+///============================================================================
+/// Name: get_perfmonitor_cached
+/// @brief get the latest snapshot of performance counters
+///
+/// @param[in] pfme_dev - fme device pointer
+/// @param[in] pPerf - performance counters pointer
+/// @return    error code
+///============================================================================
+bt32bitInt get_perfmonitor_cached(struct fme_device *pfme_dev,
+                                  struct CCIP_PERF_COUNTERS* pPerf)
+{
+   struct ccipui_perfsnap_buf snap;
+   struct PERFCOUNTER_EVENT  *pevt = (struct PERFCOUNTER_EVENT *)pPerf;
+   btUnsigned64bitInt         gen  = 0;
+   bt32bitInt                 res  = 0;
+   unsigned                   i;
+
+   if ( (NULL == pfme_dev) || (NULL == pPerf) ) {
+      PERR("Invalid Input pointers  \n");
+      return -EINVAL;
+   }
 
+   if ( NULL == ccip_fme_perfsnap(pfme_dev) ) {
+      return get_perfmonitor_snapshot(pfme_dev, pPerf);
+   }
 
+   gen = ccipui_perfsnap_read(ccip_fme_perfsnap(pfme_dev), &snap);
+   if ( !perfsnap_stale(pfme_dev, &snap, gen) ) {
+      goto COPY;
+   }
 
+   if ( kosal_sem_get_krnl_alertable(&pfme_dev->m_perfsnap_sem) ) {
+      return -ERESTARTSYS;
+   }
 
+   // Another reader may have refreshed it while we waited.
+   gen = ccipui_perfsnap_read(ccip_fme_perfsnap(pfme_dev), &snap);
+   if ( perfsnap_stale(pfme_dev, &snap, gen) ) {
+      res = perfsnap_refresh(pfme_dev, pPerf);
+      gen = ccipui_perfsnap_read(ccip_fme_perfsnap(pfme_dev), &snap);
+   }
 
+   kosal_sem_put(&pfme_dev->m_perfsnap_sem);
 
+   if ( 0 == gen ) {
+      return ( 0 != res ) ? res : -EIO;
+   }
 
+COPY:
+   for ( i = 0 ; i < CCIPUI_PERFSNAP_VALUES ; ++i ) {
+      pevt[i].value = snap.values[i];
+   }
+   return 0;
+}
 
+///============================================================================
+/// Name: ccip_perfmon_mmap
+/// @brief maps the performance counter snapshot page read-only, and keeps it
+///        refreshed every perfmon_interval ms from then on.
+///
+/// @param[in] pfme_dev - fme device pointer
+/// @param[in] pvma - user virtual memory area.
+/// @return    error code
+///============================================================================
+int ccip_perfmon_mmap(struct fme_device* pfme_dev,
+                      struct vm_area_struct *pvma)
+{
+   int res = 0;
 
+   if ( NULL == ccip_fme_perfsnap(pfme_dev) ) {
+      PERR("Performance counter snapshot cache disabled\n");
+      return -ENODEV;
+   }
 
+   if ( (pvma->vm_end - pvma->vm_start) > PAGE_ALIGN(sizeof(struct ccipui_perfsnap)) ) {
+      PERR("Invalid size for performance counter snapshot mmap\n");
+      return -EINVAL;
+   }
 
+   if ( pvma->vm_flags & VM_WRITE ) {
+      PERR("Performance counter snapshot page is read-only\n");
+      return -EPERM;
+   }
+   pvma->vm_flags &= ~VM_MAYWRITE;
 
+   res = remap_vmalloc_range(pvma, ccip_fme_perfsnap(pfme_dev), 0);
+   if ( 0 != res ) {
+      PERR("remap_vmalloc_range error at perfmon snapshot mmap %d\n", res);
+      return res;
+   }
 
+   // Mapped readers cannot ask for a refresh, so the worker keeps the page
+   //  current until the FME goes away.
+   kosal_sem_get_krnl(&pfme_dev->m_perfsnap_sem);
+   if ( !pfme_dev->m_perfsnap_running && !pfme_dev->m_perfsnap_stop ) {
+      pfme_dev->m_perfsnap_running = true;
+      kosal_queue_delayed_work(pfme_dev->m_perfsnap_wq, &pfme_dev->m_perfsnap_wobj, 0);
+   }
+   kosal_sem_put(&pfme_dev->m_perfsnap_sem);
 
+   return 0;
+}
@@ -90,6 +90,15 @@ bt32bitInt create_perfmonitor(kosal_pci_dev* ppcidev,
 /// @return    error code
 bt32bitInt remove_perfmonitor(kosal_pci_dev* ppcidev);
 
+/// Name:    ccip_perfmon_mmap
+/// @brief   maps the performance counter snapshot page read-only
+///
+/// @param[in] pfme_dev fme device pointer.
+/// @param[in] pvma     user virtual memory area.
+/// @return    error code
+int ccip_perfmon_mmap(struct fme_device* pfme_dev,
+                      struct vm_area_struct *pvma);
+
 
 
 #endif //__AALKERNEL_CCIP_PERFMON_LINUX_H_
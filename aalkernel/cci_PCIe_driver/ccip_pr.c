@@ -2534,6 +2534,7 @@ CommandHandler(struct aaldev_ownerSession *pownerSess,
             PDEBUG( "Workspace free failed due to bad WS type. Should be %d but received %d\n",WSM_TYPE_VIRTUAL,
                   wsidp->m_type);
 
+            ccidrv_putwsid(wsidp);
             pafuws_evt = ccipdrv_event_afu_afufreecws_create(pownerSess->m_device,
                                                            Message->m_tranID,
                                                            Message->m_context,
@@ -2550,8 +2551,9 @@ CommandHandler(struct aaldev_ownerSession *pownerSess,
          kosal_free_contiguous_mem(krnl_virt, wsidp->m_size);
 
          // remove the wsid from the device and destroy
-         kosal_list_del_init(&wsidp->m_list);
+         aalsess_del_ws(wsidp->m_list);
          ccidrv_freewsid(wsidp);
+         ccidrv_putwsid(wsidp);
 
          // Create the  event
          pafuws_evt = ccipdrv_event_afu_afufreecws_create(pownerSess->m_device,
@@ -568,6 +568,112 @@ void _kosal_free_dma_coherent( __ASSERT_HERE_PROTO btHANDLE devhandle,
 #endif // OS
 }
 
+//=============================================================================
+/// _kosal_alloc_dma_node
+/// @brief     Allocate a buffer of DMA-able contiguous memory on a given NUMA node
+/// @param[in] devhandle OS specific
+///            size in bytes
+///            node NUMA node to take the pages from
+///            pdma_handle Address to return DMA address for device
+/// @return    pointer to memory. NULL if failure, including an offline node.
+/// @note      Unlike _kosal_alloc_dma_coherent, which takes pages near the
+///            device, the pages come only from node. They are mapped for
+///            streaming DMA, which is coherent on the x86 platforms hosting
+///            the FPGA. Free with _kosal_free_dma_node.
+//=============================================================================
+btVirtAddr _kosal_alloc_dma_node( __ASSERT_HERE_PROTO btHANDLE devhandle,
+                                  btWSSize size_in_bytes,
+                                  int node,
+                                  btHANDLE *pdma_handle)
+{
+   btVirtAddr krnl_virt = NULL;
+
+   __ASSERT_HERE_IN_FN(size_in_bytes > 0);
+
+#if   defined( __AAL_LINUX__ )
+   {
+      struct page *pg   = NULL;
+      dma_addr_t   addr = 0;
+
+      if ( ( node < 0 ) || ( node >= MAX_NUMNODES ) || !node_online(node) ) {
+         return NULL;
+      }
+
+      pg = alloc_pages_node(node, GFP_KERNEL | __GFP_ZERO | __GFP_THISNODE, get_order(size_in_bytes));
+      if ( NULL == pg ) {
+         return NULL;
+      }
+
+      addr = dma_map_page(&((struct pci_dev*)devhandle)->dev, pg, 0, size_in_bytes, DMA_BIDIRECTIONAL);
+      if ( dma_mapping_error(&((struct pci_dev*)devhandle)->dev, addr) ) {
+         __free_pages(pg, get_order(size_in_bytes));
+         return NULL;
+      }
+
+      krnl_virt    = (btVirtAddr)page_address(pg);
+      *pdma_handle = (btHANDLE)addr;
+   }
+
+#elif defined( __AAL_WINDOWS__ )
+   UNREFERENCED_PARAMETER(node);
+
+   // No node-restricted contiguous allocator; fall back to the device's placement.
+   krnl_virt = _kosal_alloc_dma_coherent(__ASSERT_HERE_ARGS devhandle, size_in_bytes, pdma_handle);
+   if ( NULL == krnl_virt ) {
+      return NULL;
+   }
+
+#endif // OS
+
+   PMEMORY_HERE("_kosal_alloc_dma_node(size=%llu [0x%llx], node=%d) = 0x%" PRIxUINTPTR_T " [phys=0x%" PRIxPHYS_ADDR "]\n",
+                   size_in_bytes, size_in_bytes,
+                   node,
+                   __UINTPTR_T_CAST(krnl_virt),
+                 (long unsigned int)*pdma_handle);
+
+   return krnl_virt;
+}
+
+//=============================================================================
+/// _kosal_free_dma_node
+/// @brief     Free a buffer allocated through _kosal_alloc_dma_node
+/// @param[in] devhandle OS specific
+///            krnl_virt, size in bytes and dma_handle as allocated
+/// @return    void
+/// @note
+//=============================================================================
+void _kosal_free_dma_node( __ASSERT_HERE_PROTO btHANDLE devhandle,
+                           btVirtAddr krnl_virt,
+                           btWSSize size_in_bytes,
+                           btHANDLE dma_handle)
+{
+   __ASSERT_HERE_IN_FN(NULL != krnl_virt);
+   __ASSERT_HERE_IN_FN(size_in_bytes > 0);
+
+   PMEMORY_HERE("_kosal_free_dma_node(ptr=0x%" PRIxUINTPTR_T " [phys=0x%" PRIxPHYS_ADDR "], bytes=%llu [0x%llx])\n",
+                   __UINTPTR_T_CAST(krnl_virt),
+                   kosal_virt_to_phys(krnl_virt),
+                   size_in_bytes, size_in_bytes);
+
+   if ( NULL == krnl_virt ) {
+      return;
+   }
+
+#if   defined( __AAL_LINUX__ )
+
+   // Recommended security practice..
+   memset(krnl_virt, 0, (size_t)size_in_bytes);
+
+   dma_unmap_page(&((struct pci_dev*)devhandle)->dev, (dma_addr_t)dma_handle, size_in_bytes, DMA_BIDIRECTIONAL);
+   free_pages((unsigned long)krnl_virt, get_order(size_in_bytes));
+
+#elif defined( __AAL_WINDOWS__ )
+
+   _kosal_free_dma_coherent(__ASSERT_HERE_ARGS devhandle, krnl_virt, size_in_bytes, dma_handle);
+
+#endif // OS
+}
+
 #if   defined( __AAL_LINUX__ )
 
 void task_poller(struct work_struct *work)
@@ -325,11 +325,13 @@ protected:
    IALIBuffer    *m_pALIBufferService_afu0; ///< Pointer to Buffer Service
    IALIMMIO      *m_pALIMMIOService_afu0;   ///< Pointer to MMIO Service
    IALIReset     *m_pALIResetService_afu0;  ///< Pointer to AFU Reset Service
+   IALICompletion *m_pALICompletionService_afu0; ///< Pointer to Completion Service
 
    IBase         *m_pAALService_afu1;       ///< The generic AAL Service interface for the AFU.
    IALIBuffer    *m_pALIBufferService_afu1; ///< Pointer to Buffer Service
    IALIMMIO      *m_pALIMMIOService_afu1;   ///< Pointer to MMIO Service
    IALIReset     *m_pALIResetService_afu1;  ///< Pointer to AFU Reset Service
+   IALICompletion *m_pALICompletionService_afu1; ///< Pointer to Completion Service
 
    // Workspace info
    btVirtAddr     m_DSMVirt_afu0;        ///< DSM workspace virtual address.
@@ -364,10 +366,12 @@ DualNLBApp::DualNLBApp() :
    m_pALIBufferService_afu0(NULL),
    m_pALIMMIOService_afu0(NULL),
    m_pALIResetService_afu0(NULL),
+   m_pALICompletionService_afu0(NULL),
    m_pAALService_afu1(NULL),
    m_pALIBufferService_afu1(NULL),
    m_pALIMMIOService_afu1(NULL),
    m_pALIResetService_afu1(NULL),
+   m_pALICompletionService_afu1(NULL),
    m_Result(0),
    m_DSMVirt_afu0(NULL),
    m_DSMPhys_afu0(0),
@@ -699,15 +703,11 @@ btInt DualNLBApp::run()
 	   m_pALIMMIOService_afu0->mmioWrite32(CSR_CTL, 7);
 
 	   // Wait for test completion
-	   while( 0 == ((*StatusAddr_afu1)&0x1) ) {
-		 SleepMicro(100);
-	   }
+	   m_pALICompletionService_afu1->completionWaitFor(StatusAddr_afu1, 0x1, 0x1, AAL_INFINITE_WAIT);
 	   MSG("Done Running Test on AFU 1");
 
       // Wait for test completion
-      while( 0 == ((*StatusAddr_afu0)&0x1) ) {
-         SleepMicro(100);
-      }
+      m_pALICompletionService_afu0->completionWaitFor(StatusAddr_afu0, 0x1, 0x1, AAL_INFINITE_WAIT);
       MSG("Done Running Test on AFU 0");
 
       // Check that output buffer now contains what was in input buffer, e.g. 0xAF
@@ -798,6 +798,15 @@ void DualNLBApp::serviceAllocated(IBase *pServiceBase,
 		  return;
 	   }
 
+	   // Documentation says HWALIAFU Service publishes
+	   //    IALICompletion as subclass interface. Used to wait for the DSM
+	   m_pALICompletionService_afu0 = dynamic_ptr<IALICompletion>(iidALI_CMPL_Service, pServiceBase);
+	   ASSERT(NULL != m_pALICompletionService_afu0);
+	   if ( NULL == m_pALICompletionService_afu0 ) {
+		  m_bIsOK = false;
+		  return;
+	   }
+
 	   MSG("Service on AFU0 Allocated");
 
 	}else if(rTranID.ID() == AFU1){
@@ -837,6 +846,15 @@ void DualNLBApp::serviceAllocated(IBase *pServiceBase,
 		  return;
 	   }
 
+	   // Documentation says HWALIAFU Service publishes
+	   //    IALICompletion as subclass interface. Used to wait for the DSM
+	   m_pALICompletionService_afu1 = dynamic_ptr<IALICompletion>(iidALI_CMPL_Service, pServiceBase);
+	   ASSERT(NULL != m_pALICompletionService_afu1);
+	   if ( NULL == m_pALICompletionService_afu1 ) {
+		  m_bIsOK = false;
+		  return;
+	   }
+
 	   MSG("Service on AFU1 Allocated");
    }
    m_Sem.Post(1);
@@ -183,6 +183,7 @@ protected:
    IALIBuffer    *m_pALIBufferService; ///< Pointer to Buffer Service
    IALIMMIO      *m_pALIMMIOService;   ///< Pointer to MMIO Service
    IALIReset     *m_pALIResetService;  ///< Pointer to AFU Reset Service
+   IALICompletion *m_pALICompletionService; ///< Pointer to Completion Service
    CSemaphore     m_Sem;               ///< For synchronizing with the AAL runtime.
    btInt          m_Result;            ///< Returned result value; 0 if success
 
@@ -212,6 +213,7 @@ HelloALINLBApp::HelloALINLBApp() :
    m_pALIBufferService(NULL),
    m_pALIMMIOService(NULL),
    m_pALIResetService(NULL),
+   m_pALICompletionService(NULL),
    m_Result(0),
    m_DSMVirt(NULL),
    m_DSMPhys(0),
@@ -463,9 +465,7 @@ btInt HelloALINLBApp::run(int busnum, int devnum, int funnum)
 
 
       // Wait for test completion
-      while( 0 == ((*StatusAddr)&0x1) ) {
-         SleepMicro(100);
-      }
+      m_pALICompletionService->completionWaitFor(StatusAddr, 0x1, 0x1, AAL_INFINITE_WAIT);
       MSG("Done Running Test");
 
       // Stop the device
@@ -545,6 +545,15 @@ void HelloALINLBApp::serviceAllocated(IBase *pServiceBase,
       return;
    }
 
+   // Documentation says HWALIAFU Service publishes
+   //    IALICompletion as subclass interface. Used to wait for the DSM
+   m_pALICompletionService = dynamic_ptr<IALICompletion>(iidALI_CMPL_Service, pServiceBase);
+   ASSERT(NULL != m_pALICompletionService);
+   if ( NULL == m_pALICompletionService ) {
+      m_bIsOK = false;
+      return;
+   }
+
    MSG("Service Allocated");
    m_Sem.Post(1);
 }
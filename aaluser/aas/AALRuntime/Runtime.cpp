@@ -44,6 +44,7 @@
 #include "_RuntimeImpl.h"
 #include "aalsdk/CAALEvent.h"
 #include "aalsdk/aas/Dispatchables.h"
+#include "aalsdk/osal/ThreadGroup.h"
 
 /// @addtogroup AAL Runtime
 /// @{
@@ -219,6 +220,38 @@ btBool Runtime::IsOK()
    return CAASBase::IsOK() && m_pImplementation->IsOK();
 }
 
+//=============================================================================
+/// Report the duration of each phase of start-up.
+///
+/// @param[out]   rProfile       Receives an AALRUNTIME_PROFILE_* key, in
+///                                 nanoseconds, for each phase completed so far.
+/// @return       true if successful.
+//=============================================================================
+btBool Runtime::getStartupProfile(NamedValueSet &rProfile)
+{
+   AutoLock(this);
+   if ( IsOK() ) {
+      return m_pImplementation->getStartupProfile(rProfile);
+   }
+   return false;
+}
+
+//=============================================================================
+/// Report on the queue of the Runtime's message dispatcher.
+///
+/// @param[out]   rStats         Receives the dispatcher's statistics, including
+///                                 queue depth and latency per DispatchClass.
+/// @return       true if successful.
+//=============================================================================
+btBool Runtime::getDispatchStats(OSLThreadGroupStats &rStats)
+{
+   AutoLock(this);
+   if ( IsOK() ) {
+      return m_pImplementation->getDispatchStats(rStats);
+   }
+   return false;
+}
+
 //=============================================================================
 // Constructor of Runtime class.
 //
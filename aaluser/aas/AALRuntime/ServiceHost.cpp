@@ -45,6 +45,7 @@
 
 #include "aalsdk/AALDefs.h"
 #include "aalsdk/aas/ServiceHost.h"
+#include "aalsdk/AALTransactionTrace.h"
 #include <aalsdk/Runtime.h>
 
 BEGIN_NAMESPACE(AAL)
@@ -176,7 +177,12 @@ btBool ServiceHost::InstantiateService(IRuntime            *pRuntime,
       return false;
    }
 
-   return m_pProvider->Construct(pRuntime, pClientBase, rTranID, rManifest);
+   AAL_TRACE_TRANSACTION(txtraceHostInstantiate, rTranID.ID());
+
+   btBool res = m_pProvider->Construct(pRuntime, pClientBase, rTranID, rManifest);
+
+   AAL_TRACE_TRANSACTION(txtraceHostInstantiated, rTranID.ID());
+   return res;
 }
 
 END_NAMESPACE(AAL)
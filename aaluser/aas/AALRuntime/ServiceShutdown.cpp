@@ -0,0 +1,387 @@
+// Copyright(c) 2014-2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+//     CREATED: Oct 18, 2016
+//
+///        @file: ServiceShutdown.cpp
+///
+/// @brief   Parallel, deadline-bounded shutdown of Service plug-ins.
+/// @verbatim
+/// Accelerator Abstraction Layer
+///
+/// HISTORY:
+/// COMMENTS:
+/// WHEN:          WHO:     WHAT:@endverbatim
+//****************************************************************************///
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include "aalsdk/AALDefs.h"
+#include "aalsdk/aas/ServiceShutdown.h"
+#include "aalsdk/osal/CriticalSection.h"
+#include "aalsdk/osal/OSSemaphore.h"
+#include "aalsdk/osal/ThreadGroup.h"
+#include "aalsdk/osal/Timer.h"
+#include "aalsdk/osal/Env.h"
+#include "aalsdk/AALLoggerExtern.h"
+
+#include <climits>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+BEGIN_NAMESPACE(AAL)
+
+//=============================================================================
+// Name: ServiceShutdown::State
+// Description: The providers and their progress.
+// Comments: Reference counted: the ServiceShutdown holds one reference and
+//           each queued Task another, so that a Task completing after its
+//           Service was forced, or after the ServiceShutdown is gone, still
+//           has somewhere to report to.
+//=============================================================================
+class ServiceShutdown::State : public CriticalSection
+{
+public:
+   State() :
+      m_Refs(1),
+      m_Finished(0)
+   {
+      m_Progress.Create(0, INT_MAX);
+   }
+
+   void AddRef()
+   {
+      AutoLock(this);
+      ++m_Refs;
+   }
+
+   void Release()
+   {
+      btBool bDelete;
+      {
+         AutoLock(this);
+         bDelete = ( 0 == --m_Refs );
+      }
+      if ( bDelete ) {
+         delete this;
+      }
+   }
+
+   struct Entry
+   {
+      Record rec;
+      Timer  begin;
+   };
+
+   typedef std::vector<Entry> EntryList;
+
+   btUnsignedInt m_Refs;
+   btUnsignedInt m_Finished;  // Entries Done or Forced
+   EntryList     m_Entries;
+   CSemaphore    m_Progress;  // Posted as each entry finishes
+};
+
+//=============================================================================
+// Name: ServiceShutdown::Task
+// Description: Destroys the provider of one entry on a pool thread.
+//=============================================================================
+class ServiceShutdown::Task : public IDispatchable
+{
+public:
+   Task(State *pState, btUnsignedInt Index) :
+      m_pState(pState),
+      m_Index(Index)
+   {
+      m_pState->AddRef();
+   }
+
+   virtual ~Task()
+   {
+      m_pState->Release();
+   }
+
+   void operator() ()
+   {
+      IServiceModule *pProvider;
+      {
+         AutoLock(m_pState);
+         State::Entry &e = m_pState->m_Entries[m_Index];
+         if ( Pending != e.rec.Result ) {
+            // Forced before it could begin.
+            delete this;
+            return;
+         }
+         e.rec.Result = Running;
+         e.begin      = Timer();
+         pProvider    = e.rec.pProvider;
+      }
+
+      pProvider->Destroy();
+
+      {
+         AutoLock(m_pState);
+         State::Entry &e = m_pState->m_Entries[m_Index];
+         if ( Running == e.rec.Result ) {
+            (Timer() - e.begin).AsNanoSeconds(e.rec.Nanos);
+            e.rec.Result = Done;
+            ++m_pState->m_Finished;
+            m_pState->m_Progress.Post(1);
+         } else {
+            AAL_WARNING(LM_AAS, "ServiceShutdown: " << e.rec.Name << " finished after it was forced" << std::endl);
+         }
+      }
+
+      delete this;
+   }
+
+protected:
+   State        *m_pState;
+   btUnsignedInt m_Index;
+};
+
+//=============================================================================
+// Name: ReapPool
+// Description: Destroys a pool a forced Service still holds a thread of.
+// Comments: Runs on its own thread, which blocks until the Service returns
+//           from Destroy(), if ever, then deletes itself.
+//=============================================================================
+static void ReapPool(OSLThread *pThread, void *pContext)
+{
+   delete reinterpret_cast<OSLThreadGroup *>(pContext);
+   delete pThread;
+   ExitCurrentThread(0);
+}
+
+//=============================================================================
+// Name: DefaultDeadline
+// Description: The per-Service deadline for AAL_INFINITE_WAIT.
+// Interface: public
+// Comments: AAL_SERVICE_SHUTDOWN_DEADLINE in the environment overrides
+//           AAL_SERVICE_SHUTDOWN_DEFAULT_DEADLINE.
+//=============================================================================
+btTime ServiceShutdown::DefaultDeadline()
+{
+   std::string strDeadline;
+
+   if ( Environment::GetObj()->Get(AAL_SERVICE_SHUTDOWN_DEADLINE, strDeadline) ) {
+      char *pEnd = NULL;
+      long  ms   = strtol(strDeadline.c_str(), &pEnd, 0);
+      if ( ( pEnd != strDeadline.c_str() ) && ( ms > 0 ) ) {
+         return static_cast<btTime>(ms);
+      }
+      AAL_WARNING(LM_AAS, "ServiceShutdown: ignoring malformed " AAL_SERVICE_SHUTDOWN_DEADLINE " \"" << strDeadline << "\"" << std::endl);
+   }
+
+   return AAL_SERVICE_SHUTDOWN_DEFAULT_DEADLINE;
+}
+
+ServiceShutdown::ServiceShutdown() :
+   m_pState(new State())
+{}
+
+ServiceShutdown::~ServiceShutdown()
+{
+   m_pState->Release();
+}
+
+void ServiceShutdown::Add(std::string const &sName, IServiceModule *pProvider)
+{
+   State::Entry e;
+
+   e.rec.Name      = sName;
+   e.rec.pProvider = pProvider;
+   e.rec.Result    = Pending;
+   e.rec.Nanos     = 0;
+
+   AutoLock(m_pState);
+   m_pState->m_Entries.push_back(e);
+}
+
+//=============================================================================
+// Name: Run
+// Description: Destroy every provider added, in parallel.
+// Interface: public
+// Inputs: Deadline - per provider, in milliseconds.
+// Outputs: The number of providers forced.
+// Comments: The pool lasts for one Run(), so that no thread stays behind
+//           once every provider is Done. Should the pool be unavailable, the
+//           providers are destroyed in turn on the caller's thread, without
+//           a deadline.
+//=============================================================================
+btUnsignedInt ServiceShutdown::Run(btTime Deadline)
+{
+   OSLThreadGroup *pExecutor = NULL;
+   btUnsignedInt   Num;
+   btUnsignedInt   i;
+
+   if ( AAL_INFINITE_WAIT == Deadline ) {
+      Deadline = DefaultDeadline();
+   }
+
+   {
+      AutoLock(m_pState);
+      Num = static_cast<btUnsignedInt>(m_pState->m_Entries.size());
+   }
+
+   if ( Num > 0 ) {
+      const btUnsignedInt Threads = ( Num < AAL_SERVICE_SHUTDOWN_THREADS ) ? Num : AAL_SERVICE_SHUTDOWN_THREADS;
+
+      pExecutor = new(std::nothrow) OSLThreadGroup(Threads,
+                                                   Threads,
+                                                   OSLThread::THREADPRIORITY_NORMAL,
+                                                   AAL_INFINITE_WAIT,
+                                                   OSLAffinity::InternalDefault());
+      if ( ( NULL != pExecutor ) && !pExecutor->IsOK() ) {
+         delete pExecutor;
+         pExecutor = NULL;
+      }
+   }
+
+   for ( i = 0 ; i < Num ; ++i ) {
+      Task *pTask = new(std::nothrow) Task(m_pState, i);
+
+      if ( ( NULL != pExecutor ) && ( NULL != pTask ) && pExecutor->Add(pTask) ) {
+         continue;
+      }
+
+      if ( NULL != pTask ) {
+         (*pTask)();
+      } else {
+         IServiceModule *pProvider;
+         {
+            AutoLock(m_pState);
+            pProvider = m_pState->m_Entries[i].rec.pProvider;
+         }
+
+         Timer Begin;
+         pProvider->Destroy();
+
+         AutoLock(m_pState);
+         State::Entry &e = m_pState->m_Entries[i];
+         (Timer() - Begin).AsNanoSeconds(e.rec.Nanos);
+         e.rec.Result = Done;
+         ++m_pState->m_Finished;
+      }
+   }
+
+   Timer         RunBegin;
+   btUnsignedInt NumForced = 0;
+
+   for ( ; ; ) {
+      btTime Wait = Deadline;
+
+      {
+         AutoLock(m_pState);
+
+         if ( Num == m_pState->m_Finished ) {
+            break;
+         }
+
+         // Force whatever has had its time, and find the next deadline.
+         Timer Now;
+         for ( i = 0 ; i < Num ; ++i ) {
+            State::Entry &e = m_pState->m_Entries[i];
+
+            if ( ( Pending != e.rec.Result ) && ( Running != e.rec.Result ) ) {
+               continue;
+            }
+
+            btUnsigned64bitInt Elapsed = 0;
+            Timer              Since   = Now - ( ( Running == e.rec.Result ) ? e.begin : RunBegin );
+            Since.AsMilliSeconds(Elapsed);
+
+            if ( Elapsed >= Deadline ) {
+               AAL_WARNING(LM_AAS, "ServiceShutdown: forcing " << e.rec.Name << ( ( Running == e.rec.Result ) ? ", hung in Destroy()" : ", not begun" ) << std::endl);
+               Since.AsNanoSeconds(e.rec.Nanos);
+               e.rec.Result = Forced;
+               ++m_pState->m_Finished;
+               ++NumForced;
+            } else if ( Deadline - static_cast<btTime>(Elapsed) < Wait ) {
+               Wait = Deadline - static_cast<btTime>(Elapsed);
+            }
+         }
+
+         if ( Num == m_pState->m_Finished ) {
+            break;
+         }
+      }
+
+      // Wake for each completion, or at the nearest deadline.
+      m_pState->m_Progress.Wait(Wait);
+   }
+
+   if ( NULL != pExecutor ) {
+      if ( 0 == NumForced ) {
+         // Every Task has returned.
+         delete pExecutor;
+      } else if ( NULL == new(std::nothrow) OSLThread(ReapPool,
+                                                      OSLThread::THREADPRIORITY_NORMAL,
+                                                      pExecutor) ) {
+         AAL_WARNING(LM_AAS, "ServiceShutdown: leaking the pool of a forced Service" << std::endl);
+      }
+   }
+
+   return NumForced;
+}
+
+ServiceShutdown::Record ServiceShutdown::Get(btUnsignedInt i) const
+{
+   AutoLock(m_pState);
+   return m_pState->m_Entries[i].rec;
+}
+
+btUnsignedInt ServiceShutdown::Count() const
+{
+   AutoLock(m_pState);
+   return static_cast<btUnsignedInt>(m_pState->m_Entries.size());
+}
+
+std::string ServiceShutdown::ToString() const
+{
+   std::ostringstream oss;
+
+   AutoLock(m_pState);
+
+   State::EntryList::const_iterator itr;
+   for ( itr = m_pState->m_Entries.begin() ; m_pState->m_Entries.end() != itr ; ++itr ) {
+      if ( m_pState->m_Entries.begin() != itr ) {
+         oss << ' ';
+      }
+      oss << (*itr).rec.Name << '=' << ( (*itr).rec.Nanos / 1000 ) << "us";
+      switch ( (*itr).rec.Result ) {
+         case Forced  : oss << "(forced)";  break;
+         case Pending :
+         case Running : oss << "(pending)"; break;
+         default      :                     break;
+      }
+   }
+
+   return oss.str();
+}
+
+END_NAMESPACE(AAL)
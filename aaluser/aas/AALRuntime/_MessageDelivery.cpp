@@ -120,6 +120,41 @@ btBool _MessageDelivery::scheduleMessage(IDispatchable *pDispatchable)
    return m_Dispatcher.Add(pDispatchable);
 }
 
+//=============================================================================
+// Name: SetAffinity
+// Description: Place the dispatcher's threads
+// Interface: public
+// Comments:
+//=============================================================================
+btBool _MessageDelivery::SetAffinity(const OSLAffinity &rAffinity)
+{
+   AutoLock(this);
+   return m_Dispatcher.SetAffinity(rAffinity);
+}
+
+//=============================================================================
+// Name: SetPriorityDispatch
+// Description: Dispatch by DispatchClass rather than in order
+// Interface: public
+// Comments: Off by default.
+//=============================================================================
+void _MessageDelivery::SetPriorityDispatch(btBool bEnable, btUnsignedInt StarvationLimit)
+{
+   AutoLock(this);
+   m_Dispatcher.SetPriorityDispatch(bEnable, StarvationLimit);
+}
+
+//=============================================================================
+// Name: GetStats
+// Description: Snapshot of the dispatcher's queue
+// Interface: public
+// Comments:
+//=============================================================================
+void _MessageDelivery::GetStats(OSLThreadGroupStats &rStats) const
+{
+   m_Dispatcher.GetStats(rStats);
+}
+
 /// @}
 
 END_NAMESPACE(AAL)
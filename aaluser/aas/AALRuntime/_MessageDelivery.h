@@ -73,6 +73,15 @@ public:
    virtual btBool    scheduleMessage(IDispatchable * );
    // </IMessageDeliveryService>
 
+   // Moves the dispatcher's threads to the CPUs of rAffinity.
+   btBool SetAffinity(const OSLAffinity &rAffinity);
+
+   // Dispatches by DispatchClass rather than in order. Off by default.
+   void SetPriorityDispatch(btBool bEnable, btUnsignedInt StarvationLimit);
+
+   // Snapshot of the dispatcher's queue, by DispatchClass.
+   void      GetStats(OSLThreadGroupStats &rStats) const;
+
 protected:
    OSLThreadGroup m_Dispatcher;
 };
@@ -35,6 +35,7 @@
 // 06/25/2015     JG       Removed XL from name
 // 07/01/2015     JG       Redesigned RUntime Proxy structure.
 //                            MDS is no longer a Service.
+// 10/18/2016              Start-up profile. Preloading moved off the start() path.
 //****************************************************************************///
 #ifdef HAVE_CONFIG_H
 # include <config.h>
@@ -51,6 +52,11 @@
 
 #include "aalsdk/osal/Sleep.h"
 #include "aalsdk/osal/Env.h"
+#include "aalsdk/osal/Affinity.h"
+#include "aalsdk/AALTransactionTrace.h"
+
+#include <fstream>
+#include <sstream>
 
 #include "aalsdk/INTCDefs.h"
 #include "aalsdk/CAALEvent.h"
@@ -136,7 +142,9 @@ _runtime * _getnewRuntimeInstance(Runtime        *pRuntimeProxy,
       }
 
       if ( NULL == pTheRuntime ) {
+         Timer Begin;
          pTheRuntime = new _runtime(pRuntimeProxy, pClient);
+         pTheRuntime->ProfilePhase(AALRUNTIME_PROFILE_CONSTRUCT, Begin);
       }
 
       // Connect this client and proxy to the runtime
@@ -186,7 +194,8 @@ _runtime::_runtime(Runtime *pRuntimeProxy, IRuntimeClient *pClient) :
    m_pBrokerSvcHost(NULL),
    m_pBroker(NULL),
    m_pBrokerbase(NULL),
-   m_pDefaultBrokerbase(NULL)
+   m_pDefaultBrokerbase(NULL),
+   m_pPreloader(NULL)
 {
    m_sem.Create(0);
 
@@ -211,6 +220,7 @@ btBool _runtime::start(Runtime             *pProxy,
                        const NamedValueSet &rConfigParms)
 {
    IDispatchable *pDisp = NULL;
+   Timer          StartBegin;
 
    {
       AutoLock(this);
@@ -239,9 +249,13 @@ btBool _runtime::start(Runtime             *pProxy,
          goto _DISP;
       }
 
+      StartProfile(rConfigParms);
+
       // The Runtime needs a Runtime Proxy because it loads Services "much" like any application
       //  so it requires a RuntimeClient of its own.
+      Timer Begin;
       m_pProxy = m_pOwner->getRuntimeProxy(this);
+      ProfilePhase(AALRUNTIME_PROFILE_PROXY, Begin);
 
       if ( NULL == m_pProxy ) {
          // Fire the event and wait for it to be dispatched.
@@ -263,6 +277,15 @@ btBool _runtime::start(Runtime             *pProxy,
 
    }
 
+   // Before any Service is loaded, so that their threads start in place.
+   ApplyAffinity(rConfigParms);
+   StartTransactionTrace(rConfigParms);
+   ApplyPriorityDispatch(rConfigParms);
+
+   // Nothing waits for the preloaded modules, so they load alongside the Brokers.
+   //  Failure to preload is not fatal. The module is simply loaded on demand.
+   StartPreload(rConfigParms);
+
    // InstallDefaults() will wait for a notification. Don't wait while locked..
    if ( !InstallDefaults() ) {
       // Fire the event and wait for it to be dispatched.
@@ -292,6 +315,13 @@ btBool _runtime::start(Runtime             *pProxy,
 
       m_state = Started;
 
+      ProfilePhase(AALRUNTIME_PROFILE_START, StartBegin);
+      if ( !m_ProfileFile.empty() ) {
+         NamedValueSet Profile;
+         getStartupProfile(Profile);
+         WriteStartupProfile(Profile);
+      }
+
       schedDispatchable(new RuntimeStarted(m_pOwnerClient,
                                             pProxy,
                                             rConfigParms));
@@ -398,6 +428,7 @@ void _runtime::allocService(Runtime             *pProxy,
    IDispatchable *pDisp = NULL;
    ClientMap_itr  cmItr;
 
+   AAL_TRACE_TRANSACTION(txtraceRuntimeAllocService, rTranID.ID());
 
    if ( Started != m_state ) {
       pDisp = new RuntimeAllocateServiceFailed(m_pOwnerClient,
@@ -660,6 +691,9 @@ _runtime::_runtime() {/*empty*/}
 //=============================================================================
 _runtime::~_runtime()
 {
+   // Before locking, as the preloader takes the lock to finish.
+   JoinPreloader();
+
    AutoLock(this);
 
 
@@ -673,6 +707,13 @@ _runtime::~_runtime()
       delete m_pBrokerSvcHost;
       m_pBrokerSvcHost = NULL;
    }
+
+   // Drop the warm references last, after every ServiceHost has let go of its own.
+   PreloadList_itr itr;
+   for ( itr = m_Preloaded.begin() ; m_Preloaded.end() != itr ; ++itr ) {
+      delete *itr;
+   }
+   m_Preloaded.clear();
 }
 
 //=============================================================================
@@ -690,12 +731,14 @@ btBool _runtime::InstallDefaults()
    // Message Delivery Service
 
    // Service Broker. The m_Proxy is _runtime's Proxy which has a pointer to _runtime's IRuntimeClient
+   Timer Begin;
    m_pBrokerSvcHost = new ServiceHost(AAL_SVC_MOD_ENTRY_POINT(localServiceBroker));
    if(!m_pBrokerSvcHost->InstantiateService(m_pProxy, dynamic_cast<IBase *>(this), NamedValueSet(), TransactionID(Broker))){
       return false;
    }
 
    m_sem.Wait(); // for the local Broker
+   ProfilePhase(AALRUNTIME_PROFILE_DEFAULT_BROKER, Begin);
 
    if ( IsOK() ) {
       return true;
@@ -757,13 +800,462 @@ btBool _runtime::ProcessConfigParms(const NamedValueSet &rConfigParms)
       optArgs.Add(AALRUNTIME_CONFIG_RECORD, pConfigRecord);      // add runtime's config record to forward parameters
 
       // Allocate the service.
+      Timer Begin;
       allocService(this, optArgs, TransactionID(Broker));
       m_sem.Wait();
+      ProfilePhase(AALRUNTIME_PROFILE_CONFIG_BROKER, Begin);
+   }
+
+   return true;
+}
+
+//=============================================================================
+// Name: StartPreload
+// Description: Start loading the Service modules named by
+//              AALRUNTIME_CONFIG_PRELOAD_SERVICES, and that of the configured
+//              Broker, on a thread of their own.
+// Interface: private
+// Inputs: rConfigParms - Config parms
+// Outputs: none.
+// Comments: Only the shared library is loaded here. The module's provider and
+//           any Service instances are still created by the Broker on demand,
+//           but the ServiceHost's own load becomes a reference count bump
+//           instead of a trip through the dynamic loader. The configured
+//           Broker's module goes first, to be resident by the time
+//           ProcessConfigParms() allocates it. The modules are kept resident
+//           for the life of the Runtime.
+//=============================================================================
+void _runtime::StartPreload(const NamedValueSet &rConfigParms)
+{
+   INamedValueSet const *pConfigRecord = NULL;
+   btcString             sName         = NULL;
+   btcString             sList         = NULL;
+   std::string           strBroker;
+   std::string           strList;
+
+   if ( ENamedValuesOK != rConfigParms.Get(AALRUNTIME_CONFIG_RECORD, &pConfigRecord) ) {
+      pConfigRecord = NULL;
+   }
+
+   // Environment overrides the config record.
+   if ( !Environment::GetObj()->Get("AALRUNTIME_CONFIG_BROKER_SERVICE", strBroker) &&
+        ( NULL != pConfigRecord ) &&
+        ( ENamedValuesOK == pConfigRecord->Get(AALRUNTIME_CONFIG_BROKER_SERVICE, &sName) ) &&
+        ( NULL != sName ) ) {
+      strBroker = sName;
+   }
+
+   if ( !Environment::GetObj()->Get(AALRUNTIME_CONFIG_PRELOAD_SERVICES, strList) &&
+        ( NULL != pConfigRecord ) &&
+        ( ENamedValuesOK == pConfigRecord->Get(AALRUNTIME_CONFIG_PRELOAD_SERVICES, &sList) ) &&
+        ( NULL != sList ) ) {
+      strList = sList;
+   }
+
+   JoinPreloader();
+
+   AutoLock(this);
+
+   m_ToPreload.clear();
+   if ( !strBroker.empty() ) {
+      m_ToPreload.push_back(strBroker);
+   }
+
+   std::string::size_type begin = 0;
+   std::string::size_type end;
+
+   while ( begin < strList.length() ) {
+      end = strList.find_first_of(":,", begin);
+      if ( std::string::npos == end ) {
+         end = strList.length();
+      }
+
+      std::string strName = strList.substr(begin, end - begin);
+      begin = end + 1;
+
+      if ( !strName.empty() ) {
+         m_ToPreload.push_back(strName);
+      }
+   }
+
+   if ( m_ToPreload.empty() ) {
+      return;
+   }
+
+   m_pPreloader = new(std::nothrow) OSLThread(_runtime::Preloader,
+                                              OSLThread::THREADPRIORITY_NORMAL,
+                                              this,
+                                              false,
+                                              OSLAffinity::InternalDefault());
+   if ( ( NULL != m_pPreloader ) && !m_pPreloader->IsOK() ) {
+      delete m_pPreloader;
+      m_pPreloader = NULL;
+   }
+
+   if ( NULL == m_pPreloader ) {
+      AAL_WARNING(LM_AAS, "_runtime::StartPreload: unable to start the preloader" << std::endl);
+   }
+}
+
+//=============================================================================
+// Name: Preloader
+// Description: Thread that loads the modules of m_ToPreload.
+// Interface: private
+// Inputs: pThread - The preloader.
+//         pContext - The _runtime.
+// Outputs: none.
+// Comments: Records AALRUNTIME_PROFILE_PRELOAD when done.
+//=============================================================================
+void _runtime::Preloader(OSLThread *pThread, void *pContext)
+{
+   _runtime  *This = reinterpret_cast<_runtime *>(pContext);
+   ModuleList Names;
+   Timer      Begin;
+
+   {
+      AutoLock(This);
+      Names = This->m_ToPreload;
+   }
+
+   ModuleList_citr itr;
+   for ( itr = Names.begin() ; Names.end() != itr ; ++itr ) {
+      OSServiceModule mod;
+      OSServiceModuleInit(&mod, (*itr).c_str());
+
+      DynLinkLibrary *pLib = new(std::nothrow) DynLinkLibrary(std::string(mod.full_name));
+      if ( NULL == pLib ) {
+         break;
+      }
+
+      if ( !pLib->IsOK() ) {
+         AAL_WARNING(LM_AAS, "_runtime::Preloader: unable to load " << mod.full_name << std::endl);
+         delete pLib;
+         continue;
+      }
+
+      AAL_DEBUG(LM_AAS, "_runtime::Preloader: " << mod.full_name << " resident" << std::endl);
+
+      AutoLock(This);
+      This->m_Preloaded.push_back(pLib);
+   }
+
+   This->ProfilePhase(AALRUNTIME_PROFILE_PRELOAD, Begin);
+
+   // start() has usually written its profile by now, so report this phase on its own.
+   btUnsigned64bitInt nanos = 0;
+   (Timer() - Begin).AsNanoSeconds(nanos);
+
+   NamedValueSet Profile;
+   Profile.Add(AALRUNTIME_PROFILE_PRELOAD, nanos);
+   This->WriteStartupProfile(Profile);
+}
+
+//=============================================================================
+// Name: JoinPreloader
+// Description: Wait for the preloader, if any, to finish.
+// Interface: private
+// Inputs: none.
+// Outputs: none.
+// Comments: Must not be called with the lock held.
+//=============================================================================
+void _runtime::JoinPreloader()
+{
+   OSLThread *pPreloader;
+   {
+      AutoLock(this);
+      pPreloader   = m_pPreloader;
+      m_pPreloader = NULL;
+   }
+
+   if ( NULL != pPreloader ) {
+      pPreloader->Join();
+      delete pPreloader;
+   }
+}
+
+//=============================================================================
+// Name: StartProfile
+// Description: Note where AALRUNTIME_CONFIG_STARTUP_PROFILE says the start-up
+//              profile goes.
+// Interface: private
+// Inputs: rConfigParms - Config parms
+// Outputs: none.
+// Comments: The environment variable of the same name overrides the config
+//           record. The phases are recorded whether or not it is given.
+//=============================================================================
+void _runtime::StartProfile(const NamedValueSet &rConfigParms)
+{
+   INamedValueSet const *pConfigRecord = NULL;
+   btcString             sPath         = NULL;
+
+   m_ProfileFile.clear();
+
+   if ( !Environment::GetObj()->Get(AALRUNTIME_CONFIG_STARTUP_PROFILE, m_ProfileFile) ) {
+      if ( ( ENamedValuesOK != rConfigParms.Get(AALRUNTIME_CONFIG_RECORD, &pConfigRecord) ) ||
+           ( ENamedValuesOK != pConfigRecord->Get(AALRUNTIME_CONFIG_STARTUP_PROFILE, &sPath) ) ||
+           ( NULL == sPath ) ) {
+         return;
+      }
+      m_ProfileFile = sPath;
+   }
+}
+
+//=============================================================================
+// Name: ProfilePhase
+// Description: Record the time since rBegin as start-up phase sPhase.
+// Interface: public
+// Inputs: sPhase - AALRUNTIME_PROFILE_* key.
+//         rBegin - When the phase began.
+// Outputs: none.
+// Comments: A phase repeated by a restart replaces the earlier one. Kept in
+//           a plain list, as this is on the start() path; the NamedValueSet
+//           is only built for getStartupProfile().
+//=============================================================================
+void _runtime::ProfilePhase(btcString sPhase, const Timer &rBegin)
+{
+   btUnsigned64bitInt nanos = 0;
+   (Timer() - rBegin).AsNanoSeconds(nanos);
+
+   AutoLock(this);
+
+   ProfileList_itr itr;
+   for ( itr = m_Profile.begin() ; m_Profile.end() != itr ; ++itr ) {
+      if ( (*itr).first == sPhase ) {
+         (*itr).second = nanos;
+         return;
+      }
+   }
+   m_Profile.push_back(ProfilePhaseTime(sPhase, nanos));
+}
+
+//=============================================================================
+// Name: getStartupProfile
+// Description: Copy the start-up phases recorded so far.
+// Interface: public
+// Inputs: none.
+// Outputs: rProfile - AALRUNTIME_PROFILE_* keys, in nanoseconds.
+// Comments:
+//=============================================================================
+btBool _runtime::getStartupProfile(NamedValueSet &rProfile)
+{
+   AutoLock(this);
+
+   ProfileList_itr itr;
+   for ( itr = m_Profile.begin() ; m_Profile.end() != itr ; ++itr ) {
+      if ( rProfile.Has((*itr).first.c_str()) ) {
+         rProfile.Delete((*itr).first.c_str());
+      }
+      rProfile.Add((*itr).first.c_str(), (*itr).second);
    }
+   return true;
+}
 
+//=============================================================================
+// Name: getDispatchStats
+// Description: Copy the message dispatcher's statistics.
+// Interface: public
+// Inputs: none.
+// Outputs: rStats - the dispatcher's statistics.
+// Comments:
+//=============================================================================
+btBool _runtime::getDispatchStats(OSLThreadGroupStats &rStats)
+{
+   m_MDS.GetStats(rStats);
    return true;
 }
 
+//=============================================================================
+// Name: WriteStartupProfile
+// Description: Append rProfile to m_ProfileFile as a single line.
+// Interface: private
+// Inputs: rProfile - AALRUNTIME_PROFILE_* keys, in nanoseconds.
+// Outputs: none.
+// Comments: "-" writes to stderr.
+//=============================================================================
+void _runtime::WriteStartupProfile(const NamedValueSet &rProfile)
+{
+   std::string strFile;
+   {
+      AutoLock(this);
+      strFile = m_ProfileFile;
+   }
+
+   if ( strFile.empty() ) {
+      return;
+   }
+
+   std::ostringstream oss;
+   oss << "AAL Runtime start-up profile (ns):";
+
+   btUnsignedInt Num = 0;
+   rProfile.GetNumNames(&Num);
+   for ( btUnsignedInt i = 0 ; i < Num ; ++i ) {
+      btStringKey        sName = NULL;
+      btUnsigned64bitInt nanos = 0;
+      if ( ( ENamedValuesOK == rProfile.GetName(i, &sName) ) &&
+           ( ENamedValuesOK == rProfile.Get(sName, &nanos) ) ) {
+         oss << ' ' << sName << '=' << nanos;
+      }
+   }
+   oss << std::endl;
+
+   if ( "-" == strFile ) {
+      std::cerr << oss.str();
+      return;
+   }
+
+   std::ofstream ofs(strFile.c_str(), std::ios::out | std::ios::app);
+   if ( !ofs.is_open() ) {
+      AAL_WARNING(LM_AAS, "_runtime::WriteStartupProfile: unable to open " << strFile << std::endl);
+      return;
+   }
+   ofs << oss.str();
+}
+
+//=============================================================================
+// Name: ApplyAffinity
+// Description: Place the Runtime's own threads on the CPUs named by
+//              AALRUNTIME_CONFIG_AFFINITY.
+// Interface: private
+// Inputs: rConfigParms - Config parms
+// Outputs: none.
+// Comments: The message dispatcher already runs, so it is moved. Service
+//           message delivery threads and the AIA message pump pick the
+//           placement up from OSLAffinity::InternalDefault() as they start.
+//           A malformed placement is reported and ignored.
+//=============================================================================
+void _runtime::ApplyAffinity(const NamedValueSet &rConfigParms)
+{
+   INamedValueSet const *pConfigRecord = NULL;
+   btcString             sSpec         = NULL;
+   std::string           strSpec;
+
+   // Environment overrides the config record.
+   if ( !Environment::GetObj()->Get(AALRUNTIME_CONFIG_AFFINITY, strSpec) ) {
+      if ( ( ENamedValuesOK != rConfigParms.Get(AALRUNTIME_CONFIG_RECORD, &pConfigRecord) ) ||
+           ( ENamedValuesOK != pConfigRecord->Get(AALRUNTIME_CONFIG_AFFINITY, &sSpec) ) ||
+           ( NULL == sSpec ) ) {
+         return;
+      }
+      strSpec = sSpec;
+   }
+
+   OSLAffinity Affinity(strSpec.c_str());
+   if ( !Affinity.IsOK() ) {
+      AAL_WARNING(LM_AAS, "_runtime::ApplyAffinity: ignoring malformed " AALRUNTIME_CONFIG_AFFINITY " \"" << strSpec << "\"" << std::endl);
+      return;
+   }
+
+   OSLAffinity::SetInternalDefault(Affinity);
+
+   if ( !m_MDS.SetAffinity(Affinity) ) {
+      AAL_WARNING(LM_AAS, "_runtime::ApplyAffinity: unable to place the dispatcher on " << Affinity.ToString() << std::endl);
+      return;
+   }
+
+   AAL_DEBUG(LM_AAS, "_runtime::ApplyAffinity: internal threads on " << Affinity.ToString() << std::endl);
+}
+
+//=============================================================================
+// Name: StartTransactionTrace
+// Description: Enable TransactionID tracing if AALRUNTIME_CONFIG_TRANSACTION_TRACE
+//              names a file.
+// Interface: private
+// Inputs: rConfigParms - Config parms
+// Outputs: none.
+// Comments: The environment variable of the same name overrides the config
+//           record. The trace is written when the Runtime stops.
+//=============================================================================
+void _runtime::StartTransactionTrace(const NamedValueSet &rConfigParms)
+{
+   INamedValueSet const *pConfigRecord = NULL;
+   btcString             sPath         = NULL;
+
+   if ( !Environment::GetObj()->Get(AALRUNTIME_CONFIG_TRANSACTION_TRACE, m_TraceFile) ) {
+      if ( ( ENamedValuesOK != rConfigParms.Get(AALRUNTIME_CONFIG_RECORD, &pConfigRecord) ) ||
+           ( ENamedValuesOK != pConfigRecord->Get(AALRUNTIME_CONFIG_TRANSACTION_TRACE, &sPath) ) ||
+           ( NULL == sPath ) ) {
+         return;
+      }
+      m_TraceFile = sPath;
+   }
+
+   if ( m_TraceFile.empty() ) {
+      return;
+   }
+
+   if ( !TransactionTrace::Enable() ) {
+      AAL_WARNING(LM_AAS, "_runtime::StartTransactionTrace: unable to enable tracing" << std::endl);
+      m_TraceFile.clear();
+      return;
+   }
+
+   AAL_DEBUG(LM_AAS, "_runtime::StartTransactionTrace: tracing to " << m_TraceFile << std::endl);
+}
+
+//=============================================================================
+// Name: ApplyPriorityDispatch
+// Description: Dispatch by DispatchClass if AALRUNTIME_CONFIG_PRIORITY_DISPATCH
+//              is given.
+// Interface: private
+// Inputs: rConfigParms - Config parms
+// Outputs: none.
+// Comments: The environment variable of the same name overrides the config
+//           record. "on" keeps the default starvation limit. Anything else
+//           that is not a number is reported and ignored.
+//=============================================================================
+void _runtime::ApplyPriorityDispatch(const NamedValueSet &rConfigParms)
+{
+   INamedValueSet const *pConfigRecord = NULL;
+   btcString             sSpec         = NULL;
+   std::string           strSpec;
+
+   if ( !Environment::GetObj()->Get(AALRUNTIME_CONFIG_PRIORITY_DISPATCH, strSpec) ) {
+      if ( ( ENamedValuesOK != rConfigParms.Get(AALRUNTIME_CONFIG_RECORD, &pConfigRecord) ) ||
+           ( ENamedValuesOK != pConfigRecord->Get(AALRUNTIME_CONFIG_PRIORITY_DISPATCH, &sSpec) ) ||
+           ( NULL == sSpec ) ) {
+         return;
+      }
+      strSpec = sSpec;
+   }
+
+   btUnsignedInt StarvationLimit = OSLTHREADGROUP_DEFAULT_STARVATION_LIMIT;
+
+   if ( "on" != strSpec ) {
+      std::istringstream iss(strSpec);
+      if ( !( iss >> StarvationLimit ) || !iss.eof() ) {
+         AAL_WARNING(LM_AAS, "_runtime::ApplyPriorityDispatch: ignoring malformed " AALRUNTIME_CONFIG_PRIORITY_DISPATCH " \"" << strSpec << "\"" << std::endl);
+         return;
+      }
+   }
+
+   m_MDS.SetPriorityDispatch(true, StarvationLimit);
+
+   AAL_DEBUG(LM_AAS, "_runtime::ApplyPriorityDispatch: starvation limit " << StarvationLimit << std::endl);
+}
+
+//=============================================================================
+// Name: StopTransactionTrace
+// Description: Write the trace started by StartTransactionTrace().
+// Interface: private
+// Inputs: none.
+// Outputs: none.
+// Comments:
+//=============================================================================
+void _runtime::StopTransactionTrace()
+{
+   if ( m_TraceFile.empty() ) {
+      return;
+   }
+
+   TransactionTrace::Disable();
+
+   if ( !TransactionTrace::WriteChromeTrace(m_TraceFile.c_str()) ) {
+      AAL_WARNING(LM_AAS, "_runtime::StopTransactionTrace: unable to write " << m_TraceFile << std::endl);
+   }
+   m_TraceFile.clear();
+}
+
 //
 // IServiceClient Interface
 //-------------------------
@@ -854,6 +1346,7 @@ void _runtime::serviceReleased(TransactionID const &rTranID)
          m_MDS.StopMessageDelivery();
 
          m_state = Stopped;
+         StopTransactionTrace();
 
          // Release our Proxy
          m_pProxy->releaseRuntimeProxy();
@@ -891,7 +1384,8 @@ void _runtime::serviceReleaseRequest(IBase *pServiceBase, const IEvent &rEvent)
 // Interface: public
 // Inputs: rEvent - Event detailing failure
 // Outputs: none.
-// Comments: Not much to do but forward
+// Comments: Sent by the Broker when Services had to be forced. The Broker is
+//           gone all the same, so the Runtime stops as in serviceReleased().
 //=============================================================================
 void _runtime::serviceReleaseFailed(const IEvent &rEvent)
 {
@@ -902,6 +1396,7 @@ void _runtime::serviceReleaseFailed(const IEvent &rEvent)
 
    m_MDS.StopMessageDelivery();
    m_state = Stopped;
+   StopTransactionTrace();
 
    // Copy the exception event as the original will be destroyed when we return
    IExceptionTransactionEvent *pExevent = dynamic_ptr<IExceptionTransactionEvent>(iidExTranEvent, rEvent);
@@ -920,9 +1415,14 @@ void _runtime::serviceReleaseFailed(const IEvent &rEvent)
                1);
 
 
+   // Release our Proxy
+   m_pProxy->releaseRuntimeProxy();
+
    FireAndWait(new RuntimeStopped(m_pOwnerClient, m_pOwner),
                1,
                1);
+
+   m_sem.Post(1);
 }
 
 //=============================================================================
@@ -43,8 +43,11 @@
 #include <aalsdk/AALBase.h>
 
 #include <aalsdk/osal/OSSemaphore.h>
+#include <aalsdk/osal/Thread.h>
+#include <aalsdk/osal/Timer.h>
 
 #include <aalsdk/osal/OSServiceModule.h>
+#include <aalsdk/osal/DynLinkLibrary.h>
 #include <aalsdk/aas/AALServiceModule.h>
 #include <aalsdk/aas/ServiceHost.h>
 #include <aalsdk/IServiceClient.h>
@@ -52,6 +55,8 @@
 #include <aalsdk/osal/CriticalSection.h>
 #include <aalsdk/eds/AASEventDeliveryService.h>
 
+#include <vector>
+
 #include "_MessageDelivery.h"
 
 
@@ -139,6 +144,15 @@ public:
 
    void releaseRuntimeInstance(Runtime *pRuntimeProxy);
 
+   // Copies the start-up phases completed so far into rProfile.
+   btBool getStartupProfile(NamedValueSet &rProfile);
+
+   // Copies the message dispatcher's statistics into rStats.
+   btBool getDispatchStats(OSLThreadGroupStats &rStats);
+
+   // Records the time since rBegin as start-up phase sPhase.
+   void        ProfilePhase(btcString sPhase, const Timer &rBegin);
+
 private:
    // prevent empty construction.
    _runtime();
@@ -147,6 +161,15 @@ private:
 
    btBool    InstallDefaults();
    btBool ProcessConfigParms(const NamedValueSet &rConfigParms);
+   void         StartProfile(const NamedValueSet &rConfigParms);
+   void         StartPreload(const NamedValueSet &rConfigParms);
+   static void     Preloader(OSLThread *pThread, void *pContext);
+   void        JoinPreloader();
+   void  WriteStartupProfile(const NamedValueSet &rProfile);
+   void        ApplyAffinity(const NamedValueSet &rConfigParms);
+   void        StartTransactionTrace(const NamedValueSet &rConfigParms);
+   void        ApplyPriorityDispatch(const NamedValueSet &rConfigParms);
+   void        StopTransactionTrace();
 
    // <IServiceClient>
    virtual void       serviceAllocated(IBase               *pServiceBase,
@@ -178,6 +201,15 @@ private:
    typedef std::map< Runtime * , IRuntimeClient * > ClientMap;
    typedef ClientMap::iterator                      ClientMap_itr;
 
+   // Service modules held resident by AALRUNTIME_CONFIG_PRELOAD_SERVICES.
+   typedef std::list< DynLinkLibrary * >            PreloadList;
+   typedef PreloadList::iterator                    PreloadList_itr;
+   typedef std::list< std::string >                 ModuleList;
+   typedef ModuleList::const_iterator               ModuleList_citr;
+   typedef std::pair< std::string, btUnsigned64bitInt > ProfilePhaseTime;
+   typedef std::vector< ProfilePhaseTime >          ProfileList;
+   typedef ProfileList::iterator                    ProfileList_itr;
+
    enum Services {
       MDS = 1,
       Broker
@@ -212,6 +244,12 @@ private:
    IBase            *m_pDefaultBrokerbase;
 
    ClientMap         m_mClientMap;    // Map of Runtime Proxys
+   PreloadList       m_Preloaded;     // Warm Service module handles
+   ModuleList        m_ToPreload;     // Service modules for the preloader to load
+   OSLThread        *m_pPreloader;    // Loads m_ToPreload off the start() path
+   ProfileList       m_Profile;       // Start-up phase durations, in nanoseconds
+   std::string       m_ProfileFile;   // Where the start-up profile goes, if anywhere
+   std::string       m_TraceFile;     // Chrome trace written at stop, if tracing
    CSemaphore        m_sem;
    // Active core services
    _MessageDelivery  m_MDS;
@@ -33,6 +33,8 @@
 // COMMENTS:
 // WHEN:          WHO:     WHAT:
 // 06/25/2015     JG       Removed XL from name
+// 10/18/2016              Services shut down by ServiceShutdown, each with
+//                           its own deadline.
 //****************************************************************************///
 #ifdef HAVE_CONFIG_H
 # include <config.h>
@@ -45,6 +47,8 @@
 #include "aalsdk/aas/AALInProcServiceFactory.h"  // Defines InProc Service Factory
 #include "aalsdk/aas/Dispatchables.h"
 #include "aalsdk/aas/ServiceHost.h"
+#include "aalsdk/aas/ServiceShutdown.h"
+#include "aalsdk/AALTransactionTrace.h"
 #include "aalsdk/AALLoggerExtern.h"              // AAL Logger
 #include "_ServiceBroker.h"
 #include "aalsdk/aas/AALRuntimeModule.h"
@@ -105,6 +109,8 @@ void _ServiceBroker::allocService(IRuntime            *pProxy,
    ServiceHost          *SvcHost      = NULL;
    IServiceClient       *pServiceClient;
 
+   AAL_TRACE_TRANSACTION(txtraceBrokerAllocService, rTranID.ID());
+
    pServiceClient = dynamic_ptr<IServiceClient>(iidServiceClient, pServiceClientBase);
 
    ASSERT(NULL != pServiceClient);
@@ -229,11 +235,13 @@ ServiceHost *_ServiceBroker::findServiceHost(std::string const &sName)
 // call to the DoShutdown() method on the Service Factory which does the bulk
 // of the work.
 //
-// DoShutdown() iterates through the list of registered services and invokes
-// Shutdown method on their IServiceModule interface. It then waits on a
-// count-up semaphore waiting for each service to report that they have
-// shutdown or until the timeout expires. It then generates and event notifying
-// AAL core that it has completed.
+// DoShutdown() hands the IServiceModule of each registered service to a
+// ServiceShutdown, which calls their Destroy() in parallel on a thread pool
+// created for that shutdown and waits for each until its own deadline expires.
+// Services that miss it are forced. It then generates an event notifying
+// AAL core that it has completed, with the per-service durations logged:
+// ServiceReleased, or ServiceReleaseFailed with errSystemTimeout if any
+// Service was forced.
 //------------------------------------------------------------------------------
 
 struct shutdown_thread_parms
@@ -307,141 +315,86 @@ void _ServiceBroker::ShutdownThread(OSLThread *pThread,
    delete pThread;
 }
 
-struct shutdown_handler_thread_parms
-{
-   shutdown_handler_thread_parms(_ServiceBroker *pfact,
-                                 ServiceHost    *pSvcHost,
-                                 CSemaphore     *srvcCount,
-                                 btTime          timeout) :
-      m_this(pfact),
-      m_pSvcHost(pSvcHost),
-      m_srvcCount(srvcCount),
-      m_timeout(timeout)
-   {}
-
-   _ServiceBroker *m_this;
-   ServiceHost    *m_pSvcHost;
-   CSemaphore     *m_srvcCount;
-   btTime          m_timeout;
-};
-
 //=============================================================================
 // Name:          DoShutdown
 // Description:   This is the work horse of Shutdown
 // Interface:     public
 // Inputs:        rTranID,
-//                timeout - Max time hint
+//                timeout - Deadline for each Service, in milliseconds.
 // Outputs:
-// Comments:      Timeout currently not accurate but used as a hint
-//                Needs to call Shutdown on all of the loaded services in
-//                m_SrvcPkgMap, with asynchronous returns. Need timeouts to
-//                enable recovery in the case of one of them hanging.
+// Comments:      The Services are destroyed in parallel by ServiceShutdown,
+//                each given timeout. A Service that misses it is forced: its
+//                plug-in stays loaded and the release completes without it.
 //=============================================================================
 btBool _ServiceBroker::DoShutdown(TransactionID const &rTranID,
-                                    btTime               timeout)
+                                  btTime               timeout)
 {
-   CSemaphore     srvcCount;
-   Servicemap_itr itr;
-   btBool         ret = false;
+   ServiceShutdown Shutdown;
+   Servicemap_itr  itr;
 
-   btUnsigned32bitInt size = m_servicecount = static_cast<btUnsigned32bitInt>(m_ServiceMap.size());
-   if ( 0 == size ) {
-      timeout = 0;
+   {
+      AutoLock(this);
+      for ( itr = m_ServiceMap.begin() ; m_ServiceMap.end() != itr ; ++itr ) {
+         // If the IServiceModule is present
+         if ( NULL != (*itr).second->getProvider() ) {
+            Shutdown.Add((*itr).first, (*itr).second->getProvider());
+         }
+      }
    }
 
-   // Initialize the semaphore as a count up by initializing
-   //  count to a negative number.
-   //  The waiter will block until the semaphore
-   //  counts up to zero.
-   srvcCount.Create( - static_cast<btInt>(size) );
-
-   //-------------------------------------------------
-   // Iterate through the services shutting each down
-   // after issuing a shutdown on each wait for the
-   // services to complete
-   //-------------------------------------------------
-   for ( itr = m_ServiceMap.begin() ; size > 0 ; size--, itr++ ) {
+   btUnsignedInt Forced = Shutdown.Run(timeout);
 
-      // If the IServiceModule is present
-      if ( NULL != (*itr).second->getProvider() ) {
-
-         // Shutdown done in parallel so each gets same max-time
-         //   assume 0 time start so no timeout adjust performed
+   if ( Forced > 0 ) {
+      AAL_WARNING(LM_AAS, "_ServiceBroker::DoShutdown: " << Forced << " Service(s) forced: " << Shutdown.ToString() << std::endl);
+   } else {
+      AAL_INFO(LM_AAS, "_ServiceBroker::DoShutdown: " << Shutdown.ToString() << std::endl);
+   }
 
-         // Technically should join on these threads
-         new OSLThread(_ServiceBroker::ShutdownHandlerThread,
-                       OSLThread::THREADPRIORITY_NORMAL,
-                       new shutdown_handler_thread_parms(this, (*itr).second, &srvcCount, timeout));
+   {
+      AutoLock(this);
 
+      // Hosts without a provider had nothing to shut down.
+      for ( itr = m_ServiceMap.begin() ; m_ServiceMap.end() != itr ; ++itr ) {
+         if ( NULL == (*itr).second->getProvider() ) {
+            delete (*itr).second;
+         }
       }
-   }
 
-   srvcCount.Wait(timeout);
+      // Delete the Services which unloads the plug-ins (e.g.,so or dll), save
+      //  those forced, which may still have a thread inside.
+      for ( btUnsignedInt i = 0 ; i < Shutdown.Count() ; ++i ) {
+         ServiceShutdown::Record rec = Shutdown.Get(i);
+         if ( ServiceShutdown::Done != rec.Result ) {
+            continue;
+         }
+         itr = m_ServiceMap.find(rec.Name);
+         if ( m_ServiceMap.end() != itr ) {
+            delete (*itr).second;
+         }
+      }
 
-   {
-      AutoLock(this);
-      //------------------------------------------
-      // Send an event to the system event handler
-      //------------------------------------------
-      if ( m_servicecount > 0 ) {
+      if ( Forced > 0 ) {
          // Timed out - Shutdown did not succeed
-         getRuntime()->schedDispatchable(new CExceptionTransactionEvent(dynamic_cast<IBase *>(this),
-                                                                        exttranevtServiceShutdown,
-                                                                        rTranID,
-                                                                        errSystemTimeout,
-                                                                        reasSystemTimeout,
-                                                                        const_cast<btString>(strSystemTimeout)));
+         getRuntime()->schedDispatchable(new ServiceReleaseFailed(getServiceClient(),
+                                                                  new CExceptionTransactionEvent(dynamic_cast<IBase *>(this),
+                                                                                                 exttranevtServiceShutdown,
+                                                                                                 rTranID,
+                                                                                                 errSystemTimeout,
+                                                                                                 reasSystemTimeout,
+                                                                                                 const_cast<btString>(strSystemTimeout))));
       } else {
          // Generate the callback and finish the cleanup (performed in the Dispatchable)
          getRuntime()->schedDispatchable(new ServiceReleased(getServiceClient(),
                                                              this,
                                                              rTranID));
-
-         // Clear the map now
-         m_ServiceMap.clear();
-         return true;
       }
+
+      // Clear the map now
+      m_ServiceMap.clear();
    }
 
-   return false;
+   return 0 == Forced;
 }  // _ServiceBroker::DoShutdown
 
-void _ServiceBroker::ShutdownHandlerThread(OSLThread *pThread,
-                                           void      *pContext)
-{
-   //Get a pointer to this objects context
-   struct shutdown_handler_thread_parms *pparms =
-            static_cast<struct shutdown_handler_thread_parms *>(pContext);
-   _ServiceBroker *This = static_cast<_ServiceBroker *>(pparms->m_this);
-
-   This->ShutdownHandler(pparms->m_pSvcHost, *pparms->m_srvcCount);
-
-   // Destroy the thread and parms
-   delete pparms;
-   delete pThread;
-}
-
-//=============================================================================
-// Name: ShutdownHandler
-// Description: Services shutdown complete events
-//=============================================================================
-void _ServiceBroker::ShutdownHandler(ServiceHost *pSvcHost, CSemaphore &cnt)
-{
-   // get second ptr
-   IServiceModule *pProvider = pSvcHost->getProvider();
-
-   pProvider->Destroy();
-
-   {
-      AutoLock(this);
-      // Delete the service which unloads the plug-in (e.g.,so or dll)
-      // DEBUG_CERR("_ServiceBroker::ShutdownHandler: pLibrary = " << (void *)( pProvider ) << endl);
-
-      delete pSvcHost;
-      m_servicecount--;
-      cnt.Post(1);
-   }
-}
-
 END_NAMESPACE(AAL)
 
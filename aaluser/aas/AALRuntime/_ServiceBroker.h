@@ -58,8 +58,7 @@ class AALRUNTIME_API _ServiceBroker : public  ServiceBase,
 public:
    // Loadable Service
    DECLARE_AAL_SERVICE_CONSTRUCTOR(_ServiceBroker, ServiceBase),
-      m_pShutdownThread(NULL),
-      m_servicecount(0)
+      m_pShutdownThread(NULL)
    {
       if ( EObjOK != SetInterface(iidServiceBroker,
                                   dynamic_cast<IServiceBroker *>(this)) ) {
@@ -98,11 +97,7 @@ protected:
    static void ShutdownThread(OSLThread           *pThread, void  *pContext);
    btBool          DoShutdown(TransactionID const &rTranID, btTime timeout);
 
-   static void ShutdownHandlerThread(OSLThread   *pThread,  void       *pContext);
-   void              ShutdownHandler(ServiceHost *pSvcHost, CSemaphore &cnt);
-
    OSLThread          *m_pShutdownThread;
-   btUnsigned32bitInt  m_servicecount;
    ServiceMap          m_ServiceMap;
 };
 
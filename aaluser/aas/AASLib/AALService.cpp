@@ -363,7 +363,9 @@ btBool ServiceBase::startMDS()
    m_runMDT = true;
    m_pMDT   = new(std::nothrow) OSLThread(ServiceBase::_MessageDeliveryThread,
                                           OSLThread::THREADPRIORITY_ABOVE_NORMAL,
-                                          this);
+                                          this,
+                                          false,
+                                          OSLAffinity::InternalDefault());
    if ( NULL == m_pMDT ) {
       m_runMDT = false;
       return false;
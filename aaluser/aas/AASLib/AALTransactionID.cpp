@@ -54,7 +54,8 @@
 /// 12/08/2008     HM/JG    Added new TransactionID ctor and fixed random intID
 /// 01/04/2009     HM       Updated Copyright
 /// 08/12/2010     HM       Added new CTOR: Application specified ID and Handler
-/// 04/25/2014     JG       Added Support for IBase@endverbatim
+/// 04/25/2014     JG       Added Support for IBase
+/// 10/18/2016              NextUniqueID() no longer takes a lock@endverbatim
 //****************************************************************************
 #ifdef HAVE_CONFIG_H
 # include <config.h>
@@ -393,13 +394,16 @@ std::ostream & operator << (std::ostream &s, const TransactionID &TranID)
    return s;
 }
 
-btID            TransactionID::sm_NextUniqueID = 0;
-CriticalSection TransactionID::sm_CS;
+volatile btID TransactionID::sm_NextUniqueID = 0;
 
 btID TransactionID::NextUniqueID()
 {
-   AutoLock(&TransactionID::sm_CS);
-   return TransactionID::sm_NextUniqueID++;
+   // Every Service request and event takes one, so avoid serializing them on a lock.
+#if   defined( __AAL_WINDOWS__ )
+   return (btID)InterlockedExchangeAdd64((volatile LONGLONG *)&TransactionID::sm_NextUniqueID, 1);
+#elif defined( __AAL_LINUX__ )
+   return __sync_fetch_and_add(&TransactionID::sm_NextUniqueID, 1);
+#endif // OS
 }
 
 END_NAMESPACE(AAL)
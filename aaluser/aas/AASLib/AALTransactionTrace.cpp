@@ -0,0 +1,419 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// @file AALTransactionTrace.cpp
+/// @brief Transaction tracepoint collector.
+/// @ingroup Events
+/// @verbatim
+/// Accelerator Abstraction Layer
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version.@endverbatim
+//****************************************************************************
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include "aalsdk/AALTransactionTrace.h"
+#include "aalsdk/osal/CriticalSection.h"
+#include "aalsdk/osal/Thread.h"
+
+#include <new>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+
+#if defined( __AAL_LINUX__ )
+# include <time.h>
+#endif // __AAL_LINUX__
+
+BEGIN_NAMESPACE(AAL)
+
+// The ring. Slots are claimed with an atomic increment of sTraceNext; a
+//  slot's seq is 0 while it is being written and the claim number + 1 after.
+struct TransactionTraceSlot
+{
+   volatile btUnsigned64bitInt seq;
+   TransactionTraceRecord      rec;
+};
+
+static TransactionTraceSlot * volatile sTraceSlots = NULL;
+static btUnsigned64bitInt              sTraceMask  = 0;
+static volatile btUnsigned64bitInt     sTraceNext  = 0;
+static CriticalSection                 sTraceLock;   // Enable() and Reset()
+
+volatile btBool TransactionTrace::sm_bEnabled = false;
+
+static void TraceFence()
+{
+#if   defined( __AAL_WINDOWS__ )
+   MemoryBarrier();
+#elif defined( __AAL_LINUX__ )
+   __sync_synchronize();
+#endif // OS
+}
+
+static btUnsigned64bitInt TraceClaim()
+{
+#if   defined( __AAL_WINDOWS__ )
+   return (btUnsigned64bitInt)InterlockedExchangeAdd64((volatile LONGLONG *)&sTraceNext, 1);
+#elif defined( __AAL_LINUX__ )
+   return __sync_fetch_and_add(&sTraceNext, 1);
+#endif // OS
+}
+
+static btUnsigned64bitInt TraceNanos()
+{
+#if   defined( __AAL_WINDOWS__ )
+   static LARGE_INTEGER freq = { 0 };
+   LARGE_INTEGER        now;
+   if ( 0 == freq.QuadPart ) {
+      QueryPerformanceFrequency(&freq);
+   }
+   QueryPerformanceCounter(&now);
+   return (btUnsigned64bitInt)( (double)now.QuadPart * 1.0e9 / (double)freq.QuadPart );
+#elif defined( __AAL_LINUX__ )
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (btUnsigned64bitInt)ts.tv_sec * 1000000000ULL + (btUnsigned64bitInt)ts.tv_nsec;
+#endif // OS
+}
+
+btBool TransactionTrace::Enable(btUnsigned32bitInt Capacity)
+{
+   AutoLock(&sTraceLock);
+
+   if ( NULL == sTraceSlots ) {
+      btUnsigned64bitInt n = 1;
+      while ( n < Capacity ) {
+         n <<= 1;
+      }
+
+      // Never freed: a tracepoint may still be writing after Disable().
+      TransactionTraceSlot *pSlots = new(std::nothrow) TransactionTraceSlot[n];
+      if ( NULL == pSlots ) {
+         return false;
+      }
+      memset(pSlots, 0, (size_t)n * sizeof(TransactionTraceSlot));
+
+      sTraceMask  = n - 1;
+      TraceFence();
+      sTraceSlots = pSlots;
+   }
+
+   sm_bEnabled = true;
+   return true;
+}
+
+void TransactionTrace::Disable()
+{
+   sm_bEnabled = false;
+}
+
+void TransactionTrace::Reset()
+{
+   AutoLock(&sTraceLock);
+
+   TransactionTraceSlot *pSlots = sTraceSlots;
+   if ( NULL == pSlots ) {
+      return;
+   }
+
+   for ( btUnsigned64bitInt i = 0 ; i <= sTraceMask ; ++i ) {
+      pSlots[i].seq = 0;
+   }
+   sTraceNext = 0;
+   TraceFence();
+}
+
+void TransactionTrace::Record(btUnsigned32bitInt Stage, btID ID)
+{
+   TransactionTraceSlot *pSlots = sTraceSlots;
+   if ( NULL == pSlots ) {
+      return;
+   }
+
+   btUnsigned64bitInt    n = TraceClaim();
+   TransactionTraceSlot &s = pSlots[n & sTraceMask];
+
+   s.seq = 0;
+   TraceFence();
+   s.rec.ID     = ID;
+   s.rec.Nanos  = TraceNanos();
+   s.rec.Thread = GetThreadID();
+   s.rec.Stage  = Stage;
+   TraceFence();
+   s.seq = n + 1;
+}
+
+btcString TransactionTrace::StageName(btUnsigned32bitInt Stage)
+{
+   static const char * const names[] =
+   {
+      "runtime.allocService",
+      "broker.allocService",
+      "host.instantiate",
+      "host.instantiated",
+      "aia.send",
+      "aia.sent",
+      "aia.upstream",
+      "dispatch",
+      "ali.bufferAllocate",
+      "ali.bufferAllocated",
+      "ali.reconfigure"
+   };
+   static const char * const user[] =
+   {
+      "user.0",  "user.1",  "user.2",  "user.3",
+      "user.4",  "user.5",  "user.6",  "user.7",
+      "user.8",  "user.9",  "user.10", "user.11",
+      "user.12", "user.13", "user.14", "user.15"
+   };
+
+   if ( Stage < sizeof(names) / sizeof(names[0]) ) {
+      return names[Stage];
+   }
+   if ( ( Stage >= txtraceUser ) && ( Stage < txtraceMaxStage ) ) {
+      return user[Stage - txtraceUser];
+   }
+   return "unknown";
+}
+
+btUnsigned64bitInt TransactionTrace::Recorded()
+{
+   return sTraceNext;
+}
+
+btUnsigned64bitInt TransactionTrace::Capacity()
+{
+   return ( NULL == sTraceSlots ) ? 0 : sTraceMask + 1;
+}
+
+// Time order; claim order breaks ties.
+struct TransactionTraceSeqRecord
+{
+   btUnsigned64bitInt     seq;
+   TransactionTraceRecord rec;
+
+   bool operator < (const TransactionTraceSeqRecord &rhs) const
+   {
+      if ( rec.Nanos != rhs.rec.Nanos ) {
+         return rec.Nanos < rhs.rec.Nanos;
+      }
+      return seq < rhs.seq;
+   }
+};
+
+void TransactionTrace::Snapshot(std::vector<TransactionTraceRecord> &rRecords)
+{
+   rRecords.clear();
+
+   TransactionTraceSlot *pSlots = sTraceSlots;
+   if ( NULL == pSlots ) {
+      return;
+   }
+
+   std::vector<TransactionTraceSeqRecord> v;
+   v.reserve((size_t)sTraceMask + 1);
+
+   for ( btUnsigned64bitInt i = 0 ; i <= sTraceMask ; ++i ) {
+      const TransactionTraceSlot &s = pSlots[i];
+
+      TransactionTraceSeqRecord r;
+      r.seq = s.seq;
+      if ( 0 == r.seq ) {
+         continue;   // empty, or being written
+      }
+      TraceFence();
+      r.rec = s.rec;
+      TraceFence();
+      if ( r.seq == s.seq ) {
+         v.push_back(r);
+      }
+   }
+
+   std::sort(v.begin(), v.end());
+
+   rRecords.reserve(v.size());
+   std::vector<TransactionTraceSeqRecord>::const_iterator itr;
+   for ( itr = v.begin() ; v.end() != itr ; ++itr ) {
+      rRecords.push_back(itr->rec);
+   }
+}
+
+void TransactionTrace::Timelines(TransactionTimelines &rTimelines)
+{
+   std::vector<TransactionTraceRecord> records;
+   Snapshot(records);
+
+   rTimelines.clear();
+   std::vector<TransactionTraceRecord>::const_iterator itr;
+   for ( itr = records.begin() ; records.end() != itr ; ++itr ) {
+      rTimelines[itr->ID].push_back(*itr);
+   }
+}
+
+void TransactionTrace::StageLatencies(std::vector<TransactionTraceHistogram> &rHistograms)
+{
+   typedef std::map< std::pair<btUnsigned32bitInt, btUnsigned32bitInt>, TransactionTraceHistogram > HistMap;
+
+   TransactionTimelines timelines;
+   HistMap              hists;
+
+   Timelines(timelines);
+
+   TransactionTimelines::const_iterator tl;
+   for ( tl = timelines.begin() ; timelines.end() != tl ; ++tl ) {
+      const TransactionTimeline &t = tl->second;
+
+      for ( size_t i = 1 ; i < t.size() ; ++i ) {
+         const std::pair<btUnsigned32bitInt, btUnsigned32bitInt> key(t[i - 1].Stage, t[i].Stage);
+         const btUnsigned64bitInt                                d = t[i].Nanos - t[i - 1].Nanos;
+
+         HistMap::iterator h = hists.find(key);
+         if ( hists.end() == h ) {
+            TransactionTraceHistogram empty;
+            memset(&empty, 0, sizeof(empty));
+            empty.From     = key.first;
+            empty.To       = key.second;
+            empty.MinNanos = d;
+            h = hists.insert(HistMap::value_type(key, empty)).first;
+         }
+
+         TransactionTraceHistogram &hist = h->second;
+
+         btUnsigned32bitInt b = 0;
+         for ( btUnsigned64bitInt v = d ; ( 0 != v ) && ( b < TransactionTraceHistogram::Buckets - 1 ) ; v >>= 1 ) {
+            ++b;
+         }
+
+         ++hist.Count;
+         ++hist.Bucket[b];
+         hist.TotalNanos += d;
+         if ( d < hist.MinNanos ) {
+            hist.MinNanos = d;
+         }
+         if ( d > hist.MaxNanos ) {
+            hist.MaxNanos = d;
+         }
+      }
+   }
+
+   rHistograms.clear();
+   HistMap::const_iterator itr;
+   for ( itr = hists.begin() ; hists.end() != itr ; ++itr ) {
+      rHistograms.push_back(itr->second);
+   }
+}
+
+btUnsigned64bitInt TransactionTraceHistogram::Percentile(double Fraction) const
+{
+   if ( 0 == Count ) {
+      return 0;
+   }
+
+   const double       want = Fraction * (double)Count;
+   btUnsigned64bitInt seen = 0;
+
+   for ( btUnsigned32bitInt i = 0 ; i < Buckets ; ++i ) {
+      seen += Bucket[i];
+      if ( ( seen > 0 ) && ( (double)seen >= want ) ) {
+         btUnsigned64bitInt upper = (btUnsigned64bitInt)1 << i;
+         return ( upper < MaxNanos ) ? upper : MaxNanos;
+      }
+   }
+   return MaxNanos;
+}
+
+// Microseconds since base, as Chrome's ts and dur expect.
+static void ChromeMicros(std::ostream &os, btUnsigned64bitInt nanos)
+{
+   os << nanos / 1000 << '.' << std::setw(3) << std::setfill('0') << nanos % 1000 << std::setfill(' ');
+}
+
+btBool TransactionTrace::WriteChromeTrace(std::ostream &os)
+{
+   TransactionTimelines timelines;
+   Timelines(timelines);
+
+   btUnsigned64bitInt base = 0;
+   btBool             first = true;
+
+   TransactionTimelines::const_iterator tl;
+   for ( tl = timelines.begin() ; timelines.end() != tl ; ++tl ) {
+      if ( first || ( tl->second.front().Nanos < base ) ) {
+         base  = tl->second.front().Nanos;
+         first = false;
+      }
+   }
+
+   os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" << std::endl;
+   os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"AAL transactions\"}}";
+
+   for ( tl = timelines.begin() ; timelines.end() != tl ; ++tl ) {
+      const btID                 id = tl->first;
+      const TransactionTimeline &t  = tl->second;
+
+      os << "," << std::endl
+         << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << id
+         << ",\"args\":{\"name\":\"txn " << id << "\"}}";
+
+      for ( size_t i = 0 ; i < t.size() ; ++i ) {
+         os << "," << std::endl
+            << "{\"name\":\"" << StageName(t[i].Stage) << "\",\"cat\":\"aal\",\"ph\":\"i\",\"s\":\"t\",\"ts\":";
+         ChromeMicros(os, t[i].Nanos - base);
+         os << ",\"pid\":1,\"tid\":" << id << ",\"args\":{\"thread\":" << t[i].Thread << "}}";
+
+         if ( i > 0 ) {
+            os << "," << std::endl
+               << "{\"name\":\"" << StageName(t[i - 1].Stage) << " -> " << StageName(t[i].Stage)
+               << "\",\"cat\":\"aal\",\"ph\":\"X\",\"ts\":";
+            ChromeMicros(os, t[i - 1].Nanos - base);
+            os << ",\"dur\":";
+            ChromeMicros(os, t[i].Nanos - t[i - 1].Nanos);
+            os << ",\"pid\":1,\"tid\":" << id
+               << ",\"args\":{\"from_thread\":" << t[i - 1].Thread << ",\"to_thread\":" << t[i].Thread << "}}";
+         }
+      }
+   }
+
+   os << std::endl << "]}" << std::endl;
+   return os.good();
+}
+
+btBool TransactionTrace::WriteChromeTrace(btcString Path)
+{
+   std::ofstream f(Path);
+   if ( !f.is_open() ) {
+      return false;
+   }
+   return WriteChromeTrace(f);
+}
+
+END_NAMESPACE(AAL)
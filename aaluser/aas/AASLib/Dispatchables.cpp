@@ -44,6 +44,7 @@
 //#include "_RuntimeImpl.h"
 #include "aalsdk/CAALEvent.h"
 #include "aalsdk/aas/Dispatchables.h"
+#include "aalsdk/AALTransactionTrace.h"
 
 /// @addtogroup AAL Runtime
 /// @{
@@ -68,6 +69,8 @@ void ServiceAllocated::operator() ()
    IServiceClient *pSvcClient = NULL;
    IRuntimeClient *pRTClient  = NULL;
 
+   AAL_TRACE_TRANSACTION(txtraceDispatch, m_TranID.ID());
+
    // Process the TransactionID.
    if ( NULL != m_TranID.Ibase() ) {
       pSvcClient = dynamic_ptr<IServiceClient>(iidServiceClient, m_TranID.Ibase());
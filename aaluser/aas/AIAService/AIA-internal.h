@@ -44,6 +44,7 @@
 #include <aalsdk/uaia/IAFUProxy.h>                 // AFUProxy
 
 #include <aalsdk/INTCDefs.h>                       // AIA IDs
+#include <aalsdk/AALTransactionTrace.h>             // AAL_TRACE_TRANSACTION
 
 #include "UIDriverInterfaceAdapter.h"              // UIDriverInterfaceAdapter
 #include "AIATransactions.h"
@@ -84,6 +85,7 @@ void operator() ()
 {
    // Process TransactionID
    const TransactionID &msgTid = dynamic_cast<const IUIDriverEvent*>(evtUIDriverClientEvent, m_pEvent)->msgTranID(); // FIXME check for errors
+   AAL_TRACE_TRANSACTION(txtraceDispatch, msgTid.ID());
    if (msgTid.Filter() && msgTid.Handler() != NULL) {
       msgTid.Handler()(*m_pEvent);
    } else {
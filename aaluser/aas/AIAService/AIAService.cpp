@@ -170,7 +170,9 @@ btBool AIAService::init( IBase *pclientBase,
       // Create the Message delivery thread
       m_pMDT = new OSLThread(AIAService::MessageDeliveryThread,
                              OSLThread::THREADPRIORITY_NORMAL,
-                             this);
+                             this,
+                             false,
+                             OSLAffinity::InternalDefault());
 
       // Make sure that the kernel pipe to the database is open.
       //  The Wait is posted in the AIAService:MessageDeliveryThread
@@ -432,6 +434,7 @@ AIAService::Process_Event()
 
    while(m_uida.GetMessage(pMessage) != false) {
       AAL_DEBUG(LM_UAIA, "AIAService::Process_Event: GetMessage Returned\n");
+      AAL_TRACE_TRANSACTION(txtraceAIAUpstream, pMessage->tranID().m_intID);
       if (pMessage->result_code() != uid_errnumOK) {
          AAL_WARNING(LM_UAIA, "AIAService::Process_Event: pMessage->result_code() is not uid_errnumOK, but is " <<
                   pMessage->result_code() << std::endl);
@@ -141,6 +141,31 @@ btBool ALIAFUProxy::SendTransaction(IAIATransaction *pAFUmessage)
    return true;  /// SendMessage is a void TDO cleanup
 }
 
+//=============================================================================
+// Name: SendTransactions
+// Description: Queue a batch of messages to the device
+// Inputs: rBatch - Transactions to send
+// Outputs: true - queued
+// Comments: Each transaction is sent through SendTransaction() on one of the
+//           queue's submission threads, so the caller does not wait on the
+//           driver. Submit() only queues, so the lock is held across it to
+//           keep Release() from deleting the queue underneath.
+//=============================================================================
+btBool ALIAFUProxy::SendTransactions(AIATransactionBatch &rBatch)
+{
+   AutoLock(this);
+   if ( m_bReleasing ) {
+      return false;
+   }
+   if ( NULL == m_pQueue ) {
+      m_pQueue = new(std::nothrow) AIATransactionQueue(this);
+      if ( NULL == m_pQueue ) {
+         return false;
+      }
+   }
+   return m_pQueue->Submit(rBatch);
+}
+
 
 
 AAL::btBool ALIAFUProxy::MapWSID(AAL::btWSSize Size, AAL::btWSID wsid, AAL::btVirtAddr *pRet, AAL::NamedValueSet const &optArgs)
@@ -211,6 +236,19 @@ void ALIAFUProxy::AFUEvent( AAL::IEvent const &theEvent)
 //=============================================================================
 btBool ALIAFUProxy::Release(AAL::TransactionID const &rtid, AAL::btTime timeout)
 {
+   // Send whatever is still queued before unbinding. No submission can
+   //  start once the queue is taken, so it is deleted outside the lock.
+   AIATransactionQueue *pQueue;
+   {
+      AutoLock(this);
+      m_bReleasing = true;
+      pQueue       = m_pQueue;
+      m_pQueue     = NULL;
+   }
+   if ( NULL != pQueue ) {
+      delete pQueue;
+   }
+
    UnBindAFUDevice ReleaseMessage(rtid);
    m_pAIA->SendMessage(m_devHandle, &ReleaseMessage, dynamic_cast<IAFUProxyClient*>(this) );
    return true;
@@ -41,6 +41,7 @@
 #include <aalsdk/aas/AALService.h>
 #include <aalsdk/INTCDefs.h>
 #include <aalsdk/uaia/IAFUProxy.h>
+#include <aalsdk/uaia/AIATransactionQueue.h>
 
 #include "AIA-internal.h"
 
@@ -63,7 +64,9 @@ public:
       m_pClient(NULL),
       m_pAIABase(NULL),
       m_pAIA(NULL),
-      m_devHandle(NULL)
+      m_devHandle(NULL),
+      m_pQueue(NULL),
+      m_bReleasing(false)
    {
       if ( EObjOK != SetInterface(iidAFUProxy, dynamic_cast<IAFUProxy *>(this)) ) {
          m_bIsOK = false;         // CAASBase set it to true
@@ -83,6 +86,9 @@ public:
    // Send a message to the device
    AAL::btBool SendTransaction( IAIATransaction *pAFUmessage);
 
+   // Queue a batch of messages for the submission threads
+   AAL::btBool SendTransactions( AIATransactionBatch &rBatch );
+
    // Map/Unmap Workspace IDs to virtual memory addresses
    AAL::btBool MapWSID(AAL::btWSSize             Size,
                        AAL::btWSID               wsid,
@@ -100,6 +106,8 @@ protected:
    AAL::IBase            *m_pAIABase;
    AIAService            *m_pAIA;
    btHANDLE               m_devHandle;
+   AIATransactionQueue   *m_pQueue;        // Created by the first SendTransactions()
+   AAL::btBool            m_bReleasing;    // Set by Release(); no more SendTransactions()
 };
 
 END_NAMESPACE(AAL)
@@ -44,6 +44,7 @@
 
 #include "aalsdk/AALLoggerExtern.h"
 #include "aalsdk/kernel/ccipdriver.h"
+#include "aalsdk/AALTransactionTrace.h"
 
 #include "UIDriverInterfaceAdapter.h"
 
@@ -53,6 +54,7 @@ btBool UIDriverInterfaceAdapter::MapWSID(btWSSize Size, btWSID wsid, btVirtAddr
 {
    void *pTargetVirtAddr;       // requested virtual address for the mapping
    int mmapFlags;               // mmap flags
+   int mmapProt;                // mmap protection
 
    ASSERT(NULL != pRet);
    if (NULL == pRet)
@@ -68,6 +70,13 @@ btBool UIDriverInterfaceAdapter::MapWSID(btWSSize Size, btWSID wsid, btVirtAddr
       pTargetVirtAddr = NULL;    // no mapping requested
       mmapFlags = MAP_SHARED;
    }
+
+   btBool bReadOnly = false;
+   if ( ( ENamedValuesOK == optArgs.Get(ALI_MMAP_READONLY, &bReadOnly) ) && bReadOnly ) {
+      mmapProt = PROT_READ;
+   } else {
+      mmapProt = PROT_READ | PROT_WRITE;
+   }
 #elif defined( __AAL_WINDOWS__ )
 #pragma message("***NEED A WINDOWS IMPLEMENTATION??***")
 #else
@@ -110,7 +119,7 @@ btBool UIDriverInterfaceAdapter::MapWSID(btWSSize Size, btWSID wsid, btVirtAddr
    CloseHandle(hEvent);    
    return true;
 #elif defined( __AAL_LINUX__ )
-   *pRet = (btVirtAddr)mmap(pTargetVirtAddr, Size, PROT_READ | PROT_WRITE, mmapFlags, m_fdClient, wsid);
+   *pRet = (btVirtAddr)mmap(pTargetVirtAddr, Size, mmapProt, mmapFlags, m_fdClient, wsid);
    if ( (btVirtAddr)MAP_FAILED == *pRet ) {
       *pRet = NULL;
       return false;
@@ -140,6 +149,8 @@ UIDriverInterfaceAdapter::UIDriverInterfaceAdapter() :
    m_hClient(INVALID_HANDLE_VALUE),
 #elif defined( __AAL_LINUX__ )
    m_fdClient(-1),
+   m_pEvtRing(NULL),
+   m_bSendDirect(false),
 #endif // OS
    m_bIsOK(false)
 {}
@@ -316,6 +327,27 @@ void UIDriverInterfaceAdapter::Open(const char *devName)
       return;
    }
 
+   // Ask once whether the driver has SENDMSG_DIRECT. The probe carries no
+   //  descriptor, so it reaches no handler on either kind of driver.
+   struct ccipui_ioctlreq probe;
+   memset(&probe, 0, sizeof(probe));
+   m_bSendDirect = ( -1 != ioctl(m_fdClient, AALUID_IOCTL_SENDMSG_DIRECT, &probe) );
+   if ( !m_bSendDirect ) {
+      AAL_INFO(LM_UAIA, "UIDriverInterfaceAdapter::Open: driver has no SENDMSG_DIRECT, copying messages" << std::endl);
+   }
+
+   // Map the event ring. A driver without one fails the mmap and every
+   //  event comes through GETMSG instead.
+   void *pRing = mmap(NULL, sizeof(struct ccipui_evtring), PROT_READ | PROT_WRITE, MAP_SHARED,
+                      m_fdClient, CCIPUI_EVTRING_MMAP_OFFSET);
+   if ( MAP_FAILED != pRing ) {
+      m_pEvtRing = reinterpret_cast<struct ccipui_evtring *>(pRing);
+      if ( CCIPUI_EVTRING_MAGIC != m_pEvtRing->magic ) {
+         munmap(pRing, sizeof(struct ccipui_evtring));
+         m_pEvtRing = NULL;
+      }
+   }
+
 #endif // OS
 
    m_bIsOK = true;
@@ -336,6 +368,11 @@ void UIDriverInterfaceAdapter::Close() {
 
 #elif defined( __AAL_LINUX__ )
 
+   if ( NULL != m_pEvtRing ) {
+      munmap(m_pEvtRing, sizeof(struct ccipui_evtring));
+      m_pEvtRing = NULL;
+   }
+
    if ( m_fdClient >= 0 ) {
       close(m_fdClient);
       m_fdClient = -1;
@@ -475,6 +512,31 @@ FAILED: // If got here then DeviceIoControl failed.
       {
          AutoLock(this);
 
+         // Drain the event ring first. It needs no system call, and the
+         //  driver refuses GETMSG_DESC while the ring holds events.
+         if ( NULL != m_pEvtRing ) {
+            struct ccipui_evtslot *pslot = ccipui_evtring_peek(m_pEvtRing);
+            if ( NULL != pslot ) {
+               btWSSize size = pslot->hdr.size;
+               if ( size > CCIPUI_EVTRING_PAYLOAD_MAX ) {
+                  size = CCIPUI_EVTRING_PAYLOAD_MAX;
+               }
+
+               uidrvMessagep->size(size);
+
+               struct ccipui_ioctlreq *reqp = uidrvMessagep->GetReqp();
+               reqp->id      = pslot->hdr.id;
+               reqp->errcode = pslot->hdr.errcode;
+               reqp->handle  = pslot->hdr.handle;
+               reqp->context = pslot->hdr.context;
+               reqp->tranID  = pslot->hdr.tranID;
+               memcpy(aalui_ioctlPayload(reqp), pslot->payload, size);
+
+               ccipui_evtring_release(m_pEvtRing);
+               return true;
+            }
+         }
+
          // Check for messages first
          memset(&ioctlMessage,0, sizeof(struct ccipui_ioctlreq));
          if( ( ret = ioctl(m_fdClient, AALUID_IOCTL_GETMSG_DESC, &ioctlMessage) ) == 0 ) {
@@ -525,8 +587,6 @@ btBool UIDriverInterfaceAdapter::SendMessage(AAL::btHANDLE devHandle,
    int cmd;
 #endif
 
-   AutoLock(this);
-
    if ( !IsOK() ) {
       return false;
    }
@@ -558,6 +618,49 @@ btBool UIDriverInterfaceAdapter::SendMessage(AAL::btHANDLE devHandle,
          break;
    }
 
+   const btID traceID = pMessage->getTranID().m_intID;
+   AAL_TRACE_TRANSACTION(txtraceAIASend, traceID);
+
+#if defined( __AAL_LINUX__ )
+   if ( ( AALUID_IOCTL_SENDMSG == cmd ) && m_bSendDirect ) {
+      // Send the header with a descriptor of the transaction's payload buffer.
+      //  The driver reads the request from that buffer and writes the response
+      //  straight back into it, so there is nothing to marshal or copy here.
+      //  Everything is on the stack, so no lock is taken and messages from
+      //  several threads (see AIATransactionQueue) reach the driver together.
+      //  m_bSendDirect is only set by Open(), before any message is sent.
+      btUnsigned64bitInt msg[(sizeof(struct ccipui_ioctlreq) + sizeof(struct ccipui_directpayload) + 7) / 8];
+
+      struct ccipui_ioctlreq      *reqp    = reinterpret_cast<struct ccipui_ioctlreq *>(msg);
+      struct ccipui_directpayload *directp = reinterpret_cast<struct ccipui_directpayload *>(aalui_ioctlPayload(reqp));
+
+      reqp->id      = pMessage->getMsgID();
+      reqp->tranID  = pMessage->getTranID();
+      reqp->handle  = devHandle;
+      reqp->context = pProxyClient;
+      reqp->errcode = uid_errnumOK;
+      reqp->size    = sizeof(struct ccipui_directpayload);
+
+      directp->addr = (btUnsigned64bitInt)(uintptr_t)pMessage->getPayloadPtr();
+      directp->size = pMessage->getPayloadSize();
+
+      // The request reached the driver either way, so a failure is the
+      //  request's own and is returned as it is on the copying path.
+      if ( -1 == ioctl(m_fdClient, AALUID_IOCTL_SENDMSG_DIRECT, reqp) ) {
+         perror("UIDriverInterfaceAdapter::SendMessage");
+         AutoLock(this);
+         m_bIsOK = false;
+         reqp->errcode = uid_errnumInvalidRequest;
+      }
+
+      pMessage->setErrno(reqp->errcode);
+      AAL_TRACE_TRANSACTION(txtraceAIASent, traceID);
+      return true;
+   }
+#endif // __AAL_LINUX__
+
+   AutoLock(this);
+
    // Build the low level message
    struct ccipui_ioctlreq *reqp = reinterpret_cast<struct ccipui_ioctlreq *> (new char[ sizeof(struct ccipui_ioctlreq) + pMessage->getPayloadSize() ]);
 
@@ -609,6 +712,7 @@ btBool UIDriverInterfaceAdapter::SendMessage(AAL::btHANDLE devHandle,
 #endif // OS
 
    delete [] reqp;
+   AAL_TRACE_TRANSACTION(txtraceAIASent, traceID);
    return true;
 }  // UIDriverInterfaceAdapter::SendMessage
 
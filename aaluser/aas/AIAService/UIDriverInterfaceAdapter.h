@@ -61,6 +61,11 @@
 #define ALI_MMAP_TARGET_VADDR "ALIMmapTargetVAddr"
 #endif
 
+// NVS key for a read-only mapping in MapWSID()
+#ifndef ALI_MMAP_READONLY
+#define ALI_MMAP_READONLY "ALIMmapReadOnly"
+#endif
+
 BEGIN_NAMESPACE(AAL)
 
 //==========================================================================
@@ -102,6 +107,8 @@ class AIASERVICE_API UIDriverInterfaceAdapter : private CriticalSection,
       HANDLE m_hClient;
       #elif defined( __AAL_LINUX__ )
       AAL::btInt  m_fdClient;
+      struct ccipui_evtring *m_pEvtRing;  // Shared event ring, or NULL if the driver has none
+      AAL::btBool            m_bSendDirect; // the driver has SENDMSG_DIRECT, found by Open()
       #endif // OS
 
       AAL::btBool m_bIsOK;
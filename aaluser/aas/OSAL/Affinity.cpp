@@ -0,0 +1,353 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// @file Affinity.cpp
+/// @brief CPU and NUMA node placement for threads.
+/// @ingroup OSAL
+/// @verbatim
+/// Accelerator Abstraction Layer
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version. @endverbatim
+//****************************************************************************
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include "aalsdk/osal/Affinity.h"
+#include "aalsdk/osal/Thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sstream>
+
+#if defined( __AAL_LINUX__ )
+# include <sched.h>          // cpu_set_t
+# include <pthread.h>        // pthread_setaffinity_np
+# include <unistd.h>
+# include <sys/syscall.h>    // SYS_getcpu
+#endif // __AAL_LINUX__
+
+BEGIN_NAMESPACE(AAL)
+
+OSLAffinity     OSLAffinity::sm_InternalDefault;
+CriticalSection OSLAffinity::sm_Lock;
+
+#if defined( __AAL_LINUX__ )
+
+// Reads the first line of a sysfs file, without the newline.
+static btBool ReadSysfsLine(const char *path, std::string &rLine)
+{
+   FILE *fp = fopen(path, "r");
+   if ( NULL == fp ) {
+      return false;
+   }
+
+   char   buf[4096];
+   btBool res = ( NULL != fgets(buf, sizeof(buf), fp) );
+   fclose(fp);
+
+   if ( res ) {
+      buf[strcspn(buf, "\n")] = '\0';
+      rLine = buf;
+   }
+   return res;
+}
+
+#endif // __AAL_LINUX__
+
+OSLAffinity::OSLAffinity() :
+   m_bIsOK(true),
+   m_Node(-1)
+{
+   memset(m_CPUs, 0, sizeof(m_CPUs));
+}
+
+OSLAffinity::OSLAffinity(btcString Spec) :
+   m_bIsOK(true),
+   m_Node(-1)
+{
+   memset(m_CPUs, 0, sizeof(m_CPUs));
+
+   if ( ( NULL == Spec ) || ( '\0' == *Spec ) ) {
+      return;
+   }
+
+   if ( 0 == strncmp(Spec, "node:", 5) ) {
+      char *end = NULL;
+      long  n   = strtol(Spec + 5, &end, 10);
+      if ( ( end == Spec + 5 ) || ( '\0' != *end ) || ( n < 0 ) ) {
+         m_bIsOK = false;
+         return;
+      }
+      m_Node = (btInt)n;
+      return;
+   }
+
+   m_bIsOK = ParseCPUList(Spec);
+}
+
+OSLAffinity OSLAffinity::NUMANode(btInt Node)
+{
+   OSLAffinity a;
+   if ( Node < 0 ) {
+      a.m_bIsOK = false;
+   } else {
+      a.m_Node = Node;
+   }
+   return a;
+}
+
+// List is comma-separated CPU numbers and inclusive ranges, eg "0-3,8".
+btBool OSLAffinity::ParseCPUList(btcString List)
+{
+   const char *p = List;
+
+   while ( '\0' != *p ) {
+      char *end   = NULL;
+      long  first = strtol(p, &end, 10);
+      long  last  = first;
+
+      if ( ( end == p ) || ( first < 0 ) ) {
+         return false;
+      }
+      p = end;
+
+      if ( '-' == *p ) {
+         ++p;
+         last = strtol(p, &end, 10);
+         if ( ( end == p ) || ( last < first ) ) {
+            return false;
+         }
+         p = end;
+      }
+
+      if ( last >= MaxCPUs ) {
+         return false;
+      }
+
+      for ( long cpu = first ; cpu <= last ; ++cpu ) {
+         m_CPUs[cpu / 64] |= (btUnsigned64bitInt)1 << ( cpu % 64 );
+      }
+
+      if ( ',' == *p ) {
+         ++p;
+      } else if ( '\0' != *p ) {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+btBool OSLAffinity::IsSet() const
+{
+   if ( !m_bIsOK ) {
+      return false;
+   }
+   if ( m_Node >= 0 ) {
+      return true;
+   }
+   for ( btUnsignedInt i = 0 ; i < sizeof(m_CPUs) / sizeof(m_CPUs[0]) ; ++i ) {
+      if ( 0 != m_CPUs[i] ) {
+         return true;
+      }
+   }
+   return false;
+}
+
+btBool OSLAffinity::AddCPU(btUnsignedInt CPU)
+{
+   if ( CPU >= MaxCPUs ) {
+      return false;
+   }
+   m_Node   = -1;
+   m_bIsOK  = true;
+   m_CPUs[CPU / 64] |= (btUnsigned64bitInt)1 << ( CPU % 64 );
+   return true;
+}
+
+btBool OSLAffinity::HasCPU(btUnsignedInt CPU) const
+{
+   if ( CPU >= MaxCPUs ) {
+      return false;
+   }
+   return 0 != ( m_CPUs[CPU / 64] & ( (btUnsigned64bitInt)1 << ( CPU % 64 ) ) );
+}
+
+btBool OSLAffinity::Apply() const
+{
+   return Apply(GetThreadID());
+}
+
+btBool OSLAffinity::Apply(btTID tid) const
+{
+   if ( !IsSet() ) {
+      return m_bIsOK;
+   }
+
+   // A node placement is resolved to its CPUs each time it is applied.
+   OSLAffinity cpus;
+   if ( m_Node >= 0 ) {
+#if   defined( __AAL_LINUX__ )
+      char        path[64];
+      std::string list;
+      snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", m_Node);
+      if ( !ReadSysfsLine(path, list) || !cpus.ParseCPUList(list.c_str()) || !cpus.IsSet() ) {
+         return false;
+      }
+#elif defined( __AAL_WINDOWS__ )
+      ULONGLONG mask = 0;
+      if ( !GetNumaNodeProcessorMask((UCHAR)m_Node, &mask) || ( 0 == mask ) ) {
+         return false;
+      }
+      cpus.m_CPUs[0] = (btUnsigned64bitInt)mask;
+#endif // OS
+   } else {
+      cpus = *this;
+   }
+
+#if   defined( __AAL_LINUX__ )
+
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   for ( btUnsignedInt cpu = 0 ; ( cpu < MaxCPUs ) && ( cpu < CPU_SETSIZE ) ; ++cpu ) {
+      if ( cpus.HasCPU(cpu) ) {
+         CPU_SET(cpu, &set);
+      }
+   }
+   return 0 == pthread_setaffinity_np((pthread_t)tid, sizeof(set), &set);
+
+#elif defined( __AAL_WINDOWS__ )
+
+   // Windows places threads within a 64-CPU processor group.
+   HANDLE h = OpenThread(THREAD_SET_INFORMATION | THREAD_QUERY_INFORMATION, FALSE, (DWORD)tid);
+   if ( NULL == h ) {
+      return false;
+   }
+   btBool res = ( 0 != SetThreadAffinityMask(h, (DWORD_PTR)cpus.m_CPUs[0]) );
+   CloseHandle(h);
+   return res;
+
+#endif // OS
+}
+
+std::string OSLAffinity::ToString() const
+{
+   std::ostringstream oss;
+
+   if ( m_Node >= 0 ) {
+      oss << "node:" << m_Node;
+      return oss.str();
+   }
+
+   btInt first = -1;
+   for ( btInt cpu = 0 ; cpu <= MaxCPUs ; ++cpu ) {
+      btBool bIn = ( cpu < MaxCPUs ) && HasCPU((btUnsignedInt)cpu);
+      if ( bIn && ( first < 0 ) ) {
+         first = cpu;
+      } else if ( !bIn && ( first >= 0 ) ) {
+         if ( !oss.str().empty() ) {
+            oss << ',';
+         }
+         oss << first;
+         if ( cpu - 1 > first ) {
+            oss << '-' << cpu - 1;
+         }
+         first = -1;
+      }
+   }
+
+   return oss.str();
+}
+
+btInt OSLAffinity::NumNodes()
+{
+#if   defined( __AAL_LINUX__ )
+
+   std::string list;
+   OSLAffinity nodes;
+   if ( !ReadSysfsLine("/sys/devices/system/node/possible", list) || !nodes.ParseCPUList(list.c_str()) ) {
+      return 1;
+   }
+
+   btInt n = 0;
+   for ( btUnsignedInt i = 0 ; i < MaxCPUs ; ++i ) {
+      if ( nodes.HasCPU(i) ) {
+         n = (btInt)i + 1;
+      }
+   }
+   return ( n > 0 ) ? n : 1;
+
+#elif defined( __AAL_WINDOWS__ )
+
+   ULONG highest = 0;
+   if ( !GetNumaHighestNodeNumber(&highest) ) {
+      return 1;
+   }
+   return (btInt)highest + 1;
+
+#endif // OS
+}
+
+btInt OSLAffinity::CurrentNode()
+{
+#if   defined( __AAL_LINUX__ )
+
+   unsigned cpu  = 0;
+   unsigned node = 0;
+   if ( 0 != syscall(SYS_getcpu, &cpu, &node, NULL) ) {
+      return -1;
+   }
+   return (btInt)node;
+
+#elif defined( __AAL_WINDOWS__ )
+
+   UCHAR node = 0;
+   if ( !GetNumaProcessorNode((UCHAR)GetCurrentProcessorNumber(), &node) ) {
+      return -1;
+   }
+   return (btInt)node;
+
+#endif // OS
+}
+
+void OSLAffinity::SetInternalDefault(const OSLAffinity &rAffinity)
+{
+   AutoLock(&OSLAffinity::sm_Lock);
+   OSLAffinity::sm_InternalDefault = rAffinity;
+}
+
+OSLAffinity OSLAffinity::InternalDefault()
+{
+   AutoLock(&OSLAffinity::sm_Lock);
+   return OSLAffinity::sm_InternalDefault;
+}
+
+END_NAMESPACE(AAL)
+
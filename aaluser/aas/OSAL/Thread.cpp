@@ -104,7 +104,8 @@ const btInt OSLThread::sm_DefaultPriority =
 OSLThread::OSLThread(ThreadProc                     pProc,
                      OSLThread::ThreadPriority      nPriority,
                      void                          *pContext,
-                     btBool                         ThisThread) :
+                     btBool                         ThisThread,
+                     const OSLAffinity             &Affinity) :
 #if   defined( __AAL_WINDOWS__ )
    m_hThread(NULL),
 #elif defined( __AAL_LINUX__ )
@@ -114,6 +115,7 @@ OSLThread::OSLThread(ThreadProc                     pProc,
    m_pProc(pProc),
    m_nPriority(THREADPRIORITY_INVALID),
    m_pContext(pContext),
+   m_Affinity(Affinity),
    m_State(0)
 {
    ASSERT(NULL != pProc);
@@ -217,6 +219,14 @@ void * OSLThread::StartThread(void *p)
 
    }
 
+   {
+      // Serialized against SetAffinity() so that the later placement wins.
+      AutoLock(pThread);
+      if ( pThread->m_Affinity.IsSet() ) {
+         pThread->m_Affinity.Apply();
+      }
+   }
+
    pThread->m_tid = CurrentThreadID();
 
    ThreadProc fn = pThread->m_pProc;
@@ -516,6 +526,32 @@ btTID OSLThread::tid()
    return m_tid;
 }
 
+//=============================================================================
+// Name: SetAffinity
+// Description: Move the running thread to the CPUs of rAffinity.
+// Interface: public
+// Inputs: rAffinity - the new placement.
+// Outputs: true if the placement was applied.
+// Comments: A thread that has not yet reached its ThreadProc takes the new
+//           placement when it does.
+//=============================================================================
+btBool OSLThread::SetAffinity(const OSLAffinity &rAffinity)
+{
+   AutoLock(this);
+
+   m_Affinity = rAffinity;
+
+   if ( !IsOK() || flag_is_set(m_State, THR_ST_LOCAL|THR_ST_JOINED|THR_ST_DETACHED) ) {
+      return false;
+   }
+
+#if   defined( __AAL_WINDOWS__ )
+   return rAffinity.Apply((btTID)::GetThreadId(m_hThread));
+#elif defined( __AAL_LINUX__ )
+   return rAffinity.Apply((btTID)m_Thread);
+#endif // OS
+}
+
 /*
 //=============================================================================
 // Name: SetThreadPriority
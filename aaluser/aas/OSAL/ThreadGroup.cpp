@@ -41,7 +41,8 @@
 /// 05/08/2008     HM       Comments & License
 /// 01/04/2009     HM       Updated Copyright
 /// 03/06/2014     JG       Complete rewrite
-/// 05/07/2015     TSW      Complete rewrite@endverbatim
+/// 05/07/2015     TSW      Complete rewrite
+/// 10/18/2016              Grow and shrink between min and max threads@endverbatim
 //****************************************************************************
 #ifdef HAVE_CONFIG_H
 # include <config.h>
@@ -63,6 +64,25 @@
 
 BEGIN_NAMESPACE(AAL)
 
+// Monotonic clock for the queue and worker stats. Read for every work item, so it avoids
+//  Timer, whose gettimeofday() is slower.
+static btUnsigned64bitInt ThrGrpNanos()
+{
+#if   defined( __AAL_WINDOWS__ )
+   static LARGE_INTEGER freq = { 0 };
+   LARGE_INTEGER        now;
+   if ( 0 == freq.QuadPart ) {
+      QueryPerformanceFrequency(&freq);
+   }
+   QueryPerformanceCounter(&now);
+   return (btUnsigned64bitInt)( (double)now.QuadPart * 1.0e9 / (double)freq.QuadPart );
+#elif defined( __AAL_LINUX__ )
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (btUnsigned64bitInt)ts.tv_sec * 1000000000ULL + (btUnsigned64bitInt)ts.tv_nsec;
+#endif // OS
+}
+
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
@@ -76,6 +96,8 @@ BEGIN_NAMESPACE(AAL)
 //         nPriority - Thread priority
 // Outputs: none.
 // Comments: Setting min == max != 0 results in a static thread pool.
+//           Setting max > min results in a pool that grows as work backs up
+//           and shrinks back to min as the extra workers go idle.
 //           The algorithm summary:
 //               - The work queue and its semaphore are initialized to zero
 //                 for all threads to start.
@@ -85,6 +107,8 @@ BEGIN_NAMESPACE(AAL)
 //=============================================================================
 /// OSLThreadGroup Constructor
 /// @note     Setting uiMinThreads == uiMaxThreads != 0 results in a static thread pool.
+///           Setting uiMaxThreads > uiMinThreads results in a pool that grows as work backs
+///           up and shrinks back to uiMinThreads as the extra workers go idle.
 ///           The algorithm summary:
 ///               - The work queue is initialized empty.
 ///               - The work queueu semaphore is initialized to zero
@@ -97,11 +121,13 @@ BEGIN_NAMESPACE(AAL)
 /// @param[in]    uiMaxThreads - Maximum threads (default = 0 = auto).
 /// @param[in]    nPriority    - Thread priority (default = OSLThread::THREADPRIORITY_NORMAL).
 /// @param[in]    JoinTimeout  - Timeout waiting for thread to exit (default = AAL_INFINITE_WAIT).
+/// @param[in]    Affinity     - CPUs the workers run on (default = no placement).
 /// @return void
 OSLThreadGroup::OSLThreadGroup(btUnsignedInt             uiMinThreads,
                                btUnsignedInt             uiMaxThreads,
                                OSLThread::ThreadPriority nPriority,
-                               btTime                    JoinTimeout) :
+                               btTime                    JoinTimeout,
+                               const OSLAffinity        &Affinity) :
    m_bDestroyed(false),
    m_JoinTimeout(JoinTimeout),
    m_pState(NULL)
@@ -117,7 +143,6 @@ OSLThreadGroup::OSLThreadGroup(btUnsignedInt             uiMinThreads,
          uiMinThreads = 1;
       }
 
-      //TODO implement MaxThreads and dynamic sizing
       if ( uiMaxThreads < uiMinThreads ) {
          uiMaxThreads = uiMinThreads;
       }
@@ -128,7 +153,10 @@ OSLThreadGroup::OSLThreadGroup(btUnsignedInt             uiMinThreads,
       //  have been deleted. By making the state and synchronization members outside
       //  the ThreadGroup, the Threads can safely access them even if the Group object
       //  is gone.
-      m_pState = new(std::nothrow) OSLThreadGroup::ThrGrpState(uiMinThreads);
+      m_pState = new(std::nothrow) OSLThreadGroup::ThrGrpState(uiMinThreads,
+                                                                  uiMaxThreads,
+                                                                  nPriority,
+                                                                  Affinity);
       if ( NULL == m_pState ) {
          m_bDestroyed = true;
          ASSERT(false);
@@ -219,13 +247,18 @@ void OSLThreadGroup::ExecProc(OSLThread *pThread, void *lpParms)
 
    OSLThreadGroup::ThrGrpState::eState state;
 
-   IDispatchable *pWork;
-   btBool         bRunning = true;
+   IDispatchable     *pWork;
+   btBool             bRunning  = true;
+   btBool             bTimedOut;
+   btUnsigned64bitInt BusyNanos = 0;
+   btUnsigned64bitInt Taken     = 0;
 
    while ( bRunning ) {
 
-      pWork = NULL;
-      state = pState->GetWorkItem(pWork);
+      pWork     = NULL;
+      bTimedOut = false;
+      state     = pState->GetWorkItem(pWork, BusyNanos, bTimedOut, Taken);
+      BusyNanos = 0;
 
       switch ( state ) {
 
@@ -235,6 +268,7 @@ void OSLThreadGroup::ExecProc(OSLThread *pThread, void *lpParms)
                bRunning = false;
             } else {
                (*pWork) (); // invoke the functor via operator() ()
+               BusyNanos = ThrGrpNanos() - Taken;
             }
          } break;
 
@@ -242,6 +276,10 @@ void OSLThreadGroup::ExecProc(OSLThread *pThread, void *lpParms)
          case OSLThreadGroup::ThrGrpState::Running  : {
             if ( NULL != pWork ) {
                (*pWork) (); // invoke the functor via operator() ()
+               BusyNanos = ThrGrpNanos() - Taken;
+            } else if ( bTimedOut && pState->WorkerMayRetire(pThread) ) {
+               // Idle past the keep-alive, and not needed. The group Join()'s us.
+               return;
             }
          } break;
 
@@ -265,7 +303,10 @@ void OSLThreadGroup::ExecProc(OSLThread *pThread, void *lpParms)
 ////////////////////////////////////////////////////////////////////////////////
 // OSLThreadGroup::ThrGroupState
 
-OSLThreadGroup::ThrGrpState::ThrGrpState(btUnsignedInt NumThreads) :
+OSLThreadGroup::ThrGrpState::ThrGrpState(btUnsignedInt             MinThreads,
+                                         btUnsignedInt             MaxThreads,
+                                         OSLThread::ThreadPriority Priority,
+                                         const OSLAffinity        &Affinity) :
    m_eState(Running),
    m_Flags(THRGRPSTATE_FLAG_OK),
    m_WorkSemTimeout(AAL_INFINITE_WAIT),
@@ -275,12 +316,23 @@ OSLThreadGroup::ThrGrpState::ThrGrpState(btUnsignedInt NumThreads) :
    m_ThrJoinBarrier(),
    m_ThrExitBarrier(),
    m_WorkSem(),
+   m_Affinity(Affinity),
+   m_MinThreads(MinThreads),
+   m_MaxThreads(MaxThreads),
+   m_Priority(Priority),
+   m_Scaling(),
+   m_Starting(0),
+   m_IdleThreads(0),
+   m_Stats(),
+   m_ThreadsSince(ThrGrpNanos()),
+   m_bPriority(false),
    m_workqueue(),
    m_RunningThreads(),
    m_ExitedThreads(),
+   m_RetiredThreads(),
    m_DrainManager(this)
 {
-   if ( !m_ThrStartBarrier.Create(NumThreads) ) {
+   if ( !m_ThrStartBarrier.Create(MinThreads) ) {
       flag_clrf(m_Flags, THRGRPSTATE_FLAG_OK);
    }
 
@@ -288,7 +340,8 @@ OSLThreadGroup::ThrGrpState::ThrGrpState(btUnsignedInt NumThreads) :
       flag_clrf(m_Flags, THRGRPSTATE_FLAG_OK);
    }
 
-   if ( !m_ThrExitBarrier.Create(NumThreads) ) {
+   // Follows the number of workers. See GrowIfBacklogged() and WorkerMayRetire().
+   if ( !m_ThrExitBarrier.Create(MinThreads) ) {
       flag_clrf(m_Flags, THRGRPSTATE_FLAG_OK);
    }
 
@@ -303,6 +356,7 @@ OSLThreadGroup::ThrGrpState::~ThrGrpState()
    ASSERT(m_workqueue.empty());
    ASSERT(m_RunningThreads.empty());
    ASSERT(m_ExitedThreads.empty());
+   ASSERT(m_RetiredThreads.empty());
    DestructMembers();
 }
 
@@ -342,6 +396,59 @@ btObjectType OSLThreadGroup::ThrGrpState::UserDefined() const
    return m_UserDefined;
 }
 
+//=============================================================================
+// Name: SetAffinity
+// Description: Move the running workers to the CPUs of rAffinity.
+// Interface: public
+// Comments: Workers created later start there.
+//=============================================================================
+btBool OSLThreadGroup::ThrGrpState::SetAffinity(const OSLAffinity &rAffinity)
+{
+   AutoLock(this);
+
+   m_Affinity = rAffinity;
+
+   btBool        res = true;
+   thr_list_iter iter;
+   for ( iter = m_RunningThreads.begin() ; m_RunningThreads.end() != iter ; ++iter ) {
+      if ( !(*iter)->SetAffinity(rAffinity) ) {
+         res = false;
+      }
+   }
+
+   return res;
+}
+
+void OSLThreadGroup::ThrGrpState::SetScaling(const OSLThreadGroupScaling &rScaling)
+{
+   AutoLock(this);
+   m_Scaling = rScaling;
+}
+
+void OSLThreadGroup::ThrGrpState::SetPriorityDispatch(btBool bEnable, btUnsignedInt StarvationLimit)
+{
+   AutoLock(this);
+   m_bPriority                   = bEnable;
+   m_workqueue.m_StarvationLimit = StarvationLimit;
+}
+
+void OSLThreadGroup::ThrGrpState::GetStats(OSLThreadGroupStats &rStats) const
+{
+   AutoLock(this);
+
+   rStats             = m_Stats;
+   rStats.Threads     = (btUnsignedInt) m_RunningThreads.size();
+   rStats.IdleThreads = m_IdleThreads;
+   rStats.QueueDepth  = (btUnsignedInt) m_workqueue.size();
+
+   for ( btUnsignedInt c = 0 ; c < DispatchClasses ; ++c ) {
+      rStats.Classes[c].QueueDepth = (btUnsignedInt) m_workqueue.Class((DispatchClass)c).size();
+   }
+
+   // Bring the workers' lifetime up to now.
+   rStats.WorkerNanos += ( ThrGrpNanos() - m_ThreadsSince ) * rStats.Threads;
+}
+
 //=============================================================================
 // Name: Add
 // Description: Submits a work object for disposition
@@ -358,6 +465,12 @@ btBool OSLThreadGroup::ThrGrpState::Add(IDispatchable *pDisp)
       return false;
    }
 
+   btBool bGrow;
+
+   // Only elastic and prioritized groups need to know how long work has been queued. Other
+   //  groups skip the clock read, which shows in Add() throughput.
+   WorkItem w(pDisp, ( Elastic() || m_bPriority ) ? ThrGrpNanos() : 0);
+
    {
       AutoLock0(this);
 
@@ -369,13 +482,30 @@ btBool OSLThreadGroup::ThrGrpState::Add(IDispatchable *pDisp)
          return false;
       }
 
-      m_workqueue.push(pDisp);
+      if ( m_bPriority ) {
+         w.Class = pDisp->GetDispatchClass();
+         if ( w.Class >= DispatchClasses ) {
+            w.Class = DispatchBulk;
+         }
+      }
+
+      m_workqueue.push(w);
+
+      if ( m_workqueue.size() > m_Stats.PeakQueueDepth ) {
+         m_Stats.PeakQueueDepth = (btUnsignedInt) m_workqueue.size();
+      }
+
+      bGrow = GrowIfBacklogged();
    }
 
    // Signal the semaphore outside the critical section so that waking threads have an
    // opportunity to immediately acquire it.
    m_WorkSem.Post(1);
 
+   if ( bGrow ) {
+      SpawnWorker();
+   }
+
    return true;
 }
 
@@ -403,7 +533,7 @@ void OSLThreadGroup::ThrGrpState::Stop()
 
    // If there is something on the queue then remove it and destroy it.
    while ( m_workqueue.size() > 0 ) {
-      IDispatchable *wi = m_workqueue.front();
+      IDispatchable *wi = m_workqueue.front().pWork;
       m_workqueue.pop();
       delete wi;
    }
@@ -481,7 +611,13 @@ btBool OSLThreadGroup::ThrGrpState::CreateWorkerThread(ThreadProc
                                                        OSLThread::ThreadPriority pri,
                                                        void                     *context)
 {
-   OSLThread *pThread = new(std::nothrow) OSLThread(fn, pri, context);
+   OSLAffinity Affinity;
+   {
+      AutoLock(this);
+      Affinity = m_Affinity;
+   }
+
+   OSLThread *pThread = new(std::nothrow) OSLThread(fn, pri, context, false, Affinity);
 
    ASSERT(NULL != pThread);
    if ( NULL == pThread ) {
@@ -496,7 +632,152 @@ btBool OSLThreadGroup::ThrGrpState::CreateWorkerThread(ThreadProc
 
    {
       AutoLock(this);
+      CountThreads();
       m_RunningThreads.push_back(pThread);
+      if ( m_RunningThreads.size() > m_Stats.PeakThreads ) {
+         m_Stats.PeakThreads = (btUnsignedInt) m_RunningThreads.size();
+      }
+   }
+
+   return true;
+}
+
+// Add the lifetime of the current workers to the stats. Call locked, before the number of
+//  workers changes.
+void OSLThreadGroup::ThrGrpState::CountThreads()
+{
+   const btUnsigned64bitInt Now = ThrGrpNanos();
+
+   m_Stats.WorkerNanos += ( Now - m_ThreadsSince ) * m_RunningThreads.size();
+   m_ThreadsSince       = Now;
+}
+
+//=============================================================================
+// Name: GrowIfBacklogged
+// Description: Decide whether an elastic group needs another worker.
+// Interface: protected
+// Comments: Call locked. On true, a worker has been reserved, and the caller
+//           must call SpawnWorker() once unlocked.
+//=============================================================================
+btBool OSLThreadGroup::ThrGrpState::GrowIfBacklogged()
+{
+   if ( !Elastic() ) {
+      return false;
+   }
+
+   const eState st = State();
+   if ( ( Running != st ) && ( Draining != st ) ) {
+      return false;
+   }
+
+   const btUnsignedInt Workers = (btUnsignedInt) m_RunningThreads.size() + m_Starting;
+   if ( Workers >= m_MaxThreads ) {
+      return false;
+   }
+
+   // Items that no idle (or about to start) worker will take.
+   const btUnsignedInt Depth = (btUnsignedInt) m_workqueue.size();
+   const btUnsignedInt Avail = m_IdleThreads + m_Starting;
+   if ( Depth <= Avail ) {
+      return false;
+   }
+
+   btBool bGrow = ( Depth - Avail >= m_Scaling.QueueThreshold );
+
+   if ( !bGrow && ( AAL_INFINITE_WAIT != m_Scaling.WaitThreshold ) ) {
+      const btUnsigned64bitInt Waited = ThrGrpNanos() - m_workqueue.front().Queued;
+      bGrow = ( Waited >= m_Scaling.WaitThreshold * 1000000ULL );
+   }
+
+   if ( bGrow ) {
+      // The exit Barrier counts every worker, including this one. No worker has Post()'ed it
+      //  while Running or Draining, so resetting it loses nothing.
+      ++m_Starting;
+      m_ThrExitBarrier.Reset(Workers + 1);
+   }
+
+   return bGrow;
+}
+
+//=============================================================================
+// Name: SpawnWorker
+// Description: Create the worker reserved by GrowIfBacklogged().
+// Interface: protected
+// Comments: The new worker can't get work until we unlock, so it can't exit
+//           before it is on the Running list.
+//=============================================================================
+void OSLThreadGroup::ThrGrpState::SpawnWorker()
+{
+   AutoLock(this);
+
+   OSLThread *pThread = NULL;
+
+   if ( Joining != State() ) {
+      pThread = new(std::nothrow) OSLThread(OSLThreadGroup::ExecProc, m_Priority, this, false, m_Affinity);
+      if ( ( NULL != pThread ) && !pThread->IsOK() ) {
+         delete pThread;
+         pThread = NULL;
+      }
+   }
+
+   --m_Starting;
+
+   if ( NULL != pThread ) {
+      CountThreads();
+      m_RunningThreads.push_back(pThread);
+      ++m_Stats.Spawned;
+      if ( m_RunningThreads.size() > m_Stats.PeakThreads ) {
+         m_Stats.PeakThreads = (btUnsignedInt) m_RunningThreads.size();
+      }
+   } else if ( Joining == State() ) {
+      // Stand in for the worker we reserved, as if it had exited.
+      m_ThrExitBarrier.Post(1);
+   } else {
+      m_ThrExitBarrier.Reset((btUnsignedInt) m_RunningThreads.size() + m_Starting);
+   }
+}
+
+//=============================================================================
+// Name: WorkerMayRetire
+// Description: Retire a worker that has been idle for the keep-alive.
+// Interface: protected
+// Comments: Only workers beyond m_MinThreads retire, and only while Running.
+//           The retired worker is Join()'ed by the next one to retire, or by
+//           Quiesce().
+//=============================================================================
+btBool OSLThreadGroup::ThrGrpState::WorkerMayRetire(OSLThread *pThread)
+{
+   thr_list_t Reap;
+
+   {
+      AutoLock(this);
+
+      if ( ( Running != State() ) ||
+           ( m_workqueue.size() > 0 ) ||
+           ( (btUnsignedInt) m_RunningThreads.size() + m_Starting <= m_MinThreads ) ) {
+         return false;
+      }
+
+      thr_list_iter iter = std::find(m_RunningThreads.begin(), m_RunningThreads.end(), pThread);
+      if ( m_RunningThreads.end() == iter ) {
+         return false;
+      }
+
+      CountThreads();
+      m_RunningThreads.erase(iter);
+      ++m_Stats.Retired;
+
+      Reap.swap(m_RetiredThreads);
+      m_RetiredThreads.push_back(pThread);
+
+      // No worker has Post()'ed the exit Barrier while Running.
+      m_ThrExitBarrier.Reset((btUnsignedInt) m_RunningThreads.size() + m_Starting);
+   }
+
+   thr_list_iter iter;
+   for ( iter = Reap.begin() ; Reap.end() != iter ; ++iter ) {
+      (*iter)->Join();
+      delete *iter;
    }
 
    return true;
@@ -508,18 +789,51 @@ btBool OSLThreadGroup::ThrGrpState::CreateWorkerThread(ThreadProc
 // Interface: public
 // Comments:
 //=============================================================================
-OSLThreadGroup::ThrGrpState::eState OSLThreadGroup::ThrGrpState::GetWorkItem(IDispatchable * &pWork)
+OSLThreadGroup::ThrGrpState::eState OSLThreadGroup::ThrGrpState::GetWorkItem(IDispatchable *    &pWork,
+                                                                            btUnsigned64bitInt BusyNanos,
+                                                                            btBool            &bTimedOut,
+                                                                            btUnsigned64bitInt &Taken)
 {
+   btTime Timeout    = m_WorkSemTimeout;
+   btBool bKeepAlive = false;
+
+   // Only an elastic group needs to know who is idle before the wait. A static one saves the
+   //  lock.
+   if ( Elastic() ) {
+      AutoLock(this);
+
+      ++m_IdleThreads;
+
+      Timeout = m_WorkSemTimeout;
+
+      // Workers beyond the minimum wake after the keep-alive to see whether they may retire.
+      if ( ( Joining != State() ) &&
+           ( AAL_INFINITE_WAIT != m_Scaling.KeepAlive ) &&
+           ( m_Scaling.KeepAlive < Timeout ) &&
+           ( (btUnsignedInt) m_RunningThreads.size() + m_Starting > m_MinThreads ) ) {
+         Timeout    = m_Scaling.KeepAlive;
+         bKeepAlive = true;
+      }
+   }
+
    // Wait for work item
-   m_WorkSem.Wait(m_WorkSemTimeout);
+   const btBool bWoke = m_WorkSem.Wait(Timeout);
 
    // Lock until flag and queue have been processed
 
    eState state;
+   btBool bGrow = false;
+
+   Taken = ThrGrpNanos();
 
    {
       AutoLock(this);
 
+      if ( Elastic() ) {
+         --m_IdleThreads;
+      }
+      m_Stats.BusyNanos += BusyNanos;
+
       state = State();
 
       switch ( state ) {
@@ -527,8 +841,32 @@ OSLThreadGroup::ThrGrpState::eState OSLThreadGroup::ThrGrpState::GetWorkItem(IDi
          case Draining : // FALL THROUGH
          case Running  : {
             if ( m_workqueue.size() > 0 ) {
-               pWork = m_workqueue.front();
-               m_workqueue.pop();
+               const WorkItem           &w  = m_workqueue.front();
+               OSLThreadGroupClassStats &cs = m_Stats.Classes[w.Class];
+
+               ++m_Stats.Dispatched;
+               ++cs.Dispatched;
+               if ( 0 != w.Queued ) {
+                  const btUnsigned64bitInt Waited = Taken - w.Queued;
+                  m_Stats.TotalWaitNanos += Waited;
+                  if ( Waited > m_Stats.MaxWaitNanos ) {
+                     m_Stats.MaxWaitNanos = Waited;
+                  }
+                  cs.TotalWaitNanos += Waited;
+                  if ( Waited > cs.MaxWaitNanos ) {
+                     cs.MaxWaitNanos = Waited;
+                  }
+               }
+
+               pWork = w.pWork;
+               if ( m_workqueue.pop() ) {
+                  ++cs.Promoted;
+               }
+
+               // What is left may have waited long enough to need another worker.
+               bGrow = ( m_workqueue.size() > 0 ) && GrowIfBacklogged();
+            } else if ( !bWoke && bKeepAlive ) {
+               bTimedOut = true;
             }
          } break;
 
@@ -544,6 +882,10 @@ OSLThreadGroup::ThrGrpState::eState OSLThreadGroup::ThrGrpState::GetWorkItem(IDi
       }
    }
 
+   if ( bGrow ) {
+      SpawnWorker();
+   }
+
    return state;
 }
 
@@ -575,6 +917,7 @@ void OSLThreadGroup::ThrGrpState::WorkerIsSelfTerminating(OSLThread *pThread)
    thr_list_iter iter = std::find(m_RunningThreads.begin(), m_RunningThreads.end(), pThread);
 
    if ( m_RunningThreads.end() != iter ) {
+      CountThreads();
       m_RunningThreads.erase(iter);
    }
 
@@ -597,6 +940,7 @@ void OSLThreadGroup::ThrGrpState::WorkerHasExited(OSLThread *pThread)
       thr_list_iter iter = std::find(m_RunningThreads.begin(), m_RunningThreads.end(), pThread);
 
       if ( m_RunningThreads.end() != iter ) {
+         CountThreads();
          m_RunningThreads.erase(iter);
          m_ExitedThreads.push_back(pThread);
       }
@@ -642,6 +986,13 @@ btBool OSLThreadGroup::ThrGrpState::Quiesce(btTime Timeout)
       }
       m_ExitedThreads.clear();
 
+      // Workers that retired while the group was Running.
+      for ( iter = m_RetiredThreads.begin() ; m_RetiredThreads.end() != iter ; ++iter ) {
+         (*iter)->Join();
+         delete *iter;
+      }
+      m_RetiredThreads.clear();
+
       // Are any external Drain()'ers blocked on our work item? When a self-referential Join() or
       // a self-referential Destroy() is allowed to progress when there is an external Drain()'er(s),
       // the thread group worker must signal the completion of the Drain() here, before
@@ -679,6 +1030,86 @@ void OSLThreadGroup::ThrGrpState::DestructMembers()
    m_ThrJoinBarrier.Destroy();
 }
 
+//=============================================================================
+// Name: WorkQueue
+// Description: The work items, one FIFO per DispatchClass.
+// Interface: protected
+// Comments: Protected by the ThrGrpState lock.
+//=============================================================================
+OSLThreadGroup::ThrGrpState::WorkQueue::WorkQueue() :
+   m_StarvationLimit(OSLTHREADGROUP_DEFAULT_STARVATION_LIMIT),
+   m_Size(0)
+{
+   for ( btUnsignedInt c = 0 ; c < DispatchClasses ; ++c ) {
+      m_Passed[c] = 0;
+   }
+}
+
+void OSLThreadGroup::ThrGrpState::WorkQueue::push(const WorkItem &w)
+{
+   m_Class[w.Class].push_back(w);
+   ++m_Size;
+}
+
+DispatchClass OSLThreadGroup::ThrGrpState::WorkQueue::Next() const
+{
+   if ( m_Class[DispatchNormal].size() == m_Size ) {
+      // Everything queued is in the default class, as without priority dispatch.
+      return DispatchNormal;
+   }
+
+   btUnsignedInt c = 0;
+
+   // The highest class with work, unless a lower class has been passed over enough times.
+   while ( m_Class[c].empty() ) {
+      ++c;
+   }
+
+   if ( m_StarvationLimit > 0 ) {
+      for ( btUnsignedInt l = c + 1 ; l < DispatchClasses ; ++l ) {
+         if ( !m_Class[l].empty() && ( m_Passed[l] >= m_StarvationLimit ) ) {
+            return (DispatchClass)l;
+         }
+      }
+   }
+
+   return (DispatchClass)c;
+}
+
+btBool OSLThreadGroup::ThrGrpState::WorkQueue::pop()
+{
+   ASSERT(m_Size > 0);
+
+   if ( m_Class[DispatchNormal].size() == m_Size ) {
+      m_Class[DispatchNormal].pop_front();
+      m_Passed[DispatchNormal] = 0;
+      --m_Size;
+      return false;
+   }
+
+   const btUnsignedInt c = Next();
+   btBool              bPromoted = false;
+
+   m_Class[c].pop_front();
+   m_Passed[c] = 0;
+
+   // Every other class with work was either passed over or, if higher, jumped.
+   for ( btUnsignedInt o = 0 ; o < DispatchClasses ; ++o ) {
+      if ( m_Class[o].empty() ) {
+         continue;
+      }
+      if ( o < c ) {
+         bPromoted = true;
+      } else if ( o > c ) {
+         ++m_Passed[o];
+      }
+   }
+
+   --m_Size;
+
+   return bPromoted;
+}
+
 OSLThreadGroup::ThrGrpState::DrainManager::DrainManager(ThrGrpState *pTGS) :
    m_pTGS(pTGS),
    m_DrainNestLevel(0),
@@ -708,25 +1139,20 @@ Barrier * OSLThreadGroup::ThrGrpState::DrainManager::Begin(btTID tid, btUnsigned
       m_DrainBarrier.Destroy();
       m_DrainBarrier.Create(items);
 
-      work_queue_t        tmpq;
-      IDispatchable      *pWork;
       NestedBarrierPostD *pNested;
+      work_class_iter     iter;
 
-      // Pull each item from the work queue, and wrap it in a NestedBarrierPostD() object.
-      while ( m_pTGS->m_workqueue.size() > 0 ) {
-         pWork = m_pTGS->m_workqueue.front();
-         m_pTGS->m_workqueue.pop();
+      // Wrap each item in the work queue in a NestedBarrierPostD() object, in place. The
+      //  item keeps its place, class and queued time.
+      for ( btUnsignedInt c = 0 ; c < DispatchClasses ; ++c ) {
+         work_class_t &q = m_pTGS->m_workqueue.Class((DispatchClass)c);
 
-         pNested = new(std::nothrow) NestedBarrierPostD(pWork, this);
-         m_NestedWorkItems.push_back(pNested);
+         for ( iter = q.begin() ; q.end() != iter ; ++iter ) {
+            pNested = new(std::nothrow) NestedBarrierPostD(iter->pWork, this);
+            m_NestedWorkItems.push_back(pNested);
 
-         tmpq.push( pNested );
-      }
-
-      // Re-populate the work queue.
-      while ( tmpq.size() > 0 ) {
-         m_pTGS->m_workqueue.push(tmpq.front());
-         tmpq.pop();
+            iter->pWork = pNested;
+         }
       }
    }
 
@@ -899,7 +1325,7 @@ btBool OSLThreadGroup::ThrGrpState::Drain()
          // We need to continue to execute work.
          IDispatchable *pWork;
          while ( m_workqueue.size() > 0 ) {
-            pWork = m_workqueue.front();
+            pWork = m_workqueue.front().pWork;
             m_workqueue.pop();
             _UnlockedDispatch uld(this, pWork);
          }
@@ -981,7 +1407,7 @@ btBool OSLThreadGroup::ThrGrpState::Join(btTime Timeout)
          // We need to continue to execute work.
          IDispatchable *pWork;
          while ( m_workqueue.size() > 0 ) {
-            pWork = m_workqueue.front();
+            pWork = m_workqueue.front().pWork;
             m_workqueue.pop();
             _UnlockedDispatch uld(this, pWork);
          }
@@ -1047,7 +1473,7 @@ btBool OSLThreadGroup::ThrGrpState::Destroy(btTime Timeout)
 
          IDispatchable *pWork;
          while ( m_workqueue.size() > 0 ) {
-            pWork = m_workqueue.front();
+            pWork = m_workqueue.front().pWork;
             m_workqueue.pop();
             _UnlockedDispatch uld(this, pWork);
          }
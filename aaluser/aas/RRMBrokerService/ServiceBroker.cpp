@@ -41,6 +41,7 @@
 #include "aalsdk/aas/AALInProcServiceFactory.h"  // Defines InProc Service Factory
 #include "aalsdk/aas/Dispatchables.h"
 #include "aalsdk/aas/ServiceHost.h"
+#include "aalsdk/aas/ServiceShutdown.h"
 #include "aalsdk/CAALEvent.h"
 #include "aalsdk/AALLoggerExtern.h"              // AAL Logger
 
@@ -450,11 +451,11 @@ ServiceHost * ServiceBroker::findServiceHost(std::string const &sName)
 // call to the DoShutdown() method on the Service Factory which does the bulk
 // of the work.
 //
-// DoShutdown() iterates through the list of registered services and invokes
-// Shutdown method on their IServiceModule interface. It then waits on a
-// count-up semaphore waiting for each service to report that they have
-// shutdown or until the timeout expires. It then generates and event notifying
-// AAL core that it has completed.
+// DoShutdown() hands the IServiceModule of each registered service to a
+// ServiceShutdown, which calls their Destroy() in parallel on a thread pool
+// created for that shutdown and waits for each until its own deadline expires.
+// Services that miss it are forced. It then generates an event notifying
+// AAL core that it has completed, with the per-service durations logged.
 //------------------------------------------------------------------------------
 
 
@@ -505,139 +506,60 @@ void ServiceBroker::ShutdownThread(OSLThread *pThread,
    delete pparms;
 }
 
-struct shutdown_handler_thread_parms
-{
-shutdown_handler_thread_parms(ServiceBroker                 *pfact,
-                              ServiceBroker::Servicemap_itr  itr,
-                              CSemaphore                    *srvcCount,
-                              btTime                         timeout) :
-   m_this(pfact),
-   m_itr(itr),
-   m_timeout(timeout),
-   m_srvcCount(srvcCount)
-{}
-
-   ServiceBroker                 *m_this;
-   ServiceBroker::Servicemap_itr  m_itr;
-   btTime                         m_timeout;
-   CSemaphore                    *m_srvcCount;
-};
-
 //=============================================================================
 // Name:          DoShutdown
 // Description:   This is the work horse of Shutdown
 // Interface:     public
 // Inputs:        rTranID,
-//                timeout - Max time hint
+//                timeout - Deadline for each Service, in milliseconds.
 // Outputs:
-// Comments:      Timeout currently not accurate but used as a hint
-//                Needs to call Shutdown on all of the loaded services in
-//                m_SrvcPkgMap, with asynchronous returns. Need timeouts to
-//                enable recovery in the case of one of them hanging.
+// Comments:      The Services are destroyed in parallel by ServiceShutdown,
+//                each given timeout. A Service that misses it is forced: its
+//                provider is not freed and the release completes without it.
 //=============================================================================
 btBool ServiceBroker::DoShutdown(TransactionID const &rTranID,
                                  btTime               timeout)
 {
-   CSemaphore     srvcCount;
-   Servicemap_itr itr;
-   btBool         ret = false;
+   ServiceShutdown Shutdown;
+   Servicemap_itr  itr;
 
-   btUnsigned32bitInt size = m_servicecount = static_cast<btUnsigned32bitInt>(m_ServiceMap.size());
-   if ( 0 == size ) {
-      timeout = 0;
+   {
+      AutoLock(this);
+      for ( itr = m_ServiceMap.begin() ; m_ServiceMap.end() != itr ; ++itr ) {
+         // If the IServiceModule is present
+         if ( NULL != (*itr).second->getProvider() ) {
+            Shutdown.Add((*itr).first, (*itr).second->getProvider());
+         }
+      }
    }
 
-   // Initialize the semaphore as a count up by initializing
-   //  count to a negative number.
-   //  The waiter will block until the semaphore
-   //  counts up to zero.
-   srvcCount.Create( - static_cast<btInt>(size));
-
-   //-------------------------------------------------
-   // Iterate through the services shutting each down
-   // after issuing a shutdown on each wait for the
-   // services to complete
-   //-------------------------------------------------
-   for ( itr = m_ServiceMap.begin() ; size ; size--, itr++ ) {
-
-      // If the IServiceModule is present
-      if ( NULL != ( *itr ).second->getProvider() ) {
-
-         // Shutdown done in parallel so each gets same max-time
-         //   assume 0 time start so no timeout adjust performed
-         DEBUG_CERR("ServiceBroker::DoShutdown - calling IServiceModule->Shutdown()\n");
+   btUnsignedInt Forced = Shutdown.Run(timeout);
 
-         // Technically should join on these threads
-         new OSLThread(ServiceBroker::ShutdownHandlerThread,
-                       OSLThread::THREADPRIORITY_NORMAL,
-                       new shutdown_handler_thread_parms(this, itr, &srvcCount, timeout));
-
-         DEBUG_CERR("ServiceBroker::DoShutdown - returned from IServiceModule->Shutdown()\n");
-      }
+   if ( Forced > 0 ) {
+      AAL_WARNING(LM_AAS, "ServiceBroker::DoShutdown: " << Forced << " Service(s) forced: " << Shutdown.ToString() << std::endl);
+   } else {
+      AAL_INFO(LM_AAS, "ServiceBroker::DoShutdown: " << Shutdown.ToString() << std::endl);
    }
 
-   srvcCount.Wait(timeout);
-
    {
       AutoLock(this);
 
-      //------------------------------------------
-      // Send an event to the system event handler
-      //------------------------------------------
-      if ( m_servicecount ) {
-         // Timed out - Shutdown did not succeed
-         getRuntime()->schedDispatchable( new CExceptionTransactionEvent(dynamic_cast<IBase *>(this),
-                                                                         exttranevtServiceShutdown,
-                                                                         rTranID,
-                                                                         errSystemTimeout,
-                                                                         reasSystemTimeout,
-                                                                         const_cast<btString>(strSystemTimeout)) );
-         return false;
+      for ( btUnsignedInt i = 0 ; i < Shutdown.Count() ; ++i ) {
+         ServiceShutdown::Record rec = Shutdown.Get(i);
+         if ( ServiceShutdown::Done != rec.Result ) {
+            continue;
+         }
+         itr = m_ServiceMap.find(rec.Name);
+         if ( m_ServiceMap.end() != itr ) {
+            (*itr).second->freeProvider();
+         }
       }
    }
 
    ServiceBase::Release(m_releaseTid, timeout);
-   return true;
+   return 0 == Forced;
 }  // ServiceBroker::DoShutdown
 
-void ServiceBroker::ShutdownHandlerThread(OSLThread *pThread,
-                                          void      *pContext)
-{
-   //Get a pointer to this objects context
-   struct shutdown_handler_thread_parms *pparms =
-            static_cast<struct shutdown_handler_thread_parms *>(pContext);
-   ServiceBroker *This = static_cast<ServiceBroker *>(pparms->m_this);
-
-   This->ShutdownHandler(pparms->m_itr, *pparms->m_srvcCount);
-
-   // Destroy the thread and parms
-   delete pThread;
-   delete pparms;
-}
-
-//=============================================================================
-// Name: ShutdownHandler
-// Description: Services shutdown complete events
-//=============================================================================
-void ServiceBroker::ShutdownHandler(Servicemap_itr itr, CSemaphore &cnt)
-{
-   // get second ptr
-   IServiceModule *pProvider = (*itr).second->getProvider();
-
-   pProvider->Destroy();
-
-   {
-      AutoLock(this);
-
-      // Delete the service which unloads the plug-in (e.g.,so or dll)
-      //DEBUG_CERR("ServiceBroker::ShutdownHandler: pLibrary = " << (void*)(( *itr ).second.pLibrary) << endl);
-      (*itr).second->freeProvider();
-      //delete (*itr).second;
-      m_servicecount--;
-      cnt.Post(1);
-   }
-}
-
 
  //=============================================================================
  // Name: messageHandler
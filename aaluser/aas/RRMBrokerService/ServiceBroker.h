@@ -93,8 +93,7 @@ public:
       m_pRMSvcHost(NULL),
       m_ResMgr(NULL),
       m_ResMgrBase(NULL),
-      m_pShutdownThread(NULL),
-      m_servicecount(0)
+      m_pShutdownThread(NULL)
    {
       // Register all exported interfaces
       SetInterface(iidServiceBroker,
@@ -144,8 +143,6 @@ protected:
    // Used by Release
    static void        ShutdownThread(OSLThread *pThread, void *pContext);
    btBool                 DoShutdown(TransactionID const &rTranID, btTime timeout);
-   static void ShutdownHandlerThread(OSLThread *pThread, void *pContext);
-   void              ShutdownHandler(Servicemap_itr itr, CSemaphore &cnt);
 
 protected:
    ServiceHost        *m_pRMSvcHost;
@@ -153,7 +150,6 @@ protected:
    IBase              *m_ResMgrBase;
    ServiceMap          m_ServiceMap;
    OSLThread          *m_pShutdownThread;
-   btUnsigned32bitInt  m_servicecount;
    TransactionMap      m_Transactions;
    ServiceClientMap    m_ServiceClientMap;
    TransactionID      m_releaseTid;
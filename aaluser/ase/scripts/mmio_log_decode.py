@@ -0,0 +1,40 @@
+#!/usr/bin/env python
+
+## Decode the binary MMIO log written by the ASE application side
+## (APP_MMIO_LOG = 1 in ase.cfg, or env ASE_APP_MMIO_LOG=1)
+##
+## USAGE: mmio_log_decode.py [app_mmio.bin]
+##
+## Record layout matches struct mmio_logrec_t in sw/ase_common.h
+
+from __future__ import print_function
+import struct, sys
+
+MMIO_LOG_MAGIC = 0x31474F4C4F494D4D
+REC_FORMAT = "<QQIHBB"
+REC_SIZE = struct.calcsize(REC_FORMAT)
+TYPES = { 1 : "WR", 2 : "RD", 3 : "RDRSP" }
+
+filename = "app_mmio.bin"
+if len(sys.argv) > 1:
+    filename = sys.argv[1]
+
+with open(filename, "rb") as f:
+    hdr = f.read(8)
+    if len(hdr) != 8 or struct.unpack("<Q", hdr)[0] != MMIO_LOG_MAGIC:
+        print("** ERROR: ", filename, " is not an ASE MMIO log **")
+        sys.exit(1)
+
+    print("%14s  %-5s  %5s  %3s  %8s  %s" % ("time_ns", "type", "tid", "w", "offset", "data"))
+    while True:
+        rec = f.read(REC_SIZE)
+        if len(rec) < REC_SIZE:
+            break
+        tstamp, data, addr, tid, rtype, width = struct.unpack(REC_FORMAT, rec)
+        if rtype == 2:
+            datastr = ""
+        elif width == 32:
+            datastr = "0x%08x" % (data & 0xFFFFFFFF)
+        else:
+            datastr = "0x%016x" % data
+        print("%14d  %-5s  0x%03x  %3d  0x%06x  %s" % (tstamp, TYPES.get(rtype, "??"), tid, width, addr, datastr))
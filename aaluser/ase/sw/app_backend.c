@@ -36,9 +36,6 @@
 
 #include "ase_common.h"
 
-// Lock
-pthread_mutex_t mmio_port_lock;
-
 /*
  * Existance status
  */
@@ -65,6 +62,10 @@ int userbuf_index_count = 0;   // User count/index
 char *tstamp_string;
 
 // MMIO Scoreboard (used in APP-side only)
+// - A request's slot is its TID modulo MMIO_MAX_OUTSTANDING, so responses
+//   index the table directly
+// - Slots are claimed from mmio_slot_bitmap (bit set = in use) with
+//   atomic compare-and-swap, MMIO issue takes no lock
 struct mmio_scoreboard_line_t
 {
   int tid;
@@ -73,6 +74,13 @@ struct mmio_scoreboard_line_t
   bool rx_flag;
 };
 volatile struct mmio_scoreboard_line_t mmio_table[MMIO_MAX_OUTSTANDING];
+volatile uint64_t mmio_slot_bitmap;
+
+// APP-side verbosity (APP_VERBOSITY in ase.cfg or env)
+int app_verbosity = ASE_APP_VERBOSITY_QUIET;
+
+// Binary MMIO log (APP_MMIO_LOG in ase.cfg or env)
+FILE *fp_mmio_binlog = (FILE *)NULL;
 
 // Debug logs
 #ifdef ASE_DEBUG
@@ -118,25 +126,33 @@ unsigned long long runtime_nsec;
 
 /*
  * MMIO Generate TID
- * - Creation of TID must be atomic
+ * - Claims a scoreboard slot and returns a TID that maps back to it
+ * - Safe to call from any number of threads
  */
 uint32_t generate_mmio_tid()
 {
   // Return value
   uint32_t ret_mmio_tid;
+  int slot_idx;
 
-  // *FIXME*: TID credit must not overrun, no more than 64 outstanding MMIO Requests
-  while ( count_mmio_tid_used() == MMIO_MAX_OUTSTANDING )
+  // TID credit must not overrun, no more than MMIO_MAX_OUTSTANDING requests
+  while ( (slot_idx = find_empty_mmio_scoreboard_slot()) == 0xFFFF )
     {
 #ifdef ASE_DEBUG
       printf("  [APP]  MMIO TIDs have run out --- waiting !\n");
 #endif
-      usleep(10000);
+      usleep(1);
     }
 
-  // Increment and mask
-  ret_mmio_tid = glbl_mmio_tid & MMIO_TID_BITMASK;
-  glbl_mmio_tid++;
+  // Low bits select the slot, upper bits are a running count so that
+  // consecutive users of a slot do not reuse a TID
+  ret_mmio_tid = (uint32_t)__sync_fetch_and_add(&glbl_mmio_tid, 1);
+  ret_mmio_tid = ((ret_mmio_tid * MMIO_MAX_OUTSTANDING) + slot_idx) & MMIO_TID_BITMASK;
+
+  mmio_table[slot_idx].tid = ret_mmio_tid;
+  mmio_table[slot_idx].data = 0;
+  mmio_table[slot_idx].rx_flag = false;
+  mmio_table[slot_idx].tx_flag = true;
 
   // Return ID
   return ret_mmio_tid;
@@ -153,7 +169,6 @@ void *mmio_response_watcher()
 
   mmio_rsp_pkt = (struct mmio_t *)ase_malloc( sizeof(struct mmio_t) );
   int ret;
-  int slot_idx;
 
 #ifdef ASE_DEBUG
   char mmio_type[3];
@@ -189,43 +204,8 @@ void *mmio_response_watcher()
           END_YELLOW_FONTCOLOR;
 #endif
 
-          // Find scoreboard slot number to update
-          slot_idx = get_scoreboard_slot_by_tid(mmio_rsp_pkt->tid);
-
-          // #ifdef ASE_DEBUG
-          if (slot_idx == 0xFFFF)
-            {
-              BEGIN_RED_FONTCOLOR;
-              printf("get_scoreboard_slot_by_tid() found a bad slot !");
-              END_RED_FONTCOLOR;
-              raise(SIGABRT);
-            }
-          else
-            //#endif
-            {
-              // MMIO Read response (for credit count only)
-              if (mmio_rsp_pkt->write_en == MMIO_READ_REQ)
-                {
-                  mmio_table[slot_idx].tid = mmio_rsp_pkt->tid;
-                  mmio_table[slot_idx].data = mmio_rsp_pkt->qword[0];
-                  mmio_table[slot_idx].tx_flag = true;
-                  mmio_table[slot_idx].rx_flag = true;
-                }
-              // MMIO Write response (for credit count only)
-              else if (mmio_rsp_pkt->write_en == MMIO_WRITE_REQ)
-                {
-                  mmio_table[slot_idx].tx_flag = false;
-                  mmio_table[slot_idx].rx_flag = false;
-                }
-              /* #ifdef ASE_DEBUG */
-              /*          else */
-              /*            { */
-              /*              BEGIN_RED_FONTCOLOR; */
-              /*              printf("  [DEBUG]  Illegal MMIO request found -- must not happen !\n"); */
-              /*              END_RED_FONTCOLOR; */
-              /*            } */
-              /* #endif */
-            }
+          // Update scoreboard
+          mmio_scoreboard_update(mmio_rsp_pkt);
         }
     }
 
@@ -242,6 +222,106 @@ void *mmio_response_watcher()
 // }
 
 
+/*
+ * APP-side configuration
+ * - Reads APP_VERBOSITY and APP_MMIO_LOG from ase.cfg. The file is taken
+ *   from env(ASE_CONFIG), else from above ASE_WORKDIR as laid out by the
+ *   ASE Makefile
+ * - env(ASE_APP_VERBOSITY) and env(ASE_APP_MMIO_LOG) override the file
+ */
+void app_config_parse()
+{
+  FILE *fp;
+  char cfg_filepath[ASE_FILEPATH_LEN];
+  char *line = (char*)NULL;
+  size_t len = 0;
+  char *parameter;
+  char *pch;
+  char *env;
+  int enable_mmio_log = 0;
+
+  app_verbosity = ASE_APP_VERBOSITY_QUIET;
+
+  env = getenv("ASE_CONFIG");
+  if (env != NULL)
+    snprintf(cfg_filepath, ASE_FILEPATH_LEN, "%s", env);
+  else
+    snprintf(cfg_filepath, ASE_FILEPATH_LEN, "%s/../ase.cfg", ase_workdir_path);
+
+  fp = fopen(cfg_filepath, "r");
+  if (fp != NULL)
+    {
+      while (getline(&line, &len, fp) != -1)
+        {
+          remove_spaces (line);
+          remove_tabs (line);
+          remove_newline (line);
+          if ( (line[0] != '#') && (line[0] != '\0') )
+            {
+              parameter = strtok(line, "=\n");
+              pch = strtok(NULL, "");
+              if ((parameter == NULL) || (pch == NULL))
+                continue;
+              if (strncmp(parameter, "APP_VERBOSITY", 20) == 0)
+                app_verbosity = atoi(pch);
+              else if (strncmp(parameter, "APP_MMIO_LOG", 20) == 0)
+                enable_mmio_log = atoi(pch);
+            }
+        }
+      free(line);
+      fclose(fp);
+    }
+
+  env = getenv("ASE_APP_VERBOSITY");
+  if (env != NULL)
+    app_verbosity = atoi(env);
+  env = getenv("ASE_APP_MMIO_LOG");
+  if (env != NULL)
+    enable_mmio_log = atoi(env);
+
+  if (enable_mmio_log)
+    {
+      fp_mmio_binlog = fopen(APP_MMIO_LOG_FILENAME, "wb");
+      if (fp_mmio_binlog == NULL)
+        {
+          BEGIN_RED_FONTCOLOR;
+          printf("  [APP]  MMIO log %s could not be opened, logging disabled\n", APP_MMIO_LOG_FILENAME);
+          END_RED_FONTCOLOR;
+        }
+      else
+        {
+          uint64_t magic = MMIO_LOG_MAGIC;
+          setvbuf(fp_mmio_binlog, NULL, _IOFBF, 1024*1024);
+          fwrite(&magic, sizeof(magic), 1, fp_mmio_binlog);
+        }
+    }
+}
+
+
+/*
+ * Append a record to the binary MMIO log
+ * - Records are fixed size, see struct mmio_logrec_t
+ */
+void mmio_log_record(int type, struct mmio_t *pkt, uint64_t data)
+{
+  struct mmio_logrec_t rec;
+  struct timespec now;
+
+  if (fp_mmio_binlog == NULL)
+    return;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  rec.tstamp = 1000000000ULL*(now.tv_sec - start_time_snapshot.tv_sec) + (now.tv_nsec - start_time_snapshot.tv_nsec);
+  rec.data   = data;
+  rec.addr   = (uint32_t)pkt->addr;
+  rec.tid    = (uint16_t)pkt->tid;
+  rec.type   = (uint8_t)type;
+  rec.width  = (uint8_t)pkt->width;
+
+  fwrite(&rec, sizeof(rec), 1, fp_mmio_binlog);
+}
+
+
 /*
  * Send SW Reset
  */
@@ -317,15 +397,6 @@ void session_init()
 
       ipc_init();
 
-      // Initialize MMIO port lock
-      if ( pthread_mutex_init(&mmio_port_lock, NULL) != 0)
-        {
-          BEGIN_RED_FONTCOLOR;
-          printf("  [APP]  MMIO Lock initialization failed, EXIT\n");
-          END_RED_FONTCOLOR;
-          exit (EXIT_FAILURE);
-        }
-
       // Initialize ase_workdir_path
       BEGIN_YELLOW_FONTCOLOR;
       printf("  [APP]  ASE Session Directory located at =>\n");
@@ -335,6 +406,9 @@ void session_init()
       // Read ready file and check sanity
       ase_read_lock_file(ase_workdir_path);
 
+      // APP verbosity and MMIO log
+      app_config_parse();
+
       // Register kill signals to issue simkill
       signal(SIGTERM, send_simkill);
       signal(SIGINT , send_simkill);
@@ -508,6 +582,7 @@ void session_init()
           mmio_table[ii].tx_flag = false;
           mmio_table[ii].rx_flag = false;
         }
+      mmio_slot_bitmap = 0;
 
       // Session status
       session_exist_status = ESTABLISHED;
@@ -591,6 +666,13 @@ void session_deinit()
       // Close MMIO Response tracker thread
       pthread_cancel (mmio_watch_tid);
 
+      // Close binary MMIO log
+      if (fp_mmio_binlog != NULL)
+        {
+          fclose(fp_mmio_binlog);
+          fp_mmio_binlog = (FILE *)NULL;
+        }
+
       // close message queue
       mqueue_close(app2sim_mmioreq_tx);
       mqueue_close(sim2app_mmiorsp_rx);
@@ -602,10 +684,6 @@ void session_deinit()
       mqueue_close(sim2app_dealloc_rx);
       mqueue_close(sim2app_portctrl_rsp_rx);
 
-      // Lock deinit
-      pthread_mutex_unlock(&mmio_port_lock);
-      pthread_mutex_destroy(&mmio_port_lock);
-
       BEGIN_YELLOW_FONTCOLOR;
       // End Clock snapshot
       clock_gettime(CLOCK_MONOTONIC, &end_time_snapshot);
@@ -639,18 +717,34 @@ void session_deinit()
 
 /*
  * Get a scoreboard slot
+ * - Atomically claims the lowest free slot, 0xFFFF if all are in use
  */
 int find_empty_mmio_scoreboard_slot()
 {
-  int ii;
+  uint64_t used;
   int idx;
-  for (ii = 0; ii < MMIO_MAX_OUTSTANDING ; ii = ii + 1)
+
+  do
     {
-      idx = ii % MMIO_MAX_OUTSTANDING;
-      if ((mmio_table[idx].tx_flag == false) && (mmio_table[idx].rx_flag == false))
-        return idx;
+      used = mmio_slot_bitmap;
+      if (~used == 0)
+        return 0xFFFF;
+      idx = __builtin_ctzll(~used);
     }
-  return 0xFFFF;
+  while ( !__sync_bool_compare_and_swap(&mmio_slot_bitmap, used, used | ((uint64_t)1 << idx)) );
+
+  return idx;
+}
+
+
+/*
+ * Return a scoreboard slot to the free pool
+ */
+void release_mmio_scoreboard_slot(int slot_idx)
+{
+  mmio_table[slot_idx].tx_flag = false;
+  mmio_table[slot_idx].rx_flag = false;
+  __sync_fetch_and_and(&mmio_slot_bitmap, ~((uint64_t)1 << slot_idx));
 }
 
 
@@ -659,12 +753,11 @@ int find_empty_mmio_scoreboard_slot()
  */
 int get_scoreboard_slot_by_tid(int in_tid)
 {
-  int ii;
-  for (ii = 0 ; ii < MMIO_MAX_OUTSTANDING ; ii = ii + 1)
-    {
-      if ( (mmio_table[ii].tx_flag == true) && (mmio_table[ii].tid == in_tid) )
-        return ii;
-    }
+  int idx = in_tid % MMIO_MAX_OUTSTANDING;
+
+  if ( (mmio_table[idx].tx_flag == true) && (mmio_table[idx].tid == in_tid) )
+    return idx;
+
   return 0xFFFF;
 }
 
@@ -674,14 +767,63 @@ int get_scoreboard_slot_by_tid(int in_tid)
  */
 int count_mmio_tid_used()
 {
-  int ii;
-  int cnt = 0;
+  return __builtin_popcountll(mmio_slot_bitmap);
+}
+
+
+/*
+ * Update scoreboard with an MMIO response
+ * - Read data is handed to the waiting reader, write slots are freed
+ */
+void mmio_scoreboard_update(struct mmio_t *pkt)
+{
+  int slot_idx;
+
+  // Find scoreboard slot number to update
+  slot_idx = get_scoreboard_slot_by_tid(pkt->tid);
+
+  if (slot_idx == 0xFFFF)
+    {
+      BEGIN_RED_FONTCOLOR;
+      printf("get_scoreboard_slot_by_tid() found a bad slot !");
+      END_RED_FONTCOLOR;
+      raise(SIGABRT);
+    }
+  // MMIO Read response
+  else if (pkt->write_en == MMIO_READ_REQ)
+    {
+      mmio_table[slot_idx].data = pkt->qword[0];
+      // Data must be visible before the reader sees rx_flag
+      __sync_synchronize();
+      mmio_table[slot_idx].rx_flag = true;
+    }
+  // MMIO Write response (for credit count only)
+  else if (pkt->write_en == MMIO_WRITE_REQ)
+    {
+      release_mmio_scoreboard_slot(slot_idx);
+    }
+}
+
+
+/*
+ * Wait for an MMIO Read response
+ * - Returns the read data and frees the slot
+ */
+uint64_t mmio_scoreboard_wait(int slot_idx)
+{
+  uint64_t data;
 
-  for(ii = 0; ii < MMIO_MAX_OUTSTANDING ; ii = ii + 1)
-    if (mmio_table[ii].tx_flag == true)
-      cnt++;
+  // Wait until correct response found
+  while (mmio_table[slot_idx].rx_flag != true)
+    {
+      usleep(1);
+    }
+  __sync_synchronize();
+
+  data = mmio_table[slot_idx].data;
+  release_mmio_scoreboard_slot(slot_idx);
 
-  return cnt;
+  return data;
 }
 
 
@@ -697,14 +839,11 @@ int mmio_request_put(struct mmio_t *pkt)
   print_mmiopkt(fp_mmioaccess_log, "Sent", pkt);
 #endif
 
-  // Update scoreboard
+  // Update scoreboard, slot was claimed by generate_mmio_tid()
   int mmiotable_idx;
-  mmiotable_idx = find_empty_mmio_scoreboard_slot();
+  mmiotable_idx = get_scoreboard_slot_by_tid(pkt->tid);
   if (mmiotable_idx != 0xFFFF)
     {
-      mmio_table[mmiotable_idx].tx_flag = true;
-      mmio_table[mmiotable_idx].rx_flag = false;
-      mmio_table[mmiotable_idx].tid = pkt->tid;
       mmio_table[mmiotable_idx].data = pkt->qword[0];
     }
   /* #ifdef ASE_DEBUG */
@@ -742,10 +881,6 @@ void mmio_write32 (int offset, uint32_t data)
 {
   FUNC_CALL_ENTRY;
 
-#ifdef ASE_DEBUG
-  int slot_idx;
-#endif
-
   if (offset < 0)
     {
       BEGIN_RED_FONTCOLOR;
@@ -756,28 +891,18 @@ void mmio_write32 (int offset, uint32_t data)
     }
   else
     {
-      mmio_t *mmio_pkt;
-      mmio_pkt = (struct mmio_t *)ase_malloc( sizeof(struct mmio_t) );
-
-      mmio_pkt->write_en = MMIO_WRITE_REQ;
-      mmio_pkt->width    = MMIO_WIDTH_32;
-      mmio_pkt->addr     = offset;
-      memcpy(mmio_pkt->qword, &data, sizeof(uint32_t));
-      mmio_pkt->resp_en  = 0;
+      mmio_t mmio_pkt;
+      memset(&mmio_pkt, 0, sizeof(mmio_pkt));
 
-      // Critical Section
-      {
-        pthread_mutex_lock (&mmio_port_lock);
-
-        mmio_pkt->tid = generate_mmio_tid();
-#ifdef ASE_DEBUG
-        slot_idx = mmio_request_put(mmio_pkt);
-#else
-        mmio_request_put(mmio_pkt);
-#endif
+      mmio_pkt.write_en = MMIO_WRITE_REQ;
+      mmio_pkt.width    = MMIO_WIDTH_32;
+      mmio_pkt.addr     = offset;
+      memcpy(mmio_pkt.qword, &data, sizeof(uint32_t));
+      mmio_pkt.resp_en  = 0;
 
-        pthread_mutex_unlock (&mmio_port_lock);
-      }
+      mmio_pkt.tid = generate_mmio_tid();
+      mmio_request_put(&mmio_pkt);
+      mmio_log_record(MMIO_LOG_WRITE, &mmio_pkt, data);
 
       // Write to MMIO map
       uint32_t *mmio_vaddr;
@@ -785,10 +910,12 @@ void mmio_write32 (int offset, uint32_t data)
       memcpy(mmio_vaddr, (char*)&data, sizeof(uint32_t));
 
       // Display
-      BEGIN_YELLOW_FONTCOLOR;
-      printf("  [APP]  MMIO Write     : tid = 0x%03x, offset = 0x%x, data = 0x%08x\n", mmio_pkt->tid, mmio_pkt->addr, data);
-      END_YELLOW_FONTCOLOR;
-      free(mmio_pkt);
+      if (app_verbosity >= ASE_APP_VERBOSITY_MMIO)
+        {
+          BEGIN_YELLOW_FONTCOLOR;
+          printf("  [APP]  MMIO Write     : tid = 0x%03x, offset = 0x%x, data = 0x%08x\n", mmio_pkt.tid, mmio_pkt.addr, data);
+          END_YELLOW_FONTCOLOR;
+        }
     }
 
   FUNC_CALL_EXIT;
@@ -802,10 +929,6 @@ void mmio_write64 (int offset, uint64_t data)
 {
   FUNC_CALL_ENTRY;
 
-#ifdef ASE_DEBUG
-  int slot_idx;
-#endif
-
   if (offset < 0)
     {
       BEGIN_RED_FONTCOLOR;
@@ -816,39 +939,30 @@ void mmio_write64 (int offset, uint64_t data)
     }
   else
     {
-      mmio_t *mmio_pkt;
-      mmio_pkt = (struct mmio_t *)ase_malloc( sizeof(struct mmio_t) );
+      mmio_t mmio_pkt;
+      memset(&mmio_pkt, 0, sizeof(mmio_pkt));
 
-      mmio_pkt->write_en = MMIO_WRITE_REQ;
-      mmio_pkt->width = MMIO_WIDTH_64;
-      mmio_pkt->addr = offset;
-      memcpy(mmio_pkt->qword, &data, sizeof(uint64_t));
-      mmio_pkt->resp_en = 0;
+      mmio_pkt.write_en = MMIO_WRITE_REQ;
+      mmio_pkt.width    = MMIO_WIDTH_64;
+      mmio_pkt.addr     = offset;
+      memcpy(mmio_pkt.qword, &data, sizeof(uint64_t));
+      mmio_pkt.resp_en  = 0;
 
-      // Critical section
-      {
-        pthread_mutex_lock (&mmio_port_lock);
-
-        mmio_pkt->tid= generate_mmio_tid();
-#ifdef ASE_DEBUG
-        slot_idx = mmio_request_put(mmio_pkt);
-#else
-        mmio_request_put(mmio_pkt);
-#endif
-
-        pthread_mutex_unlock (&mmio_port_lock);
-      }
+      mmio_pkt.tid = generate_mmio_tid();
+      mmio_request_put(&mmio_pkt);
+      mmio_log_record(MMIO_LOG_WRITE, &mmio_pkt, data);
 
       // Write to MMIO Map
       uint64_t *mmio_vaddr;
       mmio_vaddr = (uint64_t*)((uint64_t)mmio_afu_vbase + offset);
       *mmio_vaddr = data;
 
-      BEGIN_YELLOW_FONTCOLOR;
-      printf("  [APP]  MMIO Write     : tid = 0x%03x, offset = 0x%x, data = 0x%llx\n", mmio_pkt->tid, mmio_pkt->addr, (unsigned long long)data);
-      END_YELLOW_FONTCOLOR;
-
-      free(mmio_pkt);
+      if (app_verbosity >= ASE_APP_VERBOSITY_MMIO)
+        {
+          BEGIN_YELLOW_FONTCOLOR;
+          printf("  [APP]  MMIO Write     : tid = 0x%03x, offset = 0x%x, data = 0x%llx\n", mmio_pkt.tid, mmio_pkt.addr, (unsigned long long)data);
+          END_YELLOW_FONTCOLOR;
+        }
     }
 
   FUNC_CALL_EXIT;
@@ -889,27 +1003,24 @@ void mmio_read32(int offset, uint32_t *data32)
     }
   else
     {
-      mmio_t *mmio_pkt;
-      mmio_pkt = (struct mmio_t *)ase_malloc( sizeof(struct mmio_t) );
-
-      mmio_pkt->write_en = MMIO_READ_REQ;
-      mmio_pkt->width    = MMIO_WIDTH_32;
-      mmio_pkt->addr     = offset;
-      mmio_pkt->resp_en  = 0;
-
-      // Critical section
-      {
-        pthread_mutex_lock (&mmio_port_lock);
+      mmio_t mmio_pkt;
+      memset(&mmio_pkt, 0, sizeof(mmio_pkt));
 
-        mmio_pkt->tid      = generate_mmio_tid();
-        slot_idx = mmio_request_put(mmio_pkt);
+      mmio_pkt.write_en = MMIO_READ_REQ;
+      mmio_pkt.width    = MMIO_WIDTH_32;
+      mmio_pkt.addr     = offset;
+      mmio_pkt.resp_en  = 0;
 
-        pthread_mutex_unlock (&mmio_port_lock);
-      }
+      mmio_pkt.tid      = generate_mmio_tid();
+      slot_idx = mmio_request_put(&mmio_pkt);
+      mmio_log_record(MMIO_LOG_READ, &mmio_pkt, 0);
 
-      BEGIN_YELLOW_FONTCOLOR;
-      printf("  [APP]  MMIO Read      : tid = 0x%03x, offset = 0x%x\n", mmio_pkt->tid, mmio_pkt->addr);
-      END_YELLOW_FONTCOLOR;
+      if (app_verbosity >= ASE_APP_VERBOSITY_MMIO)
+        {
+          BEGIN_YELLOW_FONTCOLOR;
+          printf("  [APP]  MMIO Read      : tid = 0x%03x, offset = 0x%x\n", mmio_pkt.tid, mmio_pkt.addr);
+          END_YELLOW_FONTCOLOR;
+        }
 
 #ifdef ASE_DEBUG
       BEGIN_YELLOW_FONTCOLOR;
@@ -917,25 +1028,17 @@ void mmio_read32(int offset, uint32_t *data32)
       END_YELLOW_FONTCOLOR;
 #endif
 
-      // Wait until correct response found
-      while (mmio_table[slot_idx].rx_flag != true)
-        {
-          usleep(1);
-        }
-
-      // Write data
-      *data32 = (uint32_t)mmio_table[slot_idx].data;
+      // Wait until correct response found, write data
+      *data32 = (uint32_t)mmio_scoreboard_wait(slot_idx);
+      mmio_log_record(MMIO_LOG_READRSP, &mmio_pkt, *data32);
 
       // Display
-      BEGIN_YELLOW_FONTCOLOR;
-      printf("  [APP]  MMIO Read Resp : tid = 0x%03x, %08x\n", mmio_table[slot_idx].tid, (uint32_t)*data32);
-      END_YELLOW_FONTCOLOR;
-
-      // Reset scoreboard flags
-      mmio_table[slot_idx].tx_flag = false;
-      mmio_table[slot_idx].rx_flag = false;
-
-      free(mmio_pkt);
+      if (app_verbosity >= ASE_APP_VERBOSITY_MMIO)
+        {
+          BEGIN_YELLOW_FONTCOLOR;
+          printf("  [APP]  MMIO Read Resp : tid = 0x%03x, %08x\n", mmio_pkt.tid, (uint32_t)*data32);
+          END_YELLOW_FONTCOLOR;
+        }
     }
 
   FUNC_CALL_EXIT;
@@ -950,10 +1053,6 @@ void mmio_read64(int offset, uint64_t *data64)
   FUNC_CALL_ENTRY;
   int slot_idx;
 
-#ifdef ASE_DEBUG
-  void *retptr;
-#endif
-
   if (offset < 0)
     {
       BEGIN_RED_FONTCOLOR;
@@ -964,27 +1063,24 @@ void mmio_read64(int offset, uint64_t *data64)
     }
   else
     {
-      mmio_t *mmio_pkt;
-      mmio_pkt = (struct mmio_t *)ase_malloc( sizeof(struct mmio_t) );
-
-      mmio_pkt->write_en = MMIO_READ_REQ;
-      mmio_pkt->width    = MMIO_WIDTH_64;
-      mmio_pkt->addr     = offset;
-      mmio_pkt->resp_en  = 0;
+      mmio_t mmio_pkt;
+      memset(&mmio_pkt, 0, sizeof(mmio_pkt));
 
-      // Critical section
-      {
-        pthread_mutex_lock (&mmio_port_lock);
+      mmio_pkt.write_en = MMIO_READ_REQ;
+      mmio_pkt.width    = MMIO_WIDTH_64;
+      mmio_pkt.addr     = offset;
+      mmio_pkt.resp_en  = 0;
 
-        mmio_pkt->tid      = generate_mmio_tid();
-        slot_idx = mmio_request_put(mmio_pkt);
+      mmio_pkt.tid      = generate_mmio_tid();
+      slot_idx = mmio_request_put(&mmio_pkt);
+      mmio_log_record(MMIO_LOG_READ, &mmio_pkt, 0);
 
-        pthread_mutex_unlock (&mmio_port_lock);
-      }
-
-      BEGIN_YELLOW_FONTCOLOR;
-      printf("  [APP]  MMIO Read      : tid = 0x%03x, offset = 0x%x\n", mmio_pkt->tid, mmio_pkt->addr);
-      END_RED_FONTCOLOR;
+      if (app_verbosity >= ASE_APP_VERBOSITY_MMIO)
+        {
+          BEGIN_YELLOW_FONTCOLOR;
+          printf("  [APP]  MMIO Read      : tid = 0x%03x, offset = 0x%x\n", mmio_pkt.tid, mmio_pkt.addr);
+          END_YELLOW_FONTCOLOR;
+        }
 
 #ifdef ASE_DEBUG
       BEGIN_YELLOW_FONTCOLOR;
@@ -992,26 +1088,17 @@ void mmio_read64(int offset, uint64_t *data64)
       END_YELLOW_FONTCOLOR;
 #endif
 
-      // Wait for correct response to be back
-      while(mmio_table[slot_idx].rx_flag != true)
-        {
-          usleep(1);
-        };
-
-      // Write data
-      *data64 = mmio_table[slot_idx].data;
+      // Wait for correct response to be back, write data
+      *data64 = mmio_scoreboard_wait(slot_idx);
+      mmio_log_record(MMIO_LOG_READRSP, &mmio_pkt, *data64);
 
       // Display
-      BEGIN_YELLOW_FONTCOLOR;
-
-      printf("  [APP]  MMIO Read Resp : tid = 0x%03x, data = %llx\n", mmio_table[slot_idx].tid, (unsigned long long)*data64);
-      END_YELLOW_FONTCOLOR;
-
-      // Reset scoreboard flags
-      mmio_table[slot_idx].tx_flag = false;
-      mmio_table[slot_idx].rx_flag = false;
-
-      free(mmio_pkt);
+      if (app_verbosity >= ASE_APP_VERBOSITY_MMIO)
+        {
+          BEGIN_YELLOW_FONTCOLOR;
+          printf("  [APP]  MMIO Read Resp : tid = 0x%03x, data = %llx\n", mmio_pkt.tid, (unsigned long long)*data64);
+          END_YELLOW_FONTCOLOR;
+        }
     }
 
   FUNC_CALL_EXIT;
@@ -113,7 +113,7 @@
 // MMIO Tid width
 #define MMIO_TID_BITWIDTH          9
 #define MMIO_TID_BITMASK           (uint32_t)(pow((uint32_t)2, MMIO_TID_BITWIDTH)-1)
-#define MMIO_MAX_OUTSTANDING       64
+#define MMIO_MAX_OUTSTANDING       64     // Slot bitmap width, must divide 2^MMIO_TID_BITWIDTH
 
 // Number of UMsgs per AFU
 #define NUM_UMSG_PER_AFU           8
@@ -321,6 +321,29 @@ uint64_t *umsg_umas_vbase;
 #define MMIO_WIDTH_32        32
 #define MMIO_WIDTH_64        64
 
+// APP-side verbosity levels
+#define ASE_APP_VERBOSITY_QUIET   0     // No per-transaction messages
+#define ASE_APP_VERBOSITY_MMIO    1     // Print every MMIO access
+
+// Binary MMIO log (APP side)
+// - File starts with MMIO_LOG_MAGIC, then one mmio_logrec_t per event
+// - Decode with scripts/mmio_log_decode.py
+#define APP_MMIO_LOG_FILENAME     "app_mmio.bin"
+#define MMIO_LOG_MAGIC            0x31474F4C4F494D4DULL  // "MMIOLOG1"
+#define MMIO_LOG_WRITE            1
+#define MMIO_LOG_READ             2
+#define MMIO_LOG_READRSP          3
+
+struct mmio_logrec_t
+{
+  uint64_t tstamp;                // ns since session start
+  uint64_t data;                  // Write data, or read response data
+  uint32_t addr;                  // AFU MMIO offset
+  uint16_t tid;
+  uint8_t  type;                  // MMIO_LOG_*
+  uint8_t  width;                 // MMIO_WIDTH_32 or MMIO_WIDTH_64
+};
+
 // UMSG info structure
 typedef struct {
   int id;
@@ -343,7 +366,9 @@ void ll_traverse_print();
 void ll_append_buffer(struct buffer_t *);
 void ll_remove_buffer(struct buffer_t *);
 uint32_t check_if_physaddr_used(uint64_t);
+uint32_t check_if_physrange_used(uint64_t, uint64_t);
 struct buffer_t* ll_search_buffer(int);
+struct buffer_t* ll_search_physaddr(uint64_t);
 
 // Mem-ops functions
 int ase_recv_msg(struct buffer_t *);
@@ -428,10 +453,15 @@ extern "C" {
   void append_wsmeta(struct wsmeta_t *);
   // MMIO activity
   int find_empty_mmio_scoreboard_slot();
-  int get_scoreboard_slot_by_tid();
+  void release_mmio_scoreboard_slot(int);
+  int get_scoreboard_slot_by_tid(int);
   int count_mmio_tid_used();
   uint32_t generate_mmio_tid();
+  void app_config_parse();
+  void mmio_log_record(int, struct mmio_t *, uint64_t);
   int mmio_request_put(struct mmio_t *);
+  void mmio_scoreboard_update(struct mmio_t *);
+  uint64_t mmio_scoreboard_wait(int);
   void mmio_response_get(struct mmio_t *);
   void mmio_write32 (int , uint32_t  );
   void mmio_write64 (int , uint64_t  );
@@ -35,6 +35,107 @@
 
 #include "ase_common.h"
 
+/*
+ * Buffer lookup index
+ * - ll_paddr_index : buffers sorted by fake_paddr, for address translation
+ * - ll_id_index    : buffers sorted by index, for ll_search_buffer()
+ * Kept in step with the linked list by ll_append_buffer() and
+ * ll_remove_buffer(), lookups are binary searches
+ */
+static struct buffer_t **ll_paddr_index = (struct buffer_t **)NULL;
+static struct buffer_t **ll_id_index    = (struct buffer_t **)NULL;
+static int ll_index_count = 0;
+static int ll_index_size  = 0;
+
+// Last buffer found by ll_search_physaddr(), streaming accesses hit it
+static struct buffer_t *ll_last_hit = (struct buffer_t *)NULL;
+
+
+/*
+ * Position of first buffer with fake_paddr above paddr
+ */
+static int ll_paddr_upper(uint64_t paddr)
+{
+  int lo = 0;
+  int hi = ll_index_count;
+  int mid;
+
+  while (lo < hi)
+    {
+      mid = (lo + hi) / 2;
+      if (ll_paddr_index[mid]->fake_paddr <= paddr)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  return lo;
+}
+
+
+/*
+ * Position of first buffer with index not below search_index
+ */
+static int ll_id_lower(int search_index)
+{
+  int lo = 0;
+  int hi = ll_index_count;
+  int mid;
+
+  while (lo < hi)
+    {
+      mid = (lo + hi) / 2;
+      if (ll_id_index[mid]->index < search_index)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  return lo;
+}
+
+
+/*
+ * Insert/remove entry at position pos of an index array
+ */
+static void ll_index_insert(struct buffer_t **arr, int pos, struct buffer_t *buf)
+{
+  memmove(&arr[pos + 1], &arr[pos], (ll_index_count - pos) * sizeof(struct buffer_t *));
+  arr[pos] = buf;
+}
+
+static void ll_index_remove(struct buffer_t **arr, int pos)
+{
+  memmove(&arr[pos], &arr[pos + 1], (ll_index_count - pos - 1) * sizeof(struct buffer_t *));
+}
+
+
+/*
+ * Grow index arrays to hold at least one more buffer
+ */
+static void ll_index_grow()
+{
+  struct buffer_t **new_paddr;
+  struct buffer_t **new_id;
+  int new_size;
+
+  if (ll_index_count < ll_index_size)
+    return;
+
+  new_size = (ll_index_size == 0) ? 64 : 2 * ll_index_size;
+  new_paddr = (struct buffer_t **)ase_malloc(new_size * sizeof(struct buffer_t *));
+  new_id    = (struct buffer_t **)ase_malloc(new_size * sizeof(struct buffer_t *));
+  if (ll_index_count != 0)
+    {
+      memcpy(new_paddr, ll_paddr_index, ll_index_count * sizeof(struct buffer_t *));
+      memcpy(new_id,    ll_id_index,    ll_index_count * sizeof(struct buffer_t *));
+    }
+  free(ll_paddr_index);
+  free(ll_id_index);
+
+  ll_paddr_index = new_paddr;
+  ll_id_index    = new_id;
+  ll_index_size  = new_size;
+}
+
 /*
  * ll_print_info: Print linked list node info
  * Thu Oct  2 15:50:06 PDT 2014 : Modified for cleanliness
@@ -98,6 +199,12 @@ void ll_append_buffer(struct buffer_t *new)
   // Adjust end to point to last node
   end = new;
 
+  // Add to lookup index
+  ll_index_grow();
+  ll_index_insert(ll_paddr_index, ll_paddr_upper(new->fake_paddr), new);
+  ll_index_insert(ll_id_index, ll_id_lower(new->index), new);
+  ll_index_count++;
+
   FUNC_CALL_EXIT;
 }
 
@@ -141,46 +248,74 @@ void ll_remove_buffer(struct buffer_t *ptr)
         end = prev;
     }
 
+  // Remove from lookup index
+  int pos;
+  for (pos = ll_paddr_upper(temp->fake_paddr) - 1; pos >= 0; pos--)
+    {
+      if (ll_paddr_index[pos] == temp)
+        {
+          ll_index_remove(ll_paddr_index, pos);
+          break;
+        }
+    }
+  for (pos = ll_id_lower(temp->index); pos < ll_index_count; pos++)
+    {
+      if (ll_id_index[pos] == temp)
+        {
+          ll_index_remove(ll_id_index, pos);
+          break;
+        }
+    }
+  ll_index_count--;
+  if (ll_last_hit == temp)
+    ll_last_hit = (struct buffer_t *)NULL;
+
   FUNC_CALL_EXIT;
 }
 
 
 // --------------------------------------------------------------------
 // search_buffer_ll : Search buffer by ID
-// Pass the head of the linked list along when calling
 // --------------------------------------------------------------------
 struct buffer_t* ll_search_buffer(int search_index)
 {
-  FUNC_CALL_ENTRY;
+  int pos;
 
-  struct buffer_t* search_ptr;
+  pos = ll_id_lower(search_index);
+  if ((pos < ll_index_count) && (ll_id_index[pos]->index == search_index))
+    return ll_id_index[pos];
+  else
+    return (struct buffer_t *)NULL;
+}
 
-  // Start searching from the head
-  search_ptr = head;
 
-  // Traverse linked list starting from head
-  if (search_ptr != NULL)
+/*
+ * Search buffer containing a fake physical address
+ * RETURN buffer, NULL if not found
+ */
+struct buffer_t* ll_search_physaddr(uint64_t paddr)
+{
+  struct buffer_t *search_ptr;
+  int pos;
+
+  // Streaming accesses stay in the same buffer
+  search_ptr = ll_last_hit;
+  if ( (search_ptr != NULL) && (paddr >= search_ptr->fake_paddr) && (paddr < search_ptr->fake_paddr_hi) )
+    return search_ptr;
+
+  // Last buffer starting at or below paddr
+  pos = ll_paddr_upper(paddr) - 1;
+  if (pos >= 0)
     {
-      while(search_ptr->index != search_index)
+      search_ptr = ll_paddr_index[pos];
+      if (paddr < search_ptr->fake_paddr_hi)
         {
-          search_ptr = search_ptr->next;
-          if(search_ptr == NULL)
-            break;
+          ll_last_hit = search_ptr;
+          return search_ptr;
         }
     }
 
-  // When found, return pointer to buffer
-  if (search_ptr != NULL)
-    {
-      if (search_index == (int)search_ptr->index)
-        return search_ptr;
-      else
-        return (struct buffer_t *)NULL;
-    }
-  else
-    return (struct buffer_t *)NULL;
-
-  FUNC_CALL_EXIT;
+  return (struct buffer_t *)NULL;
 }
 
 
@@ -190,21 +325,26 @@ struct buffer_t* ll_search_buffer(int search_index)
  */
 uint32_t check_if_physaddr_used(uint64_t paddr)
 {
-  struct buffer_t *search_ptr;
-  int flag = 0;
+  return (ll_search_physaddr(paddr) != NULL) ? 1 : 0;
+}
 
-  search_ptr = head;
-  while(search_ptr != NULL)
-    {
-      if ( (paddr >= search_ptr->fake_paddr) && (paddr < search_ptr->fake_paddr_hi) )
-        {
-          flag = 1;
-          break;
-        }
-      else
-        {
-          search_ptr = search_ptr->next;
-        }
-    }
-  return flag;
+
+/*
+ * Check if a physical address range overlaps any buffer
+ * RETURN 0 if free, 1 if any part is used
+ */
+uint32_t check_if_physrange_used(uint64_t paddr_lo, uint64_t paddr_hi)
+{
+  int pos;
+
+  // Buffer starting at or below paddr_lo must end before it
+  pos = ll_paddr_upper(paddr_lo);
+  if ((pos > 0) && (ll_paddr_index[pos - 1]->fake_paddr_hi > paddr_lo))
+    return 1;
+
+  // Next buffer must start at or after paddr_hi
+  if ((pos < ll_index_count) && (ll_paddr_index[pos]->fake_paddr < paddr_hi))
+    return 1;
+
+  return 0;
 }
@@ -367,8 +367,9 @@ uint64_t get_range_checked_physaddr(uint32_t size)
       ret_fake_paddr = ret_fake_paddr & PHYS_ADDR_PREFIX_MASK ;
 
       // Check for conditions
-      // Is address in sysmem range, go back
-      search_flag = check_if_physaddr_used(ret_fake_paddr);
+      // Does range overlap an existing buffer, go back
+      // (buffers never overlap, so lookups can binary search)
+      search_flag = check_if_physrange_used(ret_fake_paddr, ret_fake_paddr + (uint64_t)size);
 
       // Is HI smaller than LO, go back
       opposite_flag = 0;
@@ -431,29 +432,22 @@ uint64_t* ase_fakeaddr_to_vaddr(uint64_t req_paddr)
 #endif
 
       // Search which buffer offset_from_pin lies in
-      trav_ptr = head;
-      while(trav_ptr != NULL)
+      trav_ptr = ll_search_physaddr(req_paddr);
+      if (trav_ptr != NULL)
         {
-          if((req_paddr >= trav_ptr->fake_paddr) && (req_paddr < trav_ptr->fake_paddr_hi))
-            {
-              real_offset = (uint64_t)req_paddr - (uint64_t)trav_ptr->fake_paddr;
-              calc_pbase = trav_ptr->pbase;
-              ase_pbase = (uint64_t*)(calc_pbase + real_offset);
-              // buffer_found = 1;
+          real_offset = (uint64_t)req_paddr - (uint64_t)trav_ptr->fake_paddr;
+          calc_pbase = trav_ptr->pbase;
+          ase_pbase = (uint64_t*)(calc_pbase + real_offset);
+          // buffer_found = 1;
 
-              // Debug only
+          // Debug only
 #ifdef ASE_DEBUG
-              if (fp_memaccess_log != NULL)
-                {
-                  fprintf(fp_memaccess_log, "offset=0x%016lx | pbase=%p\n", real_offset, (void *)ase_pbase);
-                }
-#endif
-              return ase_pbase;
-            }
-          else
+          if (fp_memaccess_log != NULL)
             {
-              trav_ptr = trav_ptr->next;
+              fprintf(fp_memaccess_log, "offset=0x%016lx | pbase=%p\n", real_offset, (void *)ase_pbase);
             }
+#endif
+          return ase_pbase;
         }
     }
   else
@@ -1310,6 +1310,11 @@ void ase_config_parse(char *filename)
                                     }
                                 }
                             }
+                          else if ( (strncmp(parameter, "APP_VERBOSITY", 20) == 0) ||
+                                    (strncmp(parameter, "APP_MMIO_LOG", 20) == 0) )
+                            {
+                              // Application side settings, see app_config_parse()
+                            }
                           else
                             {
                               printf("SIM-C : In config file %s, Parameter type %s is unidentified \n", filename, parameter);
@@ -60,7 +60,8 @@
 /// 01/04/2009     HM       Updated Copyright
 /// 08/12/2010     HM       Added new CTOR: Application specified ID and Handler
 /// 10/21/2011     JG       Changes for Windows compatibility
-/// 05/15/2015     JG       Added Support for IBase@endverbatim
+/// 05/15/2015     JG       Added Support for IBase
+/// 10/18/2016              NextUniqueID() no longer takes a lock@endverbatim
 //****************************************************************************
 #ifndef __AALSDK_AALTRANSACTIONID_H__
 #define __AALSDK_AALTRANSACTIONID_H__
@@ -304,14 +305,13 @@ public:
    btBool operator == (const TransactionID & ) const;
 
    /// @brief Get a unique ID for a TransactionID.
-   /// @return A randomly generated 32-bit integer ID.
+   /// @return The next ID of a process-wide counter, taken with an atomic increment.
    static btID NextUniqueID();
 
 private:
    stTransactionID_t m_tid;
 
-   static btID            sm_NextUniqueID;
-   static CriticalSection sm_CS;
+   static volatile btID sm_NextUniqueID;
 };
 
 /// TransactionID streamer.
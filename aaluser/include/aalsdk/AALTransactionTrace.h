@@ -0,0 +1,198 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// @file AALTransactionTrace.h
+/// @brief Timestamped tracepoints keyed by TransactionID.
+/// @ingroup Events
+/// @verbatim
+/// Accelerator Abstraction Layer
+///
+/// A request crosses several threads and layers on its way to the client's
+/// callback: _runtime::allocService(), the Service Broker, ServiceHost, the
+/// AIA ioctl, the AIA message pump and the dispatcher. When tracing is
+/// enabled each of them records the stage, the TransactionID's ID, the
+/// thread and a monotonic timestamp. TransactionTrace rebuilds per-
+/// transaction timelines and per-stage latency histograms from those
+/// records, and writes them as Chrome trace JSON (chrome://tracing).
+///
+/// When tracing is disabled a tracepoint costs one load and branch.
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version.@endverbatim
+//****************************************************************************
+#ifndef __AALSDK_AALTRANSACTIONTRACE_H__
+#define __AALSDK_AALTRANSACTIONTRACE_H__
+#include <aalsdk/AALTypes.h>
+
+#include <iosfwd>
+#include <map>
+#include <vector>
+
+BEGIN_NAMESPACE(AAL)
+
+/// @addtogroup Events
+/// @{
+
+/// The points along a request's path that record a timestamp.
+typedef enum
+{
+   txtraceRuntimeAllocService = 0, ///< _runtime::allocService() entered.
+   txtraceBrokerAllocService,      ///< The Service Broker has the request.
+   txtraceHostInstantiate,         ///< ServiceHost is about to construct the Service.
+   txtraceHostInstantiated,        ///< The Service is constructed; its init() is under way.
+   txtraceAIASend,                 ///< A transaction is handed to the driver.
+   txtraceAIASent,                 ///< The driver's ioctl returned.
+   txtraceAIAUpstream,             ///< The AIA message pump read the driver's response.
+   txtraceDispatch,                ///< The client's callback is about to run.
+   txtraceALIBufferAllocate,       ///< IALIBuffer::bufferAllocate() entered.
+   txtraceALIBufferAllocated,      ///< IALIBuffer::bufferAllocate() returning.
+   txtraceALIReconfigure,          ///< IALIReconfigure::reconfConfigure() entered.
+
+   txtraceUser = 16,               ///< First stage free for applications.
+   txtraceMaxStage = 32
+} TransactionTraceStage;
+
+/// One tracepoint hit.
+struct TransactionTraceRecord
+{
+   btID               ID;      ///< TransactionID::ID() of the request.
+   btUnsigned64bitInt Nanos;   ///< Monotonic timestamp, in nanoseconds.
+   btTID              Thread;  ///< GetThreadID() of the recording thread.
+   btUnsigned32bitInt Stage;   ///< TransactionTraceStage.
+};
+
+/// A transaction's records, in time order.
+typedef std::vector<TransactionTraceRecord>       TransactionTimeline;
+typedef std::map<btID, TransactionTimeline>       TransactionTimelines;
+
+/// Latencies from one stage to the stage that followed it in the same transaction.
+struct TransactionTraceHistogram
+{
+   enum { Buckets = 40 };
+
+   btUnsigned32bitInt From;
+   btUnsigned32bitInt To;
+   btUnsigned64bitInt Count;
+   btUnsigned64bitInt MinNanos;
+   btUnsigned64bitInt MaxNanos;
+   btUnsigned64bitInt TotalNanos;
+   /// Bucket[i] counts latencies of at least 2^(i-1) and less than 2^i ns.
+   btUnsigned64bitInt Bucket[Buckets];
+
+   /// The latency below which Fraction (0.0 - 1.0) of the samples lie, to the bucket's upper bound.
+   btUnsigned64bitInt Percentile(double Fraction) const;
+};
+
+//=============================================================================
+/// @brief Process-wide collector of transaction tracepoints.
+///
+/// Records go to a ring of fixed capacity, allocated by the first Enable().
+///  When it is full the oldest records are overwritten. Recording takes no
+///  lock; a record overwritten while a snapshot copies it is skipped.
+//=============================================================================
+class AASLIB_API TransactionTrace
+{
+public:
+   /// Start recording. Capacity, rounded up to a power of 2, is used only by
+   ///  the first call.
+   static btBool Enable(btUnsigned32bitInt Capacity = 65536);
+   /// Stop recording. The records are kept.
+   static void   Disable();
+   /// Whether tracepoints record.
+   static btBool IsEnabled() { return sm_bEnabled; }
+   /// Discard all records.
+   static void   Reset();
+
+   /// Record that transaction ID reached Stage. Use AAL_TRACE_TRANSACTION(),
+   ///  which skips the call when tracing is disabled.
+   static void   Record(btUnsigned32bitInt Stage, btID ID);
+
+   /// Name of Stage, as it appears in the Chrome trace.
+   static btcString StageName(btUnsigned32bitInt Stage);
+
+   /// Number of records made since the last Reset(), including overwritten ones.
+   static btUnsigned64bitInt Recorded();
+   /// Number of records the ring holds, 0 before the first Enable().
+   static btUnsigned64bitInt Capacity();
+
+   /// Copy the records still in the ring, in time order.
+   static void Snapshot(std::vector<TransactionTraceRecord> &rRecords);
+   /// Group the records still in the ring by transaction.
+   static void Timelines(TransactionTimelines &rTimelines);
+   /// One histogram for each pair of consecutive stages seen, in (From, To) order.
+   static void StageLatencies(std::vector<TransactionTraceHistogram> &rHistograms);
+
+   /// Write the records still in the ring as Chrome trace JSON. Each
+   ///  transaction is a row; the interval between consecutive stages is a span.
+   static btBool WriteChromeTrace(std::ostream &os);
+   static btBool WriteChromeTrace(btcString Path);
+
+private:
+   static volatile btBool sm_bEnabled;
+};
+
+/// Records Begin on construction and End on destruction, if tracing is enabled
+///  at construction, to bracket a call that has more than one way out.
+class TransactionTraceScope
+{
+public:
+   TransactionTraceScope(btUnsigned32bitInt Begin, btUnsigned32bitInt End, btID ID) :
+      m_bOn(TransactionTrace::IsEnabled()),
+      m_End(End),
+      m_ID(ID)
+   {
+      if ( m_bOn ) {
+         TransactionTrace::Record(Begin, m_ID);
+      }
+   }
+   ~TransactionTraceScope()
+   {
+      if ( m_bOn ) {
+         TransactionTrace::Record(m_End, m_ID);
+      }
+   }
+
+private:
+   btBool             m_bOn;
+   btUnsigned32bitInt m_End;
+   btID               m_ID;
+};
+
+/// @}
+
+END_NAMESPACE(AAL)
+
+/// Record that the transaction with ID __id reached __stage, if tracing is enabled.
+#define AAL_TRACE_TRANSACTION(__stage, __id)                        \
+do                                                                  \
+{                                                                   \
+   if ( AAL::TransactionTrace::IsEnabled() ) {                      \
+      AAL::TransactionTrace::Record((__stage), (AAL::btID)(__id));  \
+   }                                                                \
+}while(0)
+
+#endif // __AALSDK_AALTRANSACTIONTRACE_H__
@@ -68,6 +68,7 @@
 #define AAL_SERVICE_COMM_PORT                   "AAL_SERVICE_COMM_PORT"
 #define AAL_SERVICE_CONNECTION_TYPE             "AAL_SERVICE_CONNECTION_TYPE"
 #define AAL_SERVICE_COMM_HOST                   "AAL_SERVICE_COMM_HOST"
+#define AAL_SERVICE_COMM_PATH                   "AAL_SERVICE_COMM_PATH"
 #define AAL_SERVICE_CONNECTION_MAX_SERVER_WAIT  "AAL_SERVICE_CONNECTION_MAX_SERVER_WAIT"
 
 /******************************************************************************
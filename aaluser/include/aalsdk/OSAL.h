@@ -58,6 +58,7 @@ END_NAMESPACE(AAL)
 # include <aalsdk/osal/CriticalSection.h>
 # include <aalsdk/osal/OSSemaphore.h>
 # include <aalsdk/osal/Barrier.h>
+# include <aalsdk/osal/Affinity.h>
 # include <aalsdk/osal/Thread.h>
 # include <aalsdk/osal/ThreadGroup.h>
 # include <aalsdk/osal/OSServiceModule.h>
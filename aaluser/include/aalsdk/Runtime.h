@@ -74,9 +74,44 @@ BEGIN_NAMESPACE(AAL)
 
 #define AALRUNTIME_CONFIG_RECORD          "AALRUNTIME_CONFIG_RECORD"
 #define AALRUNTIME_CONFIG_BROKER_SERVICE  "AALRUNTIME_CONFIG_BROKER_SERVICE"
+/// Colon- or comma-separated list of Service module root names (eg "libALI:libaia")
+/// that the Runtime loads on a thread of its own from start(), without delaying
+/// runtimeStarted(), and keeps resident until it is destroyed, so that the first
+/// allocService() for those modules does not pay the dynamic load cost.
+/// May also be given in the environment variable of the same name, which takes precedence.
+#define AALRUNTIME_CONFIG_PRELOAD_SERVICES "AALRUNTIME_CONFIG_PRELOAD_SERVICES"
+/// CPUs for the threads the Runtime and its Services create for themselves: the message
+/// dispatcher, Service message delivery and the AIA message pump. A CPU list ("0-3,8")
+/// or "node:N" for the CPUs of NUMA node N, normally the node of the FPGA's PCIe root.
+/// May also be given in the environment variable of the same name, which takes precedence.
+#define AALRUNTIME_CONFIG_AFFINITY         "AALRUNTIME_CONFIG_AFFINITY"
+/// File to write a Chrome trace (chrome://tracing) of every TransactionID's path through
+/// the Runtime, AIA and dispatcher to when the Runtime stops. Tracing is off when absent.
+/// May also be given in the environment variable of the same name, which takes precedence.
+#define AALRUNTIME_CONFIG_TRANSACTION_TRACE "AALRUNTIME_CONFIG_TRANSACTION_TRACE"
+/// File to append the start-up profile (see Runtime::getStartupProfile()) to once the
+/// Runtime has started, or "-" for stderr. Nothing is written when absent.
+/// May also be given in the environment variable of the same name, which takes precedence.
+#define AALRUNTIME_CONFIG_STARTUP_PROFILE  "AALRUNTIME_CONFIG_STARTUP_PROFILE"
+/// Dispatch schedDispatchable() work by DispatchClass rather than in the order scheduled:
+/// "on", or the starvation limit (see OSLThreadGroup::SetPriorityDispatch()) as a number.
+/// A critical event may then be delivered ahead of earlier events for the same Service.
+/// Delivery is in order when absent.
+/// May also be given in the environment variable of the same name, which takes precedence.
+#define AALRUNTIME_CONFIG_PRIORITY_DISPATCH "AALRUNTIME_CONFIG_PRIORITY_DISPATCH"
+
+/// Start-up phases reported by Runtime::getStartupProfile(), each a btUnsigned64bitInt
+/// duration in nanoseconds.
+#define AALRUNTIME_PROFILE_CONSTRUCT       "Construct"      ///< Constructing the Runtime and its message dispatcher.
+#define AALRUNTIME_PROFILE_PROXY           "Proxy"          ///< Creating the Runtime's own Proxy.
+#define AALRUNTIME_PROFILE_DEFAULT_BROKER  "DefaultBroker"  ///< Instantiating the built-in Service Broker.
+#define AALRUNTIME_PROFILE_CONFIG_BROKER   "ConfigBroker"   ///< Allocating AALRUNTIME_CONFIG_BROKER_SERVICE, when given.
+#define AALRUNTIME_PROFILE_START           "Start"          ///< From start() until runtimeStarted() is scheduled.
+#define AALRUNTIME_PROFILE_PRELOAD         "Preload"        ///< Loading AALRUNTIME_CONFIG_PRELOAD_SERVICES, off the start() path.
 
 
 class IRuntime;
+struct OSLThreadGroupStats;
 
 //=============================================================================
 /// @interface IRuntimeClient
@@ -210,6 +245,10 @@ public:
 
    /// @brief     Stops the Runtime. Releases any resources and shuts down all
    ///               Services.
+   ///
+   /// A Service that does not shut down within its deadline is forced. The
+   /// client then receives runtimeEvent() with an exception event carrying
+   /// errSystemTimeout before runtimeStopped().
    /// @return    void
    virtual void                         stop()                                                  = 0;
 
@@ -283,6 +322,20 @@ public:
    virtual btBool                       IsOK();
    // </IRuntime>
 
+   /// @brief     Reports how long each phase of start-up took.
+   /// @param[out] rProfile receives an AALRUNTIME_PROFILE_* key for each phase
+   ///               completed so far. AALRUNTIME_PROFILE_PRELOAD appears once the
+   ///               preloaded Service modules are resident, which may be after
+   ///               runtimeStarted().
+   /// @return    true = success.
+   btBool                  getStartupProfile(NamedValueSet &rProfile);
+
+   /// @brief     Reports on the queue that schedDispatchable() feeds.
+   /// @param[out] rStats receives the dispatcher's statistics. Classes gives queue
+   ///               depth and latency for each DispatchClass.
+   /// @return    true = success.
+   btBool                   getDispatchStats(OSLThreadGroupStats &rStats);
+
 protected:
    Runtime(IRuntimeClient *pClient,
            btBool          bFirstTime);
@@ -49,6 +49,7 @@
 #include <aalsdk/AALTypes.h>
 #include <aalsdk/AALNVSMarshaller.h>
 #include <aalsdk/osal/Sleep.h>
+#include <aalsdk/osal/Thread.h>
 
 #include "aalsdk/AALLoggerExtern.h"
 
@@ -56,6 +57,10 @@
 
 #include <stdio.h>
 #include <errno.h>
+#if defined( __AAL_LINUX__ )
+# include <map>
+# include <sys/un.h>
+#endif // __AAL_LINUX__
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -446,7 +451,7 @@ err:
       char lenstr[7] = {0};
       int  bytes_recv;
 
-      bytes_recv = recv(m_clientsock, lenstr, sizeof(lenstr), 0);
+      bytes_recv = recv(m_clientsock, lenstr, sizeof(lenstr), MSG_WAITALL);
       ASSERT(bytes_recv >= 0);
       if ( bytes_recv < 0 ) {
          std::cerr << "recv returned " << bytes_recv  <<std::endl;
@@ -472,7 +477,7 @@ err:
 
       // Read the message
       AutoLock(this);   // Lock to protect m_buffer
-      bytes_recv = recv(m_clientsock, m_buffer, bytes_recv, 0);        
+      bytes_recv = recv(m_clientsock, m_buffer, bytes_recv, MSG_WAITALL);
 
       ASSERT(bytes_recv >= 0);
       if ( bytes_recv < 0 ) {
@@ -503,23 +508,48 @@ err:
    int putmsg(btcString pmsg, btWSSize len)
    {
       char lenstr[7]={0};
-      sprintf(lenstr,"%llu",len);
-
-      send(m_clientsock,
-           lenstr,
-           sizeof(lenstr),
-           0);
-
-      int n = send(m_clientsock,
-                   pmsg,
-                   len,
-                   0);
+      snprintf(lenstr,sizeof(lenstr),"%llu",len);
+
+      // Length and body go out in one call. Two send()s leave the body
+      //  waiting on Nagle for the peer's delayed ACK.
+      struct iovec iov[2];
+      iov[0].iov_base = lenstr;
+      iov[0].iov_len  = sizeof(lenstr);
+      iov[1].iov_base = const_cast<char *>(pmsg);
+      iov[1].iov_len  = len;
+
+      struct msghdr msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov    = iov;
+      msg.msg_iovlen = 2;
+
+      // A stream socket may take only part of the frame; send the rest.
+      size_t remaining = sizeof(lenstr) + len;
+      while ( remaining > 0 ) {
+         ssize_t n = sendmsg(m_clientsock, &msg, MSG_NOSIGNAL);
+         if ( n < 0 ) {
+            if ( EINTR == errno ) {
+               continue;
+            }
+            perror("sendto");
+            return -1;
+         }
 
-      if(n<0){
-         perror("sendto");
+         remaining -= n;
+         while ( ( n > 0 ) && ( msg.msg_iovlen > 0 ) ) {
+            if ( (size_t)n >= msg.msg_iov->iov_len ) {
+               n -= msg.msg_iov->iov_len;
+               ++msg.msg_iov;
+               --msg.msg_iovlen;
+            } else {
+               msg.msg_iov->iov_base = static_cast<char *>(msg.msg_iov->iov_base) + n;
+               msg.msg_iov->iov_len -= n;
+               n = 0;
+            }
+         }
       }
 
-      return n;
+      return (int)len;
    }
 
 protected:
@@ -535,6 +565,521 @@ protected:
 };
 
 
+#if defined( __AAL_LINUX__ )
+
+#define UDS_MSG_MAGIC                           0x41414C55   // "ULAA"
+#define UDS_MAX_MSG_SIZE                        (64 * 1024 * 1024)
+
+/// Wire header preceding every UDSxport message. Host byte order - both ends
+///  are on the same node.
+typedef struct _UDSMsgHdr
+{
+   btUnsigned32bitInt magic;     ///< UDS_MSG_MAGIC
+   btUnsigned32bitInt length;    ///< Payload length in octets
+   btUnsigned64bitInt corrid;    ///< Correlation ID, echoed by the responder
+} UDSMsgHdr;
+
+//=============================================================================
+// Name: UDSxport
+// Description: Class provides the implementation of the AAL Service
+//              Unix domain socket IPC transport.
+//=============================================================================
+/// @brief Class provides the implementation of the AAL Service Unix domain
+///        socket IPC transport.
+///
+/// Selected with AAL_SERVICE_CONNECTION_TYPE == conn_type_uds, the socket path
+///  given by AAL_SERVICE_COMM_PATH. Use it in place of the default transport,
+///  eg IPCSvcsFact<MyProxy, UDSxport>.
+///
+/// Each message is a binary UDSMsgHdr followed by the payload, written with a
+///  single sendmsg() and read back in full regardless of how the kernel splits
+///  it. Sends and receives are serialized separately, so a client may have
+///  several requests outstanding and match the responses by correlation ID.
+///  Each receiving thread gets its own message buffer and last correlation ID.
+///  A file descriptor (eg a shared memory buffer) can travel with a message.
+class UDSxport : public IAALTransport
+{
+public:
+
+   UDSxport() :
+      m_listensock(-1),
+      m_sock(-1),
+      m_nextcorrid(1),
+      m_lastfd(-1),
+      m_bserver(false)
+   {
+      memset(&m_addr, 0, sizeof(m_addr));
+   }
+
+   ~UDSxport()
+   {
+      disconnect();
+      std::map<btTID, RecvSlot>::iterator itr;
+      for ( itr = m_recvslots.begin() ; m_recvslots.end() != itr ; ++itr ) {
+         if ( NULL != itr->second.pbuffer ) {
+            delete[] itr->second.pbuffer;
+         }
+      }
+   }
+
+   //=============================================================================
+   // Name: connectremote
+   // Description: Connect to the remote server
+   // Inputs optArgs - named ValueSet contains connection arguments
+   //=============================================================================
+   /// @brief Connects to the remote server
+   ///
+   /// @param[in] optArgs - named ValueSet contains connection arguments
+   btBool connectremote(NamedValueSet const &optArgs)
+   {
+      INamedValueSet const *connParmskvs = NULL;
+
+      if ( !GetAddress(optArgs, &connParmskvs) ) {
+         return false;
+      }
+
+      int maxwait = 10;
+      if ( connParmskvs->Has(AAL_SERVICE_CONNECTION_MAX_SERVER_WAIT) ) {
+         connParmskvs->Get(AAL_SERVICE_CONNECTION_MAX_SERVER_WAIT, reinterpret_cast<int*>(&maxwait));
+      }
+
+      m_sock = socket(AF_UNIX, SOCK_STREAM, 0);
+      if ( m_sock < 0 ) {
+         perror("socket");
+         m_sock = -1;
+         return false;
+      }
+
+      do {
+         if ( 0 == connect(m_sock, (struct sockaddr *)&m_addr, sizeof(m_addr)) ) {
+            return true;
+         }
+         SleepSec(1);
+      } while ( maxwait-- );
+
+      perror("connecting socket");
+      cerr << "path " << m_addr.sun_path << endl;
+      close(m_sock);
+      m_sock = -1;
+      return false;
+   }
+
+   //=============================================================================
+   // Name: waitforconnect
+   // Description: Wait for a connection from a client
+   // Inputs optArgs - named ValueSet contains connection arguments
+   //=============================================================================
+   /// @brief Wait for a connection from a client
+   ///
+   /// @param[in] optArgs named ValueSet contains connection arguments
+   btBool waitforconnect(NamedValueSet const &optArgs)
+   {
+      INamedValueSet const *connParmskvs = NULL;
+
+      if ( !GetAddress(optArgs, &connParmskvs) ) {
+         return false;
+      }
+
+      m_listensock = socket(AF_UNIX, SOCK_STREAM, 0);
+      if ( m_listensock < 0 ) {
+         perror("Opening socket");
+         m_listensock = -1;
+         return false;
+      }
+
+      // Remove a stale socket left by an unclean shutdown.
+      unlink(m_addr.sun_path);
+
+      if ( bind(m_listensock, (struct sockaddr *)&m_addr, sizeof(m_addr)) < 0 ) {
+         perror("binding");
+         goto err;
+      }
+
+      if ( listen(m_listensock, 5) < 0 ) {
+         perror("Listening");
+         goto err;
+      }
+
+      m_sock = accept(m_listensock, NULL, NULL);
+      if ( m_sock < 0 ) {
+         perror("accept");
+         m_sock = -1;
+         goto err;
+      }
+
+      m_bserver = true;
+      return true;
+
+err:
+      close(m_listensock);
+      m_listensock = -1;
+      unlink(m_addr.sun_path);
+      return false;
+   }
+
+   //=============================================================================
+   // Name: disconnect
+   // Description: Disconnect remote party and destroy channel
+   //=============================================================================
+   /// @brief Disconnect remote party and destroy channel.
+   ///
+   /// @retval True.
+   btBool disconnect(void)
+   {
+      if ( m_sock >= 0 ) {
+         close(m_sock);
+         m_sock = -1;
+      }
+
+      if ( m_listensock >= 0 ) {
+         close(m_listensock);
+         m_listensock = -1;
+         unlink(m_addr.sun_path);
+      }
+
+      if ( m_lastfd >= 0 ) {
+         close(m_lastfd);
+         m_lastfd = -1;
+      }
+      return true;
+   }
+
+   //=============================================================================
+   // Name: getmsg
+   // Description: Get a message from remote end
+   // Inputs: *len - pointer of where to return message length
+   // Outputs: length of message (-1) in case of error, 0 means EOF (remote close)
+   // Returns: pointer to message (NULL in case of error or EOF)
+   //=============================================================================
+   /// @brief Gets a message from remote end.
+   ///
+   ///@param[in] *len A pointer to the location the message length will be stored.
+   ///           Length of message (-1) in case of error, 0 means EOF (remote close).
+   ///@return A pointer to the message (NULL in case of error or EOF). The buffer
+   ///        is owned by the transport and valid until the calling thread's
+   ///        next getmsg().
+   btcString getmsg(btWSSize *len)
+   {
+      return getmsg(len, NULL, NULL);
+   }
+
+   /// @brief Gets a message, its correlation ID and any descriptor sent with it.
+   ///
+   ///@param[out] len    Length of message, (-1) in case of error, 0 means EOF.
+   ///@param[out] corrid Correlation ID given to putmsg() by the sender. May be NULL.
+   ///@param[out] pfd    Descriptor passed with the message, or -1. The caller
+   ///                   owns it. If NULL, a received descriptor is closed.
+   ///@return A pointer to the message (NULL in case of error or EOF).
+   btcString getmsg(btWSSize *len, btUnsigned64bitInt *corrid, int *pfd)
+   {
+      UDSMsgHdr hdr;
+      ssize_t   res;
+
+      AutoLock(&m_recvlock);
+
+      if ( NULL != pfd ) {
+         *pfd = -1;
+      }
+
+      res = recvall(reinterpret_cast<char *>(&hdr), sizeof(hdr), true);
+      if ( res <= 0 ) {
+         *len = (btWSSize)res;
+         return NULL;
+      }
+
+      if ( ( UDS_MSG_MAGIC != hdr.magic ) || ( hdr.length > UDS_MAX_MSG_SIZE ) ) {
+         AAL_ERR(LM_AAS, "UDSxport::getmsg bad header" << endl);
+         *len = (btWSSize)-1;
+         return NULL;
+      }
+
+      // Read into this thread's own buffer, so a receiver on another thread
+      //  cannot overwrite the message once the lock is dropped.
+      RecvSlot &slot = m_recvslots[GetThreadID()];
+
+      if ( hdr.length + 1 > slot.buflen ) {
+         if ( NULL != slot.pbuffer ) {
+            delete[] slot.pbuffer;
+         }
+         slot.buflen  = hdr.length + 1;
+         slot.pbuffer = new(std::nothrow) char[slot.buflen];
+         if ( NULL == slot.pbuffer ) {
+            slot.buflen = 0;
+            *len = (btWSSize)-1;
+            return NULL;
+         }
+      }
+
+      if ( hdr.length > 0 ) {
+         res = recvall(slot.pbuffer, hdr.length, false);
+         if ( res <= 0 ) {
+            *len = (btWSSize)res;
+            return NULL;
+         }
+      }
+      slot.pbuffer[hdr.length] = 0;
+
+      slot.corrid = hdr.corrid;
+      if ( NULL != corrid ) {
+         *corrid = hdr.corrid;
+      }
+
+      if ( m_lastfd >= 0 ) {
+         if ( NULL != pfd ) {
+            *pfd = m_lastfd;
+         } else {
+            close(m_lastfd);
+         }
+         m_lastfd = -1;
+      }
+
+      *len = hdr.length;
+      return slot.pbuffer;
+   }
+
+   //=============================================================================
+   // Name: putmsg
+   // Description: Send a message to remote end
+   // Inputs:  pmsg - pointer to message
+   //          len  - length of message in octets
+   // Returns: number of bytes sent (-1 if error)
+   //=============================================================================
+   /// @brief Send a message to remote end.
+   ///
+   /// On the waitforconnect() side the message echoes the correlation ID of the
+   ///  last request received by the calling thread, so a service replying
+   ///  through the plain IAALTransport interface is matched to the right
+   ///  request. On the connectremote() side each message gets a new ID.
+   /// @param[in] pmsg A pointer to the message.
+   /// @param[in] len The length of the message in bytes.
+   /// @return The number of bytes sent (-1 if error).
+   int putmsg(btcString pmsg, btWSSize len)
+   {
+      if ( !m_bserver ) {
+         return putmsg(pmsg, len, nextcorrid(), -1);
+      }
+
+      btUnsigned64bitInt corrid = 0;
+      {
+         AutoLock(&m_recvlock);
+         std::map<btTID, RecvSlot>::const_iterator itr = m_recvslots.find(GetThreadID());
+         if ( m_recvslots.end() != itr ) {
+            corrid = itr->second.corrid;
+         }
+      }
+      return putmsg(pmsg, len, corrid, -1);
+   }
+
+   /// @brief Send a message with an explicit correlation ID and, optionally, a
+   ///        file descriptor.
+   ///
+   /// @param[in] pmsg   A pointer to the message.
+   /// @param[in] len    The length of the message in bytes.
+   /// @param[in] corrid Correlation ID, eg from nextcorrid().
+   /// @param[in] fd     Descriptor to duplicate into the receiver, or -1.
+   /// @return The number of payload bytes sent (-1 if error).
+   int putmsg(btcString pmsg, btWSSize len, btUnsigned64bitInt corrid, int fd)
+   {
+      if ( len > UDS_MAX_MSG_SIZE ) {
+         return -1;
+      }
+
+      UDSMsgHdr hdr;
+      hdr.magic  = UDS_MSG_MAGIC;
+      hdr.length = (btUnsigned32bitInt)len;
+      hdr.corrid = corrid;
+
+      struct iovec iov[2];
+      iov[0].iov_base = &hdr;
+      iov[0].iov_len  = sizeof(hdr);
+      iov[1].iov_base = const_cast<char *>(pmsg);
+      iov[1].iov_len  = len;
+
+      union {
+         struct cmsghdr align;
+         char           buf[CMSG_SPACE(sizeof(int))];
+      } ctrl;
+
+      struct msghdr msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov    = iov;
+      msg.msg_iovlen = (0 == len) ? 1 : 2;
+
+      if ( fd >= 0 ) {
+         memset(&ctrl, 0, sizeof(ctrl));
+         msg.msg_control    = ctrl.buf;
+         msg.msg_controllen = sizeof(ctrl.buf);
+
+         struct cmsghdr *pcmsg = CMSG_FIRSTHDR(&msg);
+         pcmsg->cmsg_level = SOL_SOCKET;
+         pcmsg->cmsg_type  = SCM_RIGHTS;
+         pcmsg->cmsg_len   = CMSG_LEN(sizeof(int));
+         memcpy(CMSG_DATA(pcmsg), &fd, sizeof(int));
+      }
+
+      AutoLock(&m_sendlock);
+
+      size_t remaining = sizeof(hdr) + len;
+      while ( remaining > 0 ) {
+         ssize_t n = sendmsg(m_sock, &msg, MSG_NOSIGNAL);
+         if ( n < 0 ) {
+            if ( EINTR == errno ) {
+               continue;
+            }
+            perror("sendmsg");
+            return -1;
+         }
+
+         // The descriptor went with the first chunk.
+         msg.msg_control    = NULL;
+         msg.msg_controllen = 0;
+
+         remaining -= n;
+         while ( ( n > 0 ) && ( msg.msg_iovlen > 0 ) ) {
+            if ( (size_t)n >= msg.msg_iov->iov_len ) {
+               n -= msg.msg_iov->iov_len;
+               ++msg.msg_iov;
+               --msg.msg_iovlen;
+            } else {
+               msg.msg_iov->iov_base = static_cast<char *>(msg.msg_iov->iov_base) + n;
+               msg.msg_iov->iov_len -= n;
+               n = 0;
+            }
+         }
+      }
+
+      return (int)len;
+   }
+
+   /// @brief Allocate a correlation ID for a new request.
+   btUnsigned64bitInt nextcorrid()
+   {
+      AutoLock(&m_sendlock);
+      return m_nextcorrid++;
+   }
+
+protected:
+   UDSxport(UDSxport const & );
+   UDSxport & operator = (const UDSxport & );
+
+   // Fill m_addr from AAL_SERVICE_CONNECTION_PARMS.
+   btBool GetAddress(NamedValueSet const &optArgs, INamedValueSet const **ppconnParmskvs)
+   {
+      btcString                 path     = NULL;
+      eservice_connection_types conntype = conn_type_tcp;
+
+      if ( !optArgs.Has(AAL_SERVICE_CONNECTION_PARMS) ) {
+         return false;
+      }
+      optArgs.Get(AAL_SERVICE_CONNECTION_PARMS, ppconnParmskvs);
+
+      if ( !(*ppconnParmskvs)->Has(AAL_SERVICE_CONNECTION_TYPE) ) {
+         return false;
+      }
+      (*ppconnParmskvs)->Get(AAL_SERVICE_CONNECTION_TYPE, reinterpret_cast<int*>(&conntype));
+
+      if ( conn_type_uds != conntype ) {
+         cerr << "Wrong connectiontype\n";
+         return false;
+      }
+
+      if ( !(*ppconnParmskvs)->Has(AAL_SERVICE_COMM_PATH) ) {
+         return false;
+      }
+      (*ppconnParmskvs)->Get(AAL_SERVICE_COMM_PATH, &path);
+
+      if ( strlen(path) >= sizeof(m_addr.sun_path) ) {
+         cerr << "Socket path too long\n";
+         return false;
+      }
+
+      memset(&m_addr, 0, sizeof(m_addr));
+      m_addr.sun_family = AF_UNIX;
+      strncpy(m_addr.sun_path, path, sizeof(m_addr.sun_path) - 1);
+      return true;
+   }
+
+   // Read exactly len octets. Returns len, 0 on EOF or -1 on error. Any
+   //  descriptor arriving with the data is kept in m_lastfd.
+   ssize_t recvall(char *buf, size_t len, btBool bfirst)
+   {
+      size_t got = 0;
+
+      while ( got < len ) {
+         struct iovec iov;
+         iov.iov_base = buf + got;
+         iov.iov_len  = len - got;
+
+         union {
+            struct cmsghdr align;
+            char           buf[CMSG_SPACE(sizeof(int))];
+         } ctrl;
+
+         struct msghdr msg;
+         memset(&msg, 0, sizeof(msg));
+         msg.msg_iov        = &iov;
+         msg.msg_iovlen     = 1;
+         msg.msg_control    = ctrl.buf;
+         msg.msg_controllen = sizeof(ctrl.buf);
+
+         ssize_t n = recvmsg(m_sock, &msg, MSG_WAITALL);
+         if ( n < 0 ) {
+            if ( EINTR == errno ) {
+               continue;
+            }
+            perror("recvmsg");
+            return -1;
+         }
+         if ( 0 == n ) {
+            if ( bfirst && ( 0 == got ) ) {
+               return 0;   // EOF seen, not an error
+            }
+            return -1;     // Remote closed mid-message
+         }
+
+         struct cmsghdr *pcmsg = CMSG_FIRSTHDR(&msg);
+         if ( ( NULL != pcmsg ) &&
+              ( SOL_SOCKET == pcmsg->cmsg_level ) &&
+              ( SCM_RIGHTS == pcmsg->cmsg_type ) ) {
+            if ( m_lastfd >= 0 ) {
+               close(m_lastfd);
+            }
+            memcpy(&m_lastfd, CMSG_DATA(pcmsg), sizeof(int));
+         }
+
+         got += n;
+      }
+
+      return (ssize_t)got;
+   }
+
+   // What one receiving thread got last.
+   struct RecvSlot
+   {
+      RecvSlot() :
+         pbuffer(NULL),
+         buflen(0),
+         corrid(0)
+      {}
+      char               *pbuffer;
+      btUnsigned32bitInt  buflen;
+      btUnsigned64bitInt  corrid;
+   };
+
+   int                       m_listensock;
+   int                       m_sock;
+   struct sockaddr_un        m_addr;
+   std::map<btTID, RecvSlot> m_recvslots;   // Guarded by m_recvlock
+   btUnsigned64bitInt        m_nextcorrid;
+   int                       m_lastfd;
+   btBool                    m_bserver;
+   CriticalSection           m_sendlock;
+   CriticalSection           m_recvlock;
+};
+
+#endif // __AAL_LINUX__
+
+
 //=============================================================================
 /// IPCSvcsFact
 /// Template provides the implementation of the AAL Service
@@ -74,7 +74,8 @@ typedef enum eservice_connection_types
 {
    conn_type_udp,
    conn_type_tcp,
-   conn_type_shram
+   conn_type_shram,
+   conn_type_uds
 } eservice_connection_types;
 
 //=============================================================================
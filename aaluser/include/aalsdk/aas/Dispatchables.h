@@ -33,6 +33,7 @@
 // COMMENTS:
 // WHEN:          WHO:     WHAT:
 // 05/15/2015     JG       Initial Version
+// 10/19/2016              Revocations and release requests are critical
 //****************************************************************************///
 #ifndef __AALSDK_DISPATCHABLES_H__
 #define __AALSDK_DISPATCHABLES_H__
@@ -381,6 +382,8 @@ public:
    ///
    /// @returns void
    virtual void operator() ();
+   /// @brief Runs ahead of queued notifications.
+   virtual DispatchClass GetDispatchClass() const { return DispatchCritical; }
 protected:
    IServiceRevoke *m_pRevoke;
 };
@@ -394,6 +397,8 @@ public:
    ///
    /// @returns void
    virtual void operator() ();
+   /// @brief Runs ahead of queued notifications.
+   virtual DispatchClass GetDispatchClass() const { return DispatchCritical; }
 protected:
    IBase          *m_pSvcBase;
    const IEvent   *m_pEvent;
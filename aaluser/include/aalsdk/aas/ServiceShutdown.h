@@ -0,0 +1,114 @@
+// Copyright(c) 2014-2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+//        FILE: ServiceShutdown.h
+//     CREATED: Oct 18, 2016
+//
+// PURPOSE:   Parallel, deadline-bounded shutdown of Service plug-ins.
+// HISTORY:
+// COMMENTS:  The Service Brokers hand the IServiceModule of each loaded
+//            Service to a ServiceShutdown, which runs the Destroy()s on a
+//            thread pool of its own, created and joined by each Run(). A Service
+//            that misses its deadline is forced: the Broker stops waiting
+//            for it and leaves its module loaded, as a thread may still be
+//            running in it.
+// WHEN:          WHO:     WHAT:
+//****************************************************************************///
+#ifndef __SERVICESHUTDOWN_H__
+#define __SERVICESHUTDOWN_H__
+#include <aalsdk/CUnCopyable.h>
+#include <aalsdk/aas/AALServiceModule.h>
+
+/// Per-Service shutdown deadline, in milliseconds, used when a Service Broker is
+/// released with AAL_INFINITE_WAIT. May be given in the environment variable of
+/// the same name.
+#define AAL_SERVICE_SHUTDOWN_DEADLINE         "AAL_SERVICE_SHUTDOWN_DEADLINE"
+#define AAL_SERVICE_SHUTDOWN_DEFAULT_DEADLINE 10000
+
+/// Most threads Run() destroys providers on.
+#define AAL_SERVICE_SHUTDOWN_THREADS          4
+
+BEGIN_NAMESPACE(AAL)
+
+//=============================================================================
+// Name: ServiceShutdown
+// Description: Destroys a set of Service providers in parallel, each within
+//              a deadline, and reports how long each took.
+// Interface: public
+// Comments: Each provider has Deadline from the moment its Destroy() begins.
+//           One that cannot begin within Deadline of Run(), because every
+//           pool thread is held by a Service already forced, is forced
+//           without being called. So Run() returns within twice Deadline.
+//=============================================================================
+class AALRUNTIME_API ServiceShutdown : private CUnCopyable
+{
+public:
+   enum eResult {
+      Pending = 0, ///< Not yet begun.
+      Running,     ///< In Destroy().
+      Done,        ///< Destroy() returned. The module may be unloaded.
+      Forced       ///< Abandoned at its deadline. The module must stay loaded.
+   };
+
+   struct Record
+   {
+      std::string        Name;
+      IServiceModule    *pProvider;
+      eResult            Result;
+      btUnsigned64bitInt Nanos;  ///< In Destroy(), or until forced.
+   };
+
+   ServiceShutdown();
+   ~ServiceShutdown();
+
+   /// Queue pProvider's Destroy(). Only before Run().
+   void Add(std::string const &sName, IServiceModule *pProvider);
+
+   /// Destroy every provider queued, waiting at most Deadline milliseconds for
+   /// each. AAL_INFINITE_WAIT selects DefaultDeadline().
+   ///
+   /// @return The number of providers forced.
+   btUnsignedInt Run(btTime Deadline);
+
+   /// Snapshot of provider i, in the order added.
+   Record               Get(btUnsignedInt i) const;
+   btUnsignedInt      Count() const;
+
+   /// One line, eg "ALI=1834us libHWALIAFU=12003us(forced)".
+   std::string     ToString() const;
+
+   static btTime DefaultDeadline();
+
+private:
+   class State;
+   class Task;
+
+   State *m_pState;  // Shared with the pool, which outlives Run() for a forced Service.
+};
+
+END_NAMESPACE(AAL)
+
+#endif // __SERVICESHUTDOWN_H__
@@ -0,0 +1,119 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// @file Affinity.h
+/// @brief CPU and NUMA node placement for threads.
+/// @ingroup OSAL
+/// @verbatim
+/// Accelerator Abstraction Layer
+///
+/// An OSLAffinity names the CPUs a thread may run on, either as a list of
+/// CPUs or as all of the CPUs of one NUMA node. It is given to OSLThread and
+/// OSLThreadGroup at creation, or applied to a running thread.
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version. @endverbatim
+//****************************************************************************
+#ifndef __AALSDK_OSAL_AFFINITY_H__
+#define __AALSDK_OSAL_AFFINITY_H__
+#include <string>
+#include <aalsdk/AALTypes.h>
+#include <aalsdk/osal/CriticalSection.h>
+
+/// @addtogroup OSAL
+/// @{
+
+BEGIN_NAMESPACE(AAL)
+
+/// Placement of a thread on CPUs. A default-constructed OSLAffinity places
+///  nothing: threads given it run wherever the OS schedules them.
+class OSAL_API OSLAffinity
+{
+public:
+   /// One more than the largest CPU number that can be named.
+   enum { MaxCPUs = 1024 };
+
+   /// No placement.
+   OSLAffinity();
+
+   /// Parses Spec, which is a CPU list in the format of the Linux cpulist
+   ///  files ("0-3,8,10-11"), or "node:N" for the CPUs of NUMA node N. A NULL
+   ///  or empty Spec means no placement. IsOK() is false if Spec is malformed.
+   explicit OSLAffinity(btcString Spec);
+
+   /// All of the CPUs of NUMA node Node.
+   static OSLAffinity NUMANode(btInt Node);
+
+   /// false if the constructor's Spec could not be parsed.
+   btBool       IsOK() const { return m_bIsOK; }
+   /// true if there is a placement to apply.
+   btBool      IsSet() const;
+   /// The NUMA node placed on, or -1 for a CPU list or no placement.
+   btInt        Node() const { return m_Node;  }
+
+   /// Add CPU to a CPU list placement. A node placement becomes a CPU list.
+   btBool     AddCPU(btUnsignedInt CPU);
+   /// Whether CPU is in a CPU list placement.
+   btBool     HasCPU(btUnsignedInt CPU) const;
+
+   /// Restrict the calling thread to the placement.
+   /// @retval true   The placement was applied, or there is none.
+   /// @retval false  The OS refused it, or a node has no CPUs.
+   btBool      Apply() const;
+   /// Restrict thread tid, as returned by GetThreadID(), to the placement.
+   btBool      Apply(btTID tid) const;
+
+   /// The placement in the form the constructor parses, empty if none.
+   std::string ToString() const;
+
+   /// The number of NUMA nodes, 1 where the OS reports none.
+   static btInt    NumNodes();
+   /// The NUMA node of the CPU the calling thread is running on, -1 if unknown.
+   static btInt CurrentNode();
+
+   /// The placement of the threads the SDK creates for itself: the Runtime's
+   ///  message dispatcher, Service message delivery and the AIA message pump.
+   ///  Runtime::start() sets it from AALRUNTIME_CONFIG_AFFINITY.
+   static void        SetInternalDefault(const OSLAffinity &rAffinity);
+   static OSLAffinity InternalDefault();
+
+private:
+   btBool ParseCPUList(btcString List);
+
+   btBool             m_bIsOK;
+   btInt              m_Node;
+   btUnsigned64bitInt m_CPUs[MaxCPUs / 64];
+
+   static OSLAffinity     sm_InternalDefault;
+   static CriticalSection sm_Lock;
+};
+
+END_NAMESPACE(AAL)
+
+/// @}
+
+#endif // __AALSDK_OSAL_AFFINITY_H__
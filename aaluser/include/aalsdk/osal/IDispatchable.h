@@ -44,6 +44,7 @@
 ///           can effectively be functors by invoking the desired behavior in
 ///           the operator () member.
 /// WHEN:          WHO:     WHAT:
+/// 10/19/2016              Added dispatch classes
 /// @endverbatim
 //****************************************************************************///
 #ifndef __IDISPATCHABLE_H__
@@ -55,16 +56,31 @@
 
 BEGIN_NAMESPACE(AAL)
 
+/// @brief How urgently an IDispatchable should run.
+///
+/// A dispatcher that honors classes runs queued items of a higher class first, and in order
+///  within a class. See OSLThreadGroup::SetPriorityDispatch().
+enum DispatchClass
+{
+   DispatchCritical = 0, ///< Revocations, release requests and AFU reconfiguration failures.
+   DispatchNormal,       ///< The default.
+   DispatchBulk,         ///< Application work that may wait behind everything else.
+   DispatchClasses       ///< The number of classes.
+};
+
 /// @brief Object used to schedule work
 class OSAL_API IDispatchable
 {
 public:
    /// @brief  Where the work happens. The function performed here can be virtually anything.
    /// Most often used to schedule a callback.
-   ///
-   /// @returns void
+   ///
+   /// @returns void
    virtual void operator() () = 0;
 
+   /// @brief  How urgently to run this item. Ignored by dispatchers that do not honor classes.
+   virtual DispatchClass GetDispatchClass() const { return DispatchNormal; }
+
    virtual ~IDispatchable() {}
 };
 
@@ -175,14 +191,14 @@ public:
 protected:
    DispatchableGroup() {}
 
-#if defined( _MSC_VER )
-#pragma warning( push )
-#pragma warning( disable:4251 )  // Cannot export template definitions
-#endif // _MSC_VER
+#if defined( _MSC_VER )
+#pragma warning( push )
+#pragma warning( disable:4251 )  // Cannot export template definitions
+#endif // _MSC_VER
    std::list<IDispatchable *> m_DispList;
-#if defined( _MSC_VER )
-#pragma warning( pop )
-#endif // _MSC_VER
+#if defined( _MSC_VER )
+#pragma warning( pop )
+#endif // _MSC_VER
 };
 
 END_NAMESPACE(AAL)
@@ -47,6 +47,7 @@
 #ifndef __AALSDK_OSAL_THREAD_H__
 #define __AALSDK_OSAL_THREAD_H__
 #include <aalsdk/osal/OSSemaphore.h>
+#include <aalsdk/osal/Affinity.h>
 
 #ifdef __AAL_UNKNOWN_OS__
 # error TODO: Threads for unknown OS.
@@ -140,11 +141,13 @@ public:
    /// @param[in]  nPriority   The thread priority. Must be one of ThreadPriority values. If not, default is normal.
    /// @param[in]  pContext    Parameter to be passed to pProc.
    /// @param[in]  ThisThread  true if pProc is to be run in the context of this thread. false if in a new thread.
+   /// @param[in]  Affinity    The CPUs the thread runs on. Applied, like nPriority, before pProc is called.
    /// @return void
    OSLThread(ThreadProc                    pProc,
 	          OSLThread::ThreadPriority     nPriority,
 	          void                         *pContext,
-	          btBool                        ThisThread = false);
+	          btBool                        ThisThread = false,
+	          const OSLAffinity            &Affinity   = OSLAffinity());
    // OSLThread Destructor.
 	virtual ~OSLThread();
    /// Check the internal state of the thread.
@@ -184,6 +187,10 @@ public:
    /// Retrieve this thread's identifier. Don't compare ID's outright. Use IsThisThread().
    /// @return This thread's ID.
    btTID                tid();
+   /// Move the running thread to the CPUs of rAffinity. An unset rAffinity leaves it where it is.
+   /// @retval true  if the placement was applied.
+   /// @retval false if the OS refused it, or the thread has been joined, detached or ran locally.
+   btBool       SetAffinity(const OSLAffinity &rAffinity);
 
 
    static const btInt sm_PriorityTranslationTable[(btInt)THREADPRIORITY_COUNT];
@@ -199,6 +206,7 @@ private:
    ThreadProc         m_pProc;
    btInt              m_nPriority;
    void              *m_pContext;
+   OSLAffinity        m_Affinity;
    btUnsignedInt      m_State;
    CSemaphore         m_Semaphore;
 
@@ -39,7 +39,9 @@
 /// 05/08/2008     HM       Comments & License
 /// 01/04/2009     HM       Updated Copyright
 /// 03/06/2014     JG       Complete rewrite
-/// 05/07/2015     TSW      Complete rewrite@endverbatim
+/// 05/07/2015     TSW      Complete rewrite
+/// 10/18/2016              Grow and shrink between min and max threads
+/// 10/19/2016              Priority dispatch by DispatchClass@endverbatim
 //****************************************************************************
 #ifndef __AALSDK_OSAL_THREADGROUP_H__
 #define __AALSDK_OSAL_THREADGROUP_H__
@@ -53,6 +55,96 @@
 
 BEGIN_NAMESPACE(AAL)
 
+/// Default time an extra worker may sit idle before it retires, in milliseconds.
+#define OSLTHREADGROUP_DEFAULT_KEEPALIVE       5000
+/// Default number of queued work items no idle worker will take, at which a worker is added.
+#define OSLTHREADGROUP_DEFAULT_QUEUE_THRESHOLD 1
+/// Default time the oldest work item may wait in the queue before a worker is added, in milliseconds.
+#define OSLTHREADGROUP_DEFAULT_WAIT_THRESHOLD  10
+/// Default number of work items taken from higher classes while a lower class waits, after
+///  which the lower class is served.
+#define OSLTHREADGROUP_DEFAULT_STARVATION_LIMIT 16
+
+/// @brief When a Thread Group created with uiMaxThreads > uiMinThreads grows and shrinks.
+///
+/// A worker is added, up to uiMaxThreads, when QueueThreshold or more queued work items are
+///  not covered by an idle worker, or when the oldest uncovered item has waited WaitThreshold
+///  milliseconds. A worker beyond uiMinThreads retires after KeepAlive milliseconds without work.
+///  AAL_INFINITE_WAIT disables the corresponding rule.
+struct OSAL_API OSLThreadGroupScaling
+{
+   OSLThreadGroupScaling(btUnsignedInt QThreshold=OSLTHREADGROUP_DEFAULT_QUEUE_THRESHOLD,
+                         btTime        WThreshold=OSLTHREADGROUP_DEFAULT_WAIT_THRESHOLD,
+                         btTime        Keep=OSLTHREADGROUP_DEFAULT_KEEPALIVE) :
+      QueueThreshold(QThreshold),
+      WaitThreshold(WThreshold),
+      KeepAlive(Keep)
+   {}
+
+   btUnsignedInt QueueThreshold;
+   btTime        WaitThreshold;
+   btTime        KeepAlive;
+};
+
+/// @brief Work queue statistics for one DispatchClass.
+struct OSAL_API OSLThreadGroupClassStats
+{
+   OSLThreadGroupClassStats() :
+      QueueDepth(0),
+      Dispatched(0),
+      Promoted(0),
+      TotalWaitNanos(0),
+      MaxWaitNanos(0)
+   {}
+
+   btUnsignedInt      QueueDepth;     ///< Work items queued now.
+   btUnsigned64bitInt Dispatched;     ///< Work items workers have taken from the queue.
+   btUnsigned64bitInt Promoted;       ///< Of those, taken ahead of a higher class by the starvation limit.
+   btUnsigned64bitInt TotalWaitNanos; ///< Time those items spent queued.
+   btUnsigned64bitInt MaxWaitNanos;
+};
+
+/// @brief Snapshot of a Thread Group's workers and work queue.
+///
+/// Queue wait is recorded only for elastic groups and groups with priority dispatch.
+struct OSAL_API OSLThreadGroupStats
+{
+   OSLThreadGroupStats() :
+      Threads(0),
+      IdleThreads(0),
+      PeakThreads(0),
+      Spawned(0),
+      Retired(0),
+      QueueDepth(0),
+      PeakQueueDepth(0),
+      Dispatched(0),
+      TotalWaitNanos(0),
+      MaxWaitNanos(0),
+      BusyNanos(0),
+      WorkerNanos(0),
+      Classes()
+   {}
+
+   /// Fraction of the workers' lifetime spent executing work items.
+   double Utilization() const { return ( 0 == WorkerNanos ) ? 0.0 : (double)BusyNanos / (double)WorkerNanos; }
+
+   btUnsignedInt      Threads;        ///< Workers now.
+   btUnsignedInt      IdleThreads;    ///< Workers now waiting for work. Elastic groups only.
+   btUnsignedInt      PeakThreads;
+   btUnsigned64bitInt Spawned;        ///< Workers added beyond those the group was created with.
+   btUnsigned64bitInt Retired;        ///< Workers retired after the keep-alive.
+   btUnsignedInt      QueueDepth;     ///< Work items queued now.
+   btUnsignedInt      PeakQueueDepth;
+   btUnsigned64bitInt Dispatched;     ///< Work items workers have taken from the queue.
+   btUnsigned64bitInt TotalWaitNanos; ///< Time those items spent queued.
+   btUnsigned64bitInt MaxWaitNanos;
+   btUnsigned64bitInt BusyNanos;      ///< Time workers spent executing work items.
+   btUnsigned64bitInt WorkerNanos;    ///< Lifetime of the workers, summed over workers.
+
+   /// By DispatchClass. Without priority dispatch, every item counts as DispatchNormal.
+   OSLThreadGroupClassStats Classes[DispatchClasses];
+};
+
 class OSAL_API IThreadGroup
 {
 public:
@@ -126,11 +218,16 @@ public:
    ///  If uiMinThreads is the default 0, the Thread Group will determine the minimum
    ///  number of threads in the group.
    ///
-   ///  If uiMaxThreads < uiMinThreads then uiMaxThreads is set to uiMinThreads.
+   ///  If uiMaxThreads < uiMinThreads then uiMaxThreads is set to uiMinThreads. If
+   ///  uiMaxThreads > uiMinThreads, the group adds workers up to uiMaxThreads as work backs
+   ///  up, and retires the extra ones once idle. See OSLThreadGroupScaling.
+   ///
+   ///  Every worker runs on the CPUs of Affinity.
    OSLThreadGroup(btUnsignedInt             uiMinThreads=0,
                   btUnsignedInt             uiMaxThreads=0,
                   OSLThread::ThreadPriority nPriority=OSLThread::THREADPRIORITY_NORMAL,
-                  btTime                    JoinTimeout=AAL_INFINITE_WAIT);
+                  btTime                    JoinTimeout=AAL_INFINITE_WAIT,
+                  const OSLAffinity        &Affinity=OSLAffinity());
 
    virtual ~OSLThreadGroup();
 
@@ -198,6 +295,28 @@ public:
    virtual btObjectType      UserDefined() const               { return m_pState->UserDefined();     }
    // </IThreadGroup>
 
+   /// @brief  Move the workers, and any created later, to the CPUs of rAffinity.
+   /// @retval true   if every running worker was moved.
+   /// @retval false  if the OS refused the placement for one or more workers.
+   btBool                    SetAffinity(const OSLAffinity &rAffinity) { return m_pState->SetAffinity(rAffinity); }
+
+   /// @brief  Change when the group grows and shrinks. Has no effect on a static group.
+   /// @note   A worker already waiting for work picks up a new KeepAlive once it next wakes.
+   void                       SetScaling(const OSLThreadGroupScaling &rScaling) { m_pState->SetScaling(rScaling); }
+
+   /// @brief  Dispatch work items by their DispatchClass rather than in the order added.
+   ///
+   /// Workers take the oldest item of the highest class queued, except that once StarvationLimit
+   ///  items have been taken from higher classes while a lower class waited, the lower class is
+   ///  served next. A StarvationLimit of 0 serves strictly by class.
+   /// @note   Items of different classes may run out of the order they were added.
+   void             SetPriorityDispatch(btBool        bEnable,
+                                        btUnsignedInt StarvationLimit=OSLTHREADGROUP_DEFAULT_STARVATION_LIMIT)
+   { m_pState->SetPriorityDispatch(bEnable, StarvationLimit); }
+
+   /// @brief  Retrieve a snapshot of the group's workers and work queue.
+   void                         GetStats(OSLThreadGroupStats &rStats) const { m_pState->GetStats(rStats); }
+
 protected:
    virtual btBool CreateWorkerThread(ThreadProc fn, OSLThread::ThreadPriority pri, void *context)
    { return m_pState->CreateWorkerThread(fn, pri, context); }
@@ -218,7 +337,10 @@ private:
 #define THRGRPSTATE_FLAG_SELF_JOIN 0x00000002
 #define THRGRPSTATE_FLAG_JOINING   0x00000004
    public:
-      ThrGrpState(btUnsignedInt NumThreads);
+      ThrGrpState(btUnsignedInt             MinThreads,
+                  btUnsignedInt             MaxThreads,
+                  OSLThread::ThreadPriority Priority,
+                  const OSLAffinity        &Affinity);
       virtual ~ThrGrpState();
 
       // <IThreadGroup>
@@ -235,6 +357,11 @@ private:
       virtual btObjectType      UserDefined() const;
       // </IThreadGroup>
 
+      btBool                    SetAffinity(const OSLAffinity & );
+      void                       SetScaling(const OSLThreadGroupScaling & );
+      void              SetPriorityDispatch(btBool , btUnsignedInt );
+      void                         GetStats(OSLThreadGroupStats & ) const;
+
    protected:
       enum eState {
          Running = 0,
@@ -243,7 +370,45 @@ private:
          Joining
       };
 
-      typedef std::queue<IDispatchable *> work_queue_t;
+      // A queued work item, its class, and when it was queued in nanoseconds (0 if not recorded).
+      struct WorkItem
+      {
+         WorkItem(IDispatchable *p, btUnsigned64bitInt q) : pWork(p), Queued(q), Class(DispatchNormal) {}
+         IDispatchable     *pWork;
+         btUnsigned64bitInt Queued;
+         DispatchClass      Class;
+      };
+
+      typedef std::deque<WorkItem>        work_class_t;
+      typedef work_class_t::iterator      work_class_iter;
+
+      // One FIFO per DispatchClass. front() and pop() refer to the item the next worker should
+      //  take: the oldest of the highest class queued, unless a lower class has been passed over
+      //  StarvationLimit times.
+      class WorkQueue
+      {
+      public:
+         WorkQueue();
+
+         void                push(const WorkItem & );
+         /// returns true if the item was taken ahead of a higher class.
+         btBool               pop();
+         const WorkItem    &front() const { return m_Class[Next()].front(); }
+         size_t              size() const { return m_Size;                   }
+         btBool             empty() const { return 0 == m_Size;              }
+         work_class_t &     Class(DispatchClass c)       { return m_Class[c]; }
+   const work_class_t &     Class(DispatchClass c) const { return m_Class[c]; }
+
+         btUnsignedInt m_StarvationLimit;
+
+      protected:
+         DispatchClass Next() const;
+
+         work_class_t  m_Class[DispatchClasses];
+         btUnsignedInt m_Passed[DispatchClasses]; // Items taken from higher classes while this one waited.
+         size_t        m_Size;
+      };
+
       typedef std::list<OSLThread      *> thr_list_t;
       typedef thr_list_t::iterator        thr_list_iter;
       typedef thr_list_t::const_iterator  const_thr_list_iter;
@@ -257,14 +422,26 @@ private:
       Barrier       m_ThrJoinBarrier;
       Barrier       m_ThrExitBarrier;
       CSemaphore    m_WorkSem;
+      OSLAffinity   m_Affinity;
+
+      btUnsignedInt             m_MinThreads;
+      btUnsignedInt             m_MaxThreads;
+      OSLThread::ThreadPriority m_Priority;
+      OSLThreadGroupScaling     m_Scaling;
+      btUnsignedInt             m_Starting;    // Workers reserved by GrowIfBacklogged(), not yet created.
+      btUnsignedInt             m_IdleThreads;
+      OSLThreadGroupStats       m_Stats;
+      btUnsigned64bitInt        m_ThreadsSince; // Last change in the number of workers, in nanoseconds.
+      volatile btBool           m_bPriority;    // Read by Add() before taking the lock.
 
 #ifdef _MSC_VER
 # pragma warning(push)
 # pragma warning(disable:4251)
 #endif // _MSC_VER
-      work_queue_t  m_workqueue;
+      WorkQueue     m_workqueue;
       thr_list_t    m_RunningThreads;
       thr_list_t    m_ExitedThreads;
+      thr_list_t    m_RetiredThreads;
 #ifdef _MSC_VER
 # pragma warning(pop)
 #endif // _MSC_VER
@@ -371,10 +548,18 @@ private:
       void         WorkerHasExited(OSLThread * );
       void WorkerIsSelfTerminating(OSLThread * );
 
+      btBool  Elastic() const { return m_MaxThreads > m_MinThreads; }
+      btBool GrowIfBacklogged();
+      void       SpawnWorker();
+      btBool WorkerMayRetire(OSLThread * );
+      void    CountThreads();
+
       /// returns NULL if tid not in group.
       OSLThread * ThreadRunningInThisGroup(btTID ) const;
 
-      eState GetWorkItem(IDispatchable * &pWork);
+      /// BusyNanos is how long the caller spent on its previous work item. Taken is when pWork
+      ///  left the queue.
+      eState GetWorkItem(IDispatchable * &pWork, btUnsigned64bitInt BusyNanos, btBool &bTimedOut, btUnsigned64bitInt &Taken);
       eState       State() const { return m_eState; }
       eState       State(eState );
 
@@ -41,6 +41,13 @@
 ///    IALIBuffer Functions for allocating shared buffers between software
 ///               and the AFU
 ///    IALIPerf   Functions for accessing performance counters
+///    IALIPerfSampler
+///               Functions for reading performance counters without a
+///               NamedValueSet, and for sampling them in the background
+///    IALITelemetry
+///               Functions for collecting thermal, power, error and
+///               performance state together and publishing it to other
+///               processes
 ///    IALIReset  Functions for enabling, disabling, quiescing, and resetting
 ///               the AFU
 ///    IALIReconfigure
@@ -64,6 +71,9 @@
 ///   iidALI_CONF_Service         __INTC_IID(INTC_sysAFULinkInterface,0x0007)
 ///   iidALI_CONF_Service_Client  __INTC_IID(INTC_sysAFULinkInterface,0x0008)
 ///   iidALI_STAP_Service         __INTC_IID(INTC_sysAFULinkInterface,0x0009)
+///   iidALI_PERF_SAMPLER_Service __INTC_IID(INTC_sysAFULinkInterface,0x0014)
+///   iidALI_TELEMETRY_Service    __INTC_IID(INTC_sysAFULinkInterface,0x0015)
+///   iidALI_CMPL_Service         __INTC_IID(INTC_sysAFULinkInterface,0x0016)
 /// <TODO: LIST INTERFACES HERE>
 ///
 /// If an ALI Service Client needs any particular Service Interface, then it must check at runtime
@@ -114,6 +124,10 @@ BEGIN_NAMESPACE(AAL)
 // FIXME: declare this where it should be declared...
 #define ALI_MMAP_TARGET_VADDR_KEY        "ALIMmapTargetVAddr"
 #define ALI_MMAP_TARGET_VADDR_DATATYPE   void *
+#define ALI_MMAP_READONLY_KEY            "ALIMmapReadOnly"
+#define ALI_MMAP_READONLY_DATATYPE       btBool
+#define ALI_BUFALLOCATE_NUMA_NODE_KEY      "ALIBufAllocateNumaNode"
+#define ALI_BUFALLOCATE_NUMA_NODE_DATATYPE btUnsigned32bitInt
 #define ALI_GETFEATURE_ID_KEY            "ALIGetFeatureID"
 #define ALI_GETFEATURE_ID_DATATYPE       btUnsigned64bitInt
 #define ALI_GETFEATURE_TYPE_KEY          "ALIGetFeatureTYPE"
@@ -213,6 +227,9 @@ typedef enum
 #define iidALI_FMEERR_Service       __INTC_IID(INTC_sysAFULinkInterface,0x0011)
 #define iidALI_POWER_Service        __INTC_IID(INTC_sysAFULinkInterface,0x0012)
 #define iidALI_TEMP_Service         __INTC_IID(INTC_sysAFULinkInterface,0x0013)
+#define iidALI_PERF_SAMPLER_Service __INTC_IID(INTC_sysAFULinkInterface,0x0014)
+#define iidALI_TELEMETRY_Service    __INTC_IID(INTC_sysAFULinkInterface,0x0015)
+#define iidALI_CMPL_Service         __INTC_IID(INTC_sysAFULinkInterface,0x0016)
 
 
 // FME GUID
@@ -230,6 +247,10 @@ typedef enum
 /// Key for selecting SWSimCCIAFU
 # define ALIAFU_NVS_VAL_TARGET_SWSIM "ALIAFUTarget_SWSim"
 
+/// Key for recording the ALI session to a trace file (btcString path).
+/// See aalsdk/utils/ALITrace.h.
+#define ALIAFU_NVS_KEY_RECORD_TRACE "ALIAFURecordTrace"
+
 
 //-----------------------------------------------------------------------------
 // AFU Target type.
@@ -479,6 +500,8 @@ public:
    /// @param[in]  Length       Requested length, in bytes.
    /// @param[out] pBufferptr    Buffer Pointer.
    /// @param[in]  rInputArgs   Reference to optional input arguments if needed.
+   ///                          ALI_BUFALLOCATE_NUMA_NODE_KEY takes the buffer from the
+   ///                          memory of the given NUMA node rather than the device's.
    /// @return On success, ali_errnumOK.
    /// @return On failure, ali_errnumSystem.
    virtual AAL::ali_errnum_e bufferAllocate( btWSSize             Length,
@@ -600,6 +623,111 @@ public:
                                            NamedValueSet    const &pOptArgs ) = 0;
 }; // class IALIPerf
 
+/// @brief Index of each counter within ALIPerfSample::counters.
+typedef enum
+{
+   aliPerfReadHit = 0,        ///< AALPERF_READ_HIT
+   aliPerfWriteHit,           ///< AALPERF_WRITE_HIT
+   aliPerfReadMiss,           ///< AALPERF_READ_MISS
+   aliPerfWriteMiss,          ///< AALPERF_WRITE_MISS
+   aliPerfEvictions,          ///< AALPERF_EVICTIONS
+   aliPerfPCIe0Read,          ///< AALPERF_PCIE0_READ
+   aliPerfPCIe0Write,         ///< AALPERF_PCIE0_WRITE
+   aliPerfPCIe1Read,          ///< AALPERF_PCIE1_READ
+   aliPerfPCIe1Write,         ///< AALPERF_PCIE1_WRITE
+   aliPerfUPIRead,            ///< AALPERF_UPI_READ
+   aliPerfUPIWrite,           ///< AALPERF_UPI_WRITE
+   aliPerfVTdMemReadTrans,    ///< AALPERF_VTD_AFU_MEMREAD_TRANS
+   aliPerfVTdMemWriteTrans,   ///< AALPERF_VTD_AFU_MEMWRITE_TRANS
+   aliPerfVTdDevTLBReadHit,   ///< AALPERF_VTD_AFU_DEVTLBREAD_HIT
+   aliPerfVTdDevTLBWriteHit,  ///< AALPERF_VTD_AFU_DEVTLBWRITE_HIT
+   aliPerfNumCounters
+} ALIPerfCounter;
+
+/// @brief One timestamped reading of the global performance counters.
+struct ALIPerfSample
+{
+   btUnsigned64bitInt timestamp;                     ///< Monotonic time of the read, in ns.
+   AALPERF_DATATYPE   version;                       ///< AALPERF_VERSION
+   AALPERF_DATATYPE   counters[aliPerfNumCounters];  ///< Indexed by ALIPerfCounter.
+};
+
+/// @brief Per-second counter rates over the interval between two samples.
+struct ALIPerfRates
+{
+   btUnsigned64bitInt interval;                      ///< ns between the samples.
+   double             perSecond[aliPerfNumCounters]; ///< Indexed by ALIPerfCounter.
+};
+
+/// @brief Compute the rates between rPrev and rCur, allowing for 64-bit counter wrap.
+///
+/// @retval false rCur is not later than rPrev.
+inline btBool ALIPerfComputeRates(ALIPerfSample const &rPrev,
+                                  ALIPerfSample const &rCur,
+                                  ALIPerfRates        &rRates)
+{
+   if ( rCur.timestamp <= rPrev.timestamp ) {
+      return false;
+   }
+
+   rRates.interval = rCur.timestamp - rPrev.timestamp;
+
+   for ( int i = 0 ; i < aliPerfNumCounters ; ++i ) {
+      // Unsigned subtraction yields the right delta across a single wrap.
+      AALPERF_DATATYPE delta = rCur.counters[i] - rPrev.counters[i];
+      rRates.perSecond[i] = ( (double)delta * 1.0e9 ) / (double)rRates.interval;
+   }
+
+   return true;
+}
+
+//-----------------------------------------------------------------------------
+// IALIPerfSampler interface.
+//-----------------------------------------------------------------------------
+/// Number of samples retained by the background sampler.
+#define ALIPERF_SAMPLER_DEPTH 64
+
+/// @brief  Read Global Performance Data without building a NamedValueSet,
+///         and optionally sample it in the background (synchronous).
+///
+/// While sampling, the ALIPERF_SAMPLER_DEPTH most recent samples are kept
+///    in a lock-free ring. Any number of threads may read them without
+///    issuing a driver transaction and without blocking the sampler.
+///
+/// @note   This service interface is obtained from an IBase via iidALI_PERF_SAMPLER_Service.
+/// @code
+///         m_pALIPerfSampler = dynamic_ptr<IALIPerfSampler>(iidALI_PERF_SAMPLER_Service, pServiceBase);
+/// @endcode
+class IALIPerfSampler
+{
+public:
+   virtual ~IALIPerfSampler() {}
+
+   /// @brief Read the counters now, directly into rSample.
+   /// @retval false The driver transaction failed.
+   virtual btBool performanceCountersRead( ALIPerfSample &rSample ) = 0;
+
+   /// @brief Start sampling every PeriodMillis milliseconds.
+   /// @retval false Already sampling, PeriodMillis is 0, or the thread could not be created.
+   virtual btBool performanceSamplerStart( btTime PeriodMillis ) = 0;
+
+   /// @brief Stop the background sampler. Retained samples remain readable.
+   virtual void performanceSamplerStop() = 0;
+
+   /// @brief Copy the newest sample.
+   /// @retval false No sample has been taken.
+   virtual btBool performanceSamplerLatest( ALIPerfSample &rSample ) = 0;
+
+   /// @brief Compute the rates between the two newest samples.
+   /// @retval false Fewer than two samples have been taken.
+   virtual btBool performanceSamplerRates( ALIPerfRates &rRates ) = 0;
+
+   /// @brief Copy up to Max samples, newest first, into pSamples.
+   /// @return The number of samples copied.
+   virtual btUnsigned32bitInt performanceSamplerHistory( ALIPerfSample     *pSamples,
+                                                         btUnsigned32bitInt Max ) = 0;
+}; // class IALIPerfSampler
+
 //-----------------------------------------------------------------------------
 // IALIReset interface.
 //-----------------------------------------------------------------------------
@@ -1183,6 +1311,177 @@ public:
 
 }; // class IALIPower
 
+
+//-----------------------------------------------------------------------------
+// IALITelemetry interface.
+//-----------------------------------------------------------------------------
+/// Bits of ALITelemetrySnapshot::valid: which parts of the snapshot were read.
+#define ALITELEMETRY_THERMAL   0x00000001
+#define ALITELEMETRY_POWER     0x00000002
+#define ALITELEMETRY_FMEERROR  0x00000004
+#define ALITELEMETRY_PERF      0x00000008
+#define ALITELEMETRY_ALL       0x0000000f
+
+/// @brief Thermal, power, FME error and performance state read in one pass.
+///
+/// Fields correspond to the values returned by IALITemperature,
+///    IALIPower, IALIFMEError and IALIPerfSampler. Fields of a part whose
+///    bit is clear in valid are zero.
+struct ALITelemetrySnapshot
+{
+   btUnsigned64bitInt timestamp;          ///< Monotonic time the pass completed, in ns.
+   btUnsigned64bitInt collectTime;        ///< ns spent in the driver for this pass.
+   btUnsigned32bitInt valid;              ///< ALITELEMETRY_* bits.
+   btUnsigned32bitInt reserved;
+
+   // ALITELEMETRY_THERMAL
+   AALTEMP_DATATYPE   temperature;        ///< AALTEMP_FPGA_TEMP_SENSOR1, 0 if the reading is not valid.
+   AALTEMP_DATATYPE   temperatureSeqNum;  ///< AALTEMP_READING_SEQNUM
+   AALTEMP_DATATYPE   threshold1;         ///< AALTEMP_THRESHOLD1, 0 if disabled.
+   AALTEMP_DATATYPE   threshold2;         ///< AALTEMP_THRESHOLD2, 0 if disabled.
+   AALTEMP_DATATYPE   thermTrip;          ///< AALTEMP_THERM_TRIP
+
+   // ALITELEMETRY_POWER
+   AALPOWER_DATATYPE  powerConsumed;      ///< AALPOWER_CONSUMPTION
+
+   // ALITELEMETRY_FMEERROR - raw error CSRs, as decoded by IALIFMEError::errorGet().
+   btUnsigned64bitInt fmeError0;
+   btUnsigned64bitInt pcie0Error;
+   btUnsigned64bitInt pcie1Error;
+   btUnsigned64bitInt firstError;
+   btUnsigned64bitInt nextError;
+   btUnsigned64bitInt rasGreenError;
+   btUnsigned64bitInt rasBlueError;
+   btUnsigned64bitInt rasWarnError;
+
+   // ALITELEMETRY_PERF
+   ALIPerfSample      perf;
+};
+
+/// @brief  Collect FPGA telemetry in one place (not AFU-specific).
+///
+/// A collector thread reads every part of an ALITelemetrySnapshot once per
+///    period and publishes it. Readers in this process use telemetryLatest().
+///    When a shared memory name is given, the snapshots are also published
+///    there for ALITelemetryReader (aalsdk/utils/ALITelemetryShm.h), so any
+///    number of local processes can read them without the driver.
+///
+/// @note   This service interface is obtained from an IBase via iidALI_TELEMETRY_Service.
+/// @code
+///         m_pALITelemetry = dynamic_ptr<IALITelemetry>(iidALI_TELEMETRY_Service, pServiceBase);
+/// @endcode
+class IALITelemetry
+{
+public:
+   virtual ~IALITelemetry() {}
+
+   /// @brief Read every part of a snapshot now, synchronously.
+   /// @retval false No part could be read.
+   virtual btBool telemetryCollect( ALITelemetrySnapshot &rSnapshot ) = 0;
+
+   /// @brief Start collecting every PeriodMillis milliseconds.
+   /// @param[in] PeriodMillis Collection period. Must be nonzero.
+   /// @param[in] ShmName      POSIX shared memory name to publish to, e.g. "/aal_telemetry",
+   ///                         or NULL to publish only within this process.
+   /// @retval false Already collecting, bad parameter, or the shared memory or
+   ///               thread could not be created.
+   virtual btBool telemetryStart( btTime PeriodMillis, btcString ShmName ) = 0;
+
+   /// @brief Stop collecting and remove the shared memory, if any.
+   virtual void telemetryStop() = 0;
+
+   /// @brief Copy the newest collected snapshot.
+   /// @retval false Nothing has been collected.
+   virtual btBool telemetryLatest( ALITelemetrySnapshot &rSnapshot ) = 0;
+
+}; // class IALITelemetry
+
+/// Identifies one registered completion condition. 0 is never a valid handle.
+typedef btUnsigned64bitInt ALICompletionHandle;
+
+/// @brief Wait statistics kept by IALICompletion.
+struct ALICompletionStats
+{
+   btUnsigned64bitInt waits;            ///< Waits that saw their condition.
+   btUnsigned64bitInt timeouts;         ///< Waits that timed out.
+   btUnsigned64bitInt spinCompletions;  ///< Waits satisfied while spinning.
+   btUnsigned64bitInt yieldCompletions; ///< Waits satisfied while yielding.
+   btUnsigned64bitInt sleepCompletions; ///< Waits satisfied while sleeping.
+   btUnsigned64bitInt totalWaitNanos;   ///< Time spent in waits that saw their condition.
+   btUnsigned64bitInt maxWaitNanos;     ///< Longest wait that saw its condition.
+   btUnsigned64bitInt notifies;         ///< Calls to completionNotify().
+};
+
+/// @brief  Wait for the AFU to update a word in a shared buffer.
+///
+/// A condition is met when ( *pWord & Mask ) == Value. Waits spin for a
+///    while (adapted to how long recent waits took), then yield, then sleep
+///    with a growing period. Sleepers are woken early by completionNotify(),
+///    which ALI calls on every event from the AFU.
+///
+/// A thread may register any number of conditions and wait for them one at
+///    a time or with completionWaitAny(). A condition stays registered until
+///    a wait sees it met or it is cancelled; a timed out wait leaves it
+///    registered.
+///
+/// @note   This service interface is obtained from an IBase via iidALI_CMPL_Service.
+/// @code
+///         m_pALICompletion = dynamic_ptr<IALICompletion>(iidALI_CMPL_Service, pServiceBase);
+/// @endcode
+class IALICompletion
+{
+public:
+   virtual ~IALICompletion() {}
+
+   /// @brief       Result of a wait.
+   enum e_Completion {
+      e_Done,                    ///< The condition was met. Its handle is released.
+      e_Timeout,                 ///< The timeout expired first.
+      e_BadHandle                ///< The handle is not registered.
+   };
+
+   /// @brief Register the condition ( *pWord & Mask ) == Value.
+   /// @return The handle, or 0 if no more conditions can be registered.
+   virtual ALICompletionHandle completionRegister( volatile btUnsigned32bitInt *pWord,
+                                                   btUnsigned32bitInt           Mask,
+                                                   btUnsigned32bitInt           Value ) = 0;
+   /// @brief Register the condition ( *pWord & Mask ) == Value.
+   /// @return The handle, or 0 if no more conditions can be registered.
+   virtual ALICompletionHandle completionRegister( volatile btUnsigned64bitInt *pWord,
+                                                   btUnsigned64bitInt           Mask,
+                                                   btUnsigned64bitInt           Value ) = 0;
+
+   /// @brief Check a condition without waiting. The handle is not released.
+   virtual btBool completionTest( ALICompletionHandle Handle ) = 0;
+
+   /// @brief Wait up to TimeoutMillis (or AAL_INFINITE_WAIT) for a condition.
+   virtual e_Completion completionWait( ALICompletionHandle Handle,
+                                        btTime              TimeoutMillis ) = 0;
+
+   /// @brief Wait up to TimeoutMillis for the first of Count conditions.
+   /// @param[out] pIndex Index in pHandles of the condition that was met.
+   virtual e_Completion completionWaitAny( ALICompletionHandle const *pHandles,
+                                           btUnsignedInt              Count,
+                                           btTime                     TimeoutMillis,
+                                           btUnsignedInt             *pIndex ) = 0;
+
+   /// @brief Register, wait and release in one call.
+   virtual e_Completion completionWaitFor( volatile btUnsigned32bitInt *pWord,
+                                           btUnsigned32bitInt           Mask,
+                                           btUnsigned32bitInt           Value,
+                                           btTime                       TimeoutMillis ) = 0;
+
+   /// @brief Release a condition without waiting for it.
+   virtual void completionCancel( ALICompletionHandle Handle ) = 0;
+
+   /// @brief Wake sleeping waiters so they recheck their conditions now.
+   virtual void completionNotify() = 0;
+
+   /// @brief Copy the wait statistics.
+   virtual void completionStats( ALICompletionStats &rStats ) = 0;
+
+}; // class IALICompletion
+
 /// @}
 
 END_NAMESPACE(AAL)
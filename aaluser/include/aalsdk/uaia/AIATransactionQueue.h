@@ -0,0 +1,348 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// @file AIATransactionQueue.h
+/// @brief Asynchronous submission of IAIATransaction batches.
+/// @ingroup AIAService
+/// @verbatim
+/// Accelerator Abstraction Layer
+///
+/// IAFUProxy::SendTransaction() blocks the caller for the whole round trip
+///  to the driver. An AIATransactionQueue hands batches of transactions to
+///  a small pool of submission threads instead, each of which calls
+///  SendTransaction() on the proxy it was built for. The submitter continues
+///  at once and learns of completion by waiting on the batch or through an
+///  IAIATransactionBatchClient callback.
+///
+/// Transactions of an unordered batch are sent concurrently and may reach
+///  the driver in any order. An ordered batch is sent in sequence by one
+///  thread, for dependent requests such as a reset sequence, and stops at
+///  the first failure; separate ordered batches still overlap each other.
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version.@endverbatim
+//****************************************************************************
+#ifndef __AALSDK_UAIA_AIATRANSACTIONQUEUE_H__
+#define __AALSDK_UAIA_AIATRANSACTIONQUEUE_H__
+#include <vector>
+#include <aalsdk/uaia/IAFUProxy.h>
+#include <aalsdk/osal/CriticalSection.h>
+#include <aalsdk/osal/OSSemaphore.h>
+#include <aalsdk/osal/ThreadGroup.h>
+
+#define AIATRANSACTIONQUEUE_THREADS 4   ///< Default number of submission threads.
+
+class AIATransactionBatch;
+
+//=============================================================================
+// Name: IAIATransactionBatchClient
+// Description: Completion callback for an AIATransactionBatch
+// Comments: Called on a submission thread. The batch may be destroyed from
+//           within the callback.
+//=============================================================================
+class IAIATransactionBatchClient
+{
+public:
+   virtual ~IAIATransactionBatchClient() {}
+   virtual void TransactionsComplete(AIATransactionBatch &rBatch) = 0;
+};
+
+//=============================================================================
+// Name: AIATransactionBatch
+// Description: A group of transactions submitted together, and the future
+//              through which their completion is reported.
+// Comments: The transactions are owned by the caller and must remain valid,
+//           as must the batch, until Wait() returns true. With a client,
+//           both must remain valid until TransactionsComplete() is called,
+//           even if Wait() returned first. A batch may be resubmitted once
+//           it has completed.
+//=============================================================================
+class AIATransactionBatch : private AAL::CriticalSection
+{
+public:
+   AIATransactionBatch(AAL::btBool                 bOrdered = false,
+                       IAIATransactionBatchClient *pClient  = NULL,
+                       AAL::btApplicationContext   Context  = NULL) :
+      m_bOrdered(bOrdered),
+      m_pClient(pClient),
+      m_Context(Context),
+      m_Pending(0),
+      m_Failures(0),
+      m_bDone(true)
+   {
+      m_Done.Create(0, 1);
+   }
+
+   /// Append a transaction. Not allowed while the batch is outstanding.
+   void Add(IAIATransaction *pTransaction) { m_Transactions.push_back(pTransaction); }
+   /// Remove all transactions. Not allowed while the batch is outstanding.
+   void Clear()                            { m_Transactions.clear();                 }
+
+   AAL::btUnsignedInt             Count() const { return (AAL::btUnsignedInt)m_Transactions.size(); }
+   IAIATransaction * Transaction(AAL::btUnsignedInt i) const { return m_Transactions[i];      }
+   AAL::btBool                  Ordered() const { return m_bOrdered; }
+   AAL::btApplicationContext    Context() const { return m_Context;  }
+
+   /// True once every transaction has been sent.
+   AAL::btBool IsDone() const
+   {
+      AutoLock(this);
+      return m_bDone;
+   }
+
+   /// Block until every transaction has been sent, or Timeout milliseconds pass.
+   /// @retval true  The batch completed.
+   /// @retval false Timed out.
+   AAL::btBool Wait(AAL::btTime Timeout = AAL_INFINITE_WAIT)
+   {
+      if ( IsDone() ) {
+         return true;
+      }
+      if ( !m_Done.Wait(Timeout) ) {
+         return false;
+      }
+      // Sent() posts with the lock held; taking it here means the completing
+      //  thread is done with the batch by the time we return.
+      AutoLock(this);
+      m_Done.Post(1);   // Leave it signaled for later calls.
+      return true;
+   }
+
+   /// Once complete, the number of transactions that could not be sent or
+   ///  that completed with an error code other than uid_errnumOK.
+   AAL::btUnsignedInt Failures() const
+   {
+      AutoLock(this);
+      return m_Failures;
+   }
+
+protected:
+   friend class AIATransactionQueue;
+
+   // Mark the batch outstanding. Returns false if it already is.
+   AAL::btBool Begin()
+   {
+      AutoLock(this);
+      if ( !m_bDone ) {
+         return false;
+      }
+      m_Done.Reset(0);
+      m_Pending  = Count();
+      m_Failures = 0;
+      m_bDone    = false;
+      return true;
+   }
+
+   // Account for n transactions. The last one completes the batch; after
+   //  that the batch must not be touched, as its owner may free it.
+   void Sent(AAL::btUnsignedInt n, AAL::btUnsignedInt Failures)
+   {
+      IAIATransactionBatchClient *pClient = NULL;
+      {
+         AutoLock(this);
+         m_Failures += Failures;
+         m_Pending  -= n;
+         if ( 0 != m_Pending ) {
+            return;
+         }
+         m_bDone = true;
+         m_Done.Post(1);
+         pClient = m_pClient;
+      }
+
+      if ( NULL != pClient ) {
+         pClient->TransactionsComplete(*this);
+      }
+   }
+
+   AAL::btBool                    m_bOrdered;
+   IAIATransactionBatchClient    *m_pClient;
+   AAL::btApplicationContext      m_Context;
+   std::vector<IAIATransaction *> m_Transactions;
+   AAL::btUnsignedInt             m_Pending;
+   AAL::btUnsignedInt             m_Failures;
+   AAL::btBool                    m_bDone;
+   AAL::CSemaphore                m_Done;
+
+private:
+   AIATransactionBatch(const AIATransactionBatch & );
+   AIATransactionBatch & operator = (const AIATransactionBatch & );
+};
+
+//=============================================================================
+// Name: AIATransactionQueue
+// Description: Sends AIATransactionBatch'es through an IAFUProxy on a pool of
+//              submission threads.
+// Comments: Destroying the queue sends everything already submitted first.
+//=============================================================================
+class AIATransactionQueue
+{
+public:
+   AIATransactionQueue(IAFUProxy         *pProxy,
+                       AAL::btUnsignedInt Threads = AIATRANSACTIONQUEUE_THREADS) :
+      m_pProxy(pProxy),
+      m_Threads(( 0 == Threads ) ? 1 : Threads),
+      m_Group(m_Threads, m_Threads)
+   {}
+
+   ~AIATransactionQueue()
+   {
+      m_Group.Join(AAL_INFINITE_WAIT);
+   }
+
+   AAL::btBool IsOK() const                { return m_Group.IsOK(); }
+   AAL::btUnsignedInt Threads() const      { return m_Threads;      }
+
+   /// Queue rBatch for sending and return without waiting.
+   /// @retval true  rBatch was queued, or was empty and has completed.
+   /// @retval false rBatch is still outstanding from an earlier Submit().
+   ///
+   /// Transactions that cannot be queued, and those of an ordered batch
+   ///  after a failure, are not sent: they are given uid_errnumAFUTransaction
+   ///  and counted as failures.
+   AAL::btBool Submit(AIATransactionBatch &rBatch)
+   {
+      if ( !rBatch.Begin() ) {
+         return false;
+      }
+
+      const AAL::btUnsignedInt n = rBatch.Count();
+      if ( 0 == n ) {
+         rBatch.Sent(0, 0);
+         return true;
+      }
+
+      if ( rBatch.Ordered() ) {
+         if ( !Queue(new SendAll(m_pProxy, rBatch)) ) {
+            NotSent(rBatch, 0);
+         }
+         return true;
+      }
+
+      AAL::btUnsignedInt i;
+      for ( i = 0 ; i < n ; ++i ) {
+         if ( !Queue(new SendOne(m_pProxy, rBatch, rBatch.Transaction(i))) ) {
+            NotSent(rBatch, i);
+            break;
+         }
+      }
+      return true;
+   }
+
+protected:
+   static AAL::btUnsignedInt Send(IAFUProxy *pProxy, IAIATransaction *pTransaction)
+   {
+      if ( !pProxy->SendTransaction(pTransaction) ) {
+         return 1;
+      }
+      return ( AAL::uid_errnumOK == pTransaction->getErrno() ) ? 0 : 1;
+   }
+
+   // The thread group does not take the item if it refuses it.
+   AAL::btBool Queue(AAL::IDispatchable *pDisp)
+   {
+      if ( m_Group.Add(pDisp) ) {
+         return true;
+      }
+      delete pDisp;
+      return false;
+   }
+
+   // Fail transactions First onward without sending them, completing rBatch.
+   static void NotSent(AIATransactionBatch &rBatch, AAL::btUnsignedInt First)
+   {
+      const AAL::btUnsignedInt n = rBatch.Count();
+      for ( AAL::btUnsignedInt i = First ; i < n ; ++i ) {
+         rBatch.Transaction(i)->setErrno(AAL::uid_errnumAFUTransaction);
+      }
+      rBatch.Sent(n - First, n - First);
+   }
+
+   // One transaction of an unordered batch.
+   class SendOne : public AAL::IDispatchable
+   {
+   public:
+      SendOne(IAFUProxy *pProxy, AIATransactionBatch &rBatch, IAIATransaction *pTransaction) :
+         m_pProxy(pProxy),
+         m_rBatch(rBatch),
+         m_pTransaction(pTransaction)
+      {}
+      void operator() ()
+      {
+         m_rBatch.Sent(1, Send(m_pProxy, m_pTransaction));
+         delete this;
+      }
+   protected:
+      IAFUProxy           *m_pProxy;
+      AIATransactionBatch &m_rBatch;
+      IAIATransaction     *m_pTransaction;
+   };
+
+   // A whole ordered batch.
+   class SendAll : public AAL::IDispatchable
+   {
+   public:
+      SendAll(IAFUProxy *pProxy, AIATransactionBatch &rBatch) :
+         m_pProxy(pProxy),
+         m_rBatch(rBatch)
+      {}
+      void operator() ()
+      {
+         const AAL::btUnsignedInt n = m_rBatch.Count();
+         AAL::btUnsignedInt       i;
+         for ( i = 0 ; i < n ; ++i ) {
+            if ( 0 != Send(m_pProxy, m_rBatch.Transaction(i)) ) {
+               break;
+            }
+         }
+         if ( i < n ) {
+            // The failed transaction was sent; the rest are not.
+            m_rBatch.Sent(i + 1, 1);
+            if ( i + 1 < n ) {
+               NotSent(m_rBatch, i + 1);
+            }
+         } else {
+            m_rBatch.Sent(n, 0);
+         }
+         delete this;
+      }
+   protected:
+      IAFUProxy           *m_pProxy;
+      AIATransactionBatch &m_rBatch;
+   };
+
+   IAFUProxy               *m_pProxy;
+   AAL::btUnsignedInt       m_Threads;
+   AAL::OSLThreadGroup      m_Group;
+
+private:
+   AIATransactionQueue(const AIATransactionQueue & );
+   AIATransactionQueue & operator = (const AIATransactionQueue & );
+};
+
+#endif // __AALSDK_UAIA_AIATRANSACTIONQUEUE_H__
+
@@ -99,6 +99,8 @@ public:
 };
 
 
+class AIATransactionBatch;
+
 //=============================================================================
 // Name: IAFUProxy
 // Description: AFU Proxies are objects that abstract the connection/transport
@@ -113,6 +115,9 @@ public:
    // Send a message to the device
    virtual AAL::btBool SendTransaction( IAIATransaction *pAFUmessage )       = 0;
 
+   // Queue a batch of messages without waiting for them (see AIATransactionQueue.h)
+   virtual AAL::btBool SendTransactions( AIATransactionBatch &rBatch )       = 0;
+
    // Map/Unmap Workspace IDs to virtual memory addresses
    virtual AAL::btBool MapWSID(AAL::btWSSize             Size,
                                AAL::btWSID               wsid,
@@ -0,0 +1,370 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// @file ALICompletion.h
+/// @brief Adaptive spin / yield / sleep implementation of IALICompletion.
+/// @ingroup ALICompletion
+/// @verbatim
+/// Accelerator Abstraction Layer
+///
+/// ALI publishes an ALICompletion as iidALI_CMPL_Service and calls
+///  completionNotify() for every AFU event. It has no other dependency on
+///  the backend, so it can also be used directly.
+///
+/// The spin budget follows the average length of recent waits: waits that
+///  usually finish within ALICOMPLETION_SPIN_MAX_NANOS spin for twice that
+///  average; longer waits spin only briefly before yielding and sleeping.
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version.@endverbatim
+//****************************************************************************
+#ifndef __AALSDK_UTILS_ALICOMPLETION_H__
+#define __AALSDK_UTILS_ALICOMPLETION_H__
+#include <cstring>
+#include <aalsdk/service/IALIAFU.h>
+
+#if defined( __AAL_LINUX__ )
+# include <pthread.h>
+# include <sched.h>
+# include <time.h>
+
+BEGIN_NAMESPACE(AAL)
+
+/// @addtogroup ALICompletion
+/// @{
+
+#define ALICOMPLETION_SLOTS           256       ///< Conditions that may be registered at once.
+#define ALICOMPLETION_SPIN_MIN_NANOS  1000ULL
+#define ALICOMPLETION_SPIN_MAX_NANOS  50000ULL
+#define ALICOMPLETION_YIELD_NANOS     200000ULL ///< Yield this long after spinning, before sleeping.
+#define ALICOMPLETION_SLEEP_MIN_NANOS 10000ULL  ///< First sleep period; doubles up to the max.
+#define ALICOMPLETION_SLEEP_MAX_NANOS 1000000ULL
+
+/// @brief IALICompletion over a fixed table of conditions.
+///
+/// Handles may be registered, waited on and cancelled from any thread, but
+///  a handle must not be cancelled while another thread is waiting on it.
+class ALICompletion : public IALICompletion
+{
+public:
+   ALICompletion() :
+      m_FreeHead(0),
+      m_NotifySeq(0),
+      m_AvgNanos(0),
+      m_SpinNanos(ALICOMPLETION_SPIN_MIN_NANOS)
+   {
+      pthread_condattr_t attr;
+
+      pthread_mutex_init(&m_Lock, NULL);
+      pthread_condattr_init(&attr);
+      pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+      pthread_cond_init(&m_Cond, &attr);
+      pthread_condattr_destroy(&attr);
+
+      for ( btUnsigned32bitInt i = 0 ; i < ALICOMPLETION_SLOTS ; ++i ) {
+         m_Slots[i].pWord = NULL;
+         m_Slots[i].mask  = 0;
+         m_Slots[i].value = 0;
+         m_Slots[i].gen   = 0;
+         m_Slots[i].width = 0;
+         m_Slots[i].next  = i + 1;
+      }
+
+      memset(&m_Stats, 0, sizeof(m_Stats));
+   }
+   virtual ~ALICompletion()
+   {
+      pthread_cond_destroy(&m_Cond);
+      pthread_mutex_destroy(&m_Lock);
+   }
+
+   // <IALICompletion>
+   virtual ALICompletionHandle completionRegister( volatile btUnsigned32bitInt *pWord,
+                                                   btUnsigned32bitInt           Mask,
+                                                   btUnsigned32bitInt           Value )
+   { return Register(pWord, sizeof(*pWord), Mask, Value); }
+
+   virtual ALICompletionHandle completionRegister( volatile btUnsigned64bitInt *pWord,
+                                                   btUnsigned64bitInt           Mask,
+                                                   btUnsigned64bitInt           Value )
+   { return Register(pWord, sizeof(*pWord), Mask, Value); }
+
+   virtual btBool completionTest( ALICompletionHandle Handle )
+   {
+      const Slot *pslot = Find(Handle);
+      return ( NULL != pslot ) && Met(*pslot);
+   }
+
+   virtual e_Completion completionWait( ALICompletionHandle Handle,
+                                        btTime              TimeoutMillis )
+   {
+      btUnsignedInt index;
+      return completionWaitAny(&Handle, 1, TimeoutMillis, &index);
+   }
+
+   virtual e_Completion completionWaitAny( ALICompletionHandle const *pHandles,
+                                           btUnsignedInt              Count,
+                                           btTime                     TimeoutMillis,
+                                           btUnsignedInt             *pIndex )
+   {
+      if ( ( NULL == pHandles ) || ( 0 == Count ) ) {
+         return e_BadHandle;
+      }
+      for ( btUnsignedInt i = 0 ; i < Count ; ++i ) {
+         if ( NULL == Find(pHandles[i]) ) {
+            return e_BadHandle;
+         }
+      }
+
+      const btUnsigned64bitInt start    = Now();
+      const btUnsigned64bitInt deadline = ( TimeoutMillis >= ( ~0ULL - start ) / 1000000ULL ) ?
+                                             ~0ULL : start + TimeoutMillis * 1000000ULL;
+      const btUnsigned64bitInt spinEnd  = start + m_SpinNanos;
+      const btUnsigned64bitInt yieldEnd = spinEnd + ALICOMPLETION_YIELD_NANOS;
+      btUnsigned64bitInt       sleep    = ALICOMPLETION_SLEEP_MIN_NANOS;
+      btUnsigned64bitInt      *pPhase   = &m_Stats.spinCompletions;
+
+      for ( ; ; ) {
+         for ( btUnsignedInt i = 0 ; i < Count ; ++i ) {
+            if ( Met(*Find(pHandles[i])) ) {
+               if ( NULL != pIndex ) {
+                  *pIndex = i;
+               }
+               Done(pHandles[i], Now() - start, pPhase);
+               return e_Done;
+            }
+         }
+
+         btUnsigned64bitInt now = Now();
+         if ( now >= deadline ) {
+            pthread_mutex_lock(&m_Lock);
+            ++m_Stats.timeouts;
+            pthread_mutex_unlock(&m_Lock);
+            return e_Timeout;
+         }
+
+         if ( now < spinEnd ) {
+            continue;
+         }
+
+         if ( now < yieldEnd ) {
+            pPhase = &m_Stats.yieldCompletions;
+            sched_yield();
+            continue;
+         }
+
+         pPhase = &m_Stats.sleepCompletions;
+         Sleep(( deadline - now < sleep ) ? deadline - now : sleep);
+         if ( sleep < ALICOMPLETION_SLEEP_MAX_NANOS ) {
+            sleep <<= 1;
+         }
+      }
+   }
+
+   virtual e_Completion completionWaitFor( volatile btUnsigned32bitInt *pWord,
+                                           btUnsigned32bitInt           Mask,
+                                           btUnsigned32bitInt           Value,
+                                           btTime                       TimeoutMillis )
+   {
+      ALICompletionHandle h = completionRegister(pWord, Mask, Value);
+      if ( 0 == h ) {
+         return e_BadHandle;
+      }
+      e_Completion res = completionWait(h, TimeoutMillis);
+      if ( e_Done != res ) {
+         completionCancel(h);
+      }
+      return res;
+   }
+
+   virtual void completionCancel( ALICompletionHandle Handle )
+   {
+      pthread_mutex_lock(&m_Lock);
+      Release(Handle);
+      pthread_mutex_unlock(&m_Lock);
+   }
+
+   virtual void completionNotify()
+   {
+      pthread_mutex_lock(&m_Lock);
+      ++m_NotifySeq;
+      ++m_Stats.notifies;
+      pthread_cond_broadcast(&m_Cond);
+      pthread_mutex_unlock(&m_Lock);
+   }
+
+   virtual void completionStats( ALICompletionStats &rStats )
+   {
+      pthread_mutex_lock(&m_Lock);
+      rStats = m_Stats;
+      pthread_mutex_unlock(&m_Lock);
+   }
+   // </IALICompletion>
+
+protected:
+   struct Slot
+   {
+      volatile void      *pWord;
+      btUnsigned64bitInt  mask;
+      btUnsigned64bitInt  value;
+      btUnsigned32bitInt  gen;
+      btUnsigned16bitInt  width;   ///< 4 or 8, 0 when free.
+      btUnsigned16bitInt  next;    ///< Free list link.
+   };
+
+   static btUnsigned64bitInt Now()
+   {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return (btUnsigned64bitInt)ts.tv_sec * 1000000000ULL + (btUnsigned64bitInt)ts.tv_nsec;
+   }
+
+   static btBool Met(const Slot &s)
+   {
+      btUnsigned64bitInt v = ( 4 == s.width ) ?
+         *reinterpret_cast<volatile btUnsigned32bitInt *>(s.pWord) :
+         *reinterpret_cast<volatile btUnsigned64bitInt *>(s.pWord);
+      return ( v & s.mask ) == s.value;
+   }
+
+   ALICompletionHandle Register(volatile void       *pWord,
+                                btUnsigned16bitInt   width,
+                                btUnsigned64bitInt   mask,
+                                btUnsigned64bitInt   value)
+   {
+      if ( NULL == pWord ) {
+         return 0;
+      }
+
+      pthread_mutex_lock(&m_Lock);
+      if ( m_FreeHead >= ALICOMPLETION_SLOTS ) {
+         pthread_mutex_unlock(&m_Lock);
+         return 0;
+      }
+      btUnsigned32bitInt i = m_FreeHead;
+      Slot &s = m_Slots[i];
+      m_FreeHead = s.next;
+
+      s.pWord = pWord;
+      s.mask  = mask;
+      s.value = value & mask;
+      s.width = width;
+      ALICompletionHandle h = ( (ALICompletionHandle)s.gen << 32 ) | ( i + 1 );
+      pthread_mutex_unlock(&m_Lock);
+
+      return h;
+   }
+
+   const Slot * Find(ALICompletionHandle h) const
+   {
+      btUnsigned32bitInt i = (btUnsigned32bitInt)( h & 0xffffffff );
+      if ( ( 0 == i ) || ( i > ALICOMPLETION_SLOTS ) ) {
+         return NULL;
+      }
+      const Slot &s = m_Slots[i - 1];
+      if ( ( 0 == s.width ) || ( s.gen != (btUnsigned32bitInt)( h >> 32 ) ) ) {
+         return NULL;
+      }
+      return &s;
+   }
+
+   // Lock held.
+   void Release(ALICompletionHandle h)
+   {
+      if ( NULL == Find(h) ) {
+         return;
+      }
+      btUnsigned32bitInt i = (btUnsigned32bitInt)( h & 0xffffffff ) - 1;
+      Slot &s = m_Slots[i];
+      s.width = 0;
+      s.pWord = NULL;
+      s.gen++;
+      s.next  = m_FreeHead;
+      m_FreeHead = i;
+   }
+
+   void Done(ALICompletionHandle h, btUnsigned64bitInt nanos, btUnsigned64bitInt *pPhase)
+   {
+      pthread_mutex_lock(&m_Lock);
+      Release(h);
+
+      ++m_Stats.waits;
+      ++*pPhase;
+      m_Stats.totalWaitNanos += nanos;
+      if ( nanos > m_Stats.maxWaitNanos ) {
+         m_Stats.maxWaitNanos = nanos;
+      }
+
+      // Spin for twice the recent average, unless waits are too long to spin through.
+      m_AvgNanos = ( 0 == m_AvgNanos ) ? nanos : ( 7 * m_AvgNanos + nanos ) / 8;
+      if ( 2 * m_AvgNanos <= ALICOMPLETION_SPIN_MAX_NANOS ) {
+         m_SpinNanos = ( 2 * m_AvgNanos > ALICOMPLETION_SPIN_MIN_NANOS ) ? 2 * m_AvgNanos : ALICOMPLETION_SPIN_MIN_NANOS;
+      } else {
+         m_SpinNanos = ALICOMPLETION_SPIN_MIN_NANOS;
+      }
+      pthread_mutex_unlock(&m_Lock);
+   }
+
+   // Sleep for up to nanos, or until completionNotify().
+   void Sleep(btUnsigned64bitInt nanos)
+   {
+      btUnsigned64bitInt until = Now() + nanos;
+      struct timespec    ts;
+      ts.tv_sec  = (time_t)( until / 1000000000ULL );
+      ts.tv_nsec = (long)( until % 1000000000ULL );
+
+      pthread_mutex_lock(&m_Lock);
+      btUnsigned64bitInt seq = m_NotifySeq;
+      while ( seq == m_NotifySeq ) {
+         if ( 0 != pthread_cond_timedwait(&m_Cond, &m_Lock, &ts) ) {
+            break;
+         }
+      }
+      pthread_mutex_unlock(&m_Lock);
+   }
+
+   pthread_mutex_t             m_Lock;
+   pthread_cond_t              m_Cond;
+   Slot                        m_Slots[ALICOMPLETION_SLOTS];
+   btUnsigned32bitInt          m_FreeHead;
+   btUnsigned64bitInt          m_NotifySeq;
+   btUnsigned64bitInt          m_AvgNanos;
+   volatile btUnsigned64bitInt m_SpinNanos;
+   ALICompletionStats          m_Stats;
+
+private:
+   ALICompletion(const ALICompletion & );
+   ALICompletion & operator = (const ALICompletion & );
+};
+
+/// @}
+
+END_NAMESPACE(AAL)
+
+#endif // __AAL_LINUX__
+
+#endif // __AALSDK_UTILS_ALICOMPLETION_H__
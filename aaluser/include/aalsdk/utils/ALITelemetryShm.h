@@ -0,0 +1,238 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// @file ALITelemetryShm.h
+/// @brief Shared memory publication of ALITelemetrySnapshot's.
+/// @ingroup ALITelemetry
+/// @verbatim
+/// Accelerator Abstraction Layer
+///
+/// The collector (IALITelemetry::telemetryStart()) owns an
+///  ALITelemetryWriter. Any local process may attach an ALITelemetryReader
+///  to the same name and read the newest snapshot without the driver and
+///  without blocking the collector.
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version.@endverbatim
+//****************************************************************************
+#ifndef __AALSDK_UTILS_ALITELEMETRYSHM_H__
+#define __AALSDK_UTILS_ALITELEMETRYSHM_H__
+#include <new>
+#include <string>
+#include <aalsdk/service/IALIAFU.h>
+#include <aalsdk/utils/SeqlockRing.h>
+
+#if defined( __AAL_LINUX__ )
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+
+BEGIN_NAMESPACE(AAL)
+
+/// @addtogroup ALITelemetry
+/// @{
+
+#define ALITELEMETRY_SHM_MAGIC   0x54494c41   // "ALIT"
+#define ALITELEMETRY_SHM_VERSION 1
+#define ALITELEMETRY_SHM_DEPTH   4
+
+/// Layout of the shared memory object.
+struct ALITelemetryShmRegion
+{
+   volatile btUnsigned32bitInt magic;         ///< ALITELEMETRY_SHM_MAGIC once initialized, 0 after the writer leaves.
+   btUnsigned32bitInt          version;       ///< ALITELEMETRY_SHM_VERSION
+   btUnsigned32bitInt          size;          ///< sizeof(ALITelemetryShmRegion)
+   btUnsigned32bitInt          periodMillis;  ///< Collection period.
+   SeqlockRing<ALITelemetrySnapshot, ALITELEMETRY_SHM_DEPTH> ring;
+};
+
+/// @brief Creates the shared memory object and publishes snapshots into it.
+class ALITelemetryWriter
+{
+public:
+   ALITelemetryWriter() :
+      m_pRegion(NULL)
+   {}
+   ~ALITelemetryWriter() { Destroy(); }
+
+   /// Create (or take over) the shared memory object called name.
+   btBool Create(btcString name, btTime periodMillis)
+   {
+      if ( ( NULL != m_pRegion ) || ( NULL == name ) ) {
+         return false;
+      }
+
+      int fd = shm_open(name, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+      if ( fd < 0 ) {
+         return false;
+      }
+
+      // Truncating first discards anything left by a previous writer.
+      if ( ( 0 != ftruncate(fd, 0) ) ||
+           ( 0 != ftruncate(fd, sizeof(ALITelemetryShmRegion)) ) ) {
+         close(fd);
+         shm_unlink(name);
+         return false;
+      }
+
+      void *p = mmap(NULL, sizeof(ALITelemetryShmRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+      if ( MAP_FAILED == p ) {
+         shm_unlink(name);
+         return false;
+      }
+
+      m_pRegion = new(p) ALITelemetryShmRegion();
+      m_pRegion->version      = ALITELEMETRY_SHM_VERSION;
+      m_pRegion->size         = sizeof(ALITelemetryShmRegion);
+      m_pRegion->periodMillis = (btUnsigned32bitInt)periodMillis;
+      __sync_synchronize();
+      m_pRegion->magic        = ALITELEMETRY_SHM_MAGIC;
+
+      m_Name = name;
+      return true;
+   }
+
+   btBool IsOK() const { return NULL != m_pRegion; }
+
+   void Publish(const ALITelemetrySnapshot &rSnapshot)
+   {
+      if ( NULL != m_pRegion ) {
+         m_pRegion->ring.Publish(rSnapshot);
+      }
+   }
+
+   /// Mark the region stale for attached readers and remove the name.
+   void Destroy()
+   {
+      if ( NULL == m_pRegion ) {
+         return;
+      }
+      m_pRegion->magic = 0;
+      __sync_synchronize();
+      munmap(m_pRegion, sizeof(ALITelemetryShmRegion));
+      m_pRegion = NULL;
+      shm_unlink(m_Name.c_str());
+      m_Name.clear();
+   }
+
+private:
+   ALITelemetryWriter(const ALITelemetryWriter & );
+   ALITelemetryWriter & operator = (const ALITelemetryWriter & );
+
+   ALITelemetryShmRegion *m_pRegion;
+   std::string            m_Name;
+};
+
+/// @brief Read-only view of a collector's shared memory object.
+class ALITelemetryReader
+{
+public:
+   ALITelemetryReader() :
+      m_pRegion(NULL)
+   {}
+   ~ALITelemetryReader() { Close(); }
+
+   /// Attach to the object called name.
+   /// @retval false It does not exist, or is not (yet) a compatible region.
+   btBool Open(btcString name)
+   {
+      struct stat st;
+
+      if ( ( NULL != m_pRegion ) || ( NULL == name ) ) {
+         return false;
+      }
+
+      int fd = shm_open(name, O_RDONLY, 0);
+      if ( fd < 0 ) {
+         return false;
+      }
+
+      if ( ( 0 != fstat(fd, &st) ) || ( st.st_size < (off_t)sizeof(ALITelemetryShmRegion) ) ) {
+         close(fd);
+         return false;
+      }
+
+      void *p = mmap(NULL, sizeof(ALITelemetryShmRegion), PROT_READ, MAP_SHARED, fd, 0);
+      close(fd);
+      if ( MAP_FAILED == p ) {
+         return false;
+      }
+
+      m_pRegion = reinterpret_cast<const ALITelemetryShmRegion *>(p);
+
+      if ( !IsLive() ||
+           ( ALITELEMETRY_SHM_VERSION != m_pRegion->version ) ||
+           ( sizeof(ALITelemetryShmRegion) != m_pRegion->size ) ) {
+         Close();
+         return false;
+      }
+
+      return true;
+   }
+
+   /// True while the writer that created the region is publishing to it.
+   btBool IsLive() const
+   {
+      return ( NULL != m_pRegion ) && ( ALITELEMETRY_SHM_MAGIC == m_pRegion->magic );
+   }
+
+   btTime PeriodMillis() const { return ( NULL == m_pRegion ) ? 0 : m_pRegion->periodMillis; }
+
+   /// Copy the newest snapshot.
+   /// @retval false Not open, the writer has gone, or nothing is published yet.
+   btBool Latest(ALITelemetrySnapshot &rSnapshot) const
+   {
+      if ( !IsLive() ) {
+         return false;
+      }
+      return m_pRegion->ring.Latest(rSnapshot);
+   }
+
+   void Close()
+   {
+      if ( NULL != m_pRegion ) {
+         munmap(const_cast<ALITelemetryShmRegion *>(m_pRegion), sizeof(ALITelemetryShmRegion));
+         m_pRegion = NULL;
+      }
+   }
+
+private:
+   ALITelemetryReader(const ALITelemetryReader & );
+   ALITelemetryReader & operator = (const ALITelemetryReader & );
+
+   const ALITelemetryShmRegion *m_pRegion;
+};
+
+/// @}
+
+END_NAMESPACE(AAL)
+
+#endif // __AAL_LINUX__
+
+#endif // __AALSDK_UTILS_ALITELEMETRYSHM_H__
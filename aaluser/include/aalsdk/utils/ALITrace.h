@@ -0,0 +1,714 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// @file ALITrace.h
+/// @brief Record and replay of ALI sessions.
+/// @ingroup ALITrace
+/// @verbatim
+/// Accelerator Abstraction Layer
+///
+/// ALITraceRecorder sits in front of a backend's IALIMMIO, IALIBuffer,
+///  IALIUMsg and IALIReset and logs every call, with its start time and the
+///  time spent in the backend, to a binary trace file. ALITraceReplayer
+///  issues the same calls against any backend (FPGA, ASE or a test double)
+///  and reports the recorded and replayed times per operation.
+///
+/// Buffers are identified in the trace by allocation order, not address.
+///  A 64-bit MMIO write whose value lies inside a live buffer's IOVA range
+///  (as a byte address, or as a cache line address, IOVA >> 6) is stored
+///  relative to that buffer and retranslated on replay.
+///
+/// Not captured: accesses made directly through mmioGetAddress() or a
+///  buffer's virtual address, buffer contents, and NamedValueSet arguments
+///  other than the UMsg hint mask.
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version.@endverbatim
+//****************************************************************************
+#ifndef __AALSDK_UTILS_ALITRACE_H__
+#define __AALSDK_UTILS_ALITRACE_H__
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <aalsdk/service/IALIAFU.h>
+#include <aalsdk/osal/CriticalSection.h>
+
+#if defined( __AAL_LINUX__ )
+# include <time.h>
+
+BEGIN_NAMESPACE(AAL)
+
+/// @addtogroup ALITrace
+/// @{
+
+#define ALITRACE_MAGIC   0x31435254494c41ULL   // "ALITRC1"
+#define ALITRACE_VERSION 1
+
+/// Operations recorded in an ALITraceRecord.
+enum ALITraceOp
+{
+   ALITRACE_MMIO_READ32 = 1,
+   ALITRACE_MMIO_WRITE32,
+   ALITRACE_MMIO_READ64,
+   ALITRACE_MMIO_WRITE64,
+   ALITRACE_BUFFER_ALLOCATE,
+   ALITRACE_BUFFER_FREE,
+   ALITRACE_UMSG_TRIGGER64,
+   ALITRACE_UMSG_SET_ATTRIBUTES,
+   ALITRACE_RESET_QUIESCE_HALT,
+   ALITRACE_RESET_ENABLE,
+   ALITRACE_RESET,
+   ALITRACE_OP_COUNT
+};
+
+/// ALITraceRecord::flags
+#define ALITRACE_F_IOVA     0x0001   ///< value is a byte offset into buffer.
+#define ALITRACE_F_IOVA_CL  0x0002   ///< value is a byte offset into buffer, written as a cache line address.
+
+/// Start of a trace file.
+struct ALITraceHeader
+{
+   btUnsigned64bitInt magic;       ///< ALITRACE_MAGIC
+   btUnsigned32bitInt version;     ///< ALITRACE_VERSION
+   btUnsigned32bitInt recordSize;  ///< sizeof(ALITraceRecord)
+};
+
+/// One recorded call.
+struct ALITraceRecord
+{
+   btUnsigned64bitInt tstamp;    ///< ns from the start of the trace to the call.
+   btUnsigned64bitInt duration;  ///< ns spent in the backend.
+   btUnsigned64bitInt arg;       ///< MMIO offset, buffer length or UMsg number.
+   btUnsigned64bitInt value;     ///< MMIO or UMsg data, or the UMsg hint mask.
+   btUnsigned32bitInt buffer;    ///< Buffer allocated / freed, or referenced by an ALITRACE_F_IOVA* value.
+   btUnsigned32bitInt result;    ///< Backend return value: btBool, ali_errnum_e or IALIReset::e_Reset.
+   btUnsigned16bitInt op;        ///< ALITraceOp
+   btUnsigned16bitInt flags;     ///< ALITRACE_F_*
+   btUnsigned32bitInt reserved;
+};
+
+/// CLOCK_MONOTONIC in ns.
+inline btUnsigned64bitInt ALITraceNow()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (btUnsigned64bitInt)ts.tv_sec * 1000000000ULL + (btUnsigned64bitInt)ts.tv_nsec;
+}
+
+/// Printable name of an ALITraceOp.
+inline btcString ALITraceOpName(btUnsigned16bitInt op)
+{
+   static const char * const names[ALITRACE_OP_COUNT] = {
+      "?",
+      "mmioRead32",
+      "mmioWrite32",
+      "mmioRead64",
+      "mmioWrite64",
+      "bufferAllocate",
+      "bufferFree",
+      "umsgTrigger64",
+      "umsgSetAttributes",
+      "afuQuiesceAndHalt",
+      "afuEnable",
+      "afuReset"
+   };
+   return ( op < ALITRACE_OP_COUNT ) ? names[op] : names[0];
+}
+
+/// @brief Decorates a backend's ALI interfaces and records every call.
+///
+/// All four backend interfaces are required. Calls may come from any thread;
+///  records are written in the order the calls complete.
+class ALITraceRecorder : public CriticalSection,
+                         public IALIMMIO,
+                         public IALIBuffer,
+                         public IALIUMsg,
+                         public IALIReset
+{
+public:
+   ALITraceRecorder(IALIMMIO   *pMMIO,
+                    IALIBuffer *pBuffer,
+                    IALIUMsg   *pUMsg,
+                    IALIReset  *pReset) :
+      m_pMMIO(pMMIO),
+      m_pBuffer(pBuffer),
+      m_pUMsg(pUMsg),
+      m_pReset(pReset),
+      m_fp(NULL),
+      m_Start(0),
+      m_NextBufferId(1)
+   {}
+   virtual ~ALITraceRecorder() { Close(); }
+
+   /// Create (truncate) the trace file at path.
+   btBool Open(btcString path)
+   {
+      AutoLock(this);
+
+      if ( ( NULL != m_fp ) || ( NULL == path ) ) {
+         return false;
+      }
+
+      m_fp = fopen(path, "wb");
+      if ( NULL == m_fp ) {
+         return false;
+      }
+      setvbuf(m_fp, NULL, _IOFBF, 1024 * 1024);
+
+      ALITraceHeader hdr;
+      hdr.magic      = ALITRACE_MAGIC;
+      hdr.version    = ALITRACE_VERSION;
+      hdr.recordSize = sizeof(ALITraceRecord);
+      if ( 1 != fwrite(&hdr, sizeof(hdr), 1, m_fp) ) {
+         fclose(m_fp);
+         m_fp = NULL;
+         return false;
+      }
+
+      m_Start = ALITraceNow();
+      return true;
+   }
+
+   btBool IsOpen() const { return NULL != m_fp; }
+
+   void Close()
+   {
+      AutoLock(this);
+      if ( NULL != m_fp ) {
+         fclose(m_fp);
+         m_fp = NULL;
+      }
+   }
+
+   // <IALIMMIO>
+   virtual btVirtAddr  mmioGetAddress( void ) { return m_pMMIO->mmioGetAddress(); }
+   virtual btCSROffset mmioGetLength( void )  { return m_pMMIO->mmioGetLength();  }
+
+   virtual btBool mmioRead32( const btCSROffset Offset, btUnsigned32bitInt * const pValue )
+   {
+      ALITraceRecord r = Begin(ALITRACE_MMIO_READ32, Offset);
+      btBool res = m_pMMIO->mmioRead32(Offset, pValue);
+      r.value  = ( res && ( NULL != pValue ) ) ? *pValue : 0;
+      r.result = res;
+      End(r);
+      return res;
+   }
+   virtual btBool mmioWrite32( const btCSROffset Offset, const btUnsigned32bitInt Value )
+   {
+      ALITraceRecord r = Begin(ALITRACE_MMIO_WRITE32, Offset);
+      btBool res = m_pMMIO->mmioWrite32(Offset, Value);
+      r.value  = Value;
+      r.result = res;
+      End(r);
+      return res;
+   }
+   virtual btBool mmioRead64( const btCSROffset Offset, btUnsigned64bitInt * const pValue )
+   {
+      ALITraceRecord r = Begin(ALITRACE_MMIO_READ64, Offset);
+      btBool res = m_pMMIO->mmioRead64(Offset, pValue);
+      r.value  = ( res && ( NULL != pValue ) ) ? *pValue : 0;
+      r.result = res;
+      End(r);
+      return res;
+   }
+   virtual btBool mmioWrite64( const btCSROffset Offset, const btUnsigned64bitInt Value )
+   {
+      ALITraceRecord r = Begin(ALITRACE_MMIO_WRITE64, Offset);
+      btBool res = m_pMMIO->mmioWrite64(Offset, Value);
+      r.value  = Value;
+      r.result = res;
+      End(r);
+      return res;
+   }
+
+   virtual btBool mmioGetFeatureAddress( btVirtAddr          *pFeature,
+                                         NamedValueSet const &rInputArgs,
+                                         NamedValueSet       &rOutputArgs )
+   { return m_pMMIO->mmioGetFeatureAddress(pFeature, rInputArgs, rOutputArgs); }
+   virtual btBool mmioGetFeatureAddress( btVirtAddr          *pFeature,
+                                         NamedValueSet const &rInputArgs )
+   { return m_pMMIO->mmioGetFeatureAddress(pFeature, rInputArgs); }
+   virtual btBool mmioGetFeatureOffset( btCSROffset         *pFeatureOffset,
+                                        NamedValueSet const &rInputArgs,
+                                        NamedValueSet       &rOutputArgs )
+   { return m_pMMIO->mmioGetFeatureOffset(pFeatureOffset, rInputArgs, rOutputArgs); }
+   virtual btBool mmioGetFeatureOffset( btCSROffset         *pFeatureOffset,
+                                        NamedValueSet const &rInputArgs )
+   { return m_pMMIO->mmioGetFeatureOffset(pFeatureOffset, rInputArgs); }
+   // </IALIMMIO>
+
+   // <IALIBuffer>
+   virtual ali_errnum_e bufferAllocate( btWSSize Length, btVirtAddr *pBufferptr )
+   {
+      ALITraceRecord r = Begin(ALITRACE_BUFFER_ALLOCATE, Length);
+      ali_errnum_e res = m_pBuffer->bufferAllocate(Length, pBufferptr);
+      AllocateEnd(r, res, Length, pBufferptr);
+      return res;
+   }
+   virtual ali_errnum_e bufferAllocate( btWSSize             Length,
+                                        btVirtAddr          *pBufferptr,
+                                        NamedValueSet const &rInputArgs )
+   {
+      ALITraceRecord r = Begin(ALITRACE_BUFFER_ALLOCATE, Length);
+      ali_errnum_e res = m_pBuffer->bufferAllocate(Length, pBufferptr, rInputArgs);
+      AllocateEnd(r, res, Length, pBufferptr);
+      return res;
+   }
+   virtual ali_errnum_e bufferAllocate( btWSSize             Length,
+                                        btVirtAddr          *pBufferptr,
+                                        NamedValueSet const &rInputArgs,
+                                        NamedValueSet       &rOutputArgs )
+   {
+      ALITraceRecord r = Begin(ALITRACE_BUFFER_ALLOCATE, Length);
+      ali_errnum_e res = m_pBuffer->bufferAllocate(Length, pBufferptr, rInputArgs, rOutputArgs);
+      AllocateEnd(r, res, Length, pBufferptr);
+      return res;
+   }
+   virtual ali_errnum_e bufferFree( btVirtAddr Address )
+   {
+      ALITraceRecord r = Begin(ALITRACE_BUFFER_FREE, 0);
+      ali_errnum_e res = m_pBuffer->bufferFree(Address);
+      r.duration = ALITraceNow() - m_Start - r.tstamp;
+      r.result   = res;
+
+      AutoLock(this);
+      buf_virt_map::iterator itr = m_ByVirt.find(Address);
+      if ( m_ByVirt.end() != itr ) {
+         r.buffer = itr->second;
+         if ( ali_errnumOK == res ) {
+            for ( buf_iova_map::iterator i = m_ByIOVA.begin() ; m_ByIOVA.end() != i ; ++i ) {
+               if ( i->second.id == itr->second ) {
+                  m_ByIOVA.erase(i);
+                  break;
+               }
+            }
+            m_ByVirt.erase(itr);
+         }
+      }
+      Write(r);
+      return res;
+   }
+   virtual btPhysAddr bufferGetIOVA( btVirtAddr Address ) { return m_pBuffer->bufferGetIOVA(Address); }
+   // </IALIBuffer>
+
+   // <IALIUMsg>
+   virtual btUnsignedInt umsgGetNumber( void ) { return m_pUMsg->umsgGetNumber(); }
+   virtual btVirtAddr    umsgGetAddress( const btUnsignedInt UMsgNumber ) { return m_pUMsg->umsgGetAddress(UMsgNumber); }
+   virtual void umsgTrigger64( const btVirtAddr pUMsg, const btUnsigned64bitInt Value )
+   {
+      ALITraceRecord r = Begin(ALITRACE_UMSG_TRIGGER64, (btUnsigned64bitInt)-1);
+      m_pUMsg->umsgTrigger64(pUMsg, Value);
+      r.duration = ALITraceNow() - m_Start - r.tstamp;
+      r.value    = Value;
+
+      // Record the UMsg by number; its address is different on replay.
+      btUnsignedInt n = m_pUMsg->umsgGetNumber();
+      for ( btUnsignedInt i = 0 ; i < n ; ++i ) {
+         if ( m_pUMsg->umsgGetAddress(i) == pUMsg ) {
+            r.arg = i;
+            break;
+         }
+      }
+      AutoLock(this);
+      Write(r);
+   }
+   virtual bool umsgSetAttributes( NamedValueSet const &nvsArgs )
+   {
+      ALITraceRecord r = Begin(ALITRACE_UMSG_SET_ATTRIBUTES, 0);
+      bool res = m_pUMsg->umsgSetAttributes(nvsArgs);
+      btUnsigned64bitInt mask = 0;
+      if ( nvsArgs.Has(UMSG_HINT_MASK_KEY) ) {
+         nvsArgs.Get(UMSG_HINT_MASK_KEY, &mask);
+      }
+      r.value  = mask;
+      r.result = res;
+      End(r);
+      return res;
+   }
+   // </IALIUMsg>
+
+   // <IALIReset>
+   virtual e_Reset afuQuiesceAndHalt( void )                            { return ResetOp(ALITRACE_RESET_QUIESCE_HALT, NULL); }
+   virtual e_Reset afuQuiesceAndHalt( NamedValueSet const &rInputArgs ) { return ResetOp(ALITRACE_RESET_QUIESCE_HALT, &rInputArgs); }
+   virtual e_Reset afuEnable( void )                                    { return ResetOp(ALITRACE_RESET_ENABLE, NULL); }
+   virtual e_Reset afuEnable( NamedValueSet const &rInputArgs )         { return ResetOp(ALITRACE_RESET_ENABLE, &rInputArgs); }
+   virtual e_Reset afuReset( void )                                     { return ResetOp(ALITRACE_RESET, NULL); }
+   virtual e_Reset afuReset( NamedValueSet const &rInputArgs )          { return ResetOp(ALITRACE_RESET, &rInputArgs); }
+   // </IALIReset>
+
+protected:
+   struct BufferInfo
+   {
+      btUnsigned32bitInt id;
+      btWSSize           len;
+   };
+   typedef std::map<btVirtAddr, btUnsigned32bitInt> buf_virt_map;
+   typedef std::map<btPhysAddr, BufferInfo>         buf_iova_map;
+
+   ALITraceRecord Begin(btUnsigned16bitInt op, btUnsigned64bitInt arg) const
+   {
+      ALITraceRecord r;
+      memset(&r, 0, sizeof(r));
+      r.op     = op;
+      r.arg    = arg;
+      r.tstamp = ALITraceNow() - m_Start;
+      return r;
+   }
+
+   void End(ALITraceRecord &r)
+   {
+      r.duration = ALITraceNow() - m_Start - r.tstamp;
+      AutoLock(this);
+      if ( ALITRACE_MMIO_WRITE64 == r.op ) {
+         TagIOVA(r);
+      }
+      Write(r);
+   }
+
+   void AllocateEnd(ALITraceRecord &r, ali_errnum_e res, btWSSize Length, btVirtAddr *pBufferptr)
+   {
+      r.duration = ALITraceNow() - m_Start - r.tstamp;
+      r.result   = res;
+
+      AutoLock(this);
+      r.buffer = m_NextBufferId++;
+      if ( ( ali_errnumOK == res ) && ( NULL != pBufferptr ) ) {
+         BufferInfo info;
+         info.id  = r.buffer;
+         info.len = Length;
+         m_ByVirt[*pBufferptr] = r.buffer;
+         m_ByIOVA[m_pBuffer->bufferGetIOVA(*pBufferptr)] = info;
+      }
+      Write(r);
+   }
+
+   e_Reset ResetOp(btUnsigned16bitInt op, NamedValueSet const *pArgs)
+   {
+      ALITraceRecord r = Begin(op, 0);
+      e_Reset res;
+      switch ( op ) {
+         case ALITRACE_RESET_QUIESCE_HALT :
+            res = ( NULL == pArgs ) ? m_pReset->afuQuiesceAndHalt() : m_pReset->afuQuiesceAndHalt(*pArgs);
+         break;
+         case ALITRACE_RESET_ENABLE :
+            res = ( NULL == pArgs ) ? m_pReset->afuEnable() : m_pReset->afuEnable(*pArgs);
+         break;
+         default :
+            res = ( NULL == pArgs ) ? m_pReset->afuReset() : m_pReset->afuReset(*pArgs);
+         break;
+      }
+      r.result = res;
+      End(r);
+      return res;
+   }
+
+   // Lock held. Rewrite r.value relative to the buffer it points into, if any.
+   void TagIOVA(ALITraceRecord &r) const
+   {
+      if ( m_ByIOVA.empty() || ( 0 == r.value ) ) {
+         return;
+      }
+
+      btUnsigned16bitInt flags = ALITRACE_F_IOVA;
+      btPhysAddr         iova  = (btPhysAddr)r.value;
+      buf_iova_map::const_iterator itr = Find(iova);
+      if ( ( m_ByIOVA.end() == itr ) && ( r.value < ( 1ULL << 58 ) ) ) {
+         flags = ALITRACE_F_IOVA_CL;
+         iova  = (btPhysAddr)( r.value << 6 );
+         itr   = Find(iova);
+      }
+      if ( m_ByIOVA.end() == itr ) {
+         return;
+      }
+
+      r.flags  = flags;
+      r.buffer = itr->second.id;
+      r.value  = iova - itr->first;
+   }
+
+   // Lock held. The buffer containing iova, or m_ByIOVA.end().
+   buf_iova_map::const_iterator Find(btPhysAddr iova) const
+   {
+      buf_iova_map::const_iterator itr = m_ByIOVA.upper_bound(iova);
+      if ( m_ByIOVA.begin() == itr ) {
+         return m_ByIOVA.end();
+      }
+      --itr;
+      if ( iova - itr->first >= itr->second.len ) {
+         return m_ByIOVA.end();
+      }
+      return itr;
+   }
+
+   // Lock held.
+   void Write(const ALITraceRecord &r)
+   {
+      if ( NULL != m_fp ) {
+         fwrite(&r, sizeof(r), 1, m_fp);
+      }
+   }
+
+   IALIMMIO           *m_pMMIO;
+   IALIBuffer         *m_pBuffer;
+   IALIUMsg           *m_pUMsg;
+   IALIReset          *m_pReset;
+   FILE               *m_fp;
+   btUnsigned64bitInt  m_Start;
+   btUnsigned32bitInt  m_NextBufferId;
+   buf_virt_map        m_ByVirt;
+   buf_iova_map        m_ByIOVA;
+
+private:
+   ALITraceRecorder(const ALITraceRecorder & );
+   ALITraceRecorder & operator = (const ALITraceRecorder & );
+};
+
+/// Per-operation totals from ALITraceReplayer::Replay().
+struct ALITraceReplayStats
+{
+   btUnsigned64bitInt count[ALITRACE_OP_COUNT];           ///< Calls replayed.
+   btUnsigned64bitInt recordedNanos[ALITRACE_OP_COUNT];   ///< Recorded time in the backend.
+   btUnsigned64bitInt replayedNanos[ALITRACE_OP_COUNT];   ///< Replayed time in the backend.
+   btUnsigned64bitInt recordedSpanNanos;                  ///< First call to end of last call, as recorded.
+   btUnsigned64bitInt replayedSpanNanos;                  ///< First call to end of last call, on replay.
+   btUnsigned64bitInt readMismatches;                     ///< MMIO reads that returned a different value.
+   btUnsigned64bitInt resultMismatches;                   ///< Calls whose backend return value differed.
+
+   ALITraceReplayStats() :
+      recordedSpanNanos(0),
+      replayedSpanNanos(0),
+      readMismatches(0),
+      resultMismatches(0)
+   {
+      for ( int i = 0 ; i < ALITRACE_OP_COUNT ; ++i ) {
+         count[i] = recordedNanos[i] = replayedNanos[i] = 0;
+      }
+   }
+};
+
+/// @brief Replays a trace written by ALITraceRecorder against a backend.
+class ALITraceReplayer
+{
+public:
+   ALITraceReplayer(IALIMMIO   *pMMIO,
+                    IALIBuffer *pBuffer,
+                    IALIUMsg   *pUMsg,
+                    IALIReset  *pReset) :
+      m_pMMIO(pMMIO),
+      m_pBuffer(pBuffer),
+      m_pUMsg(pUMsg),
+      m_pReset(pReset)
+   {}
+
+   /// Read the trace at path.
+   /// @retval false The file is missing, truncated or not a compatible trace.
+   btBool Load(btcString path)
+   {
+      m_Records.clear();
+
+      FILE *fp = fopen(path, "rb");
+      if ( NULL == fp ) {
+         return false;
+      }
+
+      ALITraceHeader hdr;
+      btBool         res = ( 1 == fread(&hdr, sizeof(hdr), 1, fp) ) &&
+                           ( ALITRACE_MAGIC           == hdr.magic )   &&
+                           ( ALITRACE_VERSION         == hdr.version ) &&
+                           ( sizeof(ALITraceRecord)   == hdr.recordSize );
+      if ( res ) {
+         ALITraceRecord r;
+         while ( 1 == fread(&r, sizeof(r), 1, fp) ) {
+            m_Records.push_back(r);
+         }
+      }
+
+      fclose(fp);
+      return res;
+   }
+
+   std::vector<ALITraceRecord> const & Records() const { return m_Records; }
+
+   /// Issue every loaded call in order. With bPaced, each call is held back
+   ///  until its recorded offset from the start; otherwise calls are issued
+   ///  back to back. Buffers still allocated at the end are freed.
+   void Replay(ALITraceReplayStats &rStats, btBool bPaced = false)
+   {
+      std::map<btUnsigned32bitInt, Buffer> buffers;
+      std::vector<ALITraceRecord>::const_iterator itr;
+
+      rStats = ALITraceReplayStats();
+      if ( m_Records.empty() ) {
+         return;
+      }
+
+      const btUnsigned64bitInt first = m_Records.front().tstamp;
+      const btUnsigned64bitInt start = ALITraceNow();
+
+      for ( itr = m_Records.begin() ; m_Records.end() != itr ; ++itr ) {
+         const ALITraceRecord &r = *itr;
+         if ( ( 0 == r.op ) || ( r.op >= ALITRACE_OP_COUNT ) ) {
+            continue;
+         }
+
+         if ( bPaced ) {
+            WaitUntil(start + ( r.tstamp - first ));
+         }
+
+         btUnsigned64bitInt t0  = ALITraceNow();
+         btUnsigned32bitInt res = Issue(r, buffers, rStats);
+         btUnsigned64bitInt t1  = ALITraceNow();
+
+         rStats.count[r.op]++;
+         rStats.recordedNanos[r.op] += r.duration;
+         rStats.replayedNanos[r.op] += t1 - t0;
+         if ( res != r.result ) {
+            rStats.resultMismatches++;
+         }
+         if ( r.tstamp + r.duration - first > rStats.recordedSpanNanos ) {
+            rStats.recordedSpanNanos = r.tstamp + r.duration - first;
+         }
+         rStats.replayedSpanNanos = t1 - start;
+      }
+
+      std::map<btUnsigned32bitInt, Buffer>::iterator b;
+      for ( b = buffers.begin() ; buffers.end() != b ; ++b ) {
+         m_pBuffer->bufferFree(b->second.virt);
+      }
+   }
+
+protected:
+   struct Buffer
+   {
+      btVirtAddr virt;
+      btPhysAddr iova;
+   };
+
+   btUnsigned32bitInt Issue(const ALITraceRecord                &r,
+                            std::map<btUnsigned32bitInt, Buffer> &buffers,
+                            ALITraceReplayStats                  &rStats)
+   {
+      switch ( r.op ) {
+         case ALITRACE_MMIO_READ32 : {
+            btUnsigned32bitInt v = 0;
+            btBool res = m_pMMIO->mmioRead32((btCSROffset)r.arg, &v);
+            if ( res && r.result && ( v != r.value ) ) {
+               rStats.readMismatches++;
+            }
+            return res;
+         }
+         case ALITRACE_MMIO_WRITE32 :
+            return m_pMMIO->mmioWrite32((btCSROffset)r.arg, (btUnsigned32bitInt)r.value);
+         case ALITRACE_MMIO_READ64 : {
+            btUnsigned64bitInt v = 0;
+            btBool res = m_pMMIO->mmioRead64((btCSROffset)r.arg, &v);
+            if ( res && r.result && ( v != r.value ) ) {
+               rStats.readMismatches++;
+            }
+            return res;
+         }
+         case ALITRACE_MMIO_WRITE64 : {
+            btUnsigned64bitInt v = r.value;
+            if ( 0 != ( r.flags & ( ALITRACE_F_IOVA | ALITRACE_F_IOVA_CL ) ) ) {
+               std::map<btUnsigned32bitInt, Buffer>::const_iterator b = buffers.find(r.buffer);
+               if ( buffers.end() != b ) {
+                  v = b->second.iova + r.value;
+                  if ( 0 != ( r.flags & ALITRACE_F_IOVA_CL ) ) {
+                     v >>= 6;
+                  }
+               }
+            }
+            return m_pMMIO->mmioWrite64((btCSROffset)r.arg, v);
+         }
+         case ALITRACE_BUFFER_ALLOCATE : {
+            Buffer       b   = { NULL, 0 };
+            ali_errnum_e res = m_pBuffer->bufferAllocate((btWSSize)r.arg, &b.virt);
+            if ( ali_errnumOK == res ) {
+               b.iova = m_pBuffer->bufferGetIOVA(b.virt);
+               buffers[r.buffer] = b;
+            }
+            return res;
+         }
+         case ALITRACE_BUFFER_FREE : {
+            std::map<btUnsigned32bitInt, Buffer>::iterator b = buffers.find(r.buffer);
+            if ( buffers.end() == b ) {
+               return ali_errnumBadParameter;
+            }
+            ali_errnum_e res = m_pBuffer->bufferFree(b->second.virt);
+            buffers.erase(b);
+            return res;
+         }
+         case ALITRACE_UMSG_TRIGGER64 :
+            if ( r.arg < m_pUMsg->umsgGetNumber() ) {
+               m_pUMsg->umsgTrigger64(m_pUMsg->umsgGetAddress((btUnsignedInt)r.arg), r.value);
+            }
+            return 0;
+         case ALITRACE_UMSG_SET_ATTRIBUTES : {
+            NamedValueSet nvs;
+            nvs.Add(UMSG_HINT_MASK_KEY, r.value);
+            return m_pUMsg->umsgSetAttributes(nvs);
+         }
+         case ALITRACE_RESET_QUIESCE_HALT :
+            return m_pReset->afuQuiesceAndHalt();
+         case ALITRACE_RESET_ENABLE :
+            return m_pReset->afuEnable();
+         default :
+            return m_pReset->afuReset();
+      }
+   }
+
+   // Sleep through most of a long gap, then spin.
+   static void WaitUntil(btUnsigned64bitInt when)
+   {
+      btUnsigned64bitInt now = ALITraceNow();
+      if ( when > now + 100000ULL ) {
+         struct timespec ts;
+         btUnsigned64bitInt ns = when - now - 50000ULL;
+         ts.tv_sec  = (time_t)( ns / 1000000000ULL );
+         ts.tv_nsec = (long)( ns % 1000000000ULL );
+         nanosleep(&ts, NULL);
+      }
+      while ( ALITraceNow() < when ) {
+         // spin
+      }
+   }
+
+   IALIMMIO                   *m_pMMIO;
+   IALIBuffer                 *m_pBuffer;
+   IALIUMsg                   *m_pUMsg;
+   IALIReset                  *m_pReset;
+   std::vector<ALITraceRecord> m_Records;
+};
+
+/// @}
+
+END_NAMESPACE(AAL)
+
+#endif // __AAL_LINUX__
+
+#endif // __AALSDK_UTILS_ALITRACE_H__
@@ -0,0 +1,181 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// @file SeqlockRing.h
+/// @brief Single-writer, lock-free multi-reader ring of snapshots.
+/// @ingroup SeqlockRing
+/// @verbatim
+/// Accelerator Abstraction Layer
+///
+/// Each slot is guarded by a sequence counter that is odd while the writer
+///  is updating it. Readers never block the writer; they copy a slot and
+///  retry if its counter moved meanwhile. The ring contains no pointers, so
+///  it may be placed in memory shared between processes.
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version.@endverbatim
+//****************************************************************************
+#ifndef __AALSDK_UTILS_SEQLOCKRING_H__
+#define __AALSDK_UTILS_SEQLOCKRING_H__
+#include <aalsdk/AALTypes.h>
+
+BEGIN_NAMESPACE(AAL)
+
+/// @addtogroup SeqlockRing
+/// @{
+
+/// @brief Ring of the N most recent values of T.
+///
+/// T must be plain old data. N must be a power of 2. Publish() may be called
+///  from one thread (or process) at a time; Latest() and History() may be
+///  called from any number concurrently.
+template <typename T, btUnsigned32bitInt N>
+class SeqlockRing
+{
+public:
+   SeqlockRing() { Reset(); }
+
+   /// Empty the ring. Not safe against concurrent readers.
+   void Reset()
+   {
+      btUnsigned32bitInt i;
+      for ( i = 0 ; i < N ; ++i ) {
+         m_Slots[i].seq   = 0;
+         m_Slots[i].index = 0;
+      }
+      m_Published = 0;
+      Fence();
+   }
+
+   /// Number of values published since the last Reset().
+   btUnsigned64bitInt Published() const { return m_Published; }
+
+   /// Store v as the newest value, overwriting the oldest when full.
+   void Publish(const T &v)
+   {
+      btUnsigned64bitInt n = m_Published;
+      Slot              &s = m_Slots[n & ( N - 1 )];
+
+      s.seq = s.seq + 1;      // odd: update in progress
+      Fence();
+      s.index = n;
+      const_cast<T &>(s.value) = v;
+      Fence();
+      s.seq = s.seq + 1;      // even: stable
+      Fence();
+      m_Published = n + 1;
+   }
+
+   /// Copy the newest value into v.
+   /// @retval false Nothing has been published.
+   btBool Latest(T &v) const
+   {
+      for ( ;; ) {
+         btUnsigned64bitInt n = m_Published;
+         if ( 0 == n ) {
+            return false;
+         }
+         if ( Read(n - 1, v) ) {
+            return true;
+         }
+         // Lapped by the writer; start again from the new head.
+      }
+   }
+
+   /// Copy up to max values, newest first, into pOut.
+   /// @return The number of values copied. Stops early at values the writer
+   ///         overwrote during the copy.
+   btUnsigned32bitInt History(T *pOut, btUnsigned32bitInt max) const
+   {
+      btUnsigned64bitInt n = m_Published;
+      btUnsigned32bitInt i;
+
+      if ( max > N ) {
+         max = N;
+      }
+      if ( max > n ) {
+         max = (btUnsigned32bitInt)n;
+      }
+
+      for ( i = 0 ; i < max ; ++i ) {
+         if ( !Read(n - 1 - i, pOut[i]) ) {
+            break;
+         }
+      }
+      return i;
+   }
+
+private:
+   struct Slot
+   {
+      volatile btUnsigned64bitInt seq;
+      volatile btUnsigned64bitInt index;
+      volatile T                  value;
+   };
+
+   // Copy the value published as index n. False if the slot no longer
+   //  holds it.
+   btBool Read(btUnsigned64bitInt n, T &v) const
+   {
+      const Slot &s = m_Slots[n & ( N - 1 )];
+
+      for ( ;; ) {
+         btUnsigned64bitInt seq = s.seq;
+         if ( seq & 1 ) {
+            continue;
+         }
+         Fence();
+         btUnsigned64bitInt index = s.index;
+         v = const_cast<const T &>(s.value);
+         Fence();
+         if ( seq == s.seq ) {
+            return index == n;
+         }
+      }
+   }
+
+   static void Fence()
+   {
+#if   defined( __AAL_WINDOWS__ )
+      MemoryBarrier();
+#elif defined( __AAL_LINUX__ )
+      __sync_synchronize();
+#endif // OS
+   }
+
+   // Compile-time check that N is a nonzero power of 2.
+   typedef char N_must_be_a_power_of_2[( ( 0 != N ) && ( 0 == ( N & ( N - 1 ) ) ) ) ? 1 : -1];
+
+   volatile btUnsigned64bitInt m_Published;
+   Slot                        m_Slots[N];
+};
+
+/// @}
+
+END_NAMESPACE(AAL)
+
+#endif // __AALSDK_UTILS_SEQLOCKRING_H__
@@ -45,6 +45,8 @@
 #endif // HAVE_CONFIG_H
 
 #include <aalsdk/utils/ResMgrUtilities.h>
+#include <aalsdk/utils/ALITrace.h>
+#include <aalsdk/utils/ALICompletion.h>
 
 #include "HWALIFME.h"
 #include "HWALIPORT.h"
@@ -169,6 +171,17 @@ btBool ALI::Release(TransactionID const &TranID, btTime timeout)
    ReleaseContext      *prc        = NULL;
    btApplicationContext appContext = NULL;
 
+#if defined( __AAL_LINUX__ )
+   if ( m_pTraceRecorder ) {
+      delete m_pTraceRecorder;
+      m_pTraceRecorder = NULL;
+   }
+   if ( m_pCompletion ) {
+      delete m_pCompletion;
+      m_pCompletion = NULL;
+   }
+#endif // __AAL_LINUX__
+
    if ( OptArgs().Has(ALIAFU_NVS_KEY_TARGET) ) {
 
       OptArgs().Get(ALIAFU_NVS_KEY_TARGET, &targetType);
@@ -416,6 +429,14 @@ btBool ALI::setAFUInterfaces()
       goto FAIL;
    }
 
+   if(false == setCompletionInterface()) {
+      goto FAIL;
+   }
+
+   if(false == setTraceInterfaces()) {
+      goto FAIL;
+   }
+
    return true;
 
 FAIL:
@@ -493,6 +514,10 @@ btBool ALI::setFMEInterfaces()
       goto FAIL;
    }
 
+   if( EObjOK != SetInterface(iidALI_PERF_SAMPLER_Service, dynamic_cast<IALIPerfSampler *>(m_pALIBase)) ){
+      goto FAIL;
+   }
+
    if( EObjOK != SetInterface(iidALI_FMEERR_Service, dynamic_cast<IALIFMEError *>(m_pALIBase)) ){
       goto FAIL;
    }
@@ -505,6 +530,10 @@ btBool ALI::setFMEInterfaces()
       goto FAIL;
    }
 
+   if( EObjOK != SetInterface(iidALI_TELEMETRY_Service, dynamic_cast<IALITelemetry *>(m_pALIBase)) ){
+      goto FAIL;
+   }
+
    if(false == (dynamic_cast<CHWALIFME *>(m_pALIBase))->mapMMIO()) {
       goto FAIL;
    }
@@ -556,6 +585,14 @@ btBool ALI::ASEInit()
       if( EObjOK != SetInterface(iidALI_MMIO_Service, dynamic_cast<IALIMMIO *>(m_pALIBase)) ){
           goto FAIL;
       }
+
+      if(false == setCompletionInterface()) {
+         goto FAIL;
+      }
+
+      if(false == setTraceInterfaces()) {
+         goto FAIL;
+      }
    }
 
    return  ((dynamic_cast<CASEALIAFU *>(m_pALIBase))->ASEInit());
@@ -571,6 +608,66 @@ FAIL:
    return false;
 }
 
+//
+// setCompletionInterface. Publishes an ALICompletion, woken by AFU events.
+//
+btBool ALI::setCompletionInterface()
+{
+#if defined( __AAL_LINUX__ )
+   if(NULL == m_pCompletion) {
+      m_pCompletion = new (std::nothrow) ALICompletion();
+      if(NULL == m_pCompletion) {
+         AAL_ERR( LM_ALI, "No Memory to allocate completion interface"<< std::endl);
+         return false;
+      }
+   }
+
+   if( EObjOK != SetInterface(iidALI_CMPL_Service, dynamic_cast<IALICompletion *>(m_pCompletion)) ){
+      return false;
+   }
+#endif // __AAL_LINUX__
+   return true;
+}
+
+//
+// setTraceInterfaces. Puts an ALITraceRecorder in front of the AFU interfaces
+//  when the client asked for a trace.
+//
+btBool ALI::setTraceInterfaces()
+{
+   if ( !OptArgs().Has(ALIAFU_NVS_KEY_RECORD_TRACE) ) {
+      return true;
+   }
+
+#if defined( __AAL_LINUX__ )
+   btcString path = NULL;
+   OptArgs().Get(ALIAFU_NVS_KEY_RECORD_TRACE, &path);
+
+   m_pTraceRecorder = new (std::nothrow) ALITraceRecorder(dynamic_cast<IALIMMIO *>(m_pALIBase),
+                                                          dynamic_cast<IALIBuffer *>(m_pALIBase),
+                                                          dynamic_cast<IALIUMsg *>(m_pALIBase),
+                                                          dynamic_cast<IALIReset *>(m_pALIBase));
+   if ( ( NULL == m_pTraceRecorder ) || !m_pTraceRecorder->Open(path) ) {
+      AAL_ERR( LM_ALI, "Could not open ALI trace file " << ( path ? path : "(null)" ) << std::endl);
+      delete m_pTraceRecorder;
+      m_pTraceRecorder = NULL;
+      return false;
+   }
+
+   if ( ( EObjOK != ReplaceInterface(iidALI_MMIO_Service, dynamic_cast<IALIMMIO *>(m_pTraceRecorder)) ) ||
+        ( EObjOK != ReplaceInterface(iidALI_UMSG_Service, dynamic_cast<IALIUMsg *>(m_pTraceRecorder)) ) ||
+        ( EObjOK != ReplaceInterface(iidALI_BUFF_Service, dynamic_cast<IALIBuffer *>(m_pTraceRecorder)) ) ||
+        ( EObjOK != ReplaceInterface(iidALI_RSET_Service, dynamic_cast<IALIReset *>(m_pTraceRecorder)) ) ) {
+      return false;
+   }
+
+   return true;
+#else
+   AAL_ERR( LM_ALI, "ALI trace recording is not supported on this platform" << std::endl);
+   return false;
+#endif // __AAL_LINUX__
+}
+
 void ALI::serviceReleaseRequest(IBase *pServiceBase, const IEvent &rEvent)
 {
    ERR("Recieved unhandled serviceReleaseRequest() from AFU PRoxy\n");
@@ -615,6 +712,13 @@ void ALI::serviceEvent(const IEvent &rEvent) {
 void ALI::AFUEvent(AAL::IEvent const &theEvent) {
 
    (static_cast<CHWALIBase *>(m_pALIBase))->AFUEvent(theEvent);
+
+#if defined( __AAL_LINUX__ )
+   // Waiters sleeping on a DSM word recheck it now.
+   if ( NULL != m_pCompletion ) {
+      m_pCompletion->completionNotify();
+   }
+#endif // __AAL_LINUX__
 }
 
 /// @} group ALI
@@ -52,6 +52,9 @@ class CALIBase;
 
 BEGIN_NAMESPACE(AAL)
 
+class ALITraceRecorder;
+class ALICompletion;
+
 /// @addtogroup ALI
 /// @{
 
@@ -79,7 +82,9 @@ DECLARE_AAL_SERVICE_CONSTRUCTOR(ALI,ServiceBase),
                                 m_pAFUProxy(NULL),
                                 m_tidSaved(),
                                 m_pSvcClient(NULL),
-                                m_pALIBase(NULL)
+                                m_pALIBase(NULL),
+                                m_pTraceRecorder(NULL),
+                                m_pCompletion(NULL)
    {
       if ( EObjOK != SetInterface(iidServiceClient, dynamic_cast<IServiceClient *>(this)) ){
          m_bIsOK = false;
@@ -123,6 +128,11 @@ DECLARE_AAL_SERVICE_CONSTRUCTOR(ALI,ServiceBase),
    // Initialize ASE
    btBool ASEInit();
 
+   // Record the AFU interfaces if ALIAFU_NVS_KEY_RECORD_TRACE was given
+   btBool setTraceInterfaces();
+   // Sets the completion interface shared by the FPGA and ASE AFUs
+   btBool setCompletionInterface();
+
 protected:
 
    IAALService            *m_pAALService;
@@ -130,6 +140,8 @@ protected:
    TransactionID           m_tidSaved;
    IBase                  *m_pSvcClient;
    CALIBase               *m_pALIBase;
+   ALITraceRecorder       *m_pTraceRecorder;
+   ALICompletion          *m_pCompletion;
 
    struct ReleaseContext {
       const TransactionID   TranID;
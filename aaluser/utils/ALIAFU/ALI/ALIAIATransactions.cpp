@@ -75,9 +75,9 @@ USING_NAMESPACE(AAL)
 // Description:   Send a Workspace Allocate operation to the Driver stack
 // Input: devHandl - Device Handle received from Resource Manager
 //        tranID   - Transaction ID
-// Comments:
+// Comments: numa is the NUMA node + 1 to allocate from, 0 for the default.
 //=============================================================================
-BufferAllocateTransaction::BufferAllocateTransaction( btWSSize len ) :
+BufferAllocateTransaction::BufferAllocateTransaction( btWSSize len, btUnsigned32bitInt numa ) :
    m_msgID(reqid_UID_SendAFU),
    m_bIsOK(false),
    m_payload(NULL),
@@ -112,9 +112,11 @@ BufferAllocateTransaction::BufferAllocateTransaction( btWSSize len ) :
    afumsg->size    =  sizeof(union msgpayload );
 
    // fill out ahm_req
+   memset(req, 0, sizeof(union msgpayload));
    req->u.wksp.m_wsid   = 0;        // not used?
    req->u.wksp.m_size   = len;
    req->u.wksp.m_pgsize = 0;        // not used?
+   req->u.wksp.m_numa   = numa;
 
    // package in AIA transaction
    m_payload = (btVirtAddr) afumsg;
@@ -203,10 +205,10 @@ BufferFreeTransaction::~BufferFreeTransaction() {
 //=============================================================================
 // Name:          GetMMIOBufferTransaction
 // Description:   Send a Get MMIO Buffer operation to the Driver stack
-// Input:         tranID   - Transaction ID
+// Input:         wsid     - Special workspace ID of the region to map
 // Comments:
 //=============================================================================
-GetMMIOBufferTransaction::GetMMIOBufferTransaction() :
+GetMMIOBufferTransaction::GetMMIOBufferTransaction(btWSID wsid) :
    m_msgID(reqid_UID_SendAFU),
    m_bIsOK(false),
    m_payload(NULL),
@@ -240,7 +242,7 @@ GetMMIOBufferTransaction::GetMMIOBufferTransaction() :
    afumsg->cmd     = ccipdrv_getMMIORmap;
    afumsg->size    = sizeof(union msgpayload);
 
-   req->u.wksp.m_wsid = WSID_MAP_MMIOR;
+   req->u.wksp.m_wsid = wsid;
 
    // package in AIA transaction
    m_payload = (btVirtAddr) afumsg;
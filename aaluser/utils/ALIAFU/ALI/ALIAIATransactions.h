@@ -60,12 +60,12 @@
 // Description:   Send a Workspace Allocate operation to the Driver stack
 // Input: devHandl - Device Handle received from Resource Manager
 //        tranID   - Transaction ID
-// Comments:
+// Comments: numa is the NUMA node + 1 to allocate from, 0 for the default.
 //=============================================================================
 class UAIA_API BufferAllocateTransaction : public IAIATransaction
 {
 public:
-   BufferAllocateTransaction( AAL::btWSSize len );
+   BufferAllocateTransaction( AAL::btWSSize len, AAL::btUnsigned32bitInt numa = 0 );
    AAL::btBool                IsOK() const;
 
    AAL::btVirtAddr                getPayloadPtr() const;
@@ -129,13 +129,13 @@ private:
 //=============================================================================
 // Name:          GetMMIOBufferTransaction
 // Description:   Send a Get MMIO Buffer operation to the Driver stack
-// Input:         tranID   - Transaction ID
+// Input:         wsid     - Special workspace ID of the region to map
 // Comments:
 //=============================================================================
 class UAIA_API GetMMIOBufferTransaction : public IAIATransaction
 {
 public:
-   GetMMIOBufferTransaction();
+   GetMMIOBufferTransaction(AAL::btWSID wsid = WSID_MAP_MMIOR);
    AAL::btBool                IsOK() const;
 
    AAL::btVirtAddr                getPayloadPtr() const;
@@ -0,0 +1,383 @@
+// Copyright(c) 2015-2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// @file BitstreamCache.cpp
+/// @brief Process-wide cache of validated green bitstreams.
+/// @ingroup ALI
+/// @verbatim
+/// Accelerator Abstraction Layer
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version.
+/// 10/19/2016              Revalidate only when the content hash changes.@endverbatim
+//****************************************************************************
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <aalsdk/AALLoggerExtern.h>
+
+#include "BitstreamCache.h"
+
+BEGIN_NAMESPACE(AAL)
+
+// Chunk size used when the file can't be mapped and must be read.
+#define BITSTREAM_READ_CHUNK (1024 * 1024)
+
+#define FNV1A_64_OFFSET 0xcbf29ce484222325ULL
+#define FNV1A_64_PRIME  0x100000001b3ULL
+
+// FNV-1a over 64-bit words (unaligned-safe), then over the trailing bytes.
+static btUnsigned64bitInt BitstreamHash(const btByte *p, btWSSize len)
+{
+   btUnsigned64bitInt h = FNV1A_64_OFFSET;
+   btUnsigned64bitInt w;
+
+   while ( len >= sizeof(w) ) {
+      memcpy(&w, p, sizeof(w));
+      h ^= w;
+      h *= FNV1A_64_PRIME;
+      p   += sizeof(w);
+      len -= sizeof(w);
+   }
+
+   while ( len-- > 0 ) {
+      h ^= *p++;
+      h *= FNV1A_64_PRIME;
+   }
+
+   return h;
+}
+
+CBitstream::CBitstream() :
+   m_pImage(NULL),
+   m_Len(0),
+   m_bMapped(false),
+   m_Hash(0),
+   m_RefCount(0)
+{
+   memset(&m_Header, 0, sizeof(m_Header));
+}
+
+CBitstream::~CBitstream()
+{
+   if ( NULL == m_pImage ) {
+      return;
+   }
+
+   if ( m_bMapped ) {
+      munmap(m_pImage, m_Len);
+   } else {
+      delete[] m_pImage;
+   }
+}
+
+bool CBitstreamCache::FileId::operator == (const FileId &rhs) const
+{
+   return ( dev        == rhs.dev        ) &&
+          ( ino        == rhs.ino        ) &&
+          ( size       == rhs.size       ) &&
+          ( mtime_sec  == rhs.mtime_sec  ) &&
+          ( mtime_nsec == rhs.mtime_nsec );
+}
+
+CBitstreamCache CBitstreamCache::sm_Instance;
+
+CBitstreamCache::CBitstreamCache() :
+   m_Tick(0)
+{}
+
+CBitstreamCache::~CBitstreamCache()
+{
+   DoFlush();
+}
+
+EBitstreamStatus CBitstreamCache::Acquire(btcString path, CBitstream **ppBitstream)
+{
+   return sm_Instance.DoAcquire(path, ppBitstream);
+}
+
+void CBitstreamCache::Release(CBitstream *pBitstream)
+{
+   sm_Instance.DoRelease(pBitstream);
+}
+
+void CBitstreamCache::Flush()
+{
+   sm_Instance.DoFlush();
+}
+
+//=============================================================================
+// Name: DoAcquire
+// Description: Return the cached bitstream for path when the file is
+//              unchanged, otherwise load it. A load whose length and hash
+//              match the cached image keeps that image; any other is
+//              validated and cached.
+// Interface: private
+// Inputs: path - bitstream file.
+// Outputs: ppBitstream - referenced bitstream on bitstreamOK.
+// Comments: The file is examined through the descriptor that is loaded, so
+//           the recorded identity always describes the cached contents.
+//=============================================================================
+EBitstreamStatus CBitstreamCache::DoAcquire(btcString path, CBitstream **ppBitstream)
+{
+   struct stat      st;
+   FileId           id;
+   EBitstreamStatus res;
+   CBitstream      *pBitstream = NULL;
+   EntryMap_itr     itr;
+   int              fd;
+
+   if ( ( NULL == path ) || ( NULL == ppBitstream ) ) {
+      return bitstreamFileError;
+   }
+
+   AutoLock(this);
+
+   fd = open(path, O_RDONLY | O_CLOEXEC);
+   if ( fd < 0 ) {
+      AAL_ERR(LM_ALI, "Bitstream " << path << ": open failed, errno " << errno << std::endl);
+      return bitstreamFileError;
+   }
+
+   if ( ( 0 != fstat(fd, &st) ) || !S_ISREG(st.st_mode) ) {
+      close(fd);
+      return bitstreamFileError;
+   }
+
+   if ( 0 == st.st_size ) {
+      close(fd);
+      return bitstreamEmpty;
+   }
+
+   id.dev        = st.st_dev;
+   id.ino        = st.st_ino;
+   id.size       = st.st_size;
+   id.mtime_sec  = st.st_mtim.tv_sec;
+   id.mtime_nsec = st.st_mtim.tv_nsec;
+
+   ++m_Tick;
+
+   itr = m_Entries.find(path);
+   if ( ( m_Entries.end() != itr ) && ( itr->second.id == id ) ) {
+      close(fd);
+      itr->second.lastUse = m_Tick;
+      pBitstream = itr->second.pBitstream;
+      ++pBitstream->m_RefCount;
+      *ppBitstream = pBitstream;
+      return bitstreamOK;
+   }
+
+   res = Load(fd, (btWSSize)st.st_size, &pBitstream);
+   close(fd);
+
+   if ( bitstreamOK != res ) {
+      return res;
+   }
+
+   if ( ( m_Entries.end() != itr ) &&
+        ( itr->second.pBitstream->m_Len  == pBitstream->m_Len ) &&
+        ( itr->second.pBitstream->m_Hash == pBitstream->m_Hash ) ) {
+      // Touched or rewritten, but the same image. Keep the validated copy.
+      AAL_DEBUG(LM_ALI, "Bitstream " << path << " unchanged, hash 0x"
+                           << std::hex << pBitstream->m_Hash << std::dec << std::endl);
+      delete pBitstream;
+      itr->second.id      = id;
+      itr->second.lastUse = m_Tick;
+      pBitstream = itr->second.pBitstream;
+      ++pBitstream->m_RefCount;
+      *ppBitstream = pBitstream;
+      return bitstreamOK;
+   }
+
+   res = Validate(pBitstream);
+   if ( bitstreamOK != res ) {
+      delete pBitstream;
+      return res;
+   }
+
+   AAL_DEBUG(LM_ALI, "Bitstream " << path << " loaded, " << pBitstream->m_Len
+                        << " bytes, hash 0x" << std::hex << pBitstream->m_Hash << std::dec
+                        << ( pBitstream->m_bMapped ? " (mapped)" : " (buffered)" ) << std::endl);
+
+   // One reference for the cache and one for the caller.
+   pBitstream->m_RefCount = 2;
+
+   if ( m_Entries.end() != itr ) {
+      // The file changed under the old entry.
+      DoRelease(itr->second.pBitstream);
+      itr->second.id         = id;
+      itr->second.pBitstream = pBitstream;
+      itr->second.lastUse    = m_Tick;
+   } else {
+      Entry e;
+      e.id         = id;
+      e.pBitstream = pBitstream;
+      e.lastUse    = m_Tick;
+      m_Entries.insert(std::make_pair(std::string(path), e));
+      Evict();
+   }
+
+   *ppBitstream = pBitstream;
+   return bitstreamOK;
+}
+
+void CBitstreamCache::DoRelease(CBitstream *pBitstream)
+{
+   if ( NULL == pBitstream ) {
+      return;
+   }
+
+   AutoLock(this);
+
+   ASSERT(pBitstream->m_RefCount > 0);
+   if ( 0 == --pBitstream->m_RefCount ) {
+      delete pBitstream;
+   }
+}
+
+void CBitstreamCache::DoFlush()
+{
+   AutoLock(this);
+
+   EntryMap_itr itr;
+   for ( itr = m_Entries.begin() ; m_Entries.end() != itr ; ++itr ) {
+      DoRelease(itr->second.pBitstream);
+   }
+   m_Entries.clear();
+}
+
+// Drop least-recently used entries held only by the cache until the cache
+//  is within MaxEntries. Entries in use are never dropped.
+void CBitstreamCache::Evict()
+{
+   while ( m_Entries.size() > MaxEntries ) {
+      EntryMap_itr victim = m_Entries.end();
+      EntryMap_itr itr;
+
+      for ( itr = m_Entries.begin() ; m_Entries.end() != itr ; ++itr ) {
+         if ( 1 != itr->second.pBitstream->m_RefCount ) {
+            continue;
+         }
+         if ( ( m_Entries.end() == victim ) || ( itr->second.lastUse < victim->second.lastUse ) ) {
+            victim = itr;
+         }
+      }
+
+      if ( m_Entries.end() == victim ) {
+         break;
+      }
+
+      DoRelease(victim->second.pBitstream);
+      m_Entries.erase(victim);
+   }
+}
+
+//=============================================================================
+// Name: Load
+// Description: Map (or, failing that, read) the len-byte image at fd and
+//              hash it.
+// Interface: private
+// Inputs: fd - open bitstream file.
+//         len - file size.
+// Outputs: ppBitstream - new, unreferenced, unvalidated bitstream on
+//          bitstreamOK.
+// Comments: The hash pass also faults the mapping in ahead of the driver's
+//           copy.
+//=============================================================================
+EBitstreamStatus CBitstreamCache::Load(int fd, btWSSize len, CBitstream **ppBitstream)
+{
+   CBitstream *pBitstream = new(std::nothrow) CBitstream();
+
+   if ( NULL == pBitstream ) {
+      return bitstreamNoMemory;
+   }
+
+   pBitstream->m_Len = len;
+
+   void *pMap = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+   if ( MAP_FAILED != pMap ) {
+      madvise(pMap, len, MADV_SEQUENTIAL);
+      madvise(pMap, len, MADV_WILLNEED);
+      pBitstream->m_pImage  = reinterpret_cast<btByte *>(pMap);
+      pBitstream->m_bMapped = true;
+   } else {
+      pBitstream->m_pImage = new(std::nothrow) btByte[len];
+      if ( NULL == pBitstream->m_pImage ) {
+         delete pBitstream;
+         return bitstreamNoMemory;
+      }
+
+      btWSSize done = 0;
+      while ( done < len ) {
+         btWSSize chunk = len - done;
+         if ( chunk > BITSTREAM_READ_CHUNK ) {
+            chunk = BITSTREAM_READ_CHUNK;
+         }
+
+         ssize_t got = read(fd, pBitstream->m_pImage + done, chunk);
+         if ( got < 0 ) {
+            if ( EINTR == errno ) {
+               continue;
+            }
+            delete pBitstream;
+            return bitstreamFileError;
+         }
+         if ( 0 == got ) {
+            // Truncated underneath us.
+            delete pBitstream;
+            return bitstreamFileError;
+         }
+         done += (btWSSize)got;
+      }
+   }
+
+   pBitstream->m_Hash = BitstreamHash(pBitstream->m_pImage, len);
+
+   *ppBitstream = pBitstream;
+   return bitstreamOK;
+}
+
+// Parse and check the header of a freshly loaded image.
+EBitstreamStatus CBitstreamCache::Validate(CBitstream *pBitstream)
+{
+   EGBSHeaderStatus hdr = GBSParseHeader(pBitstream->m_pImage, pBitstream->m_Len, pBitstream->m_Header);
+
+   if ( gbsHeaderOK != hdr ) {
+      AAL_ERR(LM_ALI, "Invalid green bitstream header: " << GBSHeaderStatusStr(hdr) << std::endl);
+      return bitstreamBadHeader;
+   }
+
+   return bitstreamOK;
+}
+
+END_NAMESPACE(AAL)
@@ -0,0 +1,154 @@
+// Copyright(c) 2015-2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// @file BitstreamCache.h
+/// @brief Process-wide cache of validated green bitstreams.
+/// @ingroup ALI
+/// @verbatim
+/// Accelerator Abstraction Layer
+///
+/// Bitstream files are mapped read-only rather than copied onto the heap,
+///  and their headers are validated once per file version. Later requests
+///  for an unchanged file cost one stat(). A file rewritten with the same
+///  contents keeps its validated image.
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version.
+/// 10/19/2016              Revalidate only when the content hash changes.@endverbatim
+//****************************************************************************
+#ifndef __BITSTREAMCACHE_H__
+#define __BITSTREAMCACHE_H__
+#include <map>
+#include <string>
+
+#include <aalsdk/AALTypes.h>
+#include <aalsdk/osal/CriticalSection.h>
+
+#include "GBSHeader.h"
+
+BEGIN_NAMESPACE(AAL)
+
+/// @addtogroup ALI
+/// @{
+
+/// Result of CBitstreamCache::Acquire().
+typedef enum
+{
+   bitstreamOK = 0,
+   bitstreamFileError,  ///< The file could not be opened, examined or read.
+   bitstreamEmpty,      ///< The file is zero-length.
+   bitstreamNoMemory,   ///< The file could neither be mapped nor buffered.
+   bitstreamBadHeader   ///< GBSParseHeader() rejected the image.
+} EBitstreamStatus;
+
+/// @brief A validated bitstream image, shared by reference count.
+///
+/// The image stays mapped until the last reference is released, so the
+///  payload pointer may be handed to the driver without copying.
+class CBitstream
+{
+public:
+   const btByte *     Payload()    const { return m_pImage + m_Header.payloadOffset; }
+   btWSSize           PayloadLen() const { return m_Header.payloadLen;                }
+   /// 64-bit FNV-1a hash of the whole image, computed once at load.
+   btUnsigned64bitInt Hash()       const { return m_Hash;                             }
+
+private:
+   friend class CBitstreamCache;
+
+   CBitstream();
+   ~CBitstream();
+
+   btByte            *m_pImage;
+   btWSSize           m_Len;
+   btBool             m_bMapped;
+   GBSHeaderInfo      m_Header;
+   btUnsigned64bitInt m_Hash;
+   btUnsigned32bitInt m_RefCount;
+};
+
+/// @brief Path-keyed cache of CBitstream's.
+///
+/// An entry is reused while the file's device, inode, size and modification
+///  time are unchanged. Otherwise the file is loaded and hashed again, and
+///  only validated if its length or hash differ from the entry's.
+///  Only the least-recently used entries that no caller holds are evicted.
+class CBitstreamCache : public CriticalSection
+{
+public:
+   /// Obtain a referenced bitstream for the file at path. On bitstreamOK,
+   ///  *ppBitstream must later be passed to Release().
+   static EBitstreamStatus Acquire(btcString path, CBitstream **ppBitstream);
+   static void             Release(CBitstream *pBitstream);
+   /// Drop every entry. Bitstreams still held by callers survive until released.
+   static void             Flush();
+
+private:
+   CBitstreamCache();
+   ~CBitstreamCache();
+
+   struct FileId
+   {
+      btUnsigned64bitInt dev;
+      btUnsigned64bitInt ino;
+      btUnsigned64bitInt size;
+      btUnsigned64bitInt mtime_sec;
+      btUnsigned64bitInt mtime_nsec;
+      bool operator == (const FileId &rhs) const;
+   };
+
+   struct Entry
+   {
+      FileId             id;
+      CBitstream        *pBitstream;
+      btUnsigned64bitInt lastUse;
+   };
+
+   typedef std::map<std::string, Entry> EntryMap;
+   typedef EntryMap::iterator           EntryMap_itr;
+
+   enum { MaxEntries = 8 };
+
+   EBitstreamStatus DoAcquire(btcString path, CBitstream **ppBitstream);
+   void             DoRelease(CBitstream *pBitstream);
+   void             DoFlush();
+   void             Evict();
+
+   static EBitstreamStatus Load(int fd, btWSSize len, CBitstream **ppBitstream);
+   static EBitstreamStatus Validate(CBitstream *pBitstream);
+
+   EntryMap           m_Entries;
+   btUnsigned64bitInt m_Tick;
+
+   static CBitstreamCache sm_Instance;
+};
+
+/// @}
+
+END_NAMESPACE(AAL)
+
+#endif // __BITSTREAMCACHE_H__
@@ -0,0 +1,127 @@
+// Copyright(c) 2015-2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// @file GBSHeader.h
+/// @brief Green bitstream (.gbs) header parsing.
+/// @ingroup ALI
+/// @verbatim
+/// Accelerator Abstraction Layer
+///
+/// The parser is header-only so that it can be exercised without loading
+///  libALI. It never reads beyond the length it is given.
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version.@endverbatim
+//****************************************************************************
+#ifndef __GBSHEADER_H__
+#define __GBSHEADER_H__
+#include <string.h>
+#include <aalsdk/AALTypes.h>
+
+BEGIN_NAMESPACE(AAL)
+
+/// @addtogroup ALI
+/// @{
+
+// Bitstream File extension
+#define BITSTREAM_FILE_EXTENSION ".gbs"
+
+// FIXME: Placeholder for proper metadata handling (Alpha+)
+#define GBS_HEADER_MAGIC 0x1d1f8680
+#define GBS_HEADER_LEN   20
+
+/// Result of GBSParseHeader().
+typedef enum
+{
+   gbsHeaderOK = 0,     ///< Header valid; the payload follows it.
+   gbsHeaderNullBuffer, ///< No buffer was given.
+   gbsHeaderTooShort,   ///< The buffer holds no payload after the header.
+   gbsHeaderBadMagic    ///< The magic sequence does not match.
+} EGBSHeaderStatus;
+
+/// Location of the payload within a validated bitstream image.
+struct GBSHeaderInfo
+{
+   btUnsigned32bitInt magic;
+   btWSSize           payloadOffset;
+   btWSSize           payloadLen;
+};
+
+//=============================================================================
+// Name: GBSParseHeader
+// Description: Validate the header of the bitstream image at pBuf.
+// Interface: public
+// Inputs: pBuf - image start, any alignment.
+//         len  - image length in bytes.
+// Outputs: rInfo - payload offset and length. Untouched on failure.
+// Comments: Only the first GBS_HEADER_LEN bytes are examined.
+//=============================================================================
+inline EGBSHeaderStatus GBSParseHeader(const btByte *pBuf, btWSSize len, GBSHeaderInfo &rInfo)
+{
+   if ( NULL == pBuf ) {
+      return gbsHeaderNullBuffer;
+   }
+
+   btUnsigned32bitInt magic = 0;
+
+   if ( len < sizeof(magic) ) {
+      return gbsHeaderTooShort;
+   }
+
+   // The image may be mapped at any offset; don't assume alignment.
+   memcpy(&magic, pBuf, sizeof(magic));
+   if ( GBS_HEADER_MAGIC != magic ) {
+      return gbsHeaderBadMagic;
+   }
+
+   if ( len <= GBS_HEADER_LEN ) {
+      return gbsHeaderTooShort;
+   }
+
+   rInfo.magic         = magic;
+   rInfo.payloadOffset = GBS_HEADER_LEN;
+   rInfo.payloadLen    = len - GBS_HEADER_LEN;
+
+   return gbsHeaderOK;
+}
+
+inline btcString GBSHeaderStatusStr(EGBSHeaderStatus s)
+{
+   switch ( s ) {
+      case gbsHeaderOK         : return "OK";
+      case gbsHeaderNullBuffer : return "no buffer";
+      case gbsHeaderTooShort   : return "truncated";
+      case gbsHeaderBadMagic   : return "bad magic";
+   }
+   return "unknown";
+}
+
+/// @}
+
+END_NAMESPACE(AAL)
+
+#endif // __GBSHEADER_H__
@@ -49,6 +49,7 @@
 
 #include "ALIAIATransactions.h"
 #include "aalsdk/aas/Dispatchables.h"
+#include "aalsdk/AALTransactionTrace.h"
 #include "HWALIAFU.h"
 
 
@@ -84,11 +85,27 @@ AAL::ali_errnum_e CHWALIAFU::bufferAllocate( btWSSize             Length,
                                                     NamedValueSet const &rInputArgs,
                                                     NamedValueSet       &rOutputArgs )
 {
+   // Buffer calls carry no TransactionID; trace under one of their own.
+   TransactionTraceScope trace(txtraceALIBufferAllocate,
+                               txtraceALIBufferAllocated,
+                               TransactionTrace::IsEnabled() ? TransactionID::NextUniqueID() : 0);
+
    AutoLock(this);
    *pBufferptr = NULL;
 
+   // Optional NUMA placement, passed to the driver as node + 1.
+   btUnsigned32bitInt numa = 0;
+   if ( rInputArgs.Has(ALI_BUFALLOCATE_NUMA_NODE_KEY) ) {
+      ALI_BUFALLOCATE_NUMA_NODE_DATATYPE node = 0;
+      if ( ENamedValuesOK != rInputArgs.Get(ALI_BUFALLOCATE_NUMA_NODE_KEY, &node) ) {
+         AAL_ERR( LM_ALI, "bad " ALI_BUFALLOCATE_NUMA_NODE_KEY " argument" << std::endl);
+         return ali_errnumBadParameter;
+      }
+      numa = node + 1;
+   }
+
    // Create the Transaction
-   BufferAllocateTransaction transaction(Length);
+   BufferAllocateTransaction transaction(Length, numa);
 
    // Check the parameters
    if ( transaction.IsOK() ) {
@@ -420,6 +420,18 @@ btBool CHWALIBase::_discoverFeatures() {
    retVal = mmioRead64(offset + 16, &feat.guid[1]);
    ASSERT( retVal );
 
+   // Same AFU seen before in this process? Skip the walk.
+   FeatureCacheKey key;
+   key.dfh     = *reinterpret_cast<btUnsigned64bitInt *>(&feat.dfh);
+   key.guid[0] = feat.guid[0];
+   key.guid[1] = feat.guid[1];
+   key.size    = m_MMIORsize;
+
+   if ( sm_FeatureCache.Get(key, m_featureList) ) {
+      AAL_DEBUG(LM_AFU, "Using cached feature list (" << m_featureList.size() << " features)" << std::endl);
+      return true;
+   }
+
    // Add AFU feature to list
    m_featureList.push_back(feat);
    offset = feat.dfh.next_DFH_offset;
@@ -450,9 +462,52 @@ btBool CHWALIBase::_discoverFeatures() {
       offset += feat.dfh.next_DFH_offset;
    }
 
+   sm_FeatureCache.Put(key, m_featureList);
+
    return true;
 }
 
+CHWALIBase::FeatureCache CHWALIBase::sm_FeatureCache;
+
+//
+// FlushFeatureCache, Discard all cached feature lists.
+//
+void CHWALIBase::FlushFeatureCache()
+{
+   sm_FeatureCache.Flush();
+}
+
+bool CHWALIBase::FeatureCacheKey::operator < (const FeatureCacheKey &rhs) const
+{
+   if ( dfh     != rhs.dfh     ) { return dfh     < rhs.dfh;     }
+   if ( guid[0] != rhs.guid[0] ) { return guid[0] < rhs.guid[0]; }
+   if ( guid[1] != rhs.guid[1] ) { return guid[1] < rhs.guid[1]; }
+   return size < rhs.size;
+}
+
+btBool CHWALIBase::FeatureCache::Get(const FeatureCacheKey &key, FeatureList &list)
+{
+   AutoLock(this);
+   std::map<FeatureCacheKey, FeatureList>::const_iterator itr = m_Lists.find(key);
+   if ( m_Lists.end() == itr ) {
+      return false;
+   }
+   list = itr->second;
+   return true;
+}
+
+void CHWALIBase::FeatureCache::Put(const FeatureCacheKey &key, const FeatureList &list)
+{
+   AutoLock(this);
+   m_Lists[key] = list;
+}
+
+void CHWALIBase::FeatureCache::Flush()
+{
+   AutoLock(this);
+   m_Lists.clear();
+}
+
 //
 // _validateDFL,Validate CCIP device features.
 //
@@ -99,6 +99,10 @@ public :
    // AFU Event Handler
    virtual void AFUEvent(AAL::IEvent const &theEvent);
 
+   // Discard every cached device feature list, eg after the FPGA has been
+   //  reconfigured.
+   static void FlushFeatureCache();
+
 protected:
 
    IAFUProxy              *m_pAFUProxy;
@@ -119,6 +123,28 @@ protected:
    FeatureList m_featureList;
 
 private:
+   // Feature lists are walked once per AFU identity (AFU DFH, AFU ID and MMIO
+   //  size) per process. Later allocations of the same AFU copy the list.
+   struct FeatureCacheKey {
+      btUnsigned64bitInt dfh;
+      btUnsigned64bitInt guid[2];
+      btUnsigned32bitInt size;
+
+      bool operator < (const FeatureCacheKey &rhs) const;
+   };
+
+   class FeatureCache : public CriticalSection
+   {
+   public:
+      btBool Get(const FeatureCacheKey &key, FeatureList &list);
+      void   Put(const FeatureCacheKey &key, const FeatureList &list);
+      void Flush();
+   private:
+      std::map<FeatureCacheKey, FeatureList> m_Lists;
+   };
+
+   static FeatureCache sm_FeatureCache;
+
    // Populate Device Feature Header
    btBool _discoverFeatures();
    btBool _validateDFL();
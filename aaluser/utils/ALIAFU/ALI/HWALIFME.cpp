@@ -49,6 +49,8 @@
 
 #include "ALIAIATransactions.h"
 #include "HWALIFME.h"
+#include <aalsdk/osal/Timer.h>
+#include <aalsdk/uaia/AIATransactionQueue.h>
 
 #define FME_FIRST_ERR_STR "First "
 #define FME_NEXT_ERR_STR  "Next "
@@ -64,9 +66,36 @@ BEGIN_NAMESPACE(AAL)
 CHWALIFME::CHWALIFME( IBase *pSvcClient,
                       IServiceBase *pServiceBase,
                       TransactionID transID,
-                      IAFUProxy *pAFUProxy): CHWALIBase(pSvcClient,pServiceBase,transID,pAFUProxy)
+                      IAFUProxy *pAFUProxy): CHWALIBase(pSvcClient,pServiceBase,transID,pAFUProxy),
+#if defined( __AAL_LINUX__ )
+                      m_pPerfSnap(NULL),
+                      m_PerfSnapSize(0),
+                      m_bPerfSnapTried(false),
+#endif // __AAL_LINUX__
+                      m_pPerfSampler(NULL),
+                      m_PerfSamplePeriod(0),
+                      m_pTelemetryCollector(NULL),
+                      m_TelemetryPeriod(0)
 {
+   m_PerfSamplerStop.Create(0, 1);
+   m_TelemetryStop.Create(0, 1);
+}
+
+//
+// dtor. The sampler and collector issue transactions through the AFU
+//  proxy, so they must be stopped before the proxy is released.
+//
+CHWALIFME::~CHWALIFME()
+{
+   telemetryStop();
+   performanceSamplerStop();
 
+#if defined( __AAL_LINUX__ )
+   if ( NULL != m_pPerfSnap ) {
+      m_pAFUProxy->UnMapWSID(reinterpret_cast<btVirtAddr>(m_pPerfSnap), m_PerfSnapSize);
+      m_pPerfSnap = NULL;
+   }
+#endif // __AAL_LINUX__
 }
 
 //
@@ -131,6 +160,241 @@ btBool CHWALIFME::performanceCountersGet ( INamedValueSet*  const  pResult,
 }
 
 
+//
+// PerfSampleFrom. Copies the counter values of a performance counter reply
+//  into rSample.
+//
+static void PerfSampleFrom( struct CCIP_PERF_COUNTERS const *pPref, ALIPerfSample &rSample )
+{
+   rSample.version                            = pPref->version.value;
+   rSample.counters[aliPerfReadHit]           = pPref->read_hit.value;
+   rSample.counters[aliPerfWriteHit]          = pPref->write_hit.value;
+   rSample.counters[aliPerfReadMiss]          = pPref->read_miss.value;
+   rSample.counters[aliPerfWriteMiss]         = pPref->write_miss.value;
+   rSample.counters[aliPerfEvictions]         = pPref->evictions.value;
+   rSample.counters[aliPerfPCIe0Read]         = pPref->pcie0_read.value;
+   rSample.counters[aliPerfPCIe0Write]        = pPref->pcie0_write.value;
+   rSample.counters[aliPerfPCIe1Read]         = pPref->pcie1_read.value;
+   rSample.counters[aliPerfPCIe1Write]        = pPref->pcie1_write.value;
+   rSample.counters[aliPerfUPIRead]           = pPref->upi_read.value;
+   rSample.counters[aliPerfUPIWrite]          = pPref->upi_write.value;
+   rSample.counters[aliPerfVTdMemReadTrans]   = pPref->AFU0_MemRead_Trans.value;
+   rSample.counters[aliPerfVTdMemWriteTrans]  = pPref->AFU0_MemWrite_Trans.value;
+   rSample.counters[aliPerfVTdDevTLBReadHit]  = pPref->AFU0_DevTLBRead_Hit.value;
+   rSample.counters[aliPerfVTdDevTLBWriteHit] = pPref->AFU0_DevTLBWrite_Hit.value;
+}
+
+#if defined( __AAL_LINUX__ )
+//
+// mapPerfSnap. Maps the driver's performance counter snapshot page, once.
+//  Drivers without the snapshot cache refuse the WSID, leaving reads on the
+//  ioctl path.
+//
+void CHWALIFME::mapPerfSnap()
+{
+   AutoLock(this);
+
+   if ( m_bPerfSnapTried ) {
+      return;
+   }
+   m_bPerfSnapTried = true;
+
+   GetMMIOBufferTransaction transaction(WSID_MAP_PERFSNAP);
+   if ( !transaction.IsOK() ) {
+      return;
+   }
+
+   m_pAFUProxy->SendTransaction(&transaction);
+   if ( uid_errnumOK != transaction.getErrno() ) {
+      return;
+   }
+
+   struct AAL::aalui_WSMEvent wsevt = transaction.getWSIDEvent();
+   NamedValueSet              nvs;
+   btVirtAddr                 ptr = NULL;
+
+   nvs.Add(ALI_MMAP_READONLY_KEY, (ALI_MMAP_READONLY_DATATYPE)true);
+   if ( !m_pAFUProxy->MapWSID(wsevt.wsParms.size, wsevt.wsParms.wsid, &ptr, nvs) ) {
+      AAL_WARNING( LM_ALI, "Could not map performance counter snapshots" << std::endl);
+      return;
+   }
+
+   struct ccipui_perfsnap *psnap = reinterpret_cast<struct ccipui_perfsnap *>(ptr);
+   if ( ( CCIPUI_PERFSNAP_MAGIC != psnap->magic ) || ( CCIPUI_PERFSNAP_VALUES != psnap->nvalues ) ) {
+      AAL_WARNING( LM_ALI, "Unrecognized performance counter snapshot page" << std::endl);
+      m_pAFUProxy->UnMapWSID(ptr, wsevt.wsParms.size);
+      return;
+   }
+
+   m_PerfSnapSize = wsevt.wsParms.size;
+   m_pPerfSnap    = psnap;
+}
+
+//
+// readPerfSnap. Reads the latest snapshot from the mapped page, without
+//  entering the driver. The sample is timestamped when the driver read the
+//  counters, not now.
+//
+btBool CHWALIFME::readPerfSnap( ALIPerfSample &rSample )
+{
+   if ( !m_bPerfSnapTried ) {
+      mapPerfSnap();
+   }
+
+   struct ccipui_perfsnap *psnap = m_pPerfSnap;
+   if ( NULL == psnap ) {
+      return false;
+   }
+
+   struct ccipui_perfsnap_buf snap;
+   if ( 0 == ccipui_perfsnap_read(psnap, &snap) ) {
+      return false;   // None yet: the driver's worker starts on first map.
+   }
+
+   // snap.tstamp is CLOCK_MONOTONIC; carry its age over to the Timer clock
+   //  so samples from either path compare.
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   btUnsigned64bitInt mono = (btUnsigned64bitInt)ts.tv_sec * 1000000000ULL + (btUnsigned64bitInt)ts.tv_nsec;
+   btUnsigned64bitInt age  = ( mono > snap.tstamp ) ? mono - snap.tstamp : 0;
+
+   Timer().Now().AsNanoSeconds(rSample.timestamp);
+   rSample.timestamp -= age;
+
+   // Values are in struct CCIP_PERF_COUNTERS order.
+   struct CCIP_PERF_COUNTERS perf;
+   struct PERFCOUNTER_EVENT *pevt = reinterpret_cast<struct PERFCOUNTER_EVENT *>(&perf);
+   for ( btUnsignedInt i = 0 ; i < CCIPUI_PERFSNAP_VALUES ; ++i ) {
+      pevt[i].value = snap.values[i];
+   }
+   PerfSampleFrom(&perf, rSample);
+
+   return true;
+}
+#endif // __AAL_LINUX__
+
+//
+// performanceCountersRead. Returns the Performance Counter Values in rSample,
+//  without the names. Reads the driver's snapshot page when it is mapped.
+//
+btBool CHWALIFME::performanceCountersRead( ALIPerfSample &rSample )
+{
+#if defined( __AAL_LINUX__ )
+   if ( readPerfSnap(rSample) ) {
+      return true;
+   }
+#endif // __AAL_LINUX__
+
+   PerfCounterGet transaction(sizeof(struct  CCIP_PERF_COUNTERS));
+
+   if ( !transaction.IsOK() ) {
+      return false;
+   }
+
+   m_pAFUProxy->SendTransaction(&transaction);
+
+   if ( ( transaction.getErrno() != uid_errnumOK ) || ( NULL == transaction.getBuffer() ) ) {
+      AAL_ERR( LM_ALI, "Performance counter error = " << transaction.getErrno()<< std::endl);
+      return false;
+   }
+
+   Timer().Now().AsNanoSeconds(rSample.timestamp);
+
+   PerfSampleFrom((struct  CCIP_PERF_COUNTERS *)transaction.getBuffer(), rSample);
+
+   return true;
+}
+
+//
+// performanceSamplerStart. Starts the background sampler thread.
+//
+btBool CHWALIFME::performanceSamplerStart( btTime PeriodMillis )
+{
+   AutoLock(this);
+
+   if ( ( NULL != m_pPerfSampler ) || ( 0 == PeriodMillis ) ) {
+      return false;
+   }
+
+   m_PerfSamplePeriod = PeriodMillis;
+   m_PerfSamplerStop.Reset(0);
+
+   m_pPerfSampler = new(std::nothrow) OSLThread(CHWALIFME::PerfSamplerThread,
+                                                OSLThread::THREADPRIORITY_NORMAL,
+                                                this);
+   if ( ( NULL != m_pPerfSampler ) && !m_pPerfSampler->IsOK() ) {
+      delete m_pPerfSampler;
+      m_pPerfSampler = NULL;
+   }
+
+   return NULL != m_pPerfSampler;
+}
+
+//
+// performanceSamplerStop. Stops the background sampler thread, if running.
+//
+void CHWALIFME::performanceSamplerStop()
+{
+   OSLThread *pThread;
+
+   {
+      AutoLock(this);
+      pThread        = m_pPerfSampler;
+      m_pPerfSampler = NULL;
+   }
+
+   if ( NULL == pThread ) {
+      return;
+   }
+
+   m_PerfSamplerStop.Post(1);
+   pThread->Join();
+   delete pThread;
+}
+
+btBool CHWALIFME::performanceSamplerLatest( ALIPerfSample &rSample )
+{
+   return m_PerfRing.Latest(rSample);
+}
+
+btBool CHWALIFME::performanceSamplerRates( ALIPerfRates &rRates )
+{
+   ALIPerfSample s[2];
+
+   if ( 2 != m_PerfRing.History(s, 2) ) {
+      return false;
+   }
+
+   return ALIPerfComputeRates(s[1], s[0], rRates);
+}
+
+btUnsigned32bitInt CHWALIFME::performanceSamplerHistory( ALIPerfSample     *pSamples,
+                                                         btUnsigned32bitInt Max )
+{
+   if ( NULL == pSamples ) {
+      return 0;
+   }
+   return m_PerfRing.History(pSamples, Max);
+}
+
+//
+// PerfSamplerThread. Reads the counters every m_PerfSamplePeriod ms into the
+//  ring until m_PerfSamplerStop is posted.
+//
+void CHWALIFME::PerfSamplerThread(OSLThread * , void *pContext)
+{
+   CHWALIFME    *pThis = reinterpret_cast<CHWALIFME *>(pContext);
+   ALIPerfSample sample;
+
+   do
+   {
+      if ( pThis->performanceCountersRead(sample) ) {
+         pThis->m_PerfRing.Publish(sample);
+      }
+   } while ( !pThis->m_PerfSamplerStop.Wait(pThis->m_PerfSamplePeriod) );
+}
+
+
 //
 // errorGet. Returns the FME Errors
 //
@@ -1310,6 +1574,193 @@ btBool CHWALIFME::powerGetValues(INamedValueSet &rResult )
    return true;
 }
 
+//
+// ReplyBuffer. The response payload of a sent transaction, or NULL if it
+//  could not be created or failed.
+//
+template <typename T>
+static btVirtAddr ReplyBuffer( T &rTransaction )
+{
+   if ( !rTransaction.IsOK() || ( rTransaction.getErrno() != uid_errnumOK ) ) {
+      return NULL;
+   }
+   return rTransaction.getBuffer();
+}
+
+//
+// telemetryCollect. Reads thermal, power, FME error and performance state
+//  into one snapshot. The reads are independent, so they are queued as one
+//  batch and the driver sees them together.
+//
+btBool CHWALIFME::telemetryCollect( ALITelemetrySnapshot &rSnapshot )
+{
+   struct CCIP_TEMP_THRESHOLD      temp_threshold     = {0};
+   struct CCIP_TEMP_RDSSENSOR_FMT1 temp_rdssensor_fm1 = {0};
+   struct CCIP_PM_STATUS           pm_status          = {0};
+   btUnsigned64bitInt              start              = 0;
+
+   ThermalPwrGet       thermal(sizeof(struct CCIP_THERMAL_PWR), ccipdrv_gertThermal);
+   ThermalPwrGet       power(sizeof(struct CCIP_THERMAL_PWR), ccipdrv_getPower);
+   ErrorGet            errors(sizeof(struct CCIP_ERROR), ccipdrv_getFMEError);
+   PerfCounterGet      perf(sizeof(struct CCIP_PERF_COUNTERS));
+   AIATransactionBatch batch;
+
+   memset(&rSnapshot, 0, sizeof(rSnapshot));
+
+   Timer().Now().AsNanoSeconds(start);
+
+   if ( thermal.IsOK() ) {
+      batch.Add(&thermal);
+   }
+   if ( power.IsOK() ) {
+      batch.Add(&power);
+   }
+   if ( errors.IsOK() ) {
+      batch.Add(&errors);
+   }
+   if ( perf.IsOK() ) {
+      batch.Add(&perf);
+   }
+
+   if ( !m_pAFUProxy->SendTransactions(batch) ) {
+      return false;
+   }
+   batch.Wait();
+
+   struct CCIP_THERMAL_PWR *pThermal = (struct CCIP_THERMAL_PWR *)ReplyBuffer(thermal);
+   if ( NULL != pThermal ) {
+      temp_threshold.csr     = pThermal->tmp_threshold;
+      temp_rdssensor_fm1.csr = pThermal->tmp_rdsensor1;
+
+      if ( 0x1 == temp_rdssensor_fm1.tmp_reading_valid ) {
+         rSnapshot.temperature       = temp_rdssensor_fm1.tmp_reading;
+         rSnapshot.temperatureSeqNum = temp_rdssensor_fm1.tmp_reading_seq_num;
+      }
+      if ( 0x1 == temp_threshold.thshold1_status ) {
+         rSnapshot.threshold1 = temp_threshold.tmp_thshold1;
+      }
+      if ( 0x1 == temp_threshold.thshold2_status ) {
+         rSnapshot.threshold2 = temp_threshold.tmp_thshold2;
+      }
+      rSnapshot.thermTrip = temp_threshold.therm_trip_thshold;
+      rSnapshot.valid    |= ALITELEMETRY_THERMAL;
+   }
+
+   struct CCIP_THERMAL_PWR *pPower = (struct CCIP_THERMAL_PWR *)ReplyBuffer(power);
+   if ( NULL != pPower ) {
+      pm_status.csr           = pPower->pwr_status;
+      rSnapshot.powerConsumed = pm_status.pwr_consumed;
+      rSnapshot.valid        |= ALITELEMETRY_POWER;
+   }
+
+   struct CCIP_ERROR *pError = (struct CCIP_ERROR *)ReplyBuffer(errors);
+   if ( NULL != pError ) {
+      rSnapshot.fmeError0     = pError->error0;
+      rSnapshot.pcie0Error    = pError->pcie0_error;
+      rSnapshot.pcie1Error    = pError->pcie1_error;
+      rSnapshot.firstError    = pError->first_error;
+      rSnapshot.nextError     = pError->next_error;
+      rSnapshot.rasGreenError = pError->ras_gerr;
+      rSnapshot.rasBlueError  = pError->ras_berror;
+      rSnapshot.rasWarnError  = pError->ras_warnerror;
+      rSnapshot.valid        |= ALITELEMETRY_FMEERROR;
+   }
+
+   struct CCIP_PERF_COUNTERS *pPref = (struct CCIP_PERF_COUNTERS *)ReplyBuffer(perf);
+   if ( NULL != pPref ) {
+      Timer().Now().AsNanoSeconds(rSnapshot.perf.timestamp);
+      PerfSampleFrom(pPref, rSnapshot.perf);
+      rSnapshot.valid |= ALITELEMETRY_PERF;
+   }
+
+   Timer().Now().AsNanoSeconds(rSnapshot.timestamp);
+   rSnapshot.collectTime = rSnapshot.timestamp - start;
+
+   return 0 != rSnapshot.valid;
+}
+
+//
+// telemetryStart. Starts the collector thread, publishing to ShmName if given.
+//
+btBool CHWALIFME::telemetryStart( btTime PeriodMillis, btcString ShmName )
+{
+   AutoLock(this);
+
+   if ( ( NULL != m_pTelemetryCollector ) || ( 0 == PeriodMillis ) ) {
+      return false;
+   }
+
+   if ( ( NULL != ShmName ) && !m_TelemetryShm.Create(ShmName, PeriodMillis) ) {
+      AAL_ERR( LM_ALI, "Could not create telemetry shared memory " << ShmName << std::endl);
+      return false;
+   }
+
+   m_TelemetryPeriod = PeriodMillis;
+   m_TelemetryStop.Reset(0);
+
+   m_pTelemetryCollector = new(std::nothrow) OSLThread(CHWALIFME::TelemetryThread,
+                                                       OSLThread::THREADPRIORITY_NORMAL,
+                                                       this);
+   if ( ( NULL != m_pTelemetryCollector ) && !m_pTelemetryCollector->IsOK() ) {
+      delete m_pTelemetryCollector;
+      m_pTelemetryCollector = NULL;
+   }
+
+   if ( NULL == m_pTelemetryCollector ) {
+      m_TelemetryShm.Destroy();
+      return false;
+   }
+
+   return true;
+}
+
+//
+// telemetryStop. Stops the collector thread, if running.
+//
+void CHWALIFME::telemetryStop()
+{
+   OSLThread *pThread;
+
+   {
+      AutoLock(this);
+      pThread               = m_pTelemetryCollector;
+      m_pTelemetryCollector = NULL;
+   }
+
+   if ( NULL == pThread ) {
+      return;
+   }
+
+   m_TelemetryStop.Post(1);
+   pThread->Join();
+   delete pThread;
+
+   m_TelemetryShm.Destroy();
+}
+
+btBool CHWALIFME::telemetryLatest( ALITelemetrySnapshot &rSnapshot )
+{
+   return m_TelemetryRing.Latest(rSnapshot);
+}
+
+//
+// TelemetryThread. Collects a snapshot every m_TelemetryPeriod ms until
+//  m_TelemetryStop is posted.
+//
+void CHWALIFME::TelemetryThread(OSLThread * , void *pContext)
+{
+   CHWALIFME           *pThis = reinterpret_cast<CHWALIFME *>(pContext);
+   ALITelemetrySnapshot snapshot;
+
+   do
+   {
+      if ( pThis->telemetryCollect(snapshot) ) {
+         pThis->m_TelemetryRing.Publish(snapshot);
+         pThis->m_TelemetryShm.Publish(snapshot);
+      }
+   } while ( !pThis->m_TelemetryStop.Wait(pThis->m_TelemetryPeriod) );
+}
+
 //
 // AFUEvent,AFU Event Handler.
 //
@@ -43,6 +43,8 @@
 #ifndef __HWALIFME_H__
 #define __HWALIFME_H__
 
+#include <aalsdk/utils/SeqlockRing.h>
+#include <aalsdk/utils/ALITelemetryShm.h>
 #include "HWALIBase.h"
 
 BEGIN_NAMESPACE(AAL)
@@ -56,9 +58,11 @@ BEGIN_NAMESPACE(AAL)
 
 class  CHWALIFME : public CHWALIBase,
                    public IALIPerf,
+                   public IALIPerfSampler,
                    public IALIFMEError,
                    public IALITemperature,
-                   public IALIPower
+                   public IALIPower,
+                   public IALITelemetry
 {
 public :
 
@@ -67,7 +71,7 @@ public :
               TransactionID transID,
               IAFUProxy *pAFUProxy);
 
-   ~CHWALIFME()  { };
+   ~CHWALIFME();
 
    //<IALIPerf>
    virtual btBool performanceCountersGet ( INamedValueSet * const  pResult ) { return performanceCountersGet(pResult, NamedValueSet()); }
@@ -75,6 +79,16 @@ public :
                                            NamedValueSet    const &pOptArgs );
    //</IALIPerf>
 
+   //<IALIPerfSampler>
+   virtual btBool performanceCountersRead( ALIPerfSample &rSample );
+   virtual btBool performanceSamplerStart( btTime PeriodMillis );
+   virtual void   performanceSamplerStop();
+   virtual btBool performanceSamplerLatest( ALIPerfSample &rSample );
+   virtual btBool performanceSamplerRates( ALIPerfRates &rRates );
+   virtual btUnsigned32bitInt performanceSamplerHistory( ALIPerfSample     *pSamples,
+                                                         btUnsigned32bitInt Max );
+   //</IALIPerfSampler>
+
    // <IALIError>
    virtual btBool errorGet( INamedValueSet &rResult );
 
@@ -101,6 +115,13 @@ public :
    virtual btBool powerGetValues(INamedValueSet &rResult );
    // </IALIPower>
 
+   // <IALITelemetry>
+   virtual btBool telemetryCollect( ALITelemetrySnapshot &rSnapshot );
+   virtual btBool telemetryStart( btTime PeriodMillis, btcString ShmName );
+   virtual void   telemetryStop();
+   virtual btBool telemetryLatest( ALITelemetrySnapshot &rSnapshot );
+   // </IALITelemetry>
+
    // AFU Event Handler
    virtual void AFUEvent(AAL::IEvent const &theEvent);
 
@@ -112,6 +133,34 @@ public :
 
    void readOrderError( struct CCIP_ERROR *pError, INamedValueSet &rResult);
 
+protected:
+#if defined( __AAL_LINUX__ )
+   void   mapPerfSnap();
+   btBool readPerfSnap( ALIPerfSample &rSample );
+
+   // The driver's performance counter snapshot page, mapped on first read.
+   struct ccipui_perfsnap * volatile m_pPerfSnap;
+   btWSSize                          m_PerfSnapSize;
+   volatile btBool                   m_bPerfSnapTried;
+#endif // __AAL_LINUX__
+
+   static void PerfSamplerThread(OSLThread *pThread, void *pContext);
+   static void TelemetryThread(OSLThread *pThread, void *pContext);
+
+   typedef SeqlockRing<ALIPerfSample, ALIPERF_SAMPLER_DEPTH> PerfRing;
+
+   OSLThread *m_pPerfSampler;
+   CSemaphore m_PerfSamplerStop;
+   btTime     m_PerfSamplePeriod;
+   PerfRing   m_PerfRing;
+
+   typedef SeqlockRing<ALITelemetrySnapshot, ALITELEMETRY_SHM_DEPTH> TelemetryRing;
+
+   OSLThread         *m_pTelemetryCollector;
+   CSemaphore         m_TelemetryStop;
+   btTime             m_TelemetryPeriod;
+   TelemetryRing      m_TelemetryRing;
+   ALITelemetryWriter m_TelemetryShm;
 };
 
 /// @}
@@ -51,20 +51,15 @@
 #include <aalsdk/utils/ResMgrUtilities.h>
 #include "ALIAIATransactions.h"
 #include "aalsdk/aas/Dispatchables.h"
+#include "aalsdk/AALTransactionTrace.h"
 #include "HWALIReconf.h"
+#include "BitstreamCache.h"
 
 BEGIN_NAMESPACE(AAL)
 
 /// @addtogroup ALI
 /// @{
 
-// Bitstream File extension
-#define BITSTREAM_FILE_EXTENSION ".gbs"
-
-// FIXME: Placeholder for proper metadata handling (Alpha+)
-#define GBS_HEADER_MAGIC 0x1d1f8680
-#define GBS_HEADER_LEN   20
-
 //
 // ctor. CHWALIFME class constructor
 //
@@ -162,8 +157,9 @@ void CHWALIReconf::reconfDeactivate( TransactionID const &rTranID,
 void CHWALIReconf::reconfConfigure( TransactionID const &rTranID,
                                 NamedValueSet const &rInputArgs)
 {
-   btByte *bufptr                = NULL;
-   std::streampos filesize       = 0;
+   CBitstream *pBitstream = NULL;
+
+   AAL_TRACE_TRANSACTION(txtraceALIReconfigure, rTranID.ID());
 
    if(rInputArgs.Has(AALCONF_FILENAMEKEY)){
       btcString filename;
@@ -171,7 +167,8 @@ void CHWALIReconf::reconfConfigure( TransactionID const &rTranID,
 
       // File extension is not .gbs , Dispatch error Message "Wrong bitstream file extension"
       std::string bitfilename(filename);
-      if(BITSTREAM_FILE_EXTENSION != (bitfilename.substr(bitfilename.find_last_of("."))))  {
+      std::string::size_type dot = bitfilename.find_last_of(".");
+      if((std::string::npos == dot) || (BITSTREAM_FILE_EXTENSION != bitfilename.substr(dot)))  {
          // file extension invalid
          AAL_ERR( LM_ALI, "Wrong bitstream file extension "<< std::endl);
          getRuntime()->schedDispatchable(new AFUReconfigureFailed( m_pReconClient,new CExceptionTransactionEvent( NULL,
@@ -183,52 +180,53 @@ void CHWALIReconf::reconfConfigure( TransactionID const &rTranID,
          return ;
       }
 
-      std::ifstream bitfile(filename, std::ios::binary );
-
-      if(!bitfile.good()) {
-         // file is invalid, Dispatch error Message "Wrong bitstream file path"
-         AAL_ERR( LM_ALI, "Wrong bitstream file path " << std::endl);
-         getRuntime()->schedDispatchable(new AFUReconfigureFailed( m_pReconClient,new CExceptionTransactionEvent( NULL,
-                                                                                                                  rTranID,
-                                                                                                                  errFileError,
-                                                                                                                  reasParameterNameInvalid,
-                                                                                                                  "Error: Wrong bitstream file path.")));
-
-         return ;
-      }
-
-      bitfile.seekg( 0, std::ios::end );
-      filesize = bitfile.tellg();
-
-      if(0 == filesize) {
-         // file size is 0, Dispatch error Message "Zero bitstream file size"
-         AAL_ERR( LM_ALI, "Zero bitstream file size "<< std::endl);
-         getRuntime()->schedDispatchable(new AFUReconfigureFailed( m_pReconClient,new CExceptionTransactionEvent( NULL,
-                                                                                                                  rTranID,
-                                                                                                                  errFileError,
-                                                                                                                  reasParameterValueInvalid,
-                                                                                                                  "Error: Zero bitstream file size.")));
-
-         return ;
+      // The image is mapped, not copied, and its header is validated only
+      //  the first time this version of the file is seen.
+      switch(CBitstreamCache::Acquire(filename, &pBitstream)){
+         case bitstreamOK :
+            break;
+
+         case bitstreamEmpty :
+            // file size is 0, Dispatch error Message "Zero bitstream file size"
+            AAL_ERR( LM_ALI, "Zero bitstream file size "<< std::endl);
+            getRuntime()->schedDispatchable(new AFUReconfigureFailed( m_pReconClient,new CExceptionTransactionEvent( NULL,
+                                                                                                                     rTranID,
+                                                                                                                     errFileError,
+                                                                                                                     reasParameterValueInvalid,
+                                                                                                                     "Error: Zero bitstream file size.")));
+            return ;
+
+         case bitstreamNoMemory :
+            // Memory  allocation failed  error Message "Failed to allocate file buffer"
+            AAL_ERR( LM_ALI, "Failed to allocate bitstream file buffer "<< std::endl);
+            getRuntime()->schedDispatchable(new AFUReconfigureFailed( m_pReconClient,new CExceptionTransactionEvent( NULL,
+                                                                                                                     rTranID,
+                                                                                                                     errAllocationFailure,
+                                                                                                                     reasUnknown,
+                                                                                                                     "Error: Failed to allocate file buffer.")));
+            return ;
+
+         case bitstreamBadHeader :
+            AAL_ERR( LM_ALI, "Invalid green bitstream header" << std::endl);
+            getRuntime()->schedDispatchable(new AFUReconfigureFailed( m_pReconClient,new CExceptionTransactionEvent( NULL,
+                                                                                                                     rTranID,
+                                                                                                                     errFileError,
+                                                                                                                     reasUnknown,
+                                                                                                                     "Error: Invalid green bitstream header.")));
+            return ;
+
+         case bitstreamFileError :
+         default :
+            // file is invalid, Dispatch error Message "Wrong bitstream file path"
+            AAL_ERR( LM_ALI, "Wrong bitstream file path " << std::endl);
+            getRuntime()->schedDispatchable(new AFUReconfigureFailed( m_pReconClient,new CExceptionTransactionEvent( NULL,
+                                                                                                                     rTranID,
+                                                                                                                     errFileError,
+                                                                                                                     reasParameterNameInvalid,
+                                                                                                                     "Error: Wrong bitstream file path.")));
+            return ;
       }
 
-
-      bitfile.seekg( 0, std::ios::beg );
-      bufptr = new(std::nothrow) btByte[filesize];
-
-      if(NULL == bufptr) {
-         // Memory  allocation failed  error Message "Failed to allocate file buffer"
-         AAL_ERR( LM_ALI, "Failed to allocate bitstream file buffer "<< std::endl);
-         getRuntime()->schedDispatchable(new AFUReconfigureFailed( m_pReconClient,new CExceptionTransactionEvent( NULL,
-                                                                                                                  rTranID,
-                                                                                                                  errAllocationFailure,
-                                                                                                                  reasUnknown,
-                                                                                                                  "Error: Failed to allocate file buffer.")));
-         return ;
-      }
-
-      bitfile.read(reinterpret_cast<char *>(bufptr), filesize);
-
    }else{
       AAL_ERR( LM_ALI,"No bitstream file source"<< std::endl);
       getRuntime()->schedDispatchable(new AFUReconfigureFailed( m_pReconClient,new CExceptionTransactionEvent( NULL,
@@ -237,40 +235,18 @@ void CHWALIReconf::reconfConfigure( TransactionID const &rTranID,
                                                                                                                reasMissingParameter,
                                                                                                                "Error: No bitstream file source.")));
       return;
-
-#if 0 // Test code
-      bufptr = reinterpret_cast<btByte*>(malloc(100));
-      *bufptr = '<';
-      memset(bufptr+1,'*',97);
-      *(bufptr+98) = '>';
-      *(bufptr+99) = 0;
-      filesize = 100;
-#endif
    }
 
-   //
-   // FIXME: Placeholder for proper metadata handling (Alpha+)
-   //
-   btByte *bufptr_skip = bufptr;
-   btWSSize filesize_skip = filesize;
-   if (*((btUnsigned32bitInt *)bufptr) == GBS_HEADER_MAGIC) {    // Alpha+ magic sequence
-      ASSERT( filesize > GBS_HEADER_LEN );
-      bufptr_skip = bufptr + GBS_HEADER_LEN;
-      filesize_skip = ((btWSSize)filesize) - GBS_HEADER_LEN;
-   } else {
-      AAL_ERR( LM_ALI, "Invalid green bitstream header" << std::endl);
-      getRuntime()->schedDispatchable(new AFUReconfigureFailed( m_pReconClient,new CExceptionTransactionEvent( NULL,
-                  rTranID,
-                  errFileError,
-                  reasUnknown,
-                  "Error: Invalid green bitstream header.")));
-      return;
-   }
-
-
-   AFUConfigureTransaction configuretrans(reinterpret_cast<btVirtAddr>(bufptr_skip), filesize_skip, rTranID,rInputArgs);
+   // The driver copies the payload during SendTransaction(), so the
+   //  reference is only needed until it returns.
+   AFUConfigureTransaction configuretrans(reinterpret_cast<btVirtAddr>(const_cast<btByte *>(pBitstream->Payload())),
+                                          pBitstream->PayloadLen(),
+                                          rTranID,
+                                          rInputArgs);
    // Send transaction
    m_pAFUProxy->SendTransaction(&configuretrans);
+   CBitstreamCache::Release(pBitstream);
+
    if(configuretrans.getErrno() != uid_errnumOK){
       AAL_ERR( LM_ALI,"Reconfigure failed"<< std::endl);
       getRuntime()->schedDispatchable(new AFUReconfigureFailed( m_pReconClient,new CExceptionTransactionEvent( NULL,
@@ -278,12 +254,8 @@ void CHWALIReconf::reconfConfigure( TransactionID const &rTranID,
                                                                                                                errCauseUnknown,
                                                                                                                reasUnknown,
                                                                                                                "Error: Failed transaction")));
-      if(bufptr)
-         delete[] bufptr;
       return;
    }
-   if(bufptr)
-      delete[] bufptr;
 }
 
 /// @brief Activate an AFU after it has been reconfigured.
@@ -376,6 +348,8 @@ void CHWALIReconf::AFUEvent(AAL::IEvent const &theEvent)
                                                                                                                             reasUnknown,
                                                                                                                             "Error: Configure failed. Check Exception number against uid_errnum_e codes")));
                   }else{
+                     // A new green bitstream may reuse MMIO layouts we have cached.
+                     CHWALIBase::FlushFeatureCache();
                      getRuntime()->schedDispatchable(new AFUReconfigured(m_pReconClient, TransactionID(puidEvent->msgTranID())));
                   }
                  return;
@@ -38,7 +38,8 @@
 ///
 /// HISTORY:
 /// WHEN:          WHO:     WHAT:
-/// 05/11/2016     HM       Initial version.@endverbatim
+/// 05/11/2016     HM       Initial version.
+/// 10/19/2016              Failures are DispatchCritical@endverbatim
 //****************************************************************************
 #ifndef __HWALIRECONF_H__
 #define __HWALIRECONF_H__
@@ -121,6 +122,9 @@ public:
       m_pSvcClient->deactivateFailed(*m_pEvent);
    }
 
+   // An error, delivered ahead of queued notifications under priority dispatch.
+   virtual DispatchClass GetDispatchClass() const { return DispatchCritical; }
+
 
 protected:
    IALIReconfigure_Client        *m_pSvcClient;
@@ -159,6 +163,8 @@ public:
       m_pSvcClient->activateFailed(*m_pEvent);
    }
 
+   virtual DispatchClass GetDispatchClass() const { return DispatchCritical; }
+
 
 protected:
    IALIReconfigure_Client        *m_pSvcClient;
@@ -198,6 +204,8 @@ public:
       m_pSvcClient->configureFailed(*m_pEvent);
    }
 
+   virtual DispatchClass GetDispatchClass() const { return DispatchCritical; }
+
 
 protected:
    IALIReconfigure_Client        *m_pSvcClient;
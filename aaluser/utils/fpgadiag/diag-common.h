@@ -176,6 +176,7 @@ public:
    operator IALIBuffer * () { return m_pALIBufferService; }
    operator IALIReset * ()  { return m_pALIResetService; }
    operator IALIUMsg * ()   { return m_pALIuMSGService; }
+   operator IALICompletion * () { return m_pALICompletion; }
    operator IALIPerf * ()   { return m_pALIPerf; }
    operator IMPFVTP * ()    { return m_pVTPService; }
 
@@ -201,6 +202,7 @@ protected:
    IALIMMIO    *m_pALIMMIOService;   ///< Pointer to MMIO Service
    IALIReset   *m_pALIResetService;  ///< Pointer to AFU Reset Service
    IALIUMsg    *m_pALIuMSGService;   ///< Pointer to uMSg Service
+   IALICompletion *m_pALICompletion; ///< Pointer to Completion Service
    IALIPerf    *m_pALIPerf;          ///< ALI Performance Monitor
    IMPFVTP     *m_pVTPService;    	 ///< Pointer to VTP buffer service
    btCSROffset  m_VTPDFHOffset;   	 ///< VTP DFH offset
@@ -257,6 +259,7 @@ protected:
       m_pALIBufferService((IALIBuffer *) *pMyApp),
       m_pALIResetService((IALIReset *) *pMyApp),
       m_pALIuMSGService((IALIUMsg *) *pMyApp),
+      m_pALICompletion((IALICompletion *) *pMyApp),
       m_pVTPService((IMPFVTP *) *pMyApp),
       m_pALIPerf((IALIPerf *) *pMyApp)
    {
@@ -264,6 +267,7 @@ protected:
       ASSERT(NULL != m_pALIMMIOService);
       ASSERT(NULL != m_pALIBufferService);
       ASSERT(NULL != m_pALIResetService);
+      ASSERT(NULL != m_pALICompletion);
       //ASSERT(NULL != m_pALIPerf);
 
       btInt i;
@@ -275,6 +279,7 @@ protected:
 
    btInt ResetHandshake();
    btInt CacheCooldown(btVirtAddr CoolVirt, btPhysAddr CoolPhys, btWSSize CoolSize, const NLBCmdLine &cmd);
+   void  WaitTestComplete(volatile nlb_vafu_dsm *pAFUDSM, btInt &MaxPoll);
 
    void      			ReadPerfMonitors();
    void       			SavePerfMonitors();
@@ -291,6 +296,7 @@ protected:
    IALIMMIO   		  *m_pALIMMIOService;   ///< Pointer to MMIO Service
    IALIReset  		  *m_pALIResetService;  ///< Pointer to AFU Reset Service
    IALIUMsg   		  *m_pALIuMSGService;   ///< Pointer to uMSg Service
+   IALICompletion     *m_pALICompletion;    ///< Pointer to Completion Service
    IALIPerf   		  *m_pALIPerf;          ///< ALI Performance Monitor
    IMPFVTP            *m_pVTPService;       ///< Pointer to VTP buffer service
    btUnsigned64bitInt  m_PerfMonitors[NUM_PERF_MONITORS];
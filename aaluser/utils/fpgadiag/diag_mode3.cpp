@@ -250,11 +250,7 @@ btInt CNLBMode3::RunTest(const NLBCmdLine &cmd)
        m_pALIMMIOService->mmioWrite32(CSR_CTL, 3);
 
        // Wait for test completion or timeout
-       while ( 0 == pAFUDSM->test_complete &&
-             ( MaxPoll >= 0 )) {
-             MaxPoll -= 1;
-             SleepMilli(1);
-       }
+       WaitTestComplete(pAFUDSM, MaxPoll);
 
    	 // Stop the device
    	 m_pALIMMIOService->mmioWrite32(CSR_CTL, 7);
@@ -346,22 +342,14 @@ btInt CNLBMode3::RunTest(const NLBCmdLine &cmd)
 		   m_pALIMMIOService->mmioWrite32(CSR_CTL, 7);
 
 		   //wait for DSM register update or timeout
-		   while ( 0 == pAFUDSM->test_complete &&
-				 ( MaxPoll >= 0 )) {
-			   	 MaxPoll -= 1;
-			   	 SleepMilli(1);
-		   }
+		   WaitTestComplete(pAFUDSM, MaxPoll);
 
 		   //Update timer.
 		   absolute = Timer() + Timer(&ts);
 	   }
 	   else{	//In non-cont mode, wait till test completes and then stop the device.
 		   	// Wait for test completion or timeout
-		   while ( 0 == pAFUDSM->test_complete &&
-		         ( MaxPoll >= 0 )) {
-			   MaxPoll -= 1;
-			   SleepMilli(1);
-		   }
+		   WaitTestComplete(pAFUDSM, MaxPoll);
 
 		   // Stop the device
 		   m_pALIMMIOService->mmioWrite32(CSR_CTL, 7);
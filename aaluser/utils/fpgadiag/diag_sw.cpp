@@ -290,11 +290,7 @@ btInt CNLBSW::RunTest(const NLBCmdLine &cmd)
 	  // Stop the device
 	  m_pALIMMIOService->mmioWrite32(CSR_CTL, 7);
 
-	  while ( ( 0 == pAFUDSM->test_complete ) &&
-			  ( MaxPoll >= 0 ) ){
-		  	MaxPoll -= 1;
-		  	SleepMilli(1);
-	  }
+	  WaitTestComplete(pAFUDSM, MaxPoll);
 
 	  ReadPerfMonitors();
 
@@ -268,6 +268,7 @@ CMyApp::CMyApp() :
    m_pALIMMIOService(NULL),
    m_pALIResetService(NULL),
    m_pALIuMSGService(NULL),
+   m_pALICompletion(NULL),
    m_pALIPerf(NULL),
    m_isOK(false),
    m_pVTP_AALService(NULL),
@@ -560,6 +561,14 @@ void CMyApp::serviceAllocated(IBase               *pServiceBase,
 	         m_bIsOK = false;
 	         return;
 	      }
+
+	      // Used to wait for DSM updates instead of polling
+	      m_pALICompletion = dynamic_ptr<IALICompletion>(iidALI_CMPL_Service, pServiceBase);
+	      ASSERT(NULL != m_pALICompletion);
+	      if ( NULL == m_pALICompletion ) {
+	         m_bIsOK = false;
+	         return;
+	      }
    }else if(tid.ID() == CMyApp::FME){
 
 	   m_pFMEService = pServiceBase;
@@ -982,11 +991,7 @@ btInt INLB::CacheCooldown(btVirtAddr CoolVirt, btPhysAddr CoolPhys, btWSSize Coo
    m_pALIMMIOService->mmioWrite32(CSR_CTL, 3);
 
    // Wait for test completion
-   while ( 0 == pAFUDSM->test_complete &&
-         ( MaxPoll >= 0 )) {
-            MaxPoll -= 1;
-            SleepMilli(1);
-     }
+   WaitTestComplete(pAFUDSM, MaxPoll);
 
    // Stop the device
    m_pALIMMIOService->mmioWrite32(CSR_CTL, 7);
@@ -1005,6 +1010,28 @@ btInt INLB::CacheCooldown(btVirtAddr CoolVirt, btPhysAddr CoolPhys, btWSSize Coo
    return res;
 }
 
+void INLB::WaitTestComplete(volatile nlb_vafu_dsm *pAFUDSM, btInt &MaxPoll)
+{
+   // Wait for bit 0 of test_complete, charging the time waited to the
+   //  MaxPoll budget (milliseconds). MaxPoll goes negative on timeout.
+   if ( MaxPoll < 0 ) {
+      return;
+   }
+
+   Timer begin;
+   IALICompletion::e_Completion res =
+      m_pALICompletion->completionWaitFor(&pAFUDSM->test_complete, 1, 1, (btTime)MaxPoll);
+
+   if ( IALICompletion::e_Done != res ) {
+      MaxPoll = -1;
+      return;
+   }
+
+   btUnsigned64bitInt ms = 0;
+   (Timer() - begin).AsMilliSeconds(ms);
+   MaxPoll = ( (btInt)ms < MaxPoll ) ? MaxPoll - (btInt)ms : 0;
+}
+
 void INLB::ReadPerfMonitors()
 {
 	NamedValueSet PerfMon;
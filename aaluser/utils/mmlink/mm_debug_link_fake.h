@@ -0,0 +1,177 @@
+// Copyright(c) 2016, Intel Corporation
+// All rights reserved.
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+/// @file mm_debug_link_fake.h
+/// @brief In-memory mm_debug_link_interface for exercising mmlink_server.
+/// @ingroup SigTap
+/// @verbatim
+/// Accelerator Abstraction Layer Sample Application
+///
+///    This application is for example purposes only.
+///    It is not intended to represent a model for developing commercially-deployable applications.
+///    It is designed to show working examples of the AAL programming model and APIs.
+///
+/// Stands in for the remote STP debug link without hardware. Bytes written
+/// by the host are echoed back as target-to-host data, and source() queues a
+/// stream of pattern bytes (FakePattern()) for throughput runs; like a real
+/// target, the stream starts once the host has written something. The FIFO
+/// level limits of the real link (8-bit read level, fixed write capacity)
+/// are modeled, and register-level accesses are counted in stats().
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version.@endverbatim
+//****************************************************************************
+#ifndef MM_DEBUG_LINK_FAKE_H
+#define MM_DEBUG_LINK_FAKE_H
+
+#include <aalsdk/AAL.h>
+#include <string.h>
+#include <unistd.h>
+#include <deque>
+
+#include "mm_debug_link_interface.h"
+
+using namespace AAL;
+
+// The byte at offset i of a source() stream.
+inline char FakePattern(uint64_t i) { return (char)((i * 31) ^ (i >> 8)); }
+
+class mm_debug_link_fake: public mm_debug_link_interface
+{
+public:
+  // Largest value the 8-bit FIFO_READ_COUNT register can report.
+  static const size_t READ_LEVEL_MAX = 255;
+  // Write FIFO capacity reported by MM_DEBUG_LINK_WRITE_CAPACITY.
+  static const size_t WRITE_CAPACITY = 64;
+  // Echoed bytes the target holds before it stops draining the write FIFO.
+  static const size_t ECHO_MAX = 4096;
+
+  struct stats_t
+  {
+    uint64_t level_reads;  // FIFO level register reads
+    uint64_t empty_reads;  // ... that found the read FIFO empty
+    uint64_t data_reads;   // DATA_READ accesses
+    uint64_t data_writes;  // DATA_WRITE accesses
+    uint64_t t2h_bytes;
+    uint64_t h2t_bytes;
+  };
+
+  mm_debug_link_fake() :
+    m_source(0),
+    m_source_pos(0),
+    m_started(false),
+    m_open(false)
+  {
+    memset(&m_stats, 0, sizeof(m_stats));
+  }
+
+  // Queue count more pattern bytes of target-to-host data. Not thread safe;
+  // call before the server starts.
+  void source(uint64_t count) { m_source += count; }
+  const stats_t &stats(void) const { return m_stats; }
+
+  int open(btVirtAddr ) { m_open = true; return 0; }
+  void close(void) { m_open = false; }
+
+  ssize_t read(void *buf, size_t count)
+  {
+    char  *p     = static_cast<char *>(buf);
+    size_t total = 0;
+
+    while (total < count)
+    {
+      size_t level = read_level();
+      if (0 == level)
+        break;
+      if (level > count - total)
+        level = count - total;
+
+      // One access per 8-byte word, plus one each for a 4B and 1B tail.
+      m_stats.data_reads += level / 8 + (level % 8) / 4 + level % 4;
+
+      size_t n = 0;
+      while (n < level && !m_echo.empty())
+      {
+        p[n++] = m_echo.front();
+        m_echo.pop_front();
+      }
+      for ( ; n < level; ++n)
+        p[n] = FakePattern(m_source_pos++);
+
+      p += level;
+      total += level;
+    }
+
+    m_stats.t2h_bytes += total;
+    return total;
+  }
+
+  ssize_t write(const void *buf, size_t count)
+  {
+    // The target drains the write FIFO as fast as the echo queue allows.
+    size_t space = ECHO_MAX - m_echo.size();
+    if (space > WRITE_CAPACITY)
+      space = WRITE_CAPACITY;
+    if (count > space)
+      count = space;
+
+    ++m_stats.level_reads;
+    m_stats.data_writes += count / 8 + (count % 8) / 4 + count % 4;
+    m_stats.h2t_bytes += count;
+
+    const char *p = static_cast<const char *>(buf);
+    m_echo.insert(m_echo.end(), p, p + count);
+    m_started = m_started || count > 0;
+    return count;
+  }
+
+  void ident(int id[4]) { memset(id, 0, 4 * sizeof(int)); }
+  void write_ident(int ) { }
+  void reset(bool ) { }
+  void enable(int , bool ) { }
+  int get_fd(void) { return -1; }
+
+private:
+  size_t read_level(void)
+  {
+    uint64_t avail = m_echo.size() + (m_started ? m_source - m_source_pos : 0);
+
+    ++m_stats.level_reads;
+    if (0 == avail)
+      ++m_stats.empty_reads;
+    return (avail < READ_LEVEL_MAX) ? (size_t)avail : READ_LEVEL_MAX;
+  }
+
+  std::deque<char> m_echo;
+  uint64_t         m_source;
+  uint64_t         m_source_pos;
+  bool             m_started;
+  bool             m_open;
+  stats_t          m_stats;
+};
+
+#endif
@@ -54,7 +54,11 @@ class mm_debug_link_interface
 {
 public:
   virtual int open(btVirtAddr stpAddr) = 0;
-  virtual ssize_t read() = 0;
+  // Drain up to count bytes of target-to-host data from the link FIFO into
+  // buf. Returns the number of bytes read; 0 when the FIFO is empty.
+  virtual ssize_t read(void *buf, size_t count) = 0;
+  // Write as much of buf as the host-to-target FIFO has room for. Returns the
+  // number of bytes written; 0 when the FIFO is full.
   virtual ssize_t write(const void *buf, size_t count) = 0;
   virtual void close(void) = 0;
   virtual void ident(int id[4]) = 0;
@@ -62,12 +66,7 @@ public:
   virtual void reset(bool val) = 0;
   virtual void enable(int channel, bool state) = 0;
   virtual int get_fd(void) = 0;
-  virtual bool can_read_data() = 0;
-  virtual size_t buf_end(void) = 0;
-  virtual void buf_end(int index) = 0;
-  virtual char *buf(void) = 0;
-  virtual bool is_empty(void) = 0;
-  virtual bool flush_request(void) = 0;
+  virtual ~mm_debug_link_interface() {}
 };
 
 // Concrete classes must implement this routine.
@@ -60,7 +60,6 @@
 //#include "printf.h"
 
 #define DRIVER_PATH "/dev/mm_debug_link"
-#define B2P_EOP 0x7B
 
 #define BASE_ADDR 4096
 
@@ -110,11 +109,9 @@ mm_debug_link_interface *get_mm_debug_link(void)
 
 mm_debug_link_linux::mm_debug_link_linux() {
     m_fd = -1;
-    m_buf_end = 0;
     m_write_fifo_capacity = 0;
-    m_write_before_any_read_rfifo_level = false;
-    m_last_read_rfifo_level_empty_time = 0;
-    m_read_rfifo_level_empty_interval = 1;
+    m_rd_len = -1;
+    m_wr_len = -1;
 }
 
 int mm_debug_link_linux::open(btVirtAddr stpAddr)
@@ -128,6 +125,8 @@ int mm_debug_link_linux::open(btVirtAddr stpAddr)
       write_mmr(REMSTP_RESET, 'w', 0x1);
       cout << "Remote STP : De-Assert Reset" << endl << flush;
       write_mmr(REMSTP_RESET, 'w', 0x0);
+      m_rd_len = -1;
+      m_wr_len = -1;
 
       sign = *(static_cast<unsigned int*>(read_mmr(MM_DEBUG_LINK_SIGNATURE, 'w')));
       cout << "Read signature value " << std::hex << sign << " to hw\n" << flush;
@@ -208,50 +207,47 @@ void mm_debug_link_linux::write_mmr(off_t target, int access_type, uint64_t writ
         }
 }
 
-bool mm_debug_link_linux::can_read_data()
+void mm_debug_link_linux::set_rd_len(int len)
 {
-    bool ret  = this->m_write_before_any_read_rfifo_level;
+    if ( len != m_rd_len )
+    {
+        write_mmr( REMSTP_MMIO_RD_LEN, 'w', len);
+        m_rd_len = len;
+    }
+}
 
-    if ( !ret )
+void mm_debug_link_linux::set_wr_len(int len)
+{
+    if ( len != m_wr_len )
     {
-        clock_t cur_time = ::clock();
-        clock_t duration = cur_time - this->m_last_read_rfifo_level_empty_time;
-        if ( duration < 0 )
-        {
-            duration = -duration;
-        }
-        if ( duration >= this->m_read_rfifo_level_empty_interval )
-        {
-            ret = true;
-        }
+        write_mmr( REMSTP_MMIO_WR_LEN, 'w', len);
+        m_wr_len = len;
     }
+}
 
-    return ret;
+size_t mm_debug_link_linux::read_level(void)
+{
+    return *(static_cast<volatile uint8_t *>(read_mmr(MM_DEBUG_LINK_FIFO_READ_COUNT, 'b')));
 }
 
-ssize_t mm_debug_link_linux::read()
+ssize_t mm_debug_link_linux::read(void *buf, size_t count)
 {
-      volatile uint8_t  num_bytes =0;
-      num_bytes = *(static_cast<uint8_t *>(read_mmr(MM_DEBUG_LINK_FIFO_READ_COUNT, 'b' )));
+    char   *p     = static_cast<char *>(buf);
+    size_t  total = 0;
 
-      // Reset the timer record
-      if ( (this->m_write_before_any_read_rfifo_level ||  // when this is the first read after write
-           num_bytes > 0) )                               // when something is available to read
+    // Drain until the read FIFO reports empty or buf is full. The level register
+    // is only 8 bits wide, so a busy link is re-sampled after every pass.
+    while ( total < count )
+    {
+      size_t num_bytes = read_level();
+      if ( 0 == num_bytes )
       {
-          this->m_write_before_any_read_rfifo_level = false;
-          this->m_read_rfifo_level_empty_interval = 1;     // Increase the read fifo level polling freq. in anticipation of more read data availability.
+        break;
       }
-
-      if (num_bytes > 0 )
+      if ( num_bytes > count - total )
       {
-        if ( num_bytes > (mm_debug_link_linux::BUFSIZE - m_buf_end) )
-        {
-          num_bytes = mm_debug_link_linux::BUFSIZE - m_buf_end;
-        }
-
-    #ifdef DEBUG_FLAG
-           cout << "Read " << num_bytes << " bytes\n";
-        #endif
+        num_bytes = count - total;
+      }
 
       // ==========================================================================================================================
       // At this point, num_bytes has the No. of bytes available to read from the FPGA
@@ -301,201 +297,125 @@ ssize_t mm_debug_link_linux::read()
       // -----
       // MMIO reads to REMSTP_MMIO_RD_LEN or REMSTP_MMIO_WR_LEN is NOT supported
       //
+      // REMSTP_MMIO_RD_LEN is shadowed in m_rd_len: a steady stream of full words
+      // costs one MMIO read per 8 bytes, with no RD_LEN write in between.
+      //
 
-      uint8_t  num_8B_reads, num_4B_reads, num_1B_reads, remaining_bytes;
-      num_8B_reads    = num_bytes/8;
-      remaining_bytes = num_bytes%8;
-      num_4B_reads    = remaining_bytes/4;
-      remaining_bytes = remaining_bytes%4;
-      num_1B_reads    = remaining_bytes;
+      size_t num_8B_reads = num_bytes / 8;
+      size_t num_4B_reads = (num_bytes % 8) / 4;
+      size_t num_1B_reads = num_bytes % 4;
 
       #ifdef DEBUG_8B_4B_TRANSFERS
       cout << dec;
-      cout << "DBG_READ : Total_Bytes = " << (unsigned) num_bytes << " ; 8_bytes = "
-           << (unsigned) num_8B_reads << " ; 4_bytes = " << (unsigned) num_4B_reads << " ; 1_bytes = " << (unsigned) num_1B_reads << endl << flush;
+      cout << "DBG_READ : Total_Bytes = " << num_bytes << " ; 8_bytes = "
+           << num_8B_reads << " ; 4_bytes = " << num_4B_reads << " ; 1_bytes = " << num_1B_reads << endl << flush;
       #endif
 
-      // SW should update HW control (REMSTP_MMIO_RD_LEN) and use only REMSTP_MMIO_RD_LEN bytes returned
       if (num_8B_reads > 0)
       {
-        // Change REMSTP_MMIO_RD_LEN to 8B
-        write_mmr( REMSTP_MMIO_RD_LEN, 'w', LEN_8B);
-        for ( unsigned char  i = 0; i < num_8B_reads; ++i )
+        volatile uint64_t *data = static_cast<volatile uint64_t *>(read_mmr( MM_DEBUG_LINK_DATA_READ, 'q'));
+        set_rd_len(LEN_8B);
+        for ( size_t i = 0; i < num_8B_reads; ++i, p += 8 )
         {
-          char *p = (this->m_buf + this->m_buf_end + (i*8) );
-          *(uint64_t*)p = *(static_cast<uint64_t*>(read_mmr( MM_DEBUG_LINK_DATA_READ, 'q')));
-          #ifdef DEBUG_8B_4B_TRANSFERS
-          cout << "DBG_READ_8B : Iteration "<< (unsigned) i << "; READ VALUE : " << hex;
-          for (unsigned char j=0; j<8; j++)
-          cout << (int) *( this->m_buf + this->m_buf_end + (i*8) + j ) << flush;
-          cout << dec << endl << flush;
-          #endif
+          uint64_t v = *data;
+          memcpy(p, &v, 8);
         }
       }
 
       if (num_4B_reads > 0)
       {
-        // Change REMSTP_MMIO_RD_LEN to 4B
-        write_mmr( REMSTP_MMIO_RD_LEN, 'w', LEN_4B);
-        for ( unsigned char  i = 0; i < num_4B_reads; ++i )
-        {
-          char *p = (this->m_buf + this->m_buf_end + ( (num_8B_reads*8) + (i*4) ));
-          *(uint32_t*)p  = *(static_cast<uint32_t*>(read_mmr( MM_DEBUG_LINK_DATA_READ, 'w')));
-          #ifdef DEBUG_8B_4B_TRANSFERS
-          cout << "DBG_READ_4B : Iteration "<< (int) i << "; READ VALUE : " << hex;
-          for (unsigned char j=0; j<4; j++)
-          cout << (int) *( this->m_buf + this->m_buf_end + ( (num_8B_reads*8) + (i*4) + j)) << flush;
-          cout << dec << endl << flush;
-          #endif
-        }
+        volatile uint32_t *data = static_cast<volatile uint32_t *>(read_mmr( MM_DEBUG_LINK_DATA_READ, 'w'));
+        set_rd_len(LEN_4B);
+        uint32_t v = *data;
+        memcpy(p, &v, 4);
+        p += 4;
       }
 
       if (num_1B_reads > 0)
       {
-        // Change REMSTP_MMIO_RD_LEN to 1B
-        write_mmr( REMSTP_MMIO_RD_LEN, 'w', LEN_1B);
-        for ( unsigned char i = 0; i < num_1B_reads; ++i )
+        volatile uint8_t *data = static_cast<volatile uint8_t *>(read_mmr( MM_DEBUG_LINK_DATA_READ, 'b'));
+        set_rd_len(LEN_1B);
+        for ( size_t i = 0; i < num_1B_reads; ++i )
         {
-          *( this->m_buf + this->m_buf_end + ( (num_8B_reads*8) + (num_4B_reads*4) + i ) ) = *(static_cast<unsigned char*>(read_mmr( MM_DEBUG_LINK_DATA_READ, 'b')));
-          #ifdef DEBUG_8B_4B_TRANSFERS
-          cout << "DBG_READ_1B : Iteration "<< (int) i << "; READ VALUE : "
-          << hex << (int) *( this->m_buf + this->m_buf_end + ( (num_8B_reads*8) + (num_4B_reads*4) +i)) << endl << flush << dec;
-          #endif
+          *p++ = *data;
         }
       }
       // ==========================================================================================================================
 
-          unsigned int x;
-          for ( unsigned char i = 0; i < num_bytes; ++i )
-          {
-            x = this->m_buf[this->m_buf_end + i];
-
-          #ifdef DEBUG_FLAG
-               cout << setfill('0') << setw(2) << std::hex << x << " ";
-          #endif
-          }
-         #ifdef DEBUG_FLAG
-             cout << std::dec << "\n";
-         #endif
+      #ifdef DEBUG_FLAG
+      cout << "Read " << num_bytes << " bytes\n";
+      #endif
 
-          this->m_buf_end += num_bytes;
-      }
-      else
-      {
-          //printf( "%s %s(): error read hw read buffer level\n", __FILE__, __FUNCTION__ );
-          num_bytes = 0;
+      total += num_bytes;
+    }
 
-          this->m_last_read_rfifo_level_empty_time = ::clock();
+    return total;
+}
 
-          //Throttle the read rfifo level polling freq.  up to 10 sec.
-          this->m_read_rfifo_level_empty_interval *= 2;
-          if ( this->m_read_rfifo_level_empty_interval >= 10 * CLOCKS_PER_SEC )
-          {
-              this->m_read_rfifo_level_empty_interval = 10 * CLOCKS_PER_SEC;
-          }
-      }
+size_t mm_debug_link_linux::write_space(void)
+{
+    int used = *(static_cast<volatile uint8_t *>(read_mmr(MM_DEBUG_LINK_FIFO_WRITE_COUNT, 'b')));
 
-      return num_bytes;
+    return ( used < m_write_fifo_capacity ) ? m_write_fifo_capacity - used : 0;
 }
 
 ssize_t mm_debug_link_linux::write(const void *buf, size_t count)
 {
-    uint8_t num_bytes;
-    unsigned int x;
-    num_bytes = *(static_cast<uint8_t *>(read_mmr(MM_DEBUG_LINK_FIFO_WRITE_COUNT, 'b' )));
+    const char *p         = static_cast<const char *>(buf);
+    size_t      num_bytes = write_space();
 
-    this->m_write_before_any_read_rfifo_level = true;     // Set this to kick off any possible read activity even if write FIFO is full to avoid potential deadlock.
-
-    if ( num_bytes < this->m_write_fifo_capacity )
+    if ( count < num_bytes )
     {
-      num_bytes = this->m_write_fifo_capacity - num_bytes;
-      if ( count < num_bytes )
-      {
       num_bytes = count;
-      }
+    }
 
-      count = 0;
+    // ==========================================================================================================================
+    // Writes are packed the same way as reads (see read()); REMSTP_MMIO_WR_LEN is shadowed in m_wr_len.
+    size_t num_8B_writes = num_bytes / 8;
+    size_t num_4B_writes = (num_bytes % 8) / 4;
+    size_t num_1B_writes = num_bytes % 4;
 
-      // ==========================================================================================================================
-      uint8_t      num_8B_writes, num_4B_writes, num_1B_writes, remaining_bytes;
-      num_8B_writes   = num_bytes/8;
-      remaining_bytes = num_bytes%8;
-      num_4B_writes   = remaining_bytes/4;
-      remaining_bytes = remaining_bytes%4;
-      num_1B_writes   = remaining_bytes;
+    #ifdef DEBUG_8B_4B_TRANSFERS
+    cout << dec << endl;
+    cout << "DBG_WRITE : Total_Bytes = " << num_bytes << " ; 8_bytes = " << num_8B_writes
+         << " ; 4_bytes = " << num_4B_writes << " ; 1_bytes = " << num_1B_writes << endl << flush;
+    #endif
 
-      #ifdef DEBUG_8B_4B_TRANSFERS
-      cout << dec << endl;
-      cout << "DBG_WRITE : Total_Bytes = " << (unsigned) num_bytes << " ; 8_bytes = " << (unsigned) num_8B_writes
-           << " ; 4_bytes = " << (unsigned) num_4B_writes << " ; 1_bytes = " << (unsigned) num_1B_writes << endl << flush;
-      #endif
-
-      // SW should update HW control (REMSTP_MMIO_WR_LEN) and use only REMSTP_MMIO_WR_LEN bytes returned
-      if (num_8B_writes > 0)
+    if (num_8B_writes > 0)
+    {
+      set_wr_len(LEN_8B);
+      for ( size_t i = 0; i < num_8B_writes; ++i, p += 8 )
       {
-        // Change REMSTP_MMIO_WR_LEN to 8B
-        write_mmr( REMSTP_MMIO_WR_LEN, 'w', LEN_8B);
-        for ( size_t i = 0; i < num_8B_writes; ++i )
-        {
-          #ifdef DEBUG_8B_4B_TRANSFERS
-          cout << "DBG_WRITE_8B : Iteration "<< i << "; ";
-          #endif
-          write_mmr( MM_DEBUG_LINK_DATA_WRITE, 'q', *( (uint64_t *)buf + i ) );
-          count+=8;
-        }
+        uint64_t v;
+        memcpy(&v, p, 8);
+        write_mmr( MM_DEBUG_LINK_DATA_WRITE, 'q', v );
       }
+    }
 
-      if (num_4B_writes > 0)
-      {
-        // Change REMSTP_MMIO_WR_LEN to 4B
-        write_mmr( REMSTP_MMIO_WR_LEN, 'w', LEN_4B);
-        for ( size_t i = 0; i < num_4B_writes; ++i )
-        {
-          #ifdef DEBUG_8B_4B_TRANSFERS
-          cout << "DBG_WRITE_4B : Iteration "<< i << "; ";
-          #endif
-          write_mmr( MM_DEBUG_LINK_DATA_WRITE, 'w', *( (uint32_t *)buf + ( (num_8B_writes*2) + i ) ) );
-          count+=4;
-        }
-      }
+    if (num_4B_writes > 0)
+    {
+      uint32_t v;
+      memcpy(&v, p, 4);
+      set_wr_len(LEN_4B);
+      write_mmr( MM_DEBUG_LINK_DATA_WRITE, 'w', v );
+      p += 4;
+    }
 
-      if (num_1B_writes > 0)
+    if (num_1B_writes > 0)
+    {
+      set_wr_len(LEN_1B);
+      for ( size_t i = 0; i < num_1B_writes; ++i )
       {
-        // Change REMSTP_MMIO_WR_LEN to 1B
-        write_mmr( REMSTP_MMIO_WR_LEN, 'w', LEN_1B);
-        for ( size_t i = 0; i < num_1B_writes; ++i )
-        {
-          #ifdef DEBUG_8B_4B_TRANSFERS
-          cout << "DBG_WRITE_1B : Iteration "<< i << "; ";
-          #endif
-          write_mmr( MM_DEBUG_LINK_DATA_WRITE, 'b', *( (unsigned char *)buf + ( (num_8B_writes*8) + (num_4B_writes*4) + (i) ) ) );
-          ++count;
-        }
+        write_mmr( MM_DEBUG_LINK_DATA_WRITE, 'b', (unsigned char)*p++ );
       }
-      // ==========================================================================================================================
+    }
+    // ==========================================================================================================================
 
-        num_bytes = count;
-       #ifdef DEBUG_FLAG
-          cout << "Wrote " << num_bytes << " bytes\n";
-       #endif
-       for ( int i = 0; i < num_bytes; ++i )
-       {
-         x = *((unsigned char *)buf + i);
-         #ifdef DEBUG_FLAG
-            cout << setfill('0') << setw(2) << std::hex << x << " ";
-         #endif
-       }
-       #ifdef DEBUG_FLAG
-          cout << std::dec << "\n" ;
-       #endif
-      }
-      else
-      {
-         //cerr << "Error write hw write buffer level\n";
-         num_bytes = 0;
-      }
+    #ifdef DEBUG_FLAG
+    cout << "Wrote " << num_bytes << " bytes\n";
+    #endif
 
-      return num_bytes;
+    return num_bytes;
 }
 
 void mm_debug_link_linux::close(void)
@@ -540,25 +460,3 @@ void mm_debug_link_linux::enable(int channel, bool state)
 
 }
 
-bool mm_debug_link_linux::flush_request(void)
-{
-  bool should_flush = false;
-  if (m_buf_end == BUFSIZE)
-    // Full buffer? Send.
-    should_flush = true;
-  else if (memchr(m_buf, B2P_EOP, m_buf_end - 1))
-    // Buffer contains eop? Send.
-    // If the eop character occurs in the very last buffer byte, there's no packet here -
-    // we need at least one more byte.
-    // Interesting corner case: it's not strictly true that one more byte after EOP indicates
-    // the end of a packet - that byte after EOP might be the escape character. In this case,
-    // we flush even though it's not necessarily a complete packet. This probably has negligible
-    // impact on performance.
-    should_flush = true;
-
-  if ( m_buf_end > 0 )
-   {
-     should_flush = true;
-   }
-  return should_flush;
-}
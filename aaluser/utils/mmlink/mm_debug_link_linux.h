@@ -48,34 +48,34 @@
 
 #include <aalsdk/AAL.h>
 #include <unistd.h>
-#include "time.h"
 
 #include "mm_debug_link_interface.h"
 
-// size of buffer for t2h data
-#define BUFFERSIZE_T2H 1073741824
-
 using namespace AAL;
 
 class mm_debug_link_linux: public mm_debug_link_interface
 {
 private:
   int m_fd;
-  static const size_t BUFSIZE = BUFFERSIZE_T2H;
-  char m_buf[BUFSIZE];
-  volatile size_t m_buf_end;
   int m_write_fifo_capacity;
   volatile btVirtAddr map_base;
-  bool m_write_before_any_read_rfifo_level;
-  clock_t m_last_read_rfifo_level_empty_time;
-  clock_t m_read_rfifo_level_empty_interval;
+  // Last values written to REMSTP_MMIO_RD_LEN / REMSTP_MMIO_WR_LEN, or -1.
+  // Those registers are write-only, so they are shadowed here and only
+  // rewritten when the transfer width changes.
+  int m_rd_len;
+  int m_wr_len;
+
+  void set_rd_len(int len);
+  void set_wr_len(int len);
+  size_t read_level(void);
+  size_t write_space(void);
 
 public:
   mm_debug_link_linux();
   int open(btVirtAddr stpAddr);
   void* read_mmr(btCSROffset target, int access_type);
   void write_mmr(off_t target, int access_type, uint64_t write_val);
-  ssize_t read();
+  ssize_t read(void *buf, size_t count);
   ssize_t write( const void *buf, size_t count);
   void close(void);
   void ident(int id[4]);
@@ -83,12 +83,6 @@ public:
   void reset(bool val);
   void enable(int channel, bool state);
   int get_fd(void) { return m_fd; }
-  bool can_read_data(void);
-  char *buf(void) { return m_buf; }
-  bool is_empty(void) { return m_buf_end == 0; }
-  bool flush_request(void);
-  size_t buf_end(void) { return m_buf_end; }
-  void buf_end(int index) { m_buf_end = index; }
 };
 
 #endif
@@ -0,0 +1,250 @@
+// Copyright(c) 2016, Intel Corporation
+// All rights reserved.
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+/// @file mmlink_bench.cpp
+/// @brief Loopback throughput benchmark for mmlink_server.
+/// @ingroup SigTap
+/// @verbatim
+/// Accelerator Abstraction Layer Sample Application
+///
+///    This application is for example purposes only.
+///    It is not intended to represent a model for developing commercially-deployable applications.
+///    It is designed to show working examples of the AAL programming model and APIs.
+///
+/// Runs mmlink_server on 127.0.0.1 over mm_debug_link_fake and measures,
+/// from a client socket:
+///    t2h throughput streaming [MiB] of target data (default 64),
+///    1-byte h2t/t2h round-trip latency,
+///    server CPU use and FIFO level polls while the data link is idle.
+///
+/// Usage: mmlink_bench [MiB]
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version.@endverbatim
+//****************************************************************************
+#include <aalsdk/AAL.h>
+#include <aalsdk/osal/Timer.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "mm_debug_link_fake.h"
+#include "mmlink_server.h"
+
+using namespace std;
+using namespace AAL;
+
+static void ServerThread(OSLThread * , void *pContext)
+{
+  reinterpret_cast<mmlink_server *>(pContext)->run(NULL);
+}
+
+static double Elapsed(const Timer &begin)
+{
+  double us = 0.0;
+  (Timer().Now() - begin).AsMicroSeconds(us);
+  return us;
+}
+
+static double CpuSeconds(void)
+{
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+         (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+// Receive exactly len bytes.
+static bool RecvAll(int fd, char *buf, size_t len)
+{
+  while (len > 0)
+  {
+    ssize_t n = ::recv(fd, buf, len, 0);
+    if (n <= 0)
+      return false;
+    buf += n;
+    len -= n;
+  }
+  return true;
+}
+
+// Connect, read the welcome line, and convert the connection to data.
+static int OpenDataConnection(int port)
+{
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  if (fd < 0 || ::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    cerr << "connect failed: " << strerror(errno) << endl;
+    return -1;
+  }
+
+  char c = 0;
+  while (c != '\n')
+  {
+    if (!RecvAll(fd, &c, 1))
+    {
+      ::close(fd);
+      return -1;
+    }
+  }
+
+  // The pipe converts the connection to data and is echoed back by the fake.
+  c = '|';
+  if (::send(fd, &c, 1, 0) != 1 || !RecvAll(fd, &c, 1) || c != '|')
+  {
+    cerr << "failed to open the data connection" << endl;
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int main(int argc, char *argv[])
+{
+  uint64_t mib = 64;
+
+  if (argc > 1)
+  {
+    mib = strtoull(argv[1], NULL, 0);
+    if (0 == mib)
+    {
+      cerr << "Usage: " << argv[0] << " [MiB]" << endl;
+      return 1;
+    }
+  }
+
+  const uint64_t total = mib << 20;
+
+  mm_debug_link_fake *driver = new mm_debug_link_fake();
+  driver->source(total);
+
+  struct sockaddr_in sock;
+  memset(&sock, 0, sizeof(sock));
+  sock.sin_family = AF_INET;
+  sock.sin_port = 0;
+  sock.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  mmlink_server *server = new mmlink_server(&sock, driver);
+  OSLThread *thread = new OSLThread(ServerThread, OSLThread::THREADPRIORITY_NORMAL, server);
+
+  for (int i = 0; i < 5000 && 0 == server->get_port(); ++i)
+    SleepMilli(1);
+
+  int fd = OpenDataConnection(server->get_port());
+  int res = 1;
+
+  if (fd >= 0)
+  {
+    // t2h throughput.
+    std::vector<char> buf(1 << 20);
+    uint64_t received = 0;
+    bool ok = true;
+    Timer t0 = Timer().Now();
+
+    while (ok && received < total)
+    {
+      ssize_t n = ::recv(fd, &buf[0], (size_t)MIN((uint64_t)buf.size(), total - received), 0);
+      if (n <= 0)
+      {
+        ok = false;
+        break;
+      }
+      for (ssize_t i = 0; i < n; ++i)
+        if (buf[i] != FakePattern(received + i))
+          ok = false;
+      received += n;
+    }
+    double us = Elapsed(t0);
+
+    if (!ok)
+    {
+      cerr << "t2h stream corrupt or short at byte " << received << endl;
+    }
+    else
+    {
+      cout << fixed << setprecision(1)
+           << setw(24) << left << "t2h throughput" << right
+           << setw(12) << (total / us) << " MB/s ("
+           << mib << " MiB in " << (us / 1000.0) << " ms)" << endl;
+
+      // h2t -> t2h round trip.
+      std::vector<double> rtt;
+      for (int i = 0; ok && i < 1000; ++i)
+      {
+        char c = (char)i;
+        char r = 0;
+        t0 = Timer().Now();
+        ok = (::send(fd, &c, 1, 0) == 1) && RecvAll(fd, &r, 1) && (r == c);
+        rtt.push_back(Elapsed(t0));
+      }
+      std::sort(rtt.begin(), rtt.end());
+
+      cout << setw(24) << left << "round trip (usec)" << right
+           << " median " << rtt[rtt.size() / 2]
+           << "  p99 " << rtt[rtt.size() * 99 / 100] << endl;
+
+      // Idle data link.
+      uint64_t polls = driver->stats().level_reads;
+      double cpu0 = CpuSeconds();
+      t0 = Timer().Now();
+      SleepSec(1);
+      double secs = Elapsed(t0) / 1e6;
+      double cpu = CpuSeconds() - cpu0;
+
+      cout << setw(24) << left << "idle server CPU" << right
+           << setw(12) << (100.0 * cpu / secs) << " %  ("
+           << (driver->stats().level_reads - polls) / secs << " FIFO polls/s)" << endl;
+
+      res = ok ? 0 : 1;
+    }
+    ::close(fd);
+  }
+
+  server->stop();
+  thread->Join();
+  delete thread;
+  delete server;
+  delete driver;
+
+  return res;
+}
@@ -125,6 +125,17 @@ size_t mmlink_connection::send(const char *msg, const size_t msg_len)
   return len;
 }
 
+ssize_t mmlink_connection::sendv(const struct iovec *iov, int iovcnt)
+{
+  struct msghdr msg;
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = const_cast<struct iovec *>(iov);
+  msg.msg_iovlen = iovcnt;
+
+  return ::sendmsg(m_fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+}
+
 int mmlink_connection::handle_management()
 {
   int i, start;
@@ -47,6 +47,7 @@
 #define MMLINK_CONNECTION_H
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "mm_debug_link_interface.h"
@@ -64,6 +65,8 @@ public:
   void set_is_data(void) { m_is_data = true; }
 
   size_t send(const char *msg, const size_t len);
+  // Non-blocking vectored send; returns bytes sent, or -1 with errno set.
+  ssize_t sendv(const struct iovec *iov, int iovcnt);
   void close_connection() { if (is_open()) ::close(m_fd); init(); }
   void bind() { m_is_bound = true; }
   void socket(int socket) { m_fd = socket; }
@@ -74,6 +77,7 @@ public:
   char *buf(void) { return m_buf; }
   void buf_end(size_t index) { m_buf_end = index; }
   size_t buf_end(void) { return m_buf_end; }
+  bool buf_full(void) { return m_buf_end >= (size_t)m_bufsize; }
 
   static const char *UNKNOWN;
   static const char *OK;
@@ -0,0 +1,115 @@
+// Copyright(c) 2016, Intel Corporation
+// All rights reserved.
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+/// @file mmlink_ring.h
+/// @brief Byte ring buffer for target-to-host debug link data.
+/// @ingroup SigTap
+/// @verbatim
+/// Accelerator Abstraction Layer Sample Application
+///
+///    This application is for example purposes only.
+///    It is not intended to represent a model for developing commercially-deployable applications.
+///    It is designed to show working examples of the AAL programming model and APIs.
+///
+/// The debug link FIFO is drained straight into the free space of the ring
+/// (write_ptr() / commit()), and the pending bytes are handed to the socket as
+/// at most two iovecs (read_iov() / consume()), so data is never memmove'd.
+/// Single-threaded; the size is rounded up to a power of two.
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version.@endverbatim
+//****************************************************************************
+#ifndef MMLINK_RING_H
+#define MMLINK_RING_H
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+class mmlink_ring
+{
+public:
+  mmlink_ring(size_t size)
+  {
+    m_size = 1;
+    while (m_size < size)
+      m_size <<= 1;
+    m_buf = new char[m_size];
+    clear();
+  }
+  ~mmlink_ring() { delete[] m_buf; }
+
+  void clear(void) { m_head = m_tail = 0; }
+  size_t size(void) const { return m_size; }
+  size_t used(void) const { return m_head - m_tail; }
+  size_t space(void) const { return m_size - used(); }
+  bool empty(void) const { return m_head == m_tail; }
+  bool full(void) const { return used() == m_size; }
+
+  // Contiguous free space at the head; *len receives its length.
+  char *write_ptr(size_t *len)
+  {
+    size_t off = m_head & (m_size - 1);
+    size_t n   = m_size - off;
+    *len = (n < space()) ? n : space();
+    return m_buf + off;
+  }
+  void commit(size_t n) { m_head += n; }
+
+  // Describe the pending bytes as up to two iovecs; returns the iovec count.
+  int read_iov(struct iovec iov[2])
+  {
+    size_t off = m_tail & (m_size - 1);
+    size_t n   = used();
+    size_t first = m_size - off;
+
+    if (0 == n)
+      return 0;
+
+    iov[0].iov_base = m_buf + off;
+    if (n <= first)
+    {
+      iov[0].iov_len = n;
+      return 1;
+    }
+    iov[0].iov_len = first;
+    iov[1].iov_base = m_buf;
+    iov[1].iov_len = n - first;
+    return 2;
+  }
+  void consume(size_t n) { m_tail += n; }
+
+private:
+  mmlink_ring(const mmlink_ring &);
+  mmlink_ring &operator=(const mmlink_ring &);
+
+  char  *m_buf;
+  size_t m_size;
+  size_t m_head;  // free-running; bytes committed
+  size_t m_tail;  // free-running; bytes consumed
+};
+
+#endif
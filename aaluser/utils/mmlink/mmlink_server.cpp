@@ -50,6 +50,8 @@
 #include <netinet/tcp.h>
 #include <stdarg.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/param.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
@@ -75,7 +77,8 @@ using namespace AAL;
 #define ERR(x) std::cerr << __AAL_SHORT_FILE__ << ':' << __LINE__ << ':' << __AAL_FUNC__ << "() **Error : " << x << std::endl
 
 
-mmlink_server::mmlink_server(struct sockaddr_in *sock, mm_debug_link_interface *driver)
+mmlink_server::mmlink_server(struct sockaddr_in *sock, mm_debug_link_interface *driver) :
+  m_t2h(T2H_RING_SIZE)
 {
   m_addr = *sock;
 
@@ -94,6 +97,12 @@ mmlink_server::mmlink_server(struct sockaddr_in *sock, mm_debug_link_interface *
 
   m_listen = -1;
 
+  m_idle_polls = 0;
+  m_epoll = -1;
+  m_wake = eventfd(0, 0);
+  m_listening = false;
+  m_host_events = 0;
+
 #ifdef ENABLE_MMLINK_STATS
   m_h2t_stats = new mmlink_stats("h2t");
   m_t2h_stats = new mmlink_stats("t2h");
@@ -114,6 +123,12 @@ mmlink_server::~mmlink_server()
   if ( -1 != m_listen ) {
     close(m_listen);
   }
+  if ( -1 != m_epoll ) {
+    close(m_epoll);
+  }
+  if ( -1 != m_wake ) {
+    close(m_wake);
+  }
 
 #ifdef ENABLE_MMLINK_STATS
   delete m_h2t_stats; m_h2t_stats = NULL;
@@ -145,6 +160,55 @@ int mmlink_server::setup_listen_socket(void)
   return 0;
 }
 
+void mmlink_server::stop(void)
+{
+  m_running = false;
+
+  // Wake run() if it is blocked in epoll_wait().
+  uint64_t one = 1;
+  ssize_t res = ::write(m_wake, &one, sizeof(one));
+  (void)res;
+}
+
+int mmlink_server::watch(int op, int fd, unsigned events)
+{
+  struct epoll_event ev;
+
+  memset(&ev, 0, sizeof(ev));
+  ev.events = events;
+  ev.data.fd = fd;
+
+  if (epoll_ctl(m_epoll, op, fd, &ev) < 0)
+  {
+    fprintf(stderr, "epoll_ctl(%d, %d) failed: %d (%s)\n", op, fd, errno, strerror(errno));
+    return errno;
+  }
+  return 0;
+}
+
+// epoll_wait() timeout for the next pass.
+//   No data connection: nothing to poll, so sleep until a socket event.
+//   Otherwise the debug link FIFO must be polled. Poll back to back while
+//   data is flowing, then back off exponentially to MAX_POLL_MSEC.
+int mmlink_server::poll_timeout(mmlink_connection *data_conn)
+{
+  if (!data_conn)
+    return -1;
+
+  // The ring is full: nothing moves until the host socket drains it.
+  if (m_t2h.full() && !m_h2t_pending)
+    return -1;
+
+  if (m_idle_polls < SPIN_POLLS)
+    return 0;
+
+  int msec = 1;
+  for (unsigned i = SPIN_POLLS; i < m_idle_polls && msec < MAX_POLL_MSEC; ++i)
+    msec <<= 1;
+
+  return MIN(msec, MAX_POLL_MSEC);
+}
+
 int mmlink_server::run(btVirtAddr stpAddr)
 {
   int err = 0;
@@ -156,11 +220,6 @@ int mmlink_server::run(btVirtAddr stpAddr)
     return err;
   }
 
-  // Todo: modulate timeout based on number of connections, expectation of data.
-  struct timeval tv;
-  tv.tv_sec  = 0;
-  tv.tv_usec = 1000;
-
   if (setup_listen_socket())
   {
     fprintf(stderr, "setup_listen_socket() failed\n");
@@ -179,69 +238,73 @@ int mmlink_server::run(btVirtAddr stpAddr)
     return errno;
   }
 
+  // Pick up the port the kernel chose, if port 0 was requested.
+  socklen_t addr_len = sizeof(m_addr);
+  getsockname(m_listen, (struct sockaddr *)&m_addr, &addr_len);
+
   printf("listening on ip: %s; port: %d\n", inet_ntoa(m_addr.sin_addr),
     htons(m_addr.sin_port));
 
-  while (m_running)
+  m_epoll = epoll_create(MAX_EVENTS);
+  if (m_epoll < 0 || m_wake < 0)
   {
-    fd_set readfds, writefds;
-    FD_ZERO(&readfds);
-    FD_ZERO(&writefds);
+    fprintf(stderr, "epoll setup failed: %d (%s)\n", errno, strerror(errno));
+    return errno;
+  }
 
-    int max_fd = -1;
-    // Listen for more connections, if needed.
-    if (m_num_connections < MAX_CONNECTIONS)
-    {
-      FD_SET(m_listen, &readfds);
-      max_fd = MAX(m_listen, max_fd);
-    }
+  if (watch(EPOLL_CTL_ADD, m_wake, EPOLLIN) || watch(EPOLL_CTL_ADD, m_listen, EPOLLIN))
+  {
+    return -1;
+  }
+  m_listening = true;
 
-    // Listen for read on all connections.
-    for (int i = 0; i < MAX_CONNECTIONS; ++i)
+  while (m_running)
+  {
+    // Listen for more connections, if needed.
+    bool want_listen = m_num_connections < MAX_CONNECTIONS;
+    if (want_listen != m_listening)
     {
-      mmlink_connection *pc = *(m_conn + i);
-      if (pc->is_open())
-      {
-        int fd = pc->socket();
-        FD_SET(fd, &readfds);
-
-        max_fd = MAX(fd, max_fd);
-      }
+      watch(EPOLL_CTL_MOD, m_listen, want_listen ? EPOLLIN : 0);
+      m_listening = want_listen;
     }
 
-    // If we have a data socket, listen for read and write on the driver fd.
     mmlink_connection *data_conn = get_data_connection();
-    if (data_conn)
-    {
-      int driver_fd = m_driver->get_fd();
-      int host_fd = data_conn->socket();
-
-      // Listen for read on the driver fd.
-      //   responses from the driver fd are written to the host via the data socket.
-      FD_SET(driver_fd, &readfds);
-
-      // Listen for write on the driver fd.
-      //   Host commands from the data socket are written to this fd.
-      FD_SET(driver_fd, &writefds);
 
-      max_fd = MAX(driver_fd, max_fd);
-
-      // Listen for write on the host
-      //   Data from the driver are written here.
-      FD_SET(host_fd, &writefds);
-      max_fd = MAX(host_fd, max_fd);
+    struct epoll_event events[MAX_EVENTS];
+    int nevents = epoll_wait(m_epoll, events, MAX_EVENTS, poll_timeout(data_conn));
+    if (nevents < 0)
+    {
+      fprintf(stderr, "epoll_wait error: %d (%s)\n", errno, strerror(errno));
+      break;
     }
 
-    tv.tv_sec  = 0;
-    tv.tv_usec = 1000;
-    if (select(max_fd + 1, &readfds, &writefds, NULL, &tv) < 0)
+    bool can_accept = false;
+    unsigned conn_events[MAX_CONNECTIONS];
+    memset(conn_events, 0, sizeof(conn_events));
+
+    for (int e = 0; e < nevents; ++e)
     {
-      fprintf(stderr, "select error: %d (%s)\n", errno, strerror(errno));
-      break;
+      int fd = events[e].data.fd;
+      if (fd == m_wake)
+      {
+        uint64_t count;
+        ssize_t res = ::read(m_wake, &count, sizeof(count));
+        (void)res;
+      }
+      else if (fd == m_listen)
+      {
+        can_accept = true;
+      }
+      else
+      {
+        for (int i = 0; i < MAX_CONNECTIONS; ++i)
+          if (m_conn[i]->is_open() && m_conn[i]->socket() == fd)
+            conn_events[i] = events[e].events;
+      }
     }
 
     // Handle new connection attempts.
-    if (FD_ISSET(m_listen, &readfds))
+    if (can_accept)
     {
       mmlink_connection *pc = handle_accept();
       // If a new connection was accepted, send the welcome string.
@@ -249,6 +312,7 @@ int mmlink_server::run(btVirtAddr stpAddr)
       {
         char msg[256];
 
+        watch(EPOLL_CTL_ADD, pc->socket(), EPOLLIN);
         get_welcome_message(msg, sizeof(msg) / sizeof(*msg));
         // to do:spin until all bytes sent.
         pc->send(msg, strlen(msg));
@@ -258,29 +322,47 @@ int mmlink_server::run(btVirtAddr stpAddr)
     // Transfer response data from the driver to the data socket.
     if (data_conn)
     {
-      bool can_write_host = FD_ISSET(data_conn->socket(), &writefds);
-      //bool can_read_driver = FD_ISSET(m_driver->get_fd(), &readfds);
-      bool can_read_driver = m_driver->can_read_data();
-      err = handle_t2h(data_conn, can_read_driver, can_write_host); //TODO add logic to check if driver has data to be read
+      unsigned revents = 0;
+      for (int i = 0; i < MAX_CONNECTIONS; ++i)
+        if (m_conn[i] == data_conn)
+          revents = conn_events[i];
 
-      if (err)
-        break;
+      bool can_write_host = (revents & EPOLLOUT) != 0;
+      bool can_read_host = (revents & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0;
 
-      // Transfer command data from the data socket to the driver.
-      //bool can_write_driver = FD_ISSET(m_driver->get_fd(), &writefds);
-      bool can_write_driver = true;
-      bool can_read_host = FD_ISSET(data_conn->socket(), &readfds);
-      err = handle_h2t(data_conn, can_read_host, can_write_driver); //TODO add logic to check if host has data to be written to driver
+      int moved = handle_t2h(data_conn, can_write_host);
+      if (moved >= 0)
+      {
+        // Transfer command data from the data socket to the driver.
+        int written = handle_h2t(data_conn, can_read_host);
+        moved = (written < 0) ? written : moved + written;
+      }
 
-      if (err < 0)
+      if (moved < 0)
       {
         m_num_connections--;
         data_conn->close_connection();
-        printf("closed data connection due to handle_h2t return value, now have %d\n", m_num_connections);
+        m_t2h_pending = false;
+        printf("closed data connection due to data transfer error, now have %d\n", m_num_connections);
+      }
+      else
+      {
+        // Any traffic, including a host command that should draw a response,
+        // restarts back-to-back polling of the FIFO.
+        if (moved > 0)
+          m_idle_polls = 0;
+        else if (m_idle_polls < SPIN_POLLS + 32)
+          ++m_idle_polls;
+
+        // Read from the host only while there is room to buffer its data, and
+        // ask for EPOLLOUT only while t2h data is backed up.
+        unsigned host_events = (data_conn->buf_full() ? 0 : EPOLLIN) | (m_t2h_pending ? EPOLLOUT : 0);
+        if (host_events != m_host_events)
+        {
+          watch(EPOLL_CTL_MOD, data_conn->socket(), host_events);
+          m_host_events = host_events;
+        }
       }
-
-      // Yield after done process the current known acitivty
-      ::sched_yield();
     }
 
     // Handle management connection commands and responses.
@@ -296,7 +378,7 @@ int mmlink_server::run(btVirtAddr stpAddr)
 		 continue;
 	   }
 
-      if (FD_ISSET(pc->socket(), &readfds))
+      if (conn_events[i] & (EPOLLIN | EPOLLHUP | EPOLLERR))
       {
         int fail = pc->handle_receive();
         if (fail)
@@ -322,6 +404,9 @@ int mmlink_server::run(btVirtAddr stpAddr)
             // A management connection was converted to data. There can be only one.
             close_other_data_connection(pc);
             m_h2t_pending = true;
+            m_t2h_pending = false;
+            m_host_events = EPOLLIN;
+            m_idle_polls = 0;
           }
         }
       }
@@ -453,115 +538,86 @@ mmlink_connection *mmlink_server::get_data_connection(void)
   return NULL;
 }
 
-int mmlink_server::handle_t2h(mmlink_connection *data_conn, bool can_read_driver, bool can_write_host)
+// Drain the debug link FIFO into the t2h ring, then hand whatever the ring
+// holds to the data socket in one vectored send.
+// return value: bytes moved, or negative on a socket error.
+int mmlink_server::handle_t2h(mmlink_connection *data_conn, bool can_write_host)
 {
-  int err = 0;
-  bool socket_error = false;
-  bool t2h_ready = m_t2h_pending ? can_write_host : can_read_driver;
+  int moved = 0;
 
-  static bool printed8 = false;
-
-  if (!t2h_ready)
+  while (!m_t2h.full())
   {
-    return 0;
-  }
+    size_t len;
+    char *p = m_t2h.write_ptr(&len);
+    ssize_t count = m_driver->read(p, len);
+    if (count <= 0)
+      break;
 
-  // Try to get more data.
-  if (can_read_driver)
-  {
-    m_driver->read();
+    m_t2h.commit(count);
+    moved += count;
+    if ((size_t)count < len)
+      break;
   }
-  if (m_driver->is_empty())
+
+  if (m_t2h.empty())
   {
     // Still no t2h data; done here.
     m_t2h_pending = false;
-    return 0;
+    return moved;
   }
 
-  // Handle response data from the driver.
-  if (can_write_host && data_conn && m_driver->flush_request())
+  if (m_t2h_pending && !can_write_host)
   {
-    // Send the data to the data socket.
-    int total_sent = 0;
-
-    while (total_sent < m_driver->buf_end())
-    {
-      ssize_t sent = data_conn->send(m_driver->buf() + total_sent, m_driver->buf_end() - total_sent);
-      // printf("t2h sent: %u (%d of %d)\n", sent, total_sent, m_driver->buf_end());
-
-//      if (sent == 8 && !printed8)
-//      {
-//        // printed8 = true;
-//        for (int i = 0; i < sent; ++i)
-//        {
-//          printf_RAW("0x%02X; ", m_driver->buf()[i]);
-//        }
-//        printf_RAW("\n");
-//      }
-
-      if (sent < 0)
-      {
-        if (errno == EAGAIN)
-        {
-          // Try again later.
-          break;
-        }
-        else
-        {
-          // Socket error, disconnected?
-          socket_error = true;
-          break;
-        }
-      }
-      if (sent == 0)
-      {
-        // Didn't send all data; Try to send the remaining data later.
-        break;
-      }
-
-      total_sent += sent;
-    }
+    // The socket was full last time; wait for EPOLLOUT.
+    return moved;
+  }
 
-    if (total_sent > 0)
-      m_t2h_stats->update(total_sent, m_driver->buf());
+  struct iovec iov[2];
+  int iovcnt = m_t2h.read_iov(iov);
+  ssize_t sent = data_conn->sendv(iov, iovcnt);
 
-    int rem = m_driver->buf_end() - total_sent;
-    if (rem > 0)
+  if (sent < 0)
+  {
+    if (errno != EAGAIN && errno != EWOULDBLOCK)
     {
-      printf("t2h rem: %d; total_sent: %d; m_h2t_pending: %d\n", rem, total_sent, m_t2h_pending);
-      if (total_sent > 0)
-      {
-        m_t2h_pending = true;
-        memmove(m_driver->buf(), m_driver->buf() + total_sent, rem);
-      }
+      // Socket error, disconnected?
+      fprintf(stderr, "t2h send failed: %d (%s)\n", errno, strerror(errno));
+      return -1;
     }
-    m_driver->buf_end(rem);
+    sent = 0;
   }
 
-  if (socket_error || !data_conn)
+  for (int i = 0, rem = sent; i < iovcnt && rem > 0; ++i)
   {
-    // We didn't have a data connection in the first place, or an error
-    // has occurred on the data connection.
-    fprintf(stderr, "hardware returned data but there's no data socket\n");
-    err = -1;
+    int n = MIN(rem, (int)iov[i].iov_len);
+    m_t2h_stats->update(n, (char *)iov[i].iov_base);
+    rem -= n;
   }
 
-  return err;
+  m_t2h.consume(sent);
+  moved += sent;
+
+  // Anything left waits for the socket to drain.
+  m_t2h_pending = !m_t2h.empty();
+
+  return moved;
 }
 
-int mmlink_server::handle_h2t(mmlink_connection *data_conn, bool can_read_host, bool can_write_driver)
+// Move host command data from the data socket to the debug link write FIFO,
+// as far as the FIFO has room.
+// return value: bytes received plus bytes written to the driver, or negative
+// on a socket error.
+int mmlink_server::handle_h2t(mmlink_connection *data_conn, bool can_read_host)
 {
   int err = 0;
 
-  bool h2t_ready = m_h2t_pending ? can_write_driver : can_read_host;
-  if (!h2t_ready)
+  if (!m_h2t_pending && !can_read_host)
   {
     return 0;
   }
 
-  // printf("h2t_ready: m_h2t_pending: %d; can_read_host: %d; can_write_driver: %d\n", m_h2t_pending, can_read_host, can_write_driver);
-
   // If no stored data, try to get some.
+  size_t received = data_conn->buf_end();
   if (can_read_host)
   {
     err = data_conn->handle_receive();
@@ -570,6 +626,7 @@ int mmlink_server::handle_h2t(mmlink_connection *data_conn, bool can_read_host,
       return err;
     }
   }
+  received = data_conn->buf_end() - received;
 
   if (data_conn->buf_end() == 0)
   {
@@ -578,63 +635,30 @@ int mmlink_server::handle_h2t(mmlink_connection *data_conn, bool can_read_host,
     return 0;
   }
 
-  if (!can_write_driver)
-    return 0;
-
-  // Handle command data from the data socket.
+  // Handle command data from the data socket. The driver accepts only what
+  // its write FIFO has room for, and returns 0 once the FIFO is full.
   int total_sent = 0;
-  bool socket_error = false;
   while (total_sent < data_conn->buf_end())
   {
     ssize_t sent = m_driver->write(data_conn->buf() + total_sent, data_conn->buf_end() - total_sent);
-    if (sent < 0)
-    {
-      if (errno == EAGAIN)
-      {
-        // Try again later
-        printf("handle_h2t(): driver returned EAGAIN\n");
-        break;
-      }
-      else
-      {
-        // Not sure if this can happen.
-        printf("handle_h2t(): driver returned error %d (%s)\n", errno, strerror(errno));
-      }
-    }
-    if (sent == 0)
+    if (sent <= 0)
     {
-      // Didn't send all data; Try to send the remaining data later.
       break;
     }
     total_sent += sent;
   }
-//  if (total_sent > 0)
-//  {
-//    printf("sent on %d: %d bytes\n", data_conn->socket(), total_sent);
-//    for (int i = 0; i < total_sent; ++i)
-//    {
-//      unsigned char the_byte = data_conn->buf()[i];
-//      printf_RAW("%s\\x%02X", (the_byte == 0x7C) ? "\n" : "", the_byte);
-//    }
-//    printf_RAW("\n");
-//  }
 
   if (total_sent > 0)
     m_h2t_stats->update(total_sent, data_conn->buf());
 
   int rem = data_conn->buf_end() - total_sent;
-  if (rem > 0)
+  // Leftover data waits for room in the write FIFO.
+  m_h2t_pending = rem > 0;
+  if (rem > 0 && total_sent > 0)
   {
-    // printf("h2t rem: %d; total_sent: %d; m_h2t_pending: %d\n", rem, total_sent, m_h2t_pending);
-    m_h2t_pending = true;
-    if (total_sent > 0)
-    {
-      // memmove(data_conn->buf(), data_conn->buf() + data_conn->buf_end(), rem);
-      memmove(data_conn->buf(), data_conn->buf() + total_sent, rem);
-    }
+    memmove(data_conn->buf(), data_conn->buf() + total_sent, rem);
   }
   data_conn->buf_end(rem);
 
-  return err;
+  return received + total_sent;
 }
-
@@ -52,6 +52,8 @@
 #include <string.h>
 #include <sys/param.h>
 
+#include "mmlink_ring.h"
+
 class mmlink_connection;
 class mm_debug_link_interface;
 
@@ -63,8 +65,10 @@ public:
   mmlink_server(struct sockaddr_in *sock, mm_debug_link_interface *driver);
   ~mmlink_server();
   int run(btVirtAddr stpAddr);
-  void stop(void) { m_running = false; }
+  void stop(void);
   int get_server_id(void) { return m_server_id; }
+  // The bound port; differs from the requested one when that was 0.
+  int get_port(void) { return ntohs(m_addr.sin_port); }
   mm_debug_link_interface *get_driver_fd(void) { return m_driver; }
   void print_stats(void);
 
@@ -76,13 +80,33 @@ private:
   int m_num_bound_connections;
   int m_num_connections;
 
+  // Size of the t2h ring between the debug link FIFO and the data socket.
+  static const size_t T2H_RING_SIZE = 256 * 1024;
+  // The debug link has no interrupt, so its FIFO level is polled: back to
+  // back for SPIN_POLLS idle passes after any traffic, then with a timeout
+  // that doubles from 1 ms up to MAX_POLL_MSEC.
+  static const unsigned SPIN_POLLS = 256;
+  static const int MAX_POLL_MSEC = 32;
+  static const int MAX_EVENTS = MAX_CONNECTIONS + 2;
+
+  // t2h data is waiting for the data socket to become writable.
   bool m_t2h_pending;
+  // h2t data is waiting for space in the debug link write FIFO.
   bool m_h2t_pending;
-  int handle_t2h(mmlink_connection *data_conn, bool can_read_driver, bool can_write_host);
-  int handle_h2t(mmlink_connection *data_conn, bool can_read_host, bool can_write_driver);
+  mmlink_ring m_t2h;
+  unsigned m_idle_polls;
+  int handle_t2h(mmlink_connection *data_conn, bool can_write_host);
+  int handle_h2t(mmlink_connection *data_conn, bool can_read_host);
+  int poll_timeout(mmlink_connection *data_conn);
 
   struct sockaddr_in m_addr;
-  bool m_running;
+  volatile bool m_running;
+
+  int m_epoll;
+  int m_wake;
+  bool m_listening;
+  unsigned m_host_events;
+  int watch(int op, int fd, unsigned events);
 
   mm_debug_link_interface *m_driver;
 
@@ -120,6 +120,7 @@ enum wstype
    WSM_TYPE_CSR,
    WSM_TYPE_MMIO
 };
+struct aaldev_ownerSession; //forward reference
 struct aal_wsid
 {
    struct aal_device *m_device;     // Device
@@ -129,9 +130,15 @@ struct aal_wsid
    kosal_map_handle   m_maphandle;  // Used by OS User mode mapping
    enum wstype        m_type;       // Type of allocation
    btWSSize           m_size;       // Size of workspace
+   btUnsignedInt      m_numa;       // NUMA node + 1 of a node-local allocation, else 0
    kosal_list_head    m_list;       // Device owner list it is on
-   /* chain of allocated workspace IDs; head is in ui_driver */
+   struct aaldev_ownerSession *m_owner; // Owner session whose list it is on
+   kosal_refcount     m_refs;       // One for the allocated table, one per lookup
+   /* hash chain of allocated workspace IDs; table is in ui_driver */
    kosal_list_head    m_alloc_list;
+#if defined( __AAL_LINUX__ )
+   kosal_rcu_head     m_rcu;        // Deferred free after removal from the table
+#endif
 };
 
 
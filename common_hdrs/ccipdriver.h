@@ -217,6 +217,7 @@ struct aalui_CCIdrvMessage
 # define AALUID_IOCTL_BINDDEV       _IOWR('x', 0x03, struct ccipui_ioctlreq)
 # define AALUID_IOCTL_ACTIVATEDEV   _IOWR('x', 0x04, struct ccipui_ioctlreq)
 # define AALUID_IOCTL_DEACTIVATEDEV _IOWR('x', 0x05, struct ccipui_ioctlreq)
+# define AALUID_IOCTL_SENDMSG_DIRECT _IOWR('x', 0x06, struct ccipui_ioctlreq)
 #elif defined( __AAL_WINDOWS__ )
 # ifdef __AAL_USER__
 #    include <winioctl.h>
@@ -271,19 +272,156 @@ struct ccipui_ioctlreq
 
 // TODO CASSERT( sizeof(struct ccipui_ioctlreq)
 
+//=============================================================================
+// Name: ccipui_directpayload
+// Description: Payload of an AALUID_IOCTL_SENDMSG_DIRECT request. The real
+//              payload stays in the caller's buffer; the driver reads the
+//              request from it and writes the response back into it, so the
+//              caller need not marshal a contiguous header + payload block.
+//=============================================================================
+struct ccipui_directpayload
+{
+   btUnsigned64bitInt addr;         // User address of the payload [IN/OUT]
+   btWSSize           size;         // Size of the payload buffer [IN]
+};
+
 #define aalui_ioAFUmessagep(i)   (struct aalui_CCIdrvMessage *)(i->payload )
 #define aalui_ioctlPayload(i)    ((void *)(i->payload))
 #define aalui_ioctlPayloadSize(i)   ((i)->size)
 
+#if defined( __AAL_LINUX__ )
+//=============================================================================
+// Name: ccipui_evtring
+// Description: Per-session upstream event ring shared with user mode.
+//
+// The application mmap()s the device at CCIPUI_EVTRING_MMAP_OFFSET for
+// sizeof(struct ccipui_evtring) bytes. The driver is the only producer and
+// the application the only consumer, so no lock is shared between them:
+//
+//  - head and tail are free running counters. The ring is empty when they
+//    are equal and full when head - tail == CCIPUI_EVTRING_SLOTS.
+//  - The producer fills slot [head % CCIPUI_EVTRING_SLOTS] and then
+//    publishes it by advancing head (ccipui_evtring_produce/publish).
+//  - The consumer reads slot [tail % CCIPUI_EVTRING_SLOTS] and then frees
+//    it by advancing tail (ccipui_evtring_peek/release).
+//
+// Events that do not fit in a slot, or arrive while the ring is full, are
+// delivered with GETMSG_DESC/GETMSG as before. To keep events in order the
+// driver only uses the ring while nothing is waiting for GETMSG, and
+// GETMSG_DESC fails with EAGAIN while the ring holds events. A consumer
+// therefore drains the ring, then tries GETMSG_DESC, then poll()s.
+//=============================================================================
+#define CCIPUI_EVTRING_MMAP_OFFSET  0
+#define CCIPUI_EVTRING_MAGIC        0x45565452   // 'EVTR'
+#define CCIPUI_EVTRING_SLOTS        64
+#define CCIPUI_EVTRING_SLOT_SIZE    256
+
+#if defined( __AAL_KERNEL__ )
+# define ccipui_evtring_rmb()       smp_rmb()
+# define ccipui_evtring_wmb()       smp_wmb()
+# define ccipui_evtring_mb()        smp_mb()
+#else
+# define ccipui_evtring_rmb()       __sync_synchronize()
+# define ccipui_evtring_wmb()       __sync_synchronize()
+# define ccipui_evtring_mb()        __sync_synchronize()
+#endif // __AAL_KERNEL__
+
+// Event header. The fields match those of struct ccipui_ioctlreq.
+struct ccipui_evthdr
+{
+   uid_msgIDs_e       id;
+   uid_errnum_e       errcode;
+   btHANDLE           handle;
+   btObjectType       context;
+   stTransactionID_t  tranID;
+   btWSSize           size;         // Size of payload
+};
+
+#define CCIPUI_EVTRING_PAYLOAD_MAX  (CCIPUI_EVTRING_SLOT_SIZE - sizeof(struct ccipui_evthdr))
+
+struct ccipui_evtslot
+{
+   struct ccipui_evthdr hdr;
+   btByte               payload[CCIPUI_EVTRING_PAYLOAD_MAX];
+};
+
+struct ccipui_evtring
+{
+   btUnsigned32bitInt          magic;      // CCIPUI_EVTRING_MAGIC
+   btUnsigned32bitInt          nslots;     // CCIPUI_EVTRING_SLOTS
+   btUnsigned64bitInt          rsvd0[7];
+   volatile btUnsigned64bitInt head;       // Written by the producer only
+   btUnsigned64bitInt          rsvd1[7];   // head and tail in separate cache lines
+   volatile btUnsigned64bitInt tail;       // Written by the consumer only
+   btUnsigned64bitInt          rsvd2[15];
+   struct ccipui_evtslot       slots[CCIPUI_EVTRING_SLOTS];
+};
+
+static inline void ccipui_evtring_init(struct ccipui_evtring *pring)
+{
+   pring->magic  = CCIPUI_EVTRING_MAGIC;
+   pring->nslots = CCIPUI_EVTRING_SLOTS;
+   pring->head   = 0;
+   pring->tail   = 0;
+}
+
+static inline int ccipui_evtring_empty(const struct ccipui_evtring *pring)
+{
+   return pring->head == pring->tail;
+}
+
+// Producer: the slot to fill, or NULL if the ring is full.
+static inline struct ccipui_evtslot * ccipui_evtring_produce(struct ccipui_evtring *pring)
+{
+   btUnsigned64bitInt head = pring->head;
+
+   // Slots are indexed by the constant, never by nslots, so a consumer
+   //  scribbling on the ring cannot steer the producer out of bounds.
+   if ( head - pring->tail >= CCIPUI_EVTRING_SLOTS ) {
+      return NULL;
+   }
+   // The consumer's reads of the slot precede its update of tail.
+   ccipui_evtring_mb();
+   return &pring->slots[head % CCIPUI_EVTRING_SLOTS];
+}
+
+// Producer: make the slot from ccipui_evtring_produce() visible.
+static inline void ccipui_evtring_publish(struct ccipui_evtring *pring)
+{
+   ccipui_evtring_wmb();
+   pring->head = pring->head + 1;
+}
+
+// Consumer: the oldest unread slot, or NULL if the ring is empty.
+static inline struct ccipui_evtslot * ccipui_evtring_peek(struct ccipui_evtring *pring)
+{
+   btUnsigned64bitInt tail = pring->tail;
+
+   if ( pring->head == tail ) {
+      return NULL;
+   }
+   ccipui_evtring_rmb();
+   return &pring->slots[tail % CCIPUI_EVTRING_SLOTS];
+}
+
+// Consumer: hand the slot from ccipui_evtring_peek() back to the producer.
+static inline void ccipui_evtring_release(struct ccipui_evtring *pring)
+{
+   ccipui_evtring_mb();
+   pring->tail = pring->tail + 1;
+}
+#endif // __AAL_LINUX__
+
 
 struct ahm_req
 {
    union {
       // mem_alloc
       struct {
-         btWSID   m_wsid;     // IN
-         btWSSize m_size;     // IN
-         btWSSize m_pgsize;
+         btWSID             m_wsid;     // IN
+         btWSSize           m_size;     // IN
+         btWSSize           m_pgsize;
+         btUnsigned32bitInt m_numa;     // IN NUMA node + 1, 0 for the device's own placement
       } wksp;
 
       // Special workspace IDs for CSR Aperture mapping
@@ -292,6 +430,7 @@ struct ahm_req
 #define WSID_CSRMAP_WRITEAREA 0x00000002
 #define WSID_MAP_MMIOR        0x00000003
 #define WSID_MAP_UMSG         0x00000004
+#define WSID_MAP_PERFSNAP     0x00000005
       // mem_get_cookie
       struct {
          btWSID             m_wsid;   /* IN  */
@@ -623,6 +762,110 @@ struct  CCIP_PERF_COUNTERS
 
 
 };
+
+#if defined( __AAL_LINUX__ )
+//=============================================================================
+// Name: ccipui_perfsnap
+// Description: Cached performance counter snapshots, shared with user mode.
+//
+// Freezing and reading the FME performance counters is slow and serializes
+// every reader, so the driver takes at most one snapshot per perfmon_interval
+// milliseconds and hands the latest one to all readers. The cache is double
+// buffered: gen counts the snapshots published so far and buf[gen & 1] holds
+// the latest one.
+//
+//  - The writer fills buf[(gen + 1) & 1] and then publishes it by advancing
+//    gen (ccipui_perfsnap_publish). There is only one writer at a time.
+//  - A reader copies buf[gen & 1] and retries if gen moved meanwhile
+//    (ccipui_perfsnap_read), so readers never block the writer or each other.
+//
+// The FME's perfmon page is mapped read-only by requesting WSID_MAP_PERFSNAP
+// with ccipdrv_getMMIORmap. Values are in struct CCIP_PERF_COUNTERS order and
+// tstamp is CLOCK_MONOTONIC, in ns.
+//=============================================================================
+#define CCIPUI_PERFSNAP_MAGIC       0x50534e50   // 'PSNP'
+#define CCIPUI_PERFSNAP_VALUES      (sizeof(struct CCIP_PERF_COUNTERS) / sizeof(struct PERFCOUNTER_EVENT))
+
+#if defined( __AAL_KERNEL__ )
+# define ccipui_perfsnap_rmb()      smp_rmb()
+# define ccipui_perfsnap_wmb()      smp_wmb()
+#else
+# define ccipui_perfsnap_rmb()      __sync_synchronize()
+# define ccipui_perfsnap_wmb()      __sync_synchronize()
+#endif // __AAL_KERNEL__
+
+struct ccipui_perfsnap_buf
+{
+   btUnsigned64bitInt          tstamp;     // When the counters were read, ns
+   btUnsigned64bitInt          values[CCIPUI_PERFSNAP_VALUES];
+};
+
+struct ccipui_perfsnap
+{
+   btUnsigned32bitInt          magic;      // CCIPUI_PERFSNAP_MAGIC
+   btUnsigned32bitInt          nvalues;    // CCIPUI_PERFSNAP_VALUES
+   btUnsigned32bitInt          interval;   // Minimum ms between snapshots
+   btUnsigned32bitInt          rsvd0;
+   volatile btUnsigned64bitInt gen;        // Snapshots published, 0 = none yet
+   btUnsigned64bitInt          rsvd1[5];
+   struct ccipui_perfsnap_buf  buf[2];
+};
+
+static inline void ccipui_perfsnap_init(struct ccipui_perfsnap *psnap, btUnsigned32bitInt interval)
+{
+   unsigned i;
+
+   psnap->magic    = CCIPUI_PERFSNAP_MAGIC;
+   psnap->nvalues  = CCIPUI_PERFSNAP_VALUES;
+   psnap->interval = interval;
+   psnap->rsvd0    = 0;
+   psnap->gen      = 0;
+   for ( i = 0 ; i < sizeof(psnap->rsvd1) / sizeof(psnap->rsvd1[0]) ; ++i ) {
+      psnap->rsvd1[i] = 0;
+   }
+}
+
+// Writer: the buffer to fill with the next snapshot.
+static inline struct ccipui_perfsnap_buf * ccipui_perfsnap_next(struct ccipui_perfsnap *psnap)
+{
+   return &psnap->buf[(psnap->gen + 1) & 1];
+}
+
+// Writer: make the buffer from ccipui_perfsnap_next() the latest snapshot.
+static inline void ccipui_perfsnap_publish(struct ccipui_perfsnap *psnap)
+{
+   ccipui_perfsnap_wmb();
+   psnap->gen = psnap->gen + 1;
+}
+
+// Reader: copy the latest snapshot into *pbuf. Returns its generation, or 0
+//  if nothing has been published yet.
+static inline btUnsigned64bitInt ccipui_perfsnap_read(const struct ccipui_perfsnap *psnap,
+                                                      struct ccipui_perfsnap_buf   *pbuf)
+{
+   const struct ccipui_perfsnap_buf *psrc;
+   btUnsigned64bitInt                gen;
+   unsigned                          i;
+
+   do {
+      gen = psnap->gen;
+      if ( 0 == gen ) {
+         return 0;
+      }
+      ccipui_perfsnap_rmb();
+      psrc = &psnap->buf[gen & 1];
+      pbuf->tstamp = psrc->tstamp;
+      for ( i = 0 ; i < CCIPUI_PERFSNAP_VALUES ; ++i ) {
+         pbuf->values[i] = psrc->values[i];
+      }
+      ccipui_perfsnap_rmb();
+      // The writer starts on buf[gen & 1] again as soon as gen advances, so
+      //  any change means this copy may have raced it.
+   } while ( gen != psnap->gen );
+
+   return gen;
+}
+#endif // __AAL_LINUX__
 END_C_DECLS
 
 END_NAMESPACE(AAL)
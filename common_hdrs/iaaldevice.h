@@ -375,7 +375,10 @@ struct aaldev_ownerSession {
 #define aalsess_aalpipp(os)         (aaldev_pipp( aalsess_aaldevicep(os) ) )
 #define aalsess_pipHandle(os)       ((os)->m_PIPHandle)
 #define aalsess_uiHandle(os)        ((os)->m_UIHandle)
-#define aalsess_add_ws(os,ih)       kosal_list_add_head(&ih, &(os)->m_wshead);
+#define aalsess_add_ws(os,ih)       do{ kosal_list_add_head(&ih, &(os)->m_wshead); \
+                                        kosal_container_of(&ih, struct aal_wsid, m_list)->m_owner = (os); }while(0)
+#define aalsess_del_ws(ih)          do{ kosal_list_del_init(&ih); \
+                                        kosal_container_of(&ih, struct aal_wsid, m_list)->m_owner = NULL; }while(0)
 
 //=============================================================================
 // Name: aaldevice_interface
@@ -853,6 +853,57 @@ do                                                \
 #define kosal_list_entry(_ptr, _type, _memb)      kosal_container_of(_ptr, _type, _memb)
 #define kosal_list_get_object(_ptr, _type, _memb) kosal_container_of(_ptr, _type, _memb)
 
+//
+// RCU-protected lists (readers take no lock; writers serialize themselves)
+//
+#if   defined( __AAL_LINUX__ )
+# if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,26)
+#    include <linux/rculist.h>
+# endif // >= KERNEL_VERSION(2,6,26)
+# include <linux/rcupdate.h>
+  typedef struct rcu_head kosal_rcu_head;
+# define kosal_rcu_read_lock()                                    rcu_read_lock()
+# define kosal_rcu_read_unlock()                                  rcu_read_unlock()
+# define kosal_call_rcu(_head, _func)                             call_rcu(_head, _func)
+# define kosal_rcu_barrier()                                      rcu_barrier()
+# define kosal_list_add_head_rcu(_new, _h)                        list_add_rcu(_new, _h)
+# define kosal_list_del_rcu(_h)                                   list_del_rcu(_h)
+# define kosal_list_for_each_entry_rcu(_pos, _h, _memb, _cont_t)  list_for_each_entry_rcu(_pos, _h, _memb)
+#endif // OS
+
+//
+// Reference counts
+//
+#if   defined( __AAL_LINUX__ )
+# if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,37)
+#    include <linux/atomic.h>
+# else
+#    include <asm/atomic.h>
+# endif // >= KERNEL_VERSION(2,6,37)
+  typedef atomic_t kosal_refcount;
+# define kosal_refcount_set(_r, _v)       atomic_set(_r, _v)
+// Take a reference unless the count has already dropped to zero. Returns true if taken.
+# define kosal_refcount_inc_not_zero(_r)  atomic_inc_not_zero(_r)
+// Drop a reference. Returns true if it was the last.
+# define kosal_refcount_dec_and_test(_r)  atomic_dec_and_test(_r)
+#elif defined( __AAL_WINDOWS__ )
+  typedef LONG volatile kosal_refcount;
+# define kosal_refcount_set(_r, _v)       InterlockedExchange(_r, _v)
+static inline
+KOSAL_BOOL kosal_refcount_inc_not_zero(kosal_refcount *r) {
+   LONG __c = *r;
+   while ( 0 != __c ) {
+      LONG __p = InterlockedCompareExchange(r, __c + 1, __c);
+      if ( __p == __c ) {
+         return TRUE;
+      }
+      __c = __p;
+   }
+   return FALSE;
+}
+# define kosal_refcount_dec_and_test(_r)  ( 0 == InterlockedDecrement(_r) )
+#endif // OS
+
 
 //
 // Memory
@@ -915,6 +966,18 @@ void _kosal_free_dma_coherent(__ASSERT_HERE_PROTO  KOSAL_HANDLE , KOSAL_VIRT , K
 #    undef _kosal_free_dma_coherent
 # endif // _kosal_free_dma_coherent
 # define kosal_free_dma_coherent(__devhandle, __ptr , __size, __dmahandle) _kosal_free_dma_coherent(__ASSERT_HERE_ARGS __devhandle, __ptr, __size, __dmahandle)
+
+KOSAL_VIRT _kosal_alloc_dma_node(__ASSERT_HERE_PROTO KOSAL_HANDLE , KOSAL_WSSIZE , int , KOSAL_HANDLE *);
+#ifdef kosal_alloc_dma_node
+# undef kosal_alloc_dma_node
+#endif // kosal_alloc_dma_node
+#define kosal_alloc_dma_node(__devhandle, __size, __node, __pdmahandle) _kosal_alloc_dma_node(__ASSERT_HERE_ARGS __devhandle, __size, __node, __pdmahandle)
+
+void _kosal_free_dma_node(__ASSERT_HERE_PROTO KOSAL_HANDLE , KOSAL_VIRT , KOSAL_WSSIZE , KOSAL_HANDLE );
+#ifdef kosal_free_dma_node
+# undef kosal_free_dma_node
+#endif // kosal_free_dma_node
+#define kosal_free_dma_node(__devhandle, __ptr, __size, __dmahandle) _kosal_free_dma_node(__ASSERT_HERE_ARGS __devhandle, __ptr, __size, __dmahandle)
 //
 // Work queue
 //
@@ -0,0 +1,228 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// file ASEAddrBench.c
+/// brief ASE address translation benchmark.
+/// ingroup ASEAddrBench
+/// verbatim
+/// Accelerator Abstraction Layer Test Application
+///
+/// Replays a synthetic DPI memory trace against the ASE buffer index
+/// (ll_search_physaddr(), as used by ase_fakeaddr_to_vaddr()) and against
+/// a walk of the buffer linked list, as ASE used to translate. The trace
+/// is mostly streaming bursts of cache lines within one buffer, with
+/// random single-line accesses mixed in. Both lookups must agree.
+///
+/// Reports ns/lookup for several buffer counts, before and after half of
+/// the buffers are deallocated.
+///
+/// Usage: ASEAddrBench [trace length]
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version. endverbatim
+//****************************************************************************
+#define _GNU_SOURCE
+
+#include "ase_common.h"
+
+#define BENCH_BUFSIZE     (2*1024*1024)
+#define BENCH_PADDR_SPAN  ((uint64_t)1 << 38)
+#define BENCH_BURST       64
+
+static uint64_t seed = 0x2545F4914F6CDD1DULL;
+
+static uint64_t bench_rand()
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 7;
+  seed ^= seed << 17;
+  return seed;
+}
+
+// Buffer list walk, as ase_fakeaddr_to_vaddr() did
+static struct buffer_t *linear_lookup(uint64_t paddr)
+{
+  struct buffer_t *trav_ptr = head;
+
+  while (trav_ptr != NULL)
+    {
+      if ((paddr >= trav_ptr->fake_paddr) && (paddr < trav_ptr->fake_paddr_hi))
+        return trav_ptr;
+      trav_ptr = trav_ptr->next;
+    }
+  return NULL;
+}
+
+// Allocate nbufs buffers with unique, non-overlapping fake addresses
+static struct buffer_t **make_buffers(int nbufs)
+{
+  struct buffer_t **bufs;
+  uint64_t paddr;
+  int ii;
+
+  bufs = (struct buffer_t **)ase_malloc(nbufs * sizeof(struct buffer_t *));
+  for (ii = 0; ii < nbufs; ii = ii + 1)
+    {
+      bufs[ii] = (struct buffer_t *)ase_malloc(BUFSIZE);
+      memset(bufs[ii], 0, BUFSIZE);
+      bufs[ii]->index = ii;
+      bufs[ii]->valid = ASE_BUFFER_VALID;
+      bufs[ii]->memsize = BENCH_BUFSIZE >> (bench_rand() % 4);
+      do
+        {
+          paddr = (bench_rand() % BENCH_PADDR_SPAN) & ~((uint64_t)BENCH_BUFSIZE - 1);
+        }
+      while ((paddr == 0) ||
+             check_if_physrange_used(paddr, paddr + bufs[ii]->memsize));
+      bufs[ii]->fake_paddr = paddr;
+      bufs[ii]->fake_paddr_hi = paddr + bufs[ii]->memsize;
+      bufs[ii]->pbase = 0x10000000000ULL + (uint64_t)ii * BENCH_BUFSIZE;
+      ll_append_buffer(bufs[ii]);
+    }
+  return bufs;
+}
+
+// Synthetic trace: 3 in 4 accesses are bursts within a buffer
+static void make_trace(uint64_t *trace, unsigned long len, struct buffer_t **bufs, int nbufs)
+{
+  unsigned long ii = 0;
+  unsigned long jj;
+  struct buffer_t *buf;
+  uint64_t cl;
+
+  while (ii < len)
+    {
+      do
+        buf = bufs[bench_rand() % nbufs];
+      while (buf->valid != ASE_BUFFER_VALID);
+
+      cl = bench_rand() % (buf->memsize / CL_BYTE_WIDTH);
+      if (bench_rand() % 4 != 0)
+        {
+          for (jj = 0; (jj < BENCH_BURST) && (ii < len); jj = jj + 1)
+            trace[ii++] = buf->fake_paddr + ((cl + jj) * CL_BYTE_WIDTH) % buf->memsize;
+        }
+      else
+        {
+          trace[ii++] = buf->fake_paddr + cl * CL_BYTE_WIDTH;
+        }
+    }
+}
+
+static double elapsed_ns(struct timespec *t0, struct timespec *t1)
+{
+  return 1e9*(t1->tv_sec - t0->tv_sec) + (t1->tv_nsec - t0->tv_nsec);
+}
+
+// Replay trace through both lookups, return ns/lookup for each
+static void replay(uint64_t *trace, unsigned long len, double *indexed_ns, double *linear_ns)
+{
+  struct timespec t0, t1;
+  struct buffer_t *buf;
+  uint64_t sum_indexed = 0;
+  uint64_t sum_linear = 0;
+  unsigned long ii;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (ii = 0; ii < len; ii = ii + 1)
+    {
+      buf = ll_search_physaddr(trace[ii]);
+      sum_indexed += buf->pbase + (trace[ii] - buf->fake_paddr);
+    }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  *indexed_ns = elapsed_ns(&t0, &t1) / len;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (ii = 0; ii < len; ii = ii + 1)
+    {
+      buf = linear_lookup(trace[ii]);
+      sum_linear += buf->pbase + (trace[ii] - buf->fake_paddr);
+    }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  *linear_ns = elapsed_ns(&t0, &t1) / len;
+
+  if (sum_indexed != sum_linear)
+    {
+      fprintf(stderr, "Indexed and linear lookups disagree\n");
+      exit(1);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+  const int counts[] = { 4, 64, 1024 };
+  struct buffer_t **bufs;
+  uint64_t *trace;
+  unsigned long len;
+  double indexed_ns, linear_ns;
+  int nbufs;
+  int ii, jj;
+
+  len = 1000000;
+  if (argc > 1)
+    {
+      len = strtoul(argv[1], NULL, 0);
+      if (len == 0)
+        {
+          fprintf(stderr, "Usage: %s [trace length]\n", argv[0]);
+          return 1;
+        }
+    }
+  trace = (uint64_t *)ase_malloc(len * sizeof(uint64_t));
+
+  printf("%-10s %-8s %14s %14s\n", "buffers", "", "indexed ns", "list walk ns");
+  for (ii = 0; ii < (int)(sizeof(counts) / sizeof(counts[0])); ii = ii + 1)
+    {
+      nbufs = counts[ii];
+      bufs = make_buffers(nbufs);
+
+      make_trace(trace, len, bufs, nbufs);
+      replay(trace, len, &indexed_ns, &linear_ns);
+      printf("%-10d %-8s %14.1f %14.1f\n", nbufs, "alloc", indexed_ns, linear_ns);
+
+      // Deallocate every other buffer and replay against the rest
+      for (jj = 0; jj < nbufs; jj = jj + 2)
+        {
+          bufs[jj]->valid = ASE_BUFFER_INVALID;
+          ll_remove_buffer(bufs[jj]);
+        }
+      make_trace(trace, len, bufs, nbufs);
+      replay(trace, len, &indexed_ns, &linear_ns);
+      printf("%-10d %-8s %14.1f %14.1f\n", nbufs / 2, "dealloc", indexed_ns, linear_ns);
+
+      for (jj = 0; jj < nbufs; jj = jj + 1)
+        {
+          if (bufs[jj]->valid == ASE_BUFFER_VALID)
+            ll_remove_buffer(bufs[jj]);
+          free(bufs[jj]);
+        }
+      free(bufs);
+    }
+
+  free(trace);
+  return 0;
+}
@@ -0,0 +1,180 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// file ASEMMIOBench.c
+/// brief ASE MMIO scoreboard throughput benchmark.
+/// ingroup ASEMMIOBench
+/// verbatim
+/// Accelerator Abstraction Layer Test Application
+///
+/// Drives the ASE application-side MMIO scoreboard from several threads
+/// without a simulator. A stand-in simulator thread reads TIDs from a pipe,
+/// as the real one reads requests from the app2sim FIFO, and completes them
+/// the way mmio_response_watcher() does. Each app thread issues a mix of
+/// posted writes and reads that wait for their response.
+///
+/// Reports requests/sec for 1, 2, 4 and 8 app threads, lock-free and with
+/// every issue serialized on one mutex as ASE used to.
+///
+/// Usage: ASEMMIOBench [requests per thread]
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version. endverbatim
+//****************************************************************************
+#define _GNU_SOURCE
+
+#include "ase_common.h"
+
+static int fd_req[2];
+static int serialize;
+static unsigned long requests;
+static pthread_mutex_t issue_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Stand-in simulator: answers every request in arrival order, a request
+// with a negative TID stops it
+static void *sim_thread(void *arg)
+{
+  mmio_t pkt;
+
+  while (read(fd_req[0], &pkt, sizeof(pkt)) == sizeof(pkt))
+    {
+      if (pkt.tid < 0)
+        break;
+      pkt.qword[0] = pkt.addr;
+      mmio_scoreboard_update(&pkt);
+    }
+
+  return NULL;
+}
+
+// App thread: three posted writes to every read
+static void *app_thread(void *arg)
+{
+  unsigned long ii;
+  int slot_idx;
+  mmio_t pkt;
+
+  memset(&pkt, 0, sizeof(pkt));
+  pkt.width = MMIO_WIDTH_64;
+
+  for (ii = 0; ii < requests; ii = ii + 1)
+    {
+      pkt.write_en = ((ii & 3) == 3) ? MMIO_READ_REQ : MMIO_WRITE_REQ;
+      pkt.addr = (int)(ii & 0xFFF) * 8;
+
+      if (serialize)
+        pthread_mutex_lock(&issue_lock);
+
+      pkt.tid = generate_mmio_tid();
+      slot_idx = get_scoreboard_slot_by_tid(pkt.tid);
+      if (write(fd_req[1], &pkt, sizeof(pkt)) != sizeof(pkt))
+        abort();
+
+      if (serialize)
+        pthread_mutex_unlock(&issue_lock);
+
+      if (pkt.write_en == MMIO_READ_REQ)
+        {
+          if (mmio_scoreboard_wait(slot_idx) != (uint64_t)pkt.addr)
+            {
+              fprintf(stderr, "Read of 0x%x returned wrong data\n", pkt.addr);
+              abort();
+            }
+        }
+    }
+
+  return NULL;
+}
+
+static double run(int nthreads)
+{
+  pthread_t sim;
+  pthread_t app[8];
+  struct timespec t0, t1;
+  mmio_t stop;
+  int ii;
+
+  if (pipe(fd_req) != 0)
+    {
+      perror("pipe");
+      exit(1);
+    }
+  pthread_create(&sim, NULL, &sim_thread, NULL);
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (ii = 0; ii < nthreads; ii = ii + 1)
+    pthread_create(&app[ii], NULL, &app_thread, NULL);
+  for (ii = 0; ii < nthreads; ii = ii + 1)
+    pthread_join(app[ii], NULL);
+
+  // Posted writes may still be in flight
+  while (count_mmio_tid_used() != 0)
+    sched_yield();
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  memset(&stop, 0, sizeof(stop));
+  stop.tid = -1;
+  if (write(fd_req[1], &stop, sizeof(stop)) != sizeof(stop))
+    abort();
+  pthread_join(sim, NULL);
+  close(fd_req[0]);
+  close(fd_req[1]);
+
+  return (double)(nthreads * requests) /
+    ((t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9);
+}
+
+int main(int argc, char *argv[])
+{
+  int nthreads;
+
+  requests = 200000;
+  if (argc > 1)
+    {
+      requests = strtoul(argv[1], NULL, 0);
+      if (requests == 0)
+        {
+          fprintf(stderr, "Usage: %s [requests per thread]\n", argv[0]);
+          return 1;
+        }
+    }
+
+  printf("%-10s %16s %16s\n", "threads", "lock-free req/s", "serialized req/s");
+  for (nthreads = 1; nthreads <= 8; nthreads = nthreads * 2)
+    {
+      double lockfree, locked;
+
+      serialize = 0;
+      lockfree = run(nthreads);
+      serialize = 1;
+      locked = run(nthreads);
+
+      printf("%-10d %16.0f %16.0f\n", nthreads, lockfree, locked);
+    }
+
+  return 0;
+}
@@ -0,0 +1,237 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// file GBSLoadBench.cpp
+/// brief Green bitstream header parse and load benchmark.
+/// ingroup GBSLoadBench
+/// verbatim
+/// Accelerator Abstraction Layer Test Application
+///
+/// Measures GBSParseHeader() throughput, then compares reading a bitstream
+/// onto the heap (the former reconfConfigure() path) with a cold and a
+/// cached CBitstreamCache::Acquire().
+///
+/// Usage: GBSLoadBench [file.gbs [iterations]]
+///        Without a file, a 32 MiB image is generated in /tmp.
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version. endverbatim
+//****************************************************************************
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+
+#include <aalsdk/AALTypes.h>
+#include <aalsdk/osal/Timer.h>
+
+#include "GBSHeader.h"
+#include "BitstreamCache.h"
+
+USING_NAMESPACE(std)
+USING_NAMESPACE(AAL)
+
+static double Elapsed(const Timer &begin)
+{
+   double us = 0.0;
+   (Timer().Now() - begin).AsMicroSeconds(us);
+   return us;
+}
+
+static void Report(const char *name, std::vector<double> &v)
+{
+   std::sort(v.begin(), v.end());
+
+   double sum = 0.0;
+   std::vector<double>::const_iterator itr;
+   for ( itr = v.begin() ; v.end() != itr ; ++itr ) {
+      sum += *itr;
+   }
+
+   cout << setw(20) << left << name << right << fixed << setprecision(1)
+        << setw(12) << v.front()
+        << setw(12) << v[v.size() / 2]
+        << setw(12) << sum / v.size()
+        << setw(12) << v.back() << endl;
+}
+
+// Write a len-byte image with a valid header.
+static btBool MakeImage(const std::string &path, btWSSize len)
+{
+   std::vector<btByte> img(len);
+   btUnsigned32bitInt  magic = GBS_HEADER_MAGIC;
+
+   for ( btWSSize i = 0 ; i < len ; ++i ) {
+      img[i] = (btByte)(i * 31);
+   }
+   memcpy(&img[0], &magic, sizeof(magic));
+
+   std::ofstream f(path.c_str(), std::ios::binary);
+   f.write(reinterpret_cast<const char *>(&img[0]), len);
+   return f.good();
+}
+
+// The former reconfConfigure() path: copy the whole file onto the heap and
+//  check the header.
+static btBool HeapLoad(const std::string &path)
+{
+   std::ifstream f(path.c_str(), std::ios::binary);
+   if ( !f.good() ) {
+      return false;
+   }
+
+   f.seekg(0, std::ios::end);
+   std::streampos len = f.tellg();
+   f.seekg(0, std::ios::beg);
+
+   btByte *p = new(std::nothrow) btByte[len];
+   if ( NULL == p ) {
+      return false;
+   }
+   f.read(reinterpret_cast<char *>(p), len);
+
+   GBSHeaderInfo info;
+   btBool        res = ( gbsHeaderOK == GBSParseHeader(p, len, info) );
+
+   delete[] p;
+   return res;
+}
+
+static btBool CacheLoad(const std::string &path, btBool bCold)
+{
+   if ( bCold ) {
+      CBitstreamCache::Flush();
+   }
+
+   CBitstream *pBitstream = NULL;
+   if ( bitstreamOK != CBitstreamCache::Acquire(path.c_str(), &pBitstream) ) {
+      return false;
+   }
+   CBitstreamCache::Release(pBitstream);
+   return true;
+}
+
+int main(int argc, char *argv[])
+{
+   std::string path;
+   btBool      bTemp      = false;
+   unsigned    iterations = 20;
+
+   if ( argc > 1 ) {
+      path = argv[1];
+   } else {
+      char tmp[64];
+      sprintf(tmp, "/tmp/GBSLoadBench.%d.gbs", (int)getpid());
+      path  = tmp;
+      bTemp = true;
+      if ( !MakeImage(path, 32 * 1024 * 1024) ) {
+         cerr << "Could not create " << path << endl;
+         return 1;
+      }
+   }
+
+   if ( argc > 2 ) {
+      iterations = (unsigned)strtoul(argv[2], NULL, 0);
+      if ( 0 == iterations ) {
+         cerr << "Usage: " << argv[0] << " [file.gbs [iterations]]" << endl;
+         return 1;
+      }
+   }
+
+   // Header parse throughput.
+   {
+      btByte             hdr[GBS_HEADER_LEN + 64];
+      btUnsigned32bitInt magic = GBS_HEADER_MAGIC;
+      memset(hdr, 0, sizeof(hdr));
+      memcpy(hdr, &magic, sizeof(magic));
+
+      const unsigned long n  = 10000000UL;
+      btWSSize            ok = 0;
+      Timer               t0 = Timer().Now();
+      for ( unsigned long i = 0 ; i < n ; ++i ) {
+         GBSHeaderInfo info;
+         // Vary the length so the call can't be hoisted out of the loop.
+         if ( gbsHeaderOK == GBSParseHeader(hdr, GBS_HEADER_LEN + 1 + ( i & 63 ), info) ) {
+            ok += info.payloadLen;
+         }
+      }
+      double us = Elapsed(t0);
+
+      cout << "GBSParseHeader: " << fixed << setprecision(2)
+           << ( us * 1000.0 ) / n << " ns/parse, "
+           << setprecision(1) << n / us << " M parses/s"
+           << " (" << ok << ")" << endl << endl;
+   }
+
+   cout << setw(20) << left << "usec" << right
+        << setw(12) << "min"
+        << setw(12) << "median"
+        << setw(12) << "mean"
+        << setw(12) << "max" << endl;
+
+   std::vector<double> heap;
+   std::vector<double> cold;
+   std::vector<double> warm;
+   int                 res = 0;
+
+   for ( unsigned i = 0 ; i < iterations ; ++i ) {
+      Timer t0 = Timer().Now();
+      if ( !HeapLoad(path) ) {
+         cerr << "heap load of " << path << " failed" << endl;
+         res = 1;
+         goto _DONE;
+      }
+      heap.push_back(Elapsed(t0));
+
+      t0 = Timer().Now();
+      if ( !CacheLoad(path, true) ) {
+         cerr << "cache load of " << path << " failed" << endl;
+         res = 1;
+         goto _DONE;
+      }
+      cold.push_back(Elapsed(t0));
+
+      t0 = Timer().Now();
+      CacheLoad(path, false);
+      warm.push_back(Elapsed(t0));
+   }
+
+   Report("heap read", heap);
+   Report("mapped (cold)", cold);
+   Report("mapped (cached)", warm);
+
+_DONE:
+   CBitstreamCache::Flush();
+   if ( bTemp ) {
+      unlink(path.c_str());
+   }
+   return res;
+}
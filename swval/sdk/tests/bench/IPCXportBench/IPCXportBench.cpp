@@ -0,0 +1,256 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// file IPCXportBench.cpp
+/// brief IPC transport loopback benchmark.
+/// ingroup IPCXportBench
+/// verbatim
+/// Accelerator Abstraction Layer Test Application
+///
+/// Compares TCPIPxport and UDSxport over loopback: round trip latency for
+/// one outstanding request, and messages/sec with a window of pipelined
+/// requests (UDSxport only; TCPIPxport frames cannot be matched).
+///
+/// Usage: IPCXportBench [iterations]
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version. endverbatim
+//****************************************************************************
+#include <stdlib.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include <aalsdk/AAL.h>
+#include <aalsdk/aas/AALIPCServiceFactory.h>
+#include <aalsdk/osal/Thread.h>
+#include <aalsdk/osal/Timer.h>
+
+USING_NAMESPACE(std)
+USING_NAMESPACE(AAL)
+
+#define BENCH_MAX_MSG 4096
+#define BENCH_WINDOW  16
+
+//=============================================================================
+// Echo server - runs in its own thread, returns every message as received.
+//=============================================================================
+template <class T>
+struct ServerCtx
+{
+   NamedValueSet *pArgs;
+   T              xport;
+};
+
+static btBool Echo(TCPIPxport &x, btcString msg, btWSSize len)
+{
+   return (int)len == x.putmsg(msg, len);
+}
+
+static btBool Echo(UDSxport &x, btcString msg, btWSSize len)
+{
+   // Implicit form echoes the request's correlation ID.
+   return (int)len == x.putmsg(msg, len);
+}
+
+template <class T>
+static void ServerThread(OSLThread * , void *pContext)
+{
+   ServerCtx<T> *pCtx = reinterpret_cast< ServerCtx<T> * >(pContext);
+
+   if ( !pCtx->xport.waitforconnect(*pCtx->pArgs) ) {
+      cerr << "waitforconnect failed" << endl;
+      return;
+   }
+
+   for ( ; ; ) {
+      btWSSize  len = 0;
+      btcString msg = pCtx->xport.getmsg(&len);
+      if ( NULL == msg ) {
+         break;
+      }
+      if ( !Echo(pCtx->xport, msg, len) ) {
+         break;
+      }
+   }
+}
+
+static double Elapsed(const Timer &begin)
+{
+   double us = 0.0;
+   (Timer().Now() - begin).AsMicroSeconds(us);
+   return us;
+}
+
+static void Report(const char *name, btWSSize size, unsigned msgs, double us)
+{
+   cout << setw(12) << left << name << right
+        << setw(8)  << size
+        << setw(14) << fixed << setprecision(2) << us / msgs
+        << setw(14) << setprecision(0) << (msgs * 1000000.0) / us << endl;
+}
+
+// One request outstanding at a time.
+template <class T>
+static btBool PingPong(T &client, const char *name, btWSSize size, unsigned iterations)
+{
+   char buf[BENCH_MAX_MSG];
+   memset(buf, 0x5a, sizeof(buf));
+
+   Timer t0 = Timer().Now();
+   for ( unsigned i = 0 ; i < iterations ; ++i ) {
+      if ( (int)size != client.putmsg(buf, size) ) {
+         return false;
+      }
+      btWSSize len = 0;
+      if ( ( NULL == client.getmsg(&len) ) || ( len != size ) ) {
+         return false;
+      }
+   }
+   Report(name, size, iterations, Elapsed(t0));
+   return true;
+}
+
+// BENCH_WINDOW requests in flight, responses matched by correlation ID.
+static btBool Pipelined(UDSxport &client, btWSSize size, unsigned iterations)
+{
+   char               buf[BENCH_MAX_MSG];
+   btUnsigned64bitInt window[BENCH_WINDOW];
+   memset(buf, 0x5a, sizeof(buf));
+
+   unsigned rounds = iterations / BENCH_WINDOW;
+   if ( 0 == rounds ) {
+      rounds = 1;
+   }
+
+   Timer t0 = Timer().Now();
+   for ( unsigned r = 0 ; r < rounds ; ++r ) {
+      unsigned i;
+      for ( i = 0 ; i < BENCH_WINDOW ; ++i ) {
+         window[i] = client.nextcorrid();
+         if ( (int)size != client.putmsg(buf, size, window[i], -1) ) {
+            return false;
+         }
+      }
+      for ( i = 0 ; i < BENCH_WINDOW ; ++i ) {
+         btWSSize           len    = 0;
+         btUnsigned64bitInt corrid = 0;
+         if ( ( NULL == client.getmsg(&len, &corrid, NULL) ) ||
+              ( len != size ) ||
+              ( corrid != window[i] ) ) {
+            return false;
+         }
+      }
+   }
+   Report("uds/pipe", size, rounds * BENCH_WINDOW, Elapsed(t0));
+   return true;
+}
+
+static btBool Pipelined(TCPIPxport & , btWSSize , unsigned )
+{
+   return true;
+}
+
+template <class T>
+static btBool Run(NamedValueSet &args, const char *name, unsigned iterations)
+{
+   ServerCtx<T> ctx;
+   ctx.pArgs = &args;
+
+   OSLThread server(ServerThread<T>, OSLThread::THREADPRIORITY_NORMAL, &ctx);
+
+   T client;
+   if ( !client.connectremote(args) ) {
+      cerr << name << ": connectremote failed" << endl;
+      return false;
+   }
+
+   btWSSize sizes[] = { 64, 1024, BENCH_MAX_MSG };
+   btBool   res     = true;
+
+   for ( unsigned s = 0 ; res && ( s < sizeof(sizes) / sizeof(sizes[0]) ) ; ++s ) {
+      res = PingPong(client, name, sizes[s], iterations);
+      if ( res ) {
+         res = Pipelined(client, sizes[s], iterations);
+      }
+   }
+
+   // Server sees EOF and exits.
+   client.disconnect();
+   server.Join();
+
+   if ( !res ) {
+      cerr << name << ": transfer failed" << endl;
+   }
+   return res;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned iterations = 20000;
+
+   if ( argc > 1 ) {
+      iterations = (unsigned)strtoul(argv[1], NULL, 0);
+      if ( 0 == iterations ) {
+         cerr << "Usage: " << argv[0] << " [iterations]" << endl;
+         return 1;
+      }
+   }
+
+   cout << setw(12) << left << "xport" << right
+        << setw(8)  << "bytes"
+        << setw(14) << "usec/msg"
+        << setw(14) << "msgs/sec" << endl;
+
+   // TCP over loopback.
+   NamedValueSet tcpArgs;
+   NamedValueSet tcpParms;
+   tcpParms.Add(AAL_SERVICE_CONNECTION_TYPE, (btInt)conn_type_tcp);
+   tcpParms.Add(AAL_SERVICE_COMM_HOST, "localhost");
+   tcpParms.Add(AAL_SERVICE_COMM_PORT, (btInt)(20000 + GetProcessID() % 20000));
+   tcpArgs.Add(AAL_SERVICE_CONNECTION_PARMS, &tcpParms);
+
+   if ( !Run<TCPIPxport>(tcpArgs, "tcp", iterations) ) {
+      return 1;
+   }
+
+   // Unix domain socket.
+   char path[64];
+   snprintf(path, sizeof(path), "/tmp/IPCXportBench.%d", (int)GetProcessID());
+
+   NamedValueSet udsArgs;
+   NamedValueSet udsParms;
+   udsParms.Add(AAL_SERVICE_CONNECTION_TYPE, (btInt)conn_type_uds);
+   udsParms.Add(AAL_SERVICE_COMM_PATH, path);
+   udsArgs.Add(AAL_SERVICE_CONNECTION_PARMS, &udsParms);
+
+   if ( !Run<UDSxport>(udsArgs, "uds", iterations) ) {
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,248 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// file NUMABench.cpp
+/// brief Local vs. remote NUMA memory benchmark.
+/// ingroup NUMABench
+/// verbatim
+/// Accelerator Abstraction Layer Test Application
+///
+/// Pins the measuring thread to NUMA node 0 with OSLAffinity. For each node,
+/// a thread created on that node allocates and first-touches a buffer, so
+/// its pages land there; node 0 then measures sequential read bandwidth and
+/// dependent random-access latency over it. The node 0 row is local memory,
+/// the others remote; on a single-node system only the local row is shown.
+///
+/// Usage: NUMABench [MiB [iterations]]
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version. endverbatim
+//****************************************************************************
+#include <stdlib.h>
+#include <stdio.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+
+#include <aalsdk/AALTypes.h>
+#include <aalsdk/osal/Affinity.h>
+#include <aalsdk/osal/Thread.h>
+#include <aalsdk/osal/Timer.h>
+
+USING_NAMESPACE(std)
+USING_NAMESPACE(AAL)
+
+static double Elapsed(const Timer &begin)
+{
+   double us = 0.0;
+   (Timer().Now() - begin).AsMicroSeconds(us);
+   return us;
+}
+
+// One cache line per element, so each step of the chase is a separate miss.
+struct Line
+{
+   Line              *pNext;
+   btUnsigned64bitInt pad[7];
+};
+
+class NodeBuffer
+{
+public:
+   NodeBuffer(btInt Node, btWSSize Bytes) :
+      m_Node(Node),
+      m_Count(Bytes / sizeof(Line)),
+      m_pLines(NULL),
+      m_Where(-1)
+   {}
+   ~NodeBuffer() { delete[] m_pLines; }
+
+   // Runs on a CPU of m_Node: allocate, then link the lines into one random
+   //  cycle (Sattolo), writing every line so that each page is placed here.
+   static void Fill(OSLThread * , void *pContext)
+   {
+      NodeBuffer *p = reinterpret_cast<NodeBuffer *>(pContext);
+
+      p->m_Where  = OSLAffinity::CurrentNode();
+      p->m_pLines = new(std::nothrow) Line[p->m_Count];
+      if ( NULL == p->m_pLines ) {
+         return;
+      }
+
+      std::vector<size_t> order(p->m_Count);
+      for ( size_t i = 0 ; i < p->m_Count ; ++i ) {
+         order[i] = i;
+      }
+      srand(1);
+      for ( size_t i = p->m_Count - 1 ; i > 0 ; --i ) {
+         size_t j = ( ( (size_t)rand() << 16 ) ^ (size_t)rand() ) % i;
+         std::swap(order[i], order[j]);
+      }
+
+      for ( size_t i = 0 ; i < p->m_Count ; ++i ) {
+         Line &l = p->m_pLines[order[i]];
+         l.pNext = &p->m_pLines[order[( i + 1 ) % p->m_Count]];
+         for ( int k = 0 ; k < 7 ; ++k ) {
+            l.pad[k] = i + k;
+         }
+      }
+   }
+
+   btInt    m_Node;
+   size_t   m_Count;
+   Line    *m_pLines;
+   btInt    m_Where;   // node Fill() ran on
+};
+
+// GB/s reading every word of the buffer.
+static double ReadBandwidth(const NodeBuffer &b, btUnsigned64bitInt &sink)
+{
+   const btUnsigned64bitInt *p = reinterpret_cast<const btUnsigned64bitInt *>(b.m_pLines);
+   const size_t              n = b.m_Count * ( sizeof(Line) / sizeof(btUnsigned64bitInt) );
+   btUnsigned64bitInt        s = 0;
+
+   Timer t0 = Timer().Now();
+   for ( size_t i = 0 ; i < n ; ++i ) {
+      s += p[i];
+   }
+   double us = Elapsed(t0);
+
+   sink += s;
+   return ( n * sizeof(btUnsigned64bitInt) ) / ( us * 1000.0 );
+}
+
+// ns per dependent load, following the random cycle.
+static double ChaseLatency(const NodeBuffer &b, btUnsigned64bitInt &sink)
+{
+   const size_t steps = b.m_Count;
+   const Line  *p     = b.m_pLines;
+
+   Timer t0 = Timer().Now();
+   for ( size_t i = 0 ; i < steps ; ++i ) {
+      p = p->pNext;
+   }
+   double us = Elapsed(t0);
+
+   sink += reinterpret_cast<btUnsigned64bitInt>(p);
+   return ( us * 1000.0 ) / steps;
+}
+
+int main(int argc, char *argv[])
+{
+   btWSSize mib        = 256;
+   unsigned iterations = 5;
+
+   if ( argc > 1 ) {
+      mib = strtoul(argv[1], NULL, 0);
+   }
+   if ( argc > 2 ) {
+      iterations = (unsigned)strtoul(argv[2], NULL, 0);
+   }
+   if ( ( 0 == mib ) || ( 0 == iterations ) ) {
+      cerr << "Usage: " << argv[0] << " [MiB [iterations]]" << endl;
+      return 1;
+   }
+
+   const btInt nodes = OSLAffinity::NumNodes();
+   OSLAffinity home  = OSLAffinity::NUMANode(0);
+
+   if ( !home.Apply() ) {
+      cerr << "Could not place the measuring thread on node 0" << endl;
+      return 1;
+   }
+
+   cout << nodes << " NUMA node(s), measuring from node 0 ("
+        << home.ToString() << "), " << mib << " MiB buffers" << endl << endl;
+
+   cout << setw(8)  << left << "node" << right
+        << setw(10) << "placed"
+        << setw(14) << "read GB/s"
+        << setw(14) << "chase ns" << endl;
+
+   btUnsigned64bitInt sink = 0;
+   double             local[2] = { 0.0, 0.0 };
+   int                res = 0;
+
+   for ( btInt n = 0 ; n < nodes ; ++n ) {
+      NodeBuffer buf(n, mib * 1024 * 1024);
+
+      OSLThread *pThread = new(std::nothrow) OSLThread(NodeBuffer::Fill,
+                                                       OSLThread::THREADPRIORITY_NORMAL,
+                                                       &buf,
+                                                       false,
+                                                       OSLAffinity::NUMANode(n));
+      if ( NULL == pThread ) {
+         res = 1;
+         break;
+      }
+      pThread->Join();
+      delete pThread;
+
+      if ( NULL == buf.m_pLines ) {
+         cerr << "allocation on node " << n << " failed" << endl;
+         res = 1;
+         break;
+      }
+
+      std::vector<double> bw;
+      std::vector<double> ns;
+      for ( unsigned i = 0 ; i < iterations ; ++i ) {
+         bw.push_back(ReadBandwidth(buf, sink));
+         ns.push_back(ChaseLatency(buf, sink));
+      }
+      std::sort(bw.begin(), bw.end());
+      std::sort(ns.begin(), ns.end());
+
+      // Medians.
+      double gbs  = bw[bw.size() / 2];
+      double nsec = ns[ns.size() / 2];
+
+      cout << setw(8) << left << n << right
+           << setw(10) << buf.m_Where
+           << fixed
+           << setw(14) << setprecision(2) << gbs
+           << setw(14) << setprecision(1) << nsec;
+
+      if ( 0 == n ) {
+         local[0] = gbs;
+         local[1] = nsec;
+         cout << "   local";
+      } else {
+         cout << "   remote: " << setprecision(2)
+              << gbs / local[0] << "x bandwidth, "
+              << nsec / local[1] << "x latency";
+      }
+      cout << endl;
+   }
+
+   // Keep the loads live.
+   if ( 0 == sink ) {
+      cout << endl;
+   }
+   return res;
+}
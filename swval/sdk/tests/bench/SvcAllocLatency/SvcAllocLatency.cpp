@@ -0,0 +1,232 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// file SvcAllocLatency.cpp
+/// brief Service allocation latency benchmark.
+/// ingroup SvcAllocLatency
+/// verbatim
+/// Accelerator Abstraction Layer Test Application
+///
+/// Measures Runtime start() and first allocService() latency for
+/// libswvalsvcmod, with and without AALRUNTIME_CONFIG_PRELOAD_SERVICES.
+///
+/// Usage: SvcAllocLatency [iterations]
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version. endverbatim
+//****************************************************************************
+#include <stdlib.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+
+#include <aalsdk/AAL.h>
+#include <aalsdk/Runtime.h>
+#include <aalsdk/osal/Timer.h>
+
+#include "swvalsvcmod.h"
+
+USING_NAMESPACE(std)
+USING_NAMESPACE(AAL)
+
+//=============================================================================
+// BenchClient - Runtime and Service client. Every callback posts m_Sem so
+//               that the main thread can time each step synchronously.
+//=============================================================================
+class BenchClient : public CAASBase,
+                    public IRuntimeClient,
+                    public IServiceClient,
+                    public ISwvalSvcClient
+{
+public:
+   BenchClient() :
+      m_pService(NULL),
+      m_bOK(false)
+   {
+      SetInterface(iidRuntimeClient, dynamic_cast<IRuntimeClient *>(this));
+      SetInterface(iidServiceClient, dynamic_cast<IServiceClient *>(this));
+      SetInterface(iidSwvalSvcClient, dynamic_cast<ISwvalSvcClient *>(this));
+      m_Sem.Create(0, 1);
+   }
+
+   void Wait() { m_Sem.Wait(); }
+   btBool OK() const { return m_bOK; }
+   IBase * Service() const { return m_pService; }
+
+   // <IRuntimeClient>
+   void runtimeCreateOrGetProxyFailed(IEvent const & ) { m_bOK = false; m_Sem.Post(1); }
+   void runtimeStarted(IRuntime * , const NamedValueSet & ) { m_bOK = true; m_Sem.Post(1); }
+   void runtimeStopped(IRuntime * )                    { m_Sem.Post(1); }
+   void runtimeStartFailed(const IEvent & )            { m_bOK = false; m_Sem.Post(1); }
+   void runtimeStopFailed(const IEvent & )             { m_Sem.Post(1); }
+   void runtimeAllocateServiceFailed(IEvent const & )  { /* reported via IServiceClient */ }
+   void runtimeAllocateServiceSucceeded(IBase * ,
+                                        TransactionID const & ) { /* reported via IServiceClient */ }
+   void runtimeEvent(const IEvent & )                  { }
+   // </IRuntimeClient>
+
+   // <IServiceClient>
+   void serviceAllocated(IBase *pServiceBase, TransactionID const & )
+   {
+      m_pService = pServiceBase;
+      m_bOK      = true;
+      m_Sem.Post(1);
+   }
+   void serviceAllocateFailed(const IEvent & ) { m_pService = NULL; m_bOK = false; m_Sem.Post(1); }
+   void serviceReleased(TransactionID const & ) { m_pService = NULL; m_Sem.Post(1); }
+   void serviceReleaseRequest(IBase * , const IEvent & ) { }
+   void serviceReleaseFailed(const IEvent & ) { m_bOK = false; m_Sem.Post(1); }
+   void serviceEvent(const IEvent & ) { }
+   // </IServiceClient>
+
+   // <ISwvalSvcClient>
+   void DidSomething(const TransactionID & , int ) { }
+   // </ISwvalSvcClient>
+
+protected:
+   IBase     *m_pService;
+   btBool     m_bOK;
+   CSemaphore m_Sem;
+};
+
+struct Sample
+{
+   double start;  // usec for Runtime::start()
+   double alloc;  // usec for the first allocService()
+};
+
+static double Elapsed(const Timer &begin)
+{
+   double us = 0.0;
+   (Timer().Now() - begin).AsMicroSeconds(us);
+   return us;
+}
+
+// One full Runtime lifetime: start, allocate, release, stop.
+static btBool RunOnce(btBool bPreload, Sample &s)
+{
+   BenchClient   client;
+   Runtime       runtime(&client);
+   NamedValueSet configArgs;
+   NamedValueSet configRecord;
+
+   if ( bPreload ) {
+      configRecord.Add(AALRUNTIME_CONFIG_PRELOAD_SERVICES, "libswvalsvcmod");
+      configArgs.Add(AALRUNTIME_CONFIG_RECORD, &configRecord);
+   }
+
+   Timer t0 = Timer().Now();
+   runtime.start(configArgs);
+   client.Wait();
+   s.start = Elapsed(t0);
+
+   if ( !client.OK() ) {
+      cerr << "Runtime failed to start" << endl;
+      return false;
+   }
+
+   NamedValueSet manifest;
+   NamedValueSet svcRecord;
+
+   svcRecord.Add(AAL_FACTORY_CREATE_CONFIGRECORD_FULL_SERVICE_NAME, "libswvalsvcmod");
+   manifest.Add(AAL_FACTORY_CREATE_CONFIGRECORD_INCLUDED, &svcRecord);
+   manifest.Add(AAL_FACTORY_CREATE_SERVICENAME, "SvcAllocLatency");
+
+   t0 = Timer().Now();
+   runtime.allocService(&client, manifest);
+   client.Wait();
+   s.alloc = Elapsed(t0);
+
+   btBool res = client.OK();
+
+   if ( NULL != client.Service() ) {
+      dynamic_ptr<IAALService>(iidService, client.Service())->Release(TransactionID());
+      client.Wait();
+   }
+
+   runtime.stop();
+   client.Wait();
+
+   return res;
+}
+
+static void Report(const char *name, std::vector<double> &v)
+{
+   std::sort(v.begin(), v.end());
+
+   double sum = 0.0;
+   std::vector<double>::const_iterator itr;
+   for ( itr = v.begin() ; v.end() != itr ; ++itr ) {
+      sum += *itr;
+   }
+
+   cout << setw(16) << left << name << right << fixed << setprecision(1)
+        << setw(12) << v.front()
+        << setw(12) << v[v.size() / 2]
+        << setw(12) << sum / v.size()
+        << setw(12) << v.back() << endl;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned iterations = 20;
+
+   if ( argc > 1 ) {
+      iterations = (unsigned)strtoul(argv[1], NULL, 0);
+      if ( 0 == iterations ) {
+         cerr << "Usage: " << argv[0] << " [iterations]" << endl;
+         return 1;
+      }
+   }
+
+   cout << setw(16) << left << "usec" << right
+        << setw(12) << "min"
+        << setw(12) << "median"
+        << setw(12) << "mean"
+        << setw(12) << "max" << endl;
+
+   for ( int preload = 0 ; preload < 2 ; ++preload ) {
+      std::vector<double> starts;
+      std::vector<double> allocs;
+
+      for ( unsigned i = 0 ; i < iterations ; ++i ) {
+         Sample s;
+         if ( !RunOnce(0 != preload, s) ) {
+            cerr << "Iteration " << i << " failed" << endl;
+            return 1;
+         }
+         starts.push_back(s.start);
+         allocs.push_back(s.alloc);
+      }
+
+      Report(preload ? "start (warm)" : "start (cold)", starts);
+      Report(preload ? "alloc (warm)" : "alloc (cold)", allocs);
+   }
+
+   return 0;
+}
@@ -0,0 +1,278 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// file BenchAAS.cpp
+/// brief AASLib microbenchmarks: NamedValueSet, CAASBase, TransactionID, CLogger.
+/// ingroup aalbench
+/// verbatim
+/// Accelerator Abstraction Layer Test Application
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version. endverbatim
+//****************************************************************************
+#include <sstream>
+
+#include "aalbench.h"
+#include <aalsdk/AALTransactionTrace.h>
+
+USING_NAMESPACE(std)
+USING_NAMESPACE(AAL)
+
+// A small mixed set, about what a service manifest carries.
+static void FillNVS(NamedValueSet &nvs)
+{
+   nvs.Add("u64_0", (btUnsigned64bitInt)0);
+   nvs.Add("u64_1", (btUnsigned64bitInt)1);
+   nvs.Add("u64_2", (btUnsigned64bitInt)2);
+   nvs.Add("u64_3", (btUnsigned64bitInt)3);
+   nvs.Add("i32_0", (bt32bitInt)-1);
+   nvs.Add("i32_1", (bt32bitInt)-2);
+   nvs.Add("flt_0", (btFloat)0.5);
+   nvs.Add("flt_1", (btFloat)1.5);
+   nvs.Add("str_0", "libswvalsvcmod");
+   nvs.Add("str_1", "aalbench");
+   nvs.Add("str_2", "AALRUNTIME_CONFIG_RECORD");
+   nvs.Add("str_3", "AAL_FACTORY_CREATE_SERVICENAME");
+   nvs.Add("bool_0", true);
+   nvs.Add("bool_1", false);
+   nvs.Add("u32_0", (btUnsigned32bitInt)32);
+   nvs.Add("u32_1", (btUnsigned32bitInt)33);
+}
+
+// One Add() and one Get() per op, into a set that is cleared as it fills.
+static double NVSAddGet(btUnsigned64bitInt ops)
+{
+   static const char *keys[] =
+   {
+      "k0", "k1", "k2", "k3", "k4", "k5", "k6", "k7",
+      "k8", "k9", "k10", "k11", "k12", "k13", "k14", "k15"
+   };
+   const btUnsigned64bitInt nkeys = sizeof(keys) / sizeof(keys[0]);
+
+   NamedValueSet      nvs;
+   btUnsigned64bitInt sum = 0;
+
+   btUnsigned64bitInt t0 = BenchNow();
+   for ( btUnsigned64bitInt i = 0 ; i < ops ; ++i ) {
+      btUnsigned64bitInt k = i % nkeys;
+      btUnsigned64bitInt v = 0;
+      if ( 0 == k ) {
+         nvs.Empty();
+      }
+      if ( ( ENamedValuesOK != nvs.Add(keys[k], i) ) ||
+           ( ENamedValuesOK != nvs.Get(keys[k], &v) ) ) {
+         return -1.0;
+      }
+      sum += v;
+   }
+   double ns = BenchSince(t0);
+
+   return ( sum == ops * ( ops - 1 ) / 2 ) ? ns : -1.0;
+}
+
+// Copy construction of a populated set.
+static double NVSCopy(btUnsigned64bitInt ops)
+{
+   NamedValueSet nvs;
+   FillNVS(nvs);
+
+   btUnsigned64bitInt t0 = BenchNow();
+   for ( btUnsigned64bitInt i = 0 ; i < ops ; ++i ) {
+      NamedValueSet copy(nvs);
+      btUnsignedInt n = 0;
+      if ( ( ENamedValuesOK != copy.GetNumNames(&n) ) || ( 16 != n ) ) {
+         return -1.0;
+      }
+   }
+   return BenchSince(t0);
+}
+
+// Write() then Read() of a populated set, as the IPC path marshals it.
+static double NVSSerialize(btUnsigned64bitInt ops)
+{
+   NamedValueSet nvs;
+   FillNVS(nvs);
+
+   btUnsigned64bitInt t0 = BenchNow();
+   for ( btUnsigned64bitInt i = 0 ; i < ops ; ++i ) {
+      ostringstream os;
+      nvs.Write(os);
+
+      istringstream is(os.str());
+      NamedValueSet in;
+      in.Read(is);   // ENamedValuesEndOfFile at the end of the string
+      if ( !( in == nvs ) ) {
+         return -1.0;
+      }
+   }
+   return BenchSince(t0);
+}
+
+class BenchObject : public CAASBase
+{
+public:
+   enum { NumInterfaces = 8 };
+
+   BenchObject()
+   {
+      for ( btIID i = 0 ; i < NumInterfaces ; ++i ) {
+         SetInterface(IID(i), this);
+      }
+   }
+
+   static btIID IID(btIID i) { return (btIID)0x7ab00000 + i; }
+};
+
+// Interface() lookup on an object exposing a handful of interfaces.
+static double CAASBaseInterface(btUnsigned64bitInt ops)
+{
+   BenchObject obj;
+
+   btUnsigned64bitInt t0 = BenchNow();
+   for ( btUnsigned64bitInt i = 0 ; i < ops ; ++i ) {
+      if ( NULL == obj.Interface(BenchObject::IID(i % BenchObject::NumInterfaces)) ) {
+         return -1.0;
+      }
+   }
+   return BenchSince(t0);
+}
+
+// Default construction, which draws a new unique ID.
+static double TransactionIDCreate(btUnsigned64bitInt ops)
+{
+   btUnsigned64bitInt t0 = BenchNow();
+   for ( btUnsigned64bitInt i = 0 ; i < ops ; ++i ) {
+      TransactionID tid;
+   }
+   return BenchSince(t0);
+}
+
+// A tracepoint while tracing is off: what every request pays by default.
+static double TxTraceDisabled(btUnsigned64bitInt ops)
+{
+   TransactionTrace::Disable();
+
+   btUnsigned64bitInt t0 = BenchNow();
+   for ( btUnsigned64bitInt i = 0 ; i < ops ; ++i ) {
+      AAL_TRACE_TRANSACTION(txtraceDispatch, i);
+   }
+   return BenchSince(t0);
+}
+
+// A tracepoint that records.
+static double TxTraceEnabled(btUnsigned64bitInt ops)
+{
+   TransactionTrace::Enable();
+
+   btUnsigned64bitInt t0 = BenchNow();
+   for ( btUnsigned64bitInt i = 0 ; i < ops ; ++i ) {
+      AAL_TRACE_TRANSACTION(txtraceDispatch, i);
+   }
+   double res = BenchSince(t0);
+
+   TransactionTrace::Disable();
+   TransactionTrace::Reset();
+   return res;
+}
+
+// Sets the global logger for a benchmark and puts it back afterwards.
+class LoggerState
+{
+public:
+   LoggerState() :
+      m_pLog(pAALLogger()),
+      m_Mask(m_pLog->GetMask()),
+      m_Level(m_pLog->GetLevel(LM_Any)),
+      m_Dest(m_pLog->GetDestinationEnum()),
+      m_File(m_pLog->GetDestinationFile())
+   {}
+
+   ~LoggerState()
+   {
+      m_pLog->RemoveFromMask(LM_Any);
+      if ( m_Mask & LM_Any ) {
+         m_pLog->AddToMask(LM_Any, m_Level);
+      }
+      if ( ( m_pLog->GetDestinationEnum() != m_Dest ) || ( m_pLog->GetDestinationFile() != m_File ) ) {
+         m_pLog->SetDestination(m_Dest, m_File);
+      }
+   }
+
+   ILogger * operator -> () { return m_pLog; }
+
+protected:
+   ILogger        *m_pLog;
+   LogMask_t       m_Mask;
+   int             m_Level;
+   ILogger::eLogTo m_Dest;
+   std::string     m_File;
+};
+
+static btUnsigned64bitInt LogLoop(ILogger *pLog, btUnsigned64bitInt ops)
+{
+   btUnsigned64bitInt t0 = BenchNow();
+   for ( btUnsigned64bitInt i = 0 ; i < ops ; ++i ) {
+      if ( pLog->IfLog(LM_Any, LOG_INFO) ) {
+         pLog->Log(LOG_INFO, pLog->GetOss(LOG_INFO) << "aalbench " << i << std::endl);
+      }
+   }
+   return BenchNow() - t0;
+}
+
+// The cost of a log statement whose mask is disabled.
+static double CLoggerFiltered(btUnsigned64bitInt ops)
+{
+   LoggerState state;
+   state->RemoveFromMask(LM_Any);
+   return (double)LogLoop(pAALLogger(), ops);
+}
+
+// Formatting and writing a message, to a file sink that discards it.
+static double CLoggerWrite(btUnsigned64bitInt ops)
+{
+   LoggerState state;
+   state->SetDestination(ILogger::FILE, "/dev/null");
+   state->AddToMask(LM_Any, LOG_INFO);
+   return (double)LogLoop(pAALLogger(), ops);
+}
+
+void AddAASBenches(BenchList &rList)
+{
+   BenchDesc d[] =
+   {
+      { "nvs_add_get",          NVSAddGet,           200000  },
+      { "nvs_copy",             NVSCopy,             20000   },
+      { "nvs_serialize",        NVSSerialize,        5000    },
+      { "caasbase_interface",   CAASBaseInterface,   1000000 },
+      { "transactionid_create", TransactionIDCreate, 200000  },
+      { "txtrace_disabled",     TxTraceDisabled,     5000000 },
+      { "txtrace_enabled",      TxTraceEnabled,      1000000 },
+      { "clogger_filtered",     CLoggerFiltered,     5000000 },
+      { "clogger_write",        CLoggerWrite,        50000   },
+   };
+   rList.insert(rList.end(), d, d + sizeof(d) / sizeof(d[0]));
+}
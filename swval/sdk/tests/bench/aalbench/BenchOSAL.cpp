@@ -0,0 +1,267 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// file BenchOSAL.cpp
+/// brief OSAL microbenchmarks: Thread Group, CSemaphore and Barrier.
+/// ingroup aalbench
+/// verbatim
+/// Accelerator Abstraction Layer Test Application
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version. endverbatim
+//****************************************************************************
+#include "aalbench.h"
+
+USING_NAMESPACE(AAL)
+
+// Counts its executions. One instance is queued over and over; the Thread
+//  Group does not delete what it dispatches.
+class CountD : public IDispatchable
+{
+public:
+   CountD() : m_Count(0) {}
+   void operator() () { __sync_fetch_and_add(&m_Count, 1); }
+
+   btUnsigned64bitInt m_Count;
+};
+
+class PostD : public IDispatchable
+{
+public:
+   PostD(CSemaphore &rSem) : m_rSem(rSem) {}
+   void operator() () { m_rSem.Post(1); }
+
+   CSemaphore &m_rSem;
+};
+
+// Queue ops work items to four workers and wait for all of them to run.
+static double ThreadGroupAddThroughput(btUnsigned64bitInt ops)
+{
+   OSLThreadGroup tg(4, 4);
+   CountD         item;
+
+   btUnsigned64bitInt t0 = BenchNow();
+   for ( btUnsigned64bitInt i = 0 ; i < ops ; ++i ) {
+      if ( !tg.Add(&item) ) {
+         return -1.0;
+      }
+   }
+   tg.Drain();
+   double ns = BenchSince(t0);
+
+   // Drain() does not wait for items the workers had already taken.
+   tg.Join(AAL_INFINITE_WAIT);
+   return ( ops == item.m_Count ) ? ns : -1.0;
+}
+
+// Time from Add() until the work item has run, one at a time.
+static double ThreadGroupDispatchLatency(btUnsigned64bitInt ops)
+{
+   OSLThreadGroup tg(1, 1);
+   CSemaphore     sem;
+   sem.Create(0, 1);
+   PostD          item(sem);
+
+   btUnsigned64bitInt t0 = BenchNow();
+   for ( btUnsigned64bitInt i = 0 ; i < ops ; ++i ) {
+      if ( !tg.Add(&item) ) {
+         return -1.0;
+      }
+      sem.Wait();
+   }
+   return BenchSince(t0);
+}
+
+// Blocks briefly, as an event handler waiting on the device would.
+class SleepD : public IDispatchable
+{
+public:
+   void operator() () { SleepMicro(50); }
+};
+
+// Bursts of 32 blocking work items, each burst drained before the next.
+static double ThreadGroupBurst(btUnsignedInt MaxThreads, btUnsigned64bitInt ops)
+{
+   OSLThreadGroup tg(1, MaxThreads);
+   SleepD         item;
+
+   btUnsigned64bitInt t0 = BenchNow();
+   for ( btUnsigned64bitInt i = 0 ; i < ops ; ++i ) {
+      if ( !tg.Add(&item) ) {
+         return -1.0;
+      }
+      if ( 31 == ( i & 31 ) ) {
+         tg.Drain();
+      }
+   }
+   tg.Drain();
+   return BenchSince(t0);
+}
+
+static double ThreadGroupBurstStatic(btUnsigned64bitInt ops)  { return ThreadGroupBurst(1, ops); }
+static double ThreadGroupBurstElastic(btUnsigned64bitInt ops) { return ThreadGroupBurst(4, ops); }
+
+class BulkSleepD : public SleepD
+{
+public:
+   DispatchClass GetDispatchClass() const { return DispatchBulk; }
+};
+
+// Notes when it ran, as a revocation would be handled.
+class CriticalStampD : public IDispatchable
+{
+public:
+   CriticalStampD(CSemaphore &rSem) : m_Ran(0), m_rSem(rSem) {}
+   void operator() () { m_Ran = BenchNow(); m_rSem.Post(1); }
+   DispatchClass GetDispatchClass() const { return DispatchCritical; }
+
+   btUnsigned64bitInt m_Ran;
+   CSemaphore        &m_rSem;
+};
+
+// Time from Add() until a critical work item runs, queued behind 16 bulk ones.
+static double ThreadGroupCritical(btBool bPriority, btUnsigned64bitInt ops)
+{
+   OSLThreadGroup tg(1, 1);
+   CSemaphore     sem;
+   sem.Create(0, 1);
+   BulkSleepD     bulk;
+   CriticalStampD critical(sem);
+   double         ns = 0.0;
+
+   tg.SetPriorityDispatch(bPriority);
+
+   for ( btUnsigned64bitInt i = 0 ; i < ops ; ++i ) {
+      for ( btUnsignedInt j = 0 ; j < 16 ; ++j ) {
+         if ( !tg.Add(&bulk) ) {
+            return -1.0;
+         }
+      }
+      btUnsigned64bitInt t0 = BenchNow();
+      if ( !tg.Add(&critical) ) {
+         return -1.0;
+      }
+      sem.Wait();
+      ns += (double)( critical.m_Ran - t0 );
+      tg.Drain();
+   }
+   return ns;
+}
+
+static double ThreadGroupCriticalFIFO(btUnsigned64bitInt ops)     { return ThreadGroupCritical(false, ops); }
+static double ThreadGroupCriticalPriority(btUnsigned64bitInt ops) { return ThreadGroupCritical(true,  ops); }
+
+struct PingPong
+{
+   btUnsigned64bitInt ops;
+   CSemaphore         semPing;
+   CSemaphore         semPong;
+   Barrier            barPing;
+   Barrier            barPong;
+};
+
+static void SemPonger(OSLThread * , void *pContext)
+{
+   PingPong *p = reinterpret_cast<PingPong *>(pContext);
+   for ( btUnsigned64bitInt i = 0 ; i < p->ops ; ++i ) {
+      p->semPing.Wait();
+      p->semPong.Post(1);
+   }
+}
+
+// Round trips between two threads, each handing off through a CSemaphore.
+static double CSemaphorePingPong(btUnsigned64bitInt ops)
+{
+   PingPong p;
+   p.ops = ops;
+   p.semPing.Create(0, 1);
+   p.semPong.Create(0, 1);
+
+   OSLThread *pThread = new OSLThread(SemPonger, OSLThread::THREADPRIORITY_NORMAL, &p);
+
+   btUnsigned64bitInt t0 = BenchNow();
+   for ( btUnsigned64bitInt i = 0 ; i < ops ; ++i ) {
+      p.semPing.Post(1);
+      p.semPong.Wait();
+   }
+   double ns = BenchSince(t0);
+
+   pThread->Join();
+   delete pThread;
+   return ns;
+}
+
+// Each side resets the Barrier it waited on before opening the other's, so
+//  neither is posted again until it has been reset.
+static void BarPonger(OSLThread * , void *pContext)
+{
+   PingPong *p = reinterpret_cast<PingPong *>(pContext);
+   for ( btUnsigned64bitInt i = 0 ; i < p->ops ; ++i ) {
+      p->barPing.Wait();
+      p->barPing.Reset();
+      p->barPong.Post(1);
+   }
+}
+
+// Round trips between two threads, each handing off through a Barrier.
+static double BarrierPingPong(btUnsigned64bitInt ops)
+{
+   PingPong p;
+   p.ops = ops;
+   p.barPing.Create(1, false);
+   p.barPong.Create(1, false);
+
+   OSLThread *pThread = new OSLThread(BarPonger, OSLThread::THREADPRIORITY_NORMAL, &p);
+
+   btUnsigned64bitInt t0 = BenchNow();
+   for ( btUnsigned64bitInt i = 0 ; i < ops ; ++i ) {
+      p.barPing.Post(1);
+      p.barPong.Wait();
+      p.barPong.Reset();
+   }
+   double ns = BenchSince(t0);
+
+   pThread->Join();
+   delete pThread;
+   return ns;
+}
+
+void AddOSALBenches(BenchList &rList)
+{
+   BenchDesc d[] =
+   {
+      { "threadgroup_add_throughput",    ThreadGroupAddThroughput,    200000 },
+      { "threadgroup_dispatch_latency",  ThreadGroupDispatchLatency,  20000  },
+      { "threadgroup_burst_static",      ThreadGroupBurstStatic,      2000   },
+      { "threadgroup_burst_elastic",     ThreadGroupBurstElastic,     2000   },
+      { "threadgroup_critical_fifo",     ThreadGroupCriticalFIFO,     200    },
+      { "threadgroup_critical_priority", ThreadGroupCriticalPriority, 200    },
+      { "csemaphore_pingpong",           CSemaphorePingPong,          20000  },
+      { "barrier_pingpong",              BarrierPingPong,             20000  },
+   };
+   rList.insert(rList.end(), d, d + sizeof(d) / sizeof(d[0]));
+}
@@ -0,0 +1,210 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// file BenchRuntime.cpp
+/// brief Runtime microbenchmarks: schedDispatchable() delivery, start/stop.
+/// ingroup aalbench
+/// verbatim
+/// Accelerator Abstraction Layer Test Application
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version. endverbatim
+//****************************************************************************
+#include "aalbench.h"
+
+#include <aalsdk/Runtime.h>
+
+USING_NAMESPACE(AAL)
+
+//=============================================================================
+// BenchClient - Runtime client. Start and stop post m_Sem so that the
+//               Runtime can be brought up outside the timed region.
+//=============================================================================
+class BenchClient : public CAASBase,
+                    public IRuntimeClient
+{
+public:
+   BenchClient() :
+      m_bOK(false)
+   {
+      SetInterface(iidRuntimeClient, dynamic_cast<IRuntimeClient *>(this));
+      m_Sem.Create(0, 1);
+   }
+
+   void Wait() { m_Sem.Wait(); }
+   btBool OK() const { return m_bOK; }
+
+   // <IRuntimeClient>
+   void runtimeCreateOrGetProxyFailed(IEvent const & ) { m_bOK = false; m_Sem.Post(1); }
+   void runtimeStarted(IRuntime * , const NamedValueSet & ) { m_bOK = true; m_Sem.Post(1); }
+   void runtimeStopped(IRuntime * )                    { m_Sem.Post(1); }
+   void runtimeStartFailed(const IEvent & )            { m_bOK = false; m_Sem.Post(1); }
+   void runtimeStopFailed(const IEvent & )             { m_Sem.Post(1); }
+   void runtimeAllocateServiceFailed(IEvent const & )  { }
+   void runtimeAllocateServiceSucceeded(IBase * ,
+                                        TransactionID const & ) { }
+   void runtimeEvent(const IEvent & )                  { }
+   // </IRuntimeClient>
+
+protected:
+   btBool     m_bOK;
+   CSemaphore m_Sem;
+};
+
+// Like the Runtime's own messages, each is allocated by the sender and
+//  deletes itself once delivered.
+class PostD : public IDispatchable
+{
+public:
+   PostD(CSemaphore &rSem) : m_rSem(rSem) {}
+   void operator() ()
+   {
+      m_rSem.Post(1);
+      delete this;
+   }
+
+   CSemaphore &m_rSem;
+};
+
+// The last of a batch to be delivered posts the semaphore.
+class CountdownD : public IDispatchable
+{
+public:
+   CountdownD(btUnsigned64bitInt *pRemaining, CSemaphore &rSem) :
+      m_pRemaining(pRemaining),
+      m_rSem(rSem)
+   {}
+   void operator() ()
+   {
+      if ( 0 == __sync_sub_and_fetch(m_pRemaining, 1) ) {
+         m_rSem.Post(1);
+      }
+      delete this;
+   }
+
+   btUnsigned64bitInt *m_pRemaining;
+   CSemaphore         &m_rSem;
+};
+
+typedef double (*RuntimeBenchFn)(Runtime & , btUnsigned64bitInt );
+
+// Runs fn with a started Runtime.
+static double WithRuntime(RuntimeBenchFn fn, btUnsigned64bitInt ops)
+{
+   BenchClient   client;
+   Runtime       runtime(&client);
+   NamedValueSet configArgs;
+
+   runtime.start(configArgs);
+   client.Wait();
+   if ( !client.OK() ) {
+      return -1.0;
+   }
+
+   double ns = fn(runtime, ops);
+
+   runtime.stop();
+   client.Wait();
+   return ns;
+}
+
+// From schedDispatchable() until the client code has run, one at a time.
+static double SchedLatency(Runtime &runtime, btUnsigned64bitInt ops)
+{
+   CSemaphore sem;
+   sem.Create(0, 1);
+
+   btUnsigned64bitInt t0 = BenchNow();
+   for ( btUnsigned64bitInt i = 0 ; i < ops ; ++i ) {
+      if ( !runtime.schedDispatchable(new PostD(sem)) ) {
+         return -1.0;
+      }
+      sem.Wait();
+   }
+   return BenchSince(t0);
+}
+
+// ops messages scheduled back to back, until the last has been delivered.
+static double SchedThroughput(Runtime &runtime, btUnsigned64bitInt ops)
+{
+   CSemaphore         sem;
+   btUnsigned64bitInt remaining = ops;
+   sem.Create(0, 1);
+
+   btUnsigned64bitInt t0 = BenchNow();
+   for ( btUnsigned64bitInt i = 0 ; i < ops ; ++i ) {
+      if ( !runtime.schedDispatchable(new CountdownD(&remaining, sem)) ) {
+         return -1.0;
+      }
+   }
+   sem.Wait();
+   return BenchSince(t0);
+}
+
+// Construction, start() until runtimeStarted(), stop() until runtimeStopped()
+//  and destruction of a Runtime, one after the other.
+static double RuntimeStartStop(btUnsigned64bitInt ops)
+{
+   NamedValueSet configArgs;
+
+   btUnsigned64bitInt t0 = BenchNow();
+   for ( btUnsigned64bitInt i = 0 ; i < ops ; ++i ) {
+      BenchClient client;
+      Runtime     runtime(&client);
+
+      runtime.start(configArgs);
+      client.Wait();
+      if ( !client.OK() ) {
+         return -1.0;
+      }
+
+      runtime.stop();
+      client.Wait();
+   }
+   return BenchSince(t0);
+}
+
+static double RuntimeSchedLatency(btUnsigned64bitInt ops)
+{
+   return WithRuntime(SchedLatency, ops);
+}
+
+static double RuntimeSchedThroughput(btUnsigned64bitInt ops)
+{
+   return WithRuntime(SchedThroughput, ops);
+}
+
+void AddRuntimeBenches(BenchList &rList)
+{
+   BenchDesc d[] =
+   {
+      { "runtime_sched_latency",    RuntimeSchedLatency,    20000  },
+      { "runtime_sched_throughput", RuntimeSchedThroughput, 200000 },
+      { "runtime_start_stop",       RuntimeStartStop,       200    },
+   };
+   rList.insert(rList.end(), d, d + sizeof(d) / sizeof(d[0]));
+}
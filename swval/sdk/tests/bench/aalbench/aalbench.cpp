@@ -0,0 +1,341 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// file aalbench.cpp
+/// brief AAS runtime microbenchmark driver.
+/// ingroup aalbench
+/// verbatim
+/// Accelerator Abstraction Layer Test Application
+///
+/// Runs the OSAL, AASLib and Runtime microbenchmarks and writes the results
+/// as JSON. Each benchmark is warmed up, then repeated; the median ns/op of
+/// the repetitions is reported along with the fastest and slowest.
+///
+/// Given a baseline (the JSON of an earlier run), each result is compared
+/// with it and any that slowed by more than the threshold is flagged as a
+/// regression. A progress table goes to stderr.
+///
+/// Usage: aalbench [--list] [--filter SUBSTR] [--reps N] [--scale F]
+///                 [--out FILE] [--baseline FILE] [--threshold PCT]
+///
+/// Exit status: 0 on success, 1 on error, 2 if any benchmark regressed.
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version. endverbatim
+//****************************************************************************
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <map>
+#include <algorithm>
+
+#include "aalbench.h"
+
+USING_NAMESPACE(std)
+USING_NAMESPACE(AAL)
+
+#define AALBENCH_FORMAT 1
+
+struct Result
+{
+   string             name;
+   btUnsigned64bitInt ops;
+   double             median;   // ns/op
+   double             fastest;
+   double             slowest;
+   btBool             bHasBaseline;
+   double             baseline;
+   double             change;   // percent, positive is slower
+   btBool             bRegressed;
+};
+
+typedef map<string, double> Baseline;
+
+static void Usage(const char *argv0)
+{
+   cerr << "Usage: " << argv0 << " [--list] [--filter SUBSTR] [--reps N] [--scale F]" << endl
+        << "       " << string(strlen(argv0), ' ') << " [--out FILE] [--baseline FILE] [--threshold PCT]" << endl;
+}
+
+// Warm up, then time reps repetitions of ops operations each.
+static btBool Measure(const BenchDesc &rDesc, double scale, unsigned reps, Result &rResult)
+{
+   btUnsigned64bitInt ops = (btUnsigned64bitInt)(rDesc.ops * scale);
+   if ( 0 == ops ) {
+      ops = 1;
+   }
+
+   if ( rDesc.fn(std::max((btUnsigned64bitInt)1, ops / 10)) < 0.0 ) {
+      return false;
+   }
+
+   vector<double> perOp;
+   for ( unsigned r = 0 ; r < reps ; ++r ) {
+      double ns = rDesc.fn(ops);
+      if ( ns < 0.0 ) {
+         return false;
+      }
+      perOp.push_back(ns / ops);
+   }
+   std::sort(perOp.begin(), perOp.end());
+
+   rResult.name         = rDesc.name;
+   rResult.ops          = ops;
+   rResult.median       = perOp[perOp.size() / 2];
+   rResult.fastest      = perOp.front();
+   rResult.slowest      = perOp.back();
+   rResult.bHasBaseline = false;
+   rResult.baseline     = 0.0;
+   rResult.change       = 0.0;
+   rResult.bRegressed   = false;
+   return true;
+}
+
+// The value of "key": "..." in line, which aalbench wrote.
+static btBool JsonString(const string &line, const char *key, string &rValue)
+{
+   string            pat = string("\"") + key + "\": \"";
+   string::size_type pos = line.find(pat);
+   if ( string::npos == pos ) {
+      return false;
+   }
+   pos += pat.size();
+   string::size_type end = line.find('"', pos);
+   if ( string::npos == end ) {
+      return false;
+   }
+   rValue = line.substr(pos, end - pos);
+   return true;
+}
+
+// The value of "key": number in line, which aalbench wrote.
+static btBool JsonNumber(const string &line, const char *key, double &rValue)
+{
+   string            pat = string("\"") + key + "\": ";
+   string::size_type pos = line.find(pat);
+   if ( string::npos == pos ) {
+      return false;
+   }
+   const char *p   = line.c_str() + pos + pat.size();
+   char       *end = NULL;
+   rValue = strtod(p, &end);
+   return end != p;
+}
+
+// Reads the per-benchmark medians of an earlier run. Results are written
+//  one per line, so no general JSON parser is needed.
+static btBool LoadBaseline(const char *path, Baseline &rBaseline)
+{
+   ifstream in(path);
+   if ( !in.is_open() ) {
+      cerr << "Cannot open baseline " << path << endl;
+      return false;
+   }
+
+   string line;
+   while ( getline(in, line) ) {
+      string name;
+      double ns;
+      if ( JsonString(line, "name", name) && JsonNumber(line, "ns_per_op", ns) ) {
+         rBaseline[name] = ns;
+      }
+   }
+
+   if ( rBaseline.empty() ) {
+      cerr << "No results in baseline " << path << endl;
+      return false;
+   }
+   return true;
+}
+
+static string JsonEscape(const string &s)
+{
+   string out;
+   for ( string::size_type i = 0 ; i < s.size() ; ++i ) {
+      if ( ( '"' == s[i] ) || ( '\\' == s[i] ) ) {
+         out += '\\';
+      }
+      out += s[i];
+   }
+   return out;
+}
+
+static void WriteJson(ostream        &os,
+                      vector<Result> &rResults,
+                      unsigned        reps,
+                      double          scale,
+                      const char     *baseline,
+                      double          threshold,
+                      unsigned        regressions)
+{
+   os << "{" << endl
+      << "  \"aalbench\": " << AALBENCH_FORMAT << "," << endl
+      << "  \"reps\": " << reps << "," << endl
+      << "  \"scale\": " << scale << "," << endl;
+   if ( NULL != baseline ) {
+      os << "  \"baseline\": \"" << JsonEscape(baseline) << "\"," << endl
+         << "  \"threshold_pct\": " << threshold << "," << endl
+         << "  \"regressions\": " << regressions << "," << endl;
+   }
+   os << "  \"results\": [" << endl;
+
+   os << fixed << setprecision(2);
+   for ( vector<Result>::size_type i = 0 ; i < rResults.size() ; ++i ) {
+      const Result &r = rResults[i];
+      os << "    { \"name\": \"" << r.name << "\""
+         << ", \"ops\": " << r.ops
+         << ", \"ns_per_op\": " << r.median
+         << ", \"min_ns_per_op\": " << r.fastest
+         << ", \"max_ns_per_op\": " << r.slowest
+         << ", \"ops_per_sec\": " << ( ( r.median > 0.0 ) ? 1.0e9 / r.median : 0.0 );
+      if ( r.bHasBaseline ) {
+         os << ", \"baseline_ns_per_op\": " << r.baseline
+            << ", \"change_pct\": " << r.change
+            << ", \"regressed\": " << ( r.bRegressed ? "true" : "false" );
+      }
+      os << " }" << ( ( i + 1 < rResults.size() ) ? "," : "" ) << endl;
+   }
+
+   os << "  ]" << endl
+      << "}" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+   const char *filter    = NULL;
+   const char *out       = NULL;
+   const char *baseline  = NULL;
+   unsigned    reps      = 5;
+   double      scale     = 1.0;
+   double      threshold = 10.0;
+   btBool      bList     = false;
+
+   for ( int i = 1 ; i < argc ; ++i ) {
+      string arg(argv[i]);
+      btBool bHasValue = ( i + 1 < argc );
+
+      if ( "--list" == arg ) {
+         bList = true;
+      } else if ( ( "--filter" == arg ) && bHasValue ) {
+         filter = argv[++i];
+      } else if ( ( "--reps" == arg ) && bHasValue ) {
+         reps = (unsigned)strtoul(argv[++i], NULL, 0);
+      } else if ( ( "--scale" == arg ) && bHasValue ) {
+         scale = strtod(argv[++i], NULL);
+      } else if ( ( "--out" == arg ) && bHasValue ) {
+         out = argv[++i];
+      } else if ( ( "--baseline" == arg ) && bHasValue ) {
+         baseline = argv[++i];
+      } else if ( ( "--threshold" == arg ) && bHasValue ) {
+         threshold = strtod(argv[++i], NULL);
+      } else {
+         Usage(argv[0]);
+         return 1;
+      }
+   }
+
+   if ( ( 0 == reps ) || ( scale <= 0.0 ) || ( threshold < 0.0 ) ) {
+      Usage(argv[0]);
+      return 1;
+   }
+
+   BenchList benches;
+   AddOSALBenches(benches);
+   AddAASBenches(benches);
+   AddRuntimeBenches(benches);
+
+   if ( bList ) {
+      for ( BenchList::size_type i = 0 ; i < benches.size() ; ++i ) {
+         cout << benches[i].name << endl;
+      }
+      return 0;
+   }
+
+   Baseline base;
+   if ( ( NULL != baseline ) && !LoadBaseline(baseline, base) ) {
+      return 1;
+   }
+
+   cerr << setw(28) << left << "benchmark" << right
+        << setw(14) << "ns/op"
+        << setw(14) << "baseline"
+        << setw(10) << "change" << endl;
+
+   vector<Result> results;
+   unsigned       regressions = 0;
+
+   for ( BenchList::size_type i = 0 ; i < benches.size() ; ++i ) {
+      if ( ( NULL != filter ) && ( NULL == strstr(benches[i].name, filter) ) ) {
+         continue;
+      }
+
+      Result r;
+      if ( !Measure(benches[i], scale, reps, r) ) {
+         cerr << benches[i].name << " failed" << endl;
+         return 1;
+      }
+
+      Baseline::const_iterator itr = base.find(r.name);
+      if ( ( base.end() != itr ) && ( itr->second > 0.0 ) ) {
+         r.bHasBaseline = true;
+         r.baseline     = itr->second;
+         r.change       = ( r.median - r.baseline ) * 100.0 / r.baseline;
+         r.bRegressed   = ( r.change > threshold );
+         if ( r.bRegressed ) {
+            ++regressions;
+         }
+      }
+
+      cerr << setw(28) << left << r.name << right << fixed << setprecision(1)
+           << setw(14) << r.median;
+      if ( r.bHasBaseline ) {
+         cerr << setw(14) << r.baseline
+              << setw(9)  << showpos << r.change << noshowpos << "%"
+              << ( r.bRegressed ? "  REGRESSED" : "" );
+      }
+      cerr << endl;
+
+      results.push_back(r);
+   }
+
+   if ( NULL != out ) {
+      ofstream os(out);
+      if ( !os.is_open() ) {
+         cerr << "Cannot write " << out << endl;
+         return 1;
+      }
+      WriteJson(os, results, reps, scale, baseline, threshold, regressions);
+   } else {
+      WriteJson(cout, results, reps, scale, baseline, threshold, regressions);
+   }
+
+   return ( regressions > 0 ) ? 2 : 0;
+}
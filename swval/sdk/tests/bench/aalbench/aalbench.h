@@ -0,0 +1,77 @@
+// Copyright(c) 2016, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//****************************************************************************
+/// file aalbench.h
+/// brief Shared definitions for the AAS runtime microbenchmarks.
+/// ingroup aalbench
+/// verbatim
+/// Accelerator Abstraction Layer Test Application
+///
+/// Each benchmark performs a given number of operations and returns the
+/// time they took. Setup and teardown happen outside the timed region.
+///
+/// HISTORY:
+/// WHEN:          WHO:     WHAT:
+/// 10/18/2016              Initial version. endverbatim
+//****************************************************************************
+#ifndef __AALBENCH_H__
+#define __AALBENCH_H__
+#include <time.h>
+#include <vector>
+
+#include <aalsdk/AAL.h>
+
+/// Times ops operations. Returns the elapsed ns, or a negative value on failure.
+typedef double (*BenchFn)(AAL::btUnsigned64bitInt ops);
+
+struct BenchDesc
+{
+   const char             *name;   ///< Stable key, used to match baselines.
+   BenchFn                 fn;
+   AAL::btUnsigned64bitInt ops;    ///< Operations per repetition, before --scale.
+};
+
+typedef std::vector<BenchDesc> BenchList;
+
+/// CLOCK_MONOTONIC in ns.
+inline AAL::btUnsigned64bitInt BenchNow()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (AAL::btUnsigned64bitInt)ts.tv_sec * 1000000000ULL + (AAL::btUnsigned64bitInt)ts.tv_nsec;
+}
+
+inline double BenchSince(AAL::btUnsigned64bitInt t0)
+{
+   return (double)(BenchNow() - t0);
+}
+
+// Each suite appends its benchmarks, in the order they are run.
+void AddOSALBenches(BenchList &rList);
+void AddAASBenches(BenchList &rList);
+void AddRuntimeBenches(BenchList &rList);
+
+#endif // __AALBENCH_H__
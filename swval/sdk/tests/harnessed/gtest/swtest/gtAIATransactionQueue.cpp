@@ -0,0 +1,240 @@
+// INTEL CONFIDENTIAL - For Intel Internal Use Only
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+#include "gtCommon.h"
+#include <aalsdk/uaia/AIATransactionQueue.h>
+
+#if defined( __AAL_LINUX__ )
+
+class FakeTransaction : public IAIATransaction
+{
+public:
+   FakeTransaction(btUnsignedInt Id=0, uid_errnum_e Result=uid_errnumOK) :
+      m_Id(Id),
+      m_Result(Result),
+      m_errno(uid_errnumOK),
+      m_Seq(0)
+   {}
+
+   btVirtAddr                 getPayloadPtr()const         { return NULL;                  }
+   btWSSize                   getPayloadSize()const        { return 0;                     }
+   stTransactionID_t  const   getTranID()const             { return stTransactionID_t();   }
+   uid_msgIDs_e               getMsgID()const              { return reqid_UID_SendAFU;     }
+   uid_errnum_e               getErrno()const              { return m_errno;               }
+   void                       setErrno(uid_errnum_e e)     { m_errno = e;                  }
+
+   btUnsignedInt m_Id;
+   uid_errnum_e  m_Result;   // What the stand-in driver answers
+   uid_errnum_e  m_errno;
+   btUnsignedInt m_Seq;      // Order in which the driver saw it, from 1
+};
+
+// Stands in for the proxy and the driver behind it: each SendTransaction()
+//  holds the caller until the test opens the gate, as an ioctl would until
+//  the device answered, and records how many callers were inside at once.
+class FakeProxy : public IAFUProxy,
+                  public CriticalSection
+{
+public:
+   FakeProxy() :
+      m_Inside(0),
+      m_MaxInside(0),
+      m_Seq(0),
+      m_bGateOpen(true)
+   {
+      m_Gate.Create(0, INT_MAX);
+   }
+
+   void CloseGate() { m_bGateOpen = false; }
+   void OpenGate()
+   {
+      m_bGateOpen = true;
+      m_Gate.Post(1000);
+   }
+
+   btBool SendTransaction( IAIATransaction *pAFUmessage )
+   {
+      FakeTransaction *pTrans = static_cast<FakeTransaction *>(pAFUmessage);
+      {
+         AutoLock(this);
+         if ( ++m_Inside > m_MaxInside ) {
+            m_MaxInside = m_Inside;
+         }
+         pTrans->m_Seq = ++m_Seq;
+      }
+
+      if ( !m_bGateOpen ) {
+         m_Gate.Wait();
+      }
+      SleepMilli(1);
+
+      pTrans->setErrno(pTrans->m_Result);
+      {
+         AutoLock(this);
+         --m_Inside;
+      }
+      return true;
+   }
+
+   btBool SendTransactions( AIATransactionBatch & ) { return false; }
+   btBool MapWSID(btWSSize , btWSID , btVirtAddr * , NamedValueSet const & ) { return false; }
+   void   UnMapWSID(btVirtAddr , btWSSize ) {}
+
+   btUnsignedInt MaxInside() const
+   {
+      AutoLock(this);
+      return m_MaxInside;
+   }
+
+   btUnsignedInt         m_Inside;
+   btUnsignedInt         m_MaxInside;
+   btUnsignedInt         m_Seq;
+   volatile btBool       m_bGateOpen;
+   CSemaphore            m_Gate;
+};
+
+class AIATransactionQueue_f : public ::testing::Test,
+                              public IAIATransactionBatchClient
+{
+public:
+   AIATransactionQueue_f() :
+      m_Completions(0),
+      m_pCompleted(NULL),
+      m_Context(NULL)
+   {}
+
+   void TransactionsComplete(AIATransactionBatch &rBatch)
+   {
+      m_pCompleted = &rBatch;
+      m_Context    = rBatch.Context();
+      ++m_Completions;
+   }
+
+   FakeProxy            m_Proxy;
+   volatile int         m_Completions;
+   AIATransactionBatch *m_pCompleted;
+   btApplicationContext m_Context;
+};
+
+TEST_F(AIATransactionQueue_f, aal0846)
+{
+   // Submit() returns while the transactions are still with the driver.
+   //  Those of an unordered batch are sent concurrently, up to the number of
+   //  submission threads, and Wait() returns once all are done. Failures
+   //  counts the transactions the driver failed.
+
+   AIATransactionQueue q(&m_Proxy, 4);
+   ASSERT_TRUE(q.IsOK());
+   EXPECT_EQ(4, q.Threads());
+
+   FakeTransaction t[8];
+   t[5].m_Result = uid_errnumBadParameter;
+
+   AIATransactionBatch batch;
+   for ( btUnsignedInt i = 0 ; i < 8 ; ++i ) {
+      t[i].m_Id = i;
+      batch.Add(&t[i]);
+   }
+   EXPECT_EQ(8, batch.Count());
+   EXPECT_TRUE(batch.IsDone());   // not yet submitted
+
+   m_Proxy.CloseGate();
+   ASSERT_TRUE(q.Submit(batch));
+
+   EXPECT_FALSE(batch.IsDone());
+   EXPECT_FALSE(batch.Wait(10));
+   EXPECT_FALSE(q.Submit(batch));   // still outstanding
+
+   // All four threads reach the driver.
+   for ( int i = 0 ; ( i < 5000 ) && ( m_Proxy.MaxInside() < 4 ) ; ++i ) {
+      SleepMilli(1);
+   }
+   EXPECT_EQ(4, m_Proxy.MaxInside());
+
+   m_Proxy.OpenGate();
+   ASSERT_TRUE(batch.Wait());
+   EXPECT_TRUE(batch.IsDone());
+   EXPECT_TRUE(batch.Wait(0));   // stays signaled
+   EXPECT_EQ(1, batch.Failures());
+
+   for ( btUnsignedInt i = 0 ; i < 8 ; ++i ) {
+      EXPECT_NE(0, t[i].m_Seq);
+      EXPECT_EQ(t[i].m_Result, t[i].getErrno());
+   }
+
+   // A completed batch may be submitted again.
+   t[5].m_Result = uid_errnumOK;
+   ASSERT_TRUE(q.Submit(batch));
+   ASSERT_TRUE(batch.Wait());
+   EXPECT_EQ(0, batch.Failures());
+
+   // An empty batch completes at once.
+   AIATransactionBatch empty;
+   ASSERT_TRUE(q.Submit(empty));
+   EXPECT_TRUE(empty.IsDone());
+   EXPECT_TRUE(empty.Wait(0));
+}
+
+TEST_F(AIATransactionQueue_f, aal0847)
+{
+   // An ordered batch is sent in sequence and stops at the first failure;
+   //  the rest are failed unsent. A batch with a client reports completion
+   //  through TransactionsComplete(), with its context. Destroying the queue
+   //  sends whatever was already submitted.
+
+   btApplicationContext ctx = reinterpret_cast<btApplicationContext>(0x1234);
+
+   FakeTransaction t[6];
+   FakeTransaction u[3];
+
+   AIATransactionBatch ordered(true, this, ctx);
+   AIATransactionBatch later(true);
+
+   for ( btUnsignedInt i = 0 ; i < 6 ; ++i ) {
+      t[i].m_Id = i;
+      ordered.Add(&t[i]);
+   }
+   t[3].m_Result = uid_errnumDeviceBusy;
+
+   for ( btUnsignedInt i = 0 ; i < 3 ; ++i ) {
+      later.Add(&u[i]);
+   }
+
+   {
+      AIATransactionQueue q(&m_Proxy, 2);
+      ASSERT_TRUE(q.Submit(ordered));
+      ASSERT_TRUE(ordered.Wait());
+
+      // The client may run just after Wait() returns.
+      for ( int i = 0 ; ( i < 5000 ) && ( 0 == m_Completions ) ; ++i ) {
+         SleepMilli(1);
+      }
+      EXPECT_EQ(1, m_Completions);
+      EXPECT_EQ(&ordered, m_pCompleted);
+      EXPECT_EQ(ctx, m_Context);
+
+      for ( btUnsignedInt i = 0 ; i < 4 ; ++i ) {
+         EXPECT_EQ(i + 1, t[i].m_Seq);
+      }
+      EXPECT_EQ(uid_errnumOK,             t[2].getErrno());
+      EXPECT_EQ(uid_errnumDeviceBusy,     t[3].getErrno());
+      EXPECT_EQ(0,                        t[4].m_Seq);
+      EXPECT_EQ(uid_errnumAFUTransaction, t[4].getErrno());
+      EXPECT_EQ(uid_errnumAFUTransaction, t[5].getErrno());
+      EXPECT_EQ(3, ordered.Failures());
+
+      m_Proxy.CloseGate();
+      ASSERT_TRUE(q.Submit(later));
+      EXPECT_FALSE(later.IsDone());
+      m_Proxy.OpenGate();
+   }
+
+   EXPECT_TRUE(later.IsDone());
+   EXPECT_EQ(0, later.Failures());
+   EXPECT_LT(u[0].m_Seq, u[1].m_Seq);
+   EXPECT_LT(u[1].m_Seq, u[2].m_Seq);
+}
+
+#endif // __AAL_LINUX__
+
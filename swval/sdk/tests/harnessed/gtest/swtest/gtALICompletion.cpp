@@ -0,0 +1,163 @@
+// INTEL CONFIDENTIAL - For Intel Internal Use Only
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+#include "gtCommon.h"
+#include <aalsdk/utils/ALICompletion.h>
+
+#if defined( __AAL_LINUX__ )
+
+class ALICompletion_f : public ::testing::Test
+{
+public:
+   ALICompletion_f() :
+      m_pThread(NULL),
+      m_DelayMicros(0)
+   {
+      memset((void *)m_Words, 0, sizeof(m_Words));
+   }
+
+   virtual void TearDown()
+   {
+      if ( NULL != m_pThread ) {
+         m_pThread->Join();
+         delete m_pThread;
+         m_pThread = NULL;
+      }
+   }
+
+   // Stands in for the AFU: sets each word, last first, m_DelayMicros apart.
+   static void Setter(OSLThread * , void *pContext)
+   {
+      ALICompletion_f *f = reinterpret_cast<ALICompletion_f *>(pContext);
+      for ( int i = NumWords - 1 ; i >= 0 ; --i ) {
+         SleepMicro(f->m_DelayMicros);
+         f->m_Words[i] = 0x100 | i;
+         if ( f->m_bNotify ) {
+            f->m_Completion.completionNotify();
+         }
+      }
+   }
+
+   void StartSetter(btTime DelayMicros, btBool bNotify)
+   {
+      m_DelayMicros = DelayMicros;
+      m_bNotify     = bNotify;
+      m_pThread     = new OSLThread(ALICompletion_f::Setter, OSLThread::THREADPRIORITY_NORMAL, this);
+   }
+
+   enum { NumWords = 8 };
+
+   ALICompletion               m_Completion;
+   volatile btUnsigned32bitInt m_Words[NumWords];
+   OSLThread                  *m_pThread;
+   btTime                      m_DelayMicros;
+   btBool                      m_bNotify;
+};
+
+TEST_F(ALICompletion_f, aal0844)
+{
+   // A condition is ( *pWord & Mask ) == Value, for 32- and 64-bit words. A
+   //  wait that sees it met releases the handle; a wait that times out leaves
+   //  it registered until cancelled.
+
+   volatile btUnsigned64bitInt word64 = 0;
+
+   ALICompletionHandle h32 = m_Completion.completionRegister(&m_Words[0], 0x1, 0x1);
+   ALICompletionHandle h64 = m_Completion.completionRegister(&word64, 0xff00000000ULL, 0x1200000000ULL);
+   ASSERT_NE(0, h32);
+   ASSERT_NE(0, h64);
+   EXPECT_NE(h32, h64);
+
+   EXPECT_FALSE(m_Completion.completionTest(h32));
+   EXPECT_EQ(IALICompletion::e_Timeout, m_Completion.completionWait(h32, 2));
+
+   m_Words[0] = 0x3;
+   word64     = 0x12000000ffULL;
+   EXPECT_TRUE(m_Completion.completionTest(h32));
+   EXPECT_EQ(IALICompletion::e_Done, m_Completion.completionWait(h32, 0));
+   EXPECT_EQ(IALICompletion::e_Done, m_Completion.completionWait(h64, AAL_INFINITE_WAIT));
+
+   // Released.
+   EXPECT_FALSE(m_Completion.completionTest(h32));
+   EXPECT_EQ(IALICompletion::e_BadHandle, m_Completion.completionWait(h32, 0));
+   EXPECT_EQ(IALICompletion::e_BadHandle, m_Completion.completionWait(0, 0));
+
+   // A slot reused after release gets a new handle.
+   ALICompletionHandle h = m_Completion.completionRegister(&m_Words[1], 0x1, 0x1);
+   ASSERT_NE(0, h);
+   EXPECT_NE(h32, h);
+   m_Completion.completionCancel(h);
+   EXPECT_EQ(IALICompletion::e_BadHandle, m_Completion.completionWait(h, 0));
+
+   // The table holds ALICOMPLETION_SLOTS conditions.
+   std::vector<ALICompletionHandle> all;
+   for ( int i = 0 ; i < ALICOMPLETION_SLOTS ; ++i ) {
+      all.push_back(m_Completion.completionRegister(&m_Words[1], 0x1, 0x1));
+      ASSERT_NE(0, all.back());
+   }
+   EXPECT_EQ(0, m_Completion.completionRegister(&m_Words[1], 0x1, 0x1));
+   for ( size_t i = 0 ; i < all.size() ; ++i ) {
+      m_Completion.completionCancel(all[i]);
+   }
+
+   ALICompletionStats stats;
+   m_Completion.completionStats(stats);
+   EXPECT_EQ(2, stats.waits);
+   EXPECT_EQ(1, stats.timeouts);
+   EXPECT_EQ(2, stats.spinCompletions);
+   EXPECT_EQ(0, stats.notifies);
+}
+
+TEST_F(ALICompletion_f, aal0845)
+{
+   // One thread may wait on many outstanding conditions. completionWaitAny()
+   //  reports each as it is met, and waits long enough to reach the sleep
+   //  phase are counted as such.
+
+   ALICompletionHandle h[NumWords];
+   for ( int i = 0 ; i < NumWords ; ++i ) {
+      h[i] = m_Completion.completionRegister(&m_Words[i], 0xff, i);
+      ASSERT_NE(0, h[i]);
+      m_Words[i] = 0xff;   // not yet
+   }
+
+   StartSetter(2000, true);
+
+   std::vector<btBool> seen(NumWords, false);
+   for ( int n = 0 ; n < NumWords ; ++n ) {
+      std::vector<ALICompletionHandle> pending;
+      std::vector<int>                 which;
+      for ( int i = 0 ; i < NumWords ; ++i ) {
+         if ( !seen[i] ) {
+            pending.push_back(h[i]);
+            which.push_back(i);
+         }
+      }
+
+      btUnsignedInt index = NumWords;
+      ASSERT_EQ(IALICompletion::e_Done,
+                m_Completion.completionWaitAny(&pending[0], (btUnsignedInt)pending.size(), 5000, &index));
+      ASSERT_LT(index, pending.size());
+      EXPECT_EQ(NumWords - 1 - n, which[index]);   // set last first
+      seen[which[index]] = true;
+   }
+
+   ALICompletionStats stats;
+   m_Completion.completionStats(stats);
+   EXPECT_EQ((btUnsigned64bitInt)NumWords, stats.waits);
+   EXPECT_EQ(0, stats.timeouts);
+   EXPECT_EQ((btUnsigned64bitInt)NumWords, stats.spinCompletions + stats.yieldCompletions + stats.sleepCompletions);
+   EXPECT_GT(stats.sleepCompletions, 0);
+   EXPECT_EQ((btUnsigned64bitInt)NumWords, stats.notifies);
+   EXPECT_GE(stats.maxWaitNanos, 1000000ULL);
+   EXPECT_GE(stats.totalWaitNanos, stats.maxWaitNanos);
+
+   // completionWaitFor() registers and releases in one call.
+   m_Words[0] = 0;
+   EXPECT_EQ(IALICompletion::e_Timeout, m_Completion.completionWaitFor(&m_Words[0], 0x1, 0x1, 1));
+   m_Words[0] = 1;
+   EXPECT_EQ(IALICompletion::e_Done, m_Completion.completionWaitFor(&m_Words[0], 0x1, 0x1, 1));
+}
+
+#endif // __AAL_LINUX__
@@ -0,0 +1,186 @@
+// INTEL CONFIDENTIAL - For Intel Internal Use Only
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+#include "gtCommon.h"
+#include "aalsdk/utils/ALITelemetryShm.h"
+
+#if defined( __AAL_LINUX__ )
+
+// Every field of snapshot n is derived from n, so a reader can tell a torn
+//  copy from a whole one.
+static void FillSnapshot(ALITelemetrySnapshot &s, btUnsigned64bitInt n)
+{
+   memset(&s, 0, sizeof(s));
+   s.timestamp     = n;
+   s.collectTime   = n + 1;
+   s.valid         = ALITELEMETRY_ALL;
+   s.temperature   = n % 128;
+   s.powerConsumed = n * 3;
+   s.fmeError0     = ~n;
+   s.rasWarnError  = n ^ 0x5a5a5a5a5a5a5a5aULL;
+   s.perf.timestamp = n;
+   for ( int i = 0 ; i < aliPerfNumCounters ; ++i ) {
+      s.perf.counters[i] = n * ( i + 1 );
+   }
+}
+
+static btBool CheckSnapshot(const ALITelemetrySnapshot &s)
+{
+   btUnsigned64bitInt n = s.timestamp;
+
+   if ( ( s.collectTime != n + 1 ) ||
+        ( s.valid != ALITELEMETRY_ALL ) ||
+        ( s.temperature != n % 128 ) ||
+        ( s.powerConsumed != n * 3 ) ||
+        ( s.fmeError0 != ~n ) ||
+        ( s.rasWarnError != ( n ^ 0x5a5a5a5a5a5a5a5aULL ) ) ||
+        ( s.perf.timestamp != n ) ) {
+      return false;
+   }
+   for ( int i = 0 ; i < aliPerfNumCounters ; ++i ) {
+      if ( s.perf.counters[i] != n * ( i + 1 ) ) {
+         return false;
+      }
+   }
+   return true;
+}
+
+class ALITelemetryShm_f : public ::testing::Test
+{
+public:
+   virtual void SetUp()
+   {
+      sprintf(m_Name, "/gtALITelemetry.%d", (int)GetProcessID());
+      m_Writes = 0;
+      m_Bad.Create(0, INT_MAX);
+      m_Ready.Create(0, INT_MAX);
+   }
+
+   virtual void TearDown()
+   {
+      m_Writer.Destroy();
+   }
+
+   static void Reader(OSLThread * , void *pContext)
+   {
+      ALITelemetryShm_f   *f = reinterpret_cast<ALITelemetryShm_f *>(pContext);
+      ALITelemetryReader   r;
+      ALITelemetrySnapshot s;
+      btUnsigned64bitInt   last = 0;
+
+      if ( !r.Open(f->m_Name) ) {
+         f->m_Bad.Post(1);
+         f->m_Ready.Post(1);
+         return;
+      }
+      f->m_Ready.Post(1);
+
+      while ( last < f->m_Writes ) {
+         if ( !r.Latest(s) ) {
+            continue;
+         }
+         if ( !CheckSnapshot(s) || ( s.timestamp < last ) ) {
+            f->m_Bad.Post(1);
+            return;
+         }
+         last = s.timestamp;
+      }
+   }
+
+   char               m_Name[64];
+   ALITelemetryWriter m_Writer;
+   btUnsigned64bitInt m_Writes;
+   CSemaphore         m_Bad;
+   CSemaphore         m_Ready;
+};
+
+TEST_F(ALITelemetryShm_f, aal0835)
+{
+   // A reader attaches to a live region and sees the newest snapshot. A
+   //  name that does not exist can't be opened.
+
+   ALITelemetryReader   r;
+   ALITelemetrySnapshot s;
+
+   EXPECT_FALSE(r.Open(m_Name));
+
+   ASSERT_TRUE(m_Writer.Create(m_Name, 250));
+   ASSERT_TRUE(r.Open(m_Name));
+   EXPECT_TRUE(r.IsLive());
+   EXPECT_EQ(250, r.PeriodMillis());
+
+   EXPECT_FALSE(r.Latest(s));
+
+   FillSnapshot(s, 7);
+   m_Writer.Publish(s);
+   FillSnapshot(s, 8);
+   m_Writer.Publish(s);
+
+   memset(&s, 0, sizeof(s));
+   ASSERT_TRUE(r.Latest(s));
+   EXPECT_EQ(8, s.timestamp);
+   EXPECT_TRUE(CheckSnapshot(s));
+}
+
+TEST_F(ALITelemetryShm_f, aal0836)
+{
+   // Once the writer goes away, attached readers stop reporting snapshots
+   //  and the name is removed.
+
+   ALITelemetryReader   r;
+   ALITelemetrySnapshot s;
+
+   ASSERT_TRUE(m_Writer.Create(m_Name, 100));
+   FillSnapshot(s, 1);
+   m_Writer.Publish(s);
+
+   ASSERT_TRUE(r.Open(m_Name));
+   EXPECT_TRUE(r.Latest(s));
+
+   m_Writer.Destroy();
+
+   EXPECT_FALSE(r.IsLive());
+   EXPECT_FALSE(r.Latest(s));
+
+   ALITelemetryReader r2;
+   EXPECT_FALSE(r2.Open(m_Name));
+}
+
+TEST_F(ALITelemetryShm_f, aal0837)
+{
+   // Load: 64 readers, each with its own mapping, poll while the writer
+   //  publishes. No reader sees a torn snapshot or time moving backwards.
+
+   const int  nReaders = 64;
+   OSLThread *readers[nReaders];
+   int        i;
+
+   ASSERT_TRUE(m_Writer.Create(m_Name, 1));
+   m_Writes = 50000;
+
+   for ( i = 0 ; i < nReaders ; ++i ) {
+      readers[i] = new OSLThread(ALITelemetryShm_f::Reader, OSLThread::THREADPRIORITY_NORMAL, this);
+   }
+   for ( i = 0 ; i < nReaders ; ++i ) {
+      m_Ready.Wait();
+   }
+
+   ALITelemetrySnapshot s;
+   for ( btUnsigned64bitInt n = 1 ; n <= m_Writes ; ++n ) {
+      FillSnapshot(s, n);
+      m_Writer.Publish(s);
+   }
+
+   for ( i = 0 ; i < nReaders ; ++i ) {
+      readers[i]->Join();
+      delete readers[i];
+   }
+
+   btInt cur = 0;
+   btInt max = 0;
+   EXPECT_TRUE(m_Bad.CurrCounts(cur, max));
+   EXPECT_EQ(0, cur);
+}
+
+#endif // __AAL_LINUX__
@@ -0,0 +1,294 @@
+// INTEL CONFIDENTIAL - For Intel Internal Use Only
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+#include "gtCommon.h"
+#include <aalsdk/utils/ALITrace.h>
+
+#if defined( __AAL_LINUX__ )
+
+// In-process ALI backend: a 4 KB register file, malloc'ed buffers with IOVAs
+//  starting at a configurable base, and eight UMsg cache lines.
+class FakeALI : public IALIMMIO,
+                public IALIBuffer,
+                public IALIUMsg,
+                public IALIReset
+{
+public:
+   enum { NumRegs = 512, NumUMsgs = 8 };
+
+   FakeALI(btPhysAddr iovaBase) :
+      m_NextIOVA(iovaBase),
+      m_HintMask(0),
+      m_Resets(0)
+   {
+      memset(m_Regs, 0, sizeof(m_Regs));
+      memset(m_UMsgs, 0, sizeof(m_UMsgs));
+   }
+   ~FakeALI()
+   {
+      std::map<btVirtAddr, btPhysAddr>::iterator itr;
+      for ( itr = m_Buffers.begin() ; m_Buffers.end() != itr ; ++itr ) {
+         free(itr->first);
+      }
+   }
+
+   btUnsigned64bitInt Reg(btCSROffset Offset) const { return m_Regs[Offset / 8]; }
+   btUnsigned64bitInt UMsg(btUnsignedInt n)  const { return m_UMsgs[n][0]; }
+   btUnsigned64bitInt HintMask()              const { return m_HintMask; }
+   int                Resets()                const { return m_Resets; }
+   size_t             Buffers()               const { return m_Buffers.size(); }
+
+   // <IALIMMIO>
+   btVirtAddr  mmioGetAddress( void ) { return reinterpret_cast<btVirtAddr>(m_Regs); }
+   btCSROffset mmioGetLength( void )  { return sizeof(m_Regs); }
+   btBool mmioRead32( const btCSROffset Offset, btUnsigned32bitInt * const pValue )
+   {
+      if ( Offset + 4 > sizeof(m_Regs) ) {
+         return false;
+      }
+      memcpy(pValue, reinterpret_cast<btByte *>(m_Regs) + Offset, 4);
+      return true;
+   }
+   btBool mmioWrite32( const btCSROffset Offset, const btUnsigned32bitInt Value )
+   {
+      if ( Offset + 4 > sizeof(m_Regs) ) {
+         return false;
+      }
+      memcpy(reinterpret_cast<btByte *>(m_Regs) + Offset, &Value, 4);
+      return true;
+   }
+   btBool mmioRead64( const btCSROffset Offset, btUnsigned64bitInt * const pValue )
+   {
+      if ( Offset + 8 > sizeof(m_Regs) ) {
+         return false;
+      }
+      *pValue = m_Regs[Offset / 8];
+      return true;
+   }
+   btBool mmioWrite64( const btCSROffset Offset, const btUnsigned64bitInt Value )
+   {
+      if ( Offset + 8 > sizeof(m_Regs) ) {
+         return false;
+      }
+      m_Regs[Offset / 8] = Value;
+      return true;
+   }
+   btBool mmioGetFeatureAddress( btVirtAddr * , NamedValueSet const & , NamedValueSet & ) { return false; }
+   btBool mmioGetFeatureAddress( btVirtAddr * , NamedValueSet const & )                   { return false; }
+   btBool mmioGetFeatureOffset( btCSROffset * , NamedValueSet const & , NamedValueSet & ) { return false; }
+   btBool mmioGetFeatureOffset( btCSROffset * , NamedValueSet const & )                   { return false; }
+   // </IALIMMIO>
+
+   // <IALIBuffer>
+   ali_errnum_e bufferAllocate( btWSSize Length, btVirtAddr *pBufferptr )
+   {
+      *pBufferptr = reinterpret_cast<btVirtAddr>(malloc(Length));
+      if ( NULL == *pBufferptr ) {
+         return ali_errnumNoMem;
+      }
+      m_Buffers[*pBufferptr] = m_NextIOVA;
+      m_NextIOVA += ( Length + 0xfff ) & ~0xfffULL;
+      return ali_errnumOK;
+   }
+   ali_errnum_e bufferAllocate( btWSSize Length, btVirtAddr *pBufferptr, NamedValueSet const & )
+   { return bufferAllocate(Length, pBufferptr); }
+   ali_errnum_e bufferAllocate( btWSSize Length, btVirtAddr *pBufferptr, NamedValueSet const & , NamedValueSet & )
+   { return bufferAllocate(Length, pBufferptr); }
+   ali_errnum_e bufferFree( btVirtAddr Address )
+   {
+      std::map<btVirtAddr, btPhysAddr>::iterator itr = m_Buffers.find(Address);
+      if ( m_Buffers.end() == itr ) {
+         return ali_errnumBadParameter;
+      }
+      free(Address);
+      m_Buffers.erase(itr);
+      return ali_errnumOK;
+   }
+   btPhysAddr bufferGetIOVA( btVirtAddr Address )
+   {
+      std::map<btVirtAddr, btPhysAddr>::const_iterator itr = m_Buffers.find(Address);
+      return ( m_Buffers.end() == itr ) ? 0 : itr->second;
+   }
+   // </IALIBuffer>
+
+   // <IALIUMsg>
+   btUnsignedInt umsgGetNumber( void ) { return NumUMsgs; }
+   btVirtAddr    umsgGetAddress( const btUnsignedInt UMsgNumber )
+   { return reinterpret_cast<btVirtAddr>(m_UMsgs[UMsgNumber]); }
+   void umsgTrigger64( const btVirtAddr pUMsg, const btUnsigned64bitInt Value )
+   { *reinterpret_cast<btUnsigned64bitInt *>(pUMsg) = Value; }
+   bool umsgSetAttributes( NamedValueSet const &nvsArgs )
+   { return ENamedValuesOK == nvsArgs.Get(UMSG_HINT_MASK_KEY, &m_HintMask); }
+   // </IALIUMsg>
+
+   // <IALIReset>
+   e_Reset afuQuiesceAndHalt( void )                  { return e_OK; }
+   e_Reset afuQuiesceAndHalt( NamedValueSet const & ) { return e_OK; }
+   e_Reset afuEnable( void )                          { return e_OK; }
+   e_Reset afuEnable( NamedValueSet const & )         { return e_OK; }
+   e_Reset afuReset( void )                           { ++m_Resets; return e_OK; }
+   e_Reset afuReset( NamedValueSet const & )          { ++m_Resets; return e_OK; }
+   // </IALIReset>
+
+protected:
+   btUnsigned64bitInt               m_Regs[NumRegs];
+   btUnsigned64bitInt               m_UMsgs[NumUMsgs][8];
+   std::map<btVirtAddr, btPhysAddr> m_Buffers;
+   btPhysAddr                       m_NextIOVA;
+   btUnsigned64bitInt               m_HintMask;
+   int                              m_Resets;
+};
+
+class ALITrace_f : public ::testing::Test
+{
+public:
+   virtual void SetUp()
+   {
+      sprintf(m_Path, "/tmp/gtALITrace.%d", (int)GetProcessID());
+   }
+   virtual void TearDown()
+   {
+      unlink(m_Path);
+   }
+
+   // A short NLB-like session: DSM and source / destination buffers, a
+   //  start CSR sequence, a status poll, a UMsg and a reset.
+   void Session(ALITraceRecorder &rec)
+   {
+      btVirtAddr dsm = NULL;
+      btVirtAddr src = NULL;
+
+      ASSERT_EQ(ali_errnumOK, rec.bufferAllocate(4096, &dsm));
+      ASSERT_EQ(ali_errnumOK, rec.bufferAllocate(8192, &src));
+
+      EXPECT_TRUE(rec.mmioWrite64(0x110, rec.bufferGetIOVA(dsm)));
+      EXPECT_TRUE(rec.mmioWrite64(0x120, ( rec.bufferGetIOVA(src) + 4096 ) >> 6));
+      EXPECT_TRUE(rec.mmioWrite32(0x130, 0xcafe));
+      EXPECT_TRUE(rec.mmioWrite64(0x138, 0x10));
+
+      btUnsigned32bitInt v32 = 0;
+      btUnsigned64bitInt v64 = 0;
+      EXPECT_TRUE(rec.mmioRead32(0x130, &v32));
+      EXPECT_EQ(0xcafe, v32);
+      EXPECT_TRUE(rec.mmioRead64(0x138, &v64));
+      EXPECT_EQ(0x10, v64);
+
+      NamedValueSet nvs;
+      nvs.Add(UMSG_HINT_MASK_KEY, (btUnsigned64bitInt)0xf0);
+      EXPECT_TRUE(rec.umsgSetAttributes(nvs));
+      rec.umsgTrigger64(rec.umsgGetAddress(3), 0x1234);
+
+      EXPECT_EQ(IALIReset::e_OK, rec.afuReset());
+
+      EXPECT_EQ(ali_errnumOK, rec.bufferFree(src));
+      EXPECT_EQ(ali_errnumOK, rec.bufferFree(dsm));
+   }
+
+   char m_Path[64];
+};
+
+TEST_F(ALITrace_f, aal0842)
+{
+   // A recorded session replays against another backend: calls are issued in
+   //  order, IOVAs written to CSRs are retranslated to the replay backend's
+   //  buffers (byte and cache line forms), and UMsgs are addressed by number.
+
+   FakeALI          recorded(0x100000000ULL);
+   ALITraceRecorder rec(&recorded, &recorded, &recorded, &recorded);
+
+   ASSERT_TRUE(rec.Open(m_Path));
+   Session(rec);
+   ASSERT_FALSE(HasFatalFailure());
+   rec.Close();
+
+   FakeALI          replayed(0x7700000000ULL);
+   ALITraceReplayer rep(&replayed, &replayed, &replayed, &replayed);
+   ASSERT_TRUE(rep.Load(m_Path));
+
+   const btUnsigned16bitInt ops[] = {
+      ALITRACE_BUFFER_ALLOCATE, ALITRACE_BUFFER_ALLOCATE,
+      ALITRACE_MMIO_WRITE64, ALITRACE_MMIO_WRITE64, ALITRACE_MMIO_WRITE32, ALITRACE_MMIO_WRITE64,
+      ALITRACE_MMIO_READ32, ALITRACE_MMIO_READ64,
+      ALITRACE_UMSG_SET_ATTRIBUTES, ALITRACE_UMSG_TRIGGER64, ALITRACE_RESET,
+      ALITRACE_BUFFER_FREE, ALITRACE_BUFFER_FREE
+   };
+   const size_t n = sizeof(ops) / sizeof(ops[0]);
+
+   std::vector<ALITraceRecord> const &recs = rep.Records();
+   ASSERT_EQ(n, recs.size());
+   for ( size_t i = 0 ; i < n ; ++i ) {
+      EXPECT_EQ(ops[i], recs[i].op) << i;
+      if ( i > 0 ) {
+         EXPECT_LE(recs[i - 1].tstamp, recs[i].tstamp) << i;
+      }
+   }
+
+   // Buffer references are by allocation order, not address.
+   EXPECT_EQ(ALITRACE_F_IOVA,    recs[2].flags);
+   EXPECT_EQ(1,                  recs[2].buffer);
+   EXPECT_EQ(0,                  recs[2].value);
+   EXPECT_EQ(ALITRACE_F_IOVA_CL, recs[3].flags);
+   EXPECT_EQ(2,                  recs[3].buffer);
+   EXPECT_EQ(4096,               recs[3].value);
+   EXPECT_EQ(0,                  recs[5].flags);
+   EXPECT_EQ(3,                  recs[9].arg);
+   EXPECT_EQ(2,                  recs[11].buffer);
+   EXPECT_EQ(1,                  recs[12].buffer);
+
+   ALITraceReplayStats stats;
+   rep.Replay(stats);
+
+   EXPECT_EQ(0x7700000000ULL,                      replayed.Reg(0x110));
+   EXPECT_EQ(( 0x7700000000ULL + 4096 + 4096 ) >> 6, replayed.Reg(0x120));
+   EXPECT_EQ(0x10,                                 replayed.Reg(0x138));
+   EXPECT_EQ(0x1234,                               replayed.UMsg(3));
+   EXPECT_EQ(0xf0,                                 replayed.HintMask());
+   EXPECT_EQ(1,                                    replayed.Resets());
+   EXPECT_EQ(0,                                    replayed.Buffers());
+
+   EXPECT_EQ(0, stats.readMismatches);
+   EXPECT_EQ(0, stats.resultMismatches);
+   EXPECT_EQ(3, stats.count[ALITRACE_MMIO_WRITE64]);
+   EXPECT_EQ(2, stats.count[ALITRACE_BUFFER_ALLOCATE]);
+   EXPECT_EQ(1, stats.count[ALITRACE_UMSG_TRIGGER64]);
+   EXPECT_LE(stats.replayedNanos[ALITRACE_MMIO_WRITE64], stats.replayedSpanNanos);
+   EXPECT_LE(stats.recordedNanos[ALITRACE_MMIO_WRITE64], stats.recordedSpanNanos);
+}
+
+TEST_F(ALITrace_f, aal0843)
+{
+   // Replay reports a backend whose reads differ from the recording, and a
+   //  file that is not a trace is rejected.
+
+   {
+      FakeALI          recorded(0x100000000ULL);
+      ALITraceRecorder rec(&recorded, &recorded, &recorded, &recorded);
+
+      ASSERT_TRUE(rec.Open(m_Path));
+      EXPECT_TRUE(recorded.mmioWrite64(0x8, 5));   // behind the recorder's back
+      btUnsigned64bitInt v = 0;
+      EXPECT_TRUE(rec.mmioRead64(0x8, &v));
+      EXPECT_FALSE(rec.mmioRead64(FakeALI::NumRegs * 8, &v));
+   }
+
+   FakeALI          replayed(0x100000000ULL);
+   ALITraceReplayer rep(&replayed, &replayed, &replayed, &replayed);
+   ASSERT_TRUE(rep.Load(m_Path));
+   ASSERT_EQ(2, rep.Records().size());
+
+   ALITraceReplayStats stats;
+   rep.Replay(stats, true);
+   EXPECT_EQ(1, stats.readMismatches);
+   EXPECT_EQ(0, stats.resultMismatches);
+   EXPECT_EQ(2, stats.count[ALITRACE_MMIO_READ64]);
+
+   FILE *fp = fopen(m_Path, "wb");
+   ASSERT_NONNULL(fp);
+   fputs("not a trace", fp);
+   fclose(fp);
+   EXPECT_FALSE(rep.Load(m_Path));
+   EXPECT_EQ(0, rep.Records().size());
+}
+
+#endif // __AAL_LINUX__
@@ -0,0 +1,181 @@
+// INTEL CONFIDENTIAL - For Intel Internal Use Only
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+#include "gtKOSALShim.h"
+#include "cci_pcie_driver_wsid.h"
+
+class CCIDrvWSID_f : public ::testing::Test
+{
+protected:
+   CCIDrvWSID_f() {}
+
+   virtual void SetUp()
+   {
+      m_pTable = new struct ccidrv_wsid_table;
+      ccidrv_wsid_table_init(m_pTable);
+   }
+
+   virtual void TearDown()
+   {
+      delete m_pTable;
+   }
+
+   // As ccidrv_getwsid() does.
+   struct aal_wsid * Add()
+   {
+      struct aal_wsid *pwsid = new struct aal_wsid;
+      pwsid->m_handle = 0;
+      pwsid->m_owner  = NULL;
+      kosal_list_init(&pwsid->m_list);
+      kosal_list_init(&pwsid->m_alloc_list);
+      EXPECT_EQ(0, ccidrv_wsid_table_add(m_pTable, pwsid));
+      return pwsid;
+   }
+
+   // As ccidrv_freewsid() does.
+   void Free(struct aal_wsid *pwsid)
+   {
+      ASSERT_EQ(0, ccidrv_wsid_table_remove(m_pTable, pwsid));
+      if ( ccidrv_wsid_put(pwsid) ) {
+         delete pwsid;
+      }
+   }
+
+   struct ccidrv_wsid_table *m_pTable;
+};
+
+TEST_F(CCIDrvWSID_f, aal0857)
+{
+   // Each add hands out a new, non-zero handle, which finds that wsid and no
+   //  other, across enough entries to share buckets. A removed wsid is no
+   //  longer found, and removing one not in the table fails.
+
+   const btUnsignedInt                 Num = 4 * CCIDRV_WSID_HASH_SIZE;
+   std::list<struct aal_wsid *>        wsids;
+   std::map<btWSID, struct aal_wsid *> byHandle;
+   btUnsignedInt                       i;
+
+   for ( i = 0 ; i < Num ; ++i ) {
+      struct aal_wsid *pwsid = Add();
+      EXPECT_NE((btWSID)0, pwsid->m_handle);
+      EXPECT_EQ(1, pwsid->m_refs);
+      EXPECT_TRUE(byHandle.insert(std::make_pair(pwsid->m_handle, pwsid)).second) << "duplicate handle";
+      wsids.push_back(pwsid);
+   }
+
+   std::list<struct aal_wsid *>::iterator itr;
+   for ( itr = wsids.begin() ; wsids.end() != itr ; ++itr ) {
+      struct aal_wsid *pwsid = ccidrv_wsid_table_lookup(m_pTable, (*itr)->m_handle);
+      ASSERT_EQ(*itr, pwsid);
+      EXPECT_EQ(2, pwsid->m_refs);
+      EXPECT_FALSE(ccidrv_wsid_put(pwsid));
+   }
+
+   EXPECT_NULL(ccidrv_wsid_table_lookup(m_pTable, 0));
+   EXPECT_NULL(ccidrv_wsid_table_lookup(m_pTable, wsid_to_wsidHandle((btWSID)Num + 1)));
+
+   // Remove every other one.
+   for ( i = 0, itr = wsids.begin() ; wsids.end() != itr ; ++i ) {
+      if ( 0 == ( i % 2 ) ) {
+         const btWSID h = (*itr)->m_handle;
+         Free(*itr);
+         itr = wsids.erase(itr);
+         EXPECT_NULL(ccidrv_wsid_table_lookup(m_pTable, h));
+      } else {
+         ++itr;
+      }
+   }
+
+   for ( itr = wsids.begin() ; wsids.end() != itr ; ++itr ) {
+      struct aal_wsid *pwsid = ccidrv_wsid_table_lookup(m_pTable, (*itr)->m_handle);
+      EXPECT_EQ(*itr, pwsid);
+      if ( NULL != pwsid ) {
+         ccidrv_wsid_put(pwsid);
+      }
+   }
+
+   struct aal_wsid stray;
+   stray.m_handle = wsid_to_wsidHandle((btWSID)Num + 1);
+   kosal_list_init(&stray.m_alloc_list);
+   EXPECT_EQ(-EINVAL, ccidrv_wsid_table_remove(m_pTable, &stray));
+
+   while ( !wsids.empty() ) {
+      Free(wsids.front());
+      wsids.pop_front();
+   }
+}
+
+TEST_F(CCIDrvWSID_f, aal0858)
+{
+   // A wsid found by lookup outlives its removal from the table until the
+   //  lookup's reference is dropped.
+
+   struct aal_wsid *pwsid = Add();
+   const btWSID     h     = pwsid->m_handle;
+
+   struct aal_wsid *pfound = ccidrv_wsid_table_lookup(m_pTable, h);
+   ASSERT_EQ(pwsid, pfound);
+
+   ASSERT_EQ(0, ccidrv_wsid_table_remove(m_pTable, pwsid));
+   EXPECT_FALSE(ccidrv_wsid_put(pwsid));   // the table's reference
+   EXPECT_NULL(ccidrv_wsid_table_lookup(m_pTable, h));
+
+   EXPECT_EQ(h, pfound->m_handle);
+   EXPECT_TRUE(ccidrv_wsid_put(pfound));   // the last
+   delete pwsid;
+}
+
+TEST_F(CCIDrvWSID_f, aal0859)
+{
+   // A wsid belongs to a session only while it is on the workspace list of
+   //  an owner session on that session's device list.
+
+   struct aaldev_owner mine;
+   struct aaldev_owner theirs;
+   kosal_list_head     mydevices;
+   kosal_list_head     theirdevices;
+
+   kosal_list_init(&mine.m_sess.m_wshead);
+   kosal_list_init(&theirs.m_sess.m_wshead);
+   kosal_list_init(&mydevices);
+   kosal_list_init(&theirdevices);
+
+   struct aal_wsid *pwsid = Add();
+
+   // Not yet on any list.
+   EXPECT_FALSE(ccidrv_wsid_owned_by(pwsid, &mydevices));
+
+   // Owned, but neither owner is bound by a session yet.
+   aalsess_add_ws(&mine.m_sess, pwsid->m_list);
+   EXPECT_FALSE(ccidrv_wsid_owned_by(pwsid, &mydevices));
+
+   kosal_list_add_head(&mine.m_devicelist, &mydevices);
+   kosal_list_add_head(&theirs.m_devicelist, &theirdevices);
+
+   EXPECT_TRUE(ccidrv_wsid_owned_by(pwsid, &mydevices));
+   EXPECT_FALSE(ccidrv_wsid_owned_by(pwsid, &theirdevices));
+
+   // Handed to another owner.
+   aalsess_del_ws(pwsid->m_list);
+   aalsess_add_ws(&theirs.m_sess, pwsid->m_list);
+
+   EXPECT_FALSE(ccidrv_wsid_owned_by(pwsid, &mydevices));
+   EXPECT_TRUE(ccidrv_wsid_owned_by(pwsid, &theirdevices));
+
+   // Off every list, as before a free. The owner is forgotten, so the check
+   //  fails even for the session that owned it.
+   aalsess_del_ws(pwsid->m_list);
+
+   EXPECT_TRUE(NULL == pwsid->m_owner);
+   EXPECT_FALSE(ccidrv_wsid_owned_by(pwsid, &theirdevices));
+
+   // The owner unbound from the session.
+   aalsess_add_ws(&theirs.m_sess, pwsid->m_list);
+   kosal_list_del(&theirs.m_devicelist);
+
+   EXPECT_FALSE(ccidrv_wsid_owned_by(pwsid, &theirdevices));
+
+   aalsess_del_ws(pwsid->m_list);
+   Free(pwsid);
+}
@@ -0,0 +1,144 @@
+// INTEL CONFIDENTIAL - For Intel Internal Use Only
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+#include "gtCommon.h"
+#include <aalsdk/kernel/ccipdriver.h>
+
+#if defined( __AAL_LINUX__ )
+
+// Stands in for the driver: posts one event with a recognizable payload.
+static btBool PostEvent(struct ccipui_evtring *pring, btUnsigned64bitInt seq)
+{
+   struct ccipui_evtslot *pslot = ccipui_evtring_produce(pring);
+   if ( NULL == pslot ) {
+      return false;
+   }
+
+   pslot->hdr.id      = rspid_AFU_Response;
+   pslot->hdr.errcode = uid_errnumOK;
+   pslot->hdr.context = reinterpret_cast<btObjectType>(seq);
+   pslot->hdr.size    = seq % CCIPUI_EVTRING_PAYLOAD_MAX;
+   for ( btWSSize i = 0 ; i < pslot->hdr.size ; ++i ) {
+      pslot->payload[i] = (btByte)(seq + i);
+   }
+
+   ccipui_evtring_publish(pring);
+   return true;
+}
+
+static void CheckEvent(const struct ccipui_evtslot *pslot, btUnsigned64bitInt seq)
+{
+   ASSERT_EQ(reinterpret_cast<btObjectType>(seq), pslot->hdr.context);
+   ASSERT_EQ(seq % CCIPUI_EVTRING_PAYLOAD_MAX, pslot->hdr.size);
+   for ( btWSSize i = 0 ; i < pslot->hdr.size ; ++i ) {
+      ASSERT_EQ((btByte)(seq + i), pslot->payload[i]);
+   }
+}
+
+TEST(CCIPEvtRing, aal0840)
+{
+   // The ring layout is shared with the driver: control words in their own
+   //  cache lines, slots following. The ring holds exactly
+   //  CCIPUI_EVTRING_SLOTS events and returns them in order across wraps.
+
+   EXPECT_EQ(CCIPUI_EVTRING_SLOT_SIZE, sizeof(struct ccipui_evtslot));
+   EXPECT_EQ(64, offsetof(struct ccipui_evtring, head));
+   EXPECT_EQ(128, offsetof(struct ccipui_evtring, tail));
+   EXPECT_EQ(256, offsetof(struct ccipui_evtring, slots));
+
+   struct ccipui_evtring *pring = new struct ccipui_evtring;
+   ccipui_evtring_init(pring);
+
+   EXPECT_TRUE(ccipui_evtring_empty(pring));
+   EXPECT_NULL(ccipui_evtring_peek(pring));
+
+   btUnsigned64bitInt produced = 0;
+   btUnsigned64bitInt consumed = 0;
+
+   for ( int pass = 0 ; pass < 5 ; ++pass ) {
+      while ( PostEvent(pring, produced) ) {
+         ++produced;
+      }
+      EXPECT_EQ((btUnsigned64bitInt)CCIPUI_EVTRING_SLOTS, produced - consumed);
+
+      // Drain part of the ring so the next pass wraps.
+      for ( int i = 0 ; i < 3 * CCIPUI_EVTRING_SLOTS / 4 ; ++i ) {
+         struct ccipui_evtslot *pslot = ccipui_evtring_peek(pring);
+         ASSERT_NONNULL(pslot);
+         CheckEvent(pslot, consumed);
+         ccipui_evtring_release(pring);
+         ++consumed;
+      }
+      EXPECT_FALSE(ccipui_evtring_empty(pring));
+   }
+
+   struct ccipui_evtslot *pslot;
+   while ( NULL != ( pslot = ccipui_evtring_peek(pring) ) ) {
+      CheckEvent(pslot, consumed);
+      ccipui_evtring_release(pring);
+      ++consumed;
+   }
+   EXPECT_EQ(produced, consumed);
+   EXPECT_TRUE(ccipui_evtring_empty(pring));
+
+   delete pring;
+}
+
+class CCIPEvtRing_f : public ::testing::Test
+{
+public:
+   static void Producer(OSLThread * , void *pContext)
+   {
+      CCIPEvtRing_f *f = reinterpret_cast<CCIPEvtRing_f *>(pContext);
+      btUnsigned64bitInt seq = 0;
+      while ( seq < f->m_Count ) {
+         if ( PostEvent(f->m_pRing, seq) ) {
+            ++seq;
+         } else {
+            sched_yield();
+         }
+      }
+   }
+
+   struct ccipui_evtring *m_pRing;
+   volatile btUnsigned64bitInt m_Count;
+};
+
+TEST_F(CCIPEvtRing_f, aal0841)
+{
+   // With the producer on another thread, the consumer sees every event,
+   //  in order and intact.
+
+   m_pRing = new struct ccipui_evtring;
+   m_Count = 200000;
+   ccipui_evtring_init(m_pRing);
+
+   OSLThread *pThread = new OSLThread(CCIPEvtRing_f::Producer, OSLThread::THREADPRIORITY_NORMAL, this);
+
+   btUnsigned64bitInt seq = 0;
+   while ( seq < m_Count ) {
+      struct ccipui_evtslot *pslot = ccipui_evtring_peek(m_pRing);
+      if ( NULL == pslot ) {
+         sched_yield();
+         continue;
+      }
+      CheckEvent(pslot, seq);
+      if ( HasFatalFailure() ) {
+         break;
+      }
+      ccipui_evtring_release(m_pRing);
+      ++seq;
+   }
+
+   if ( HasFatalFailure() ) {
+      m_Count = 0;   // let the producer finish
+   }
+   pThread->Join();
+   delete pThread;
+
+   EXPECT_TRUE(ccipui_evtring_empty(m_pRing));
+   delete m_pRing;
+}
+
+#endif // __AAL_LINUX__
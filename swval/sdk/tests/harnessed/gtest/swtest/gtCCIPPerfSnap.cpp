@@ -0,0 +1,118 @@
+// INTEL CONFIDENTIAL - For Intel Internal Use Only
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+#include "gtCommon.h"
+#include <aalsdk/kernel/ccipdriver.h>
+
+#if defined( __AAL_LINUX__ )
+
+// Stands in for the driver: publishes snapshot n, every value derived from n.
+static void PublishSnapshot(struct ccipui_perfsnap *psnap, btUnsigned64bitInt n)
+{
+   struct ccipui_perfsnap_buf *pbuf = ccipui_perfsnap_next(psnap);
+
+   pbuf->tstamp = n * 1000;
+   for ( btUnsignedInt i = 0 ; i < CCIPUI_PERFSNAP_VALUES ; ++i ) {
+      pbuf->values[i] = n * 100 + i;
+   }
+
+   ccipui_perfsnap_publish(psnap);
+}
+
+static void CheckSnapshot(const struct ccipui_perfsnap_buf *pbuf, btUnsigned64bitInt n)
+{
+   ASSERT_EQ(n * 1000, pbuf->tstamp);
+   for ( btUnsignedInt i = 0 ; i < CCIPUI_PERFSNAP_VALUES ; ++i ) {
+      ASSERT_EQ(n * 100 + i, pbuf->values[i]);
+   }
+}
+
+TEST(CCIPPerfSnap, aal0848)
+{
+   // The page layout is shared with the driver and holds one value for each
+   //  counter of struct CCIP_PERF_COUNTERS. Nothing reads until the first
+   //  snapshot is published; then each read returns the latest one.
+
+   EXPECT_EQ(17, CCIPUI_PERFSNAP_VALUES);
+   EXPECT_EQ(16, offsetof(struct ccipui_perfsnap, gen));
+   EXPECT_EQ(64, offsetof(struct ccipui_perfsnap, buf));
+   EXPECT_GE((size_t)4096, sizeof(struct ccipui_perfsnap));
+
+   struct ccipui_perfsnap    *psnap = new struct ccipui_perfsnap;
+   struct ccipui_perfsnap_buf snap;
+
+   ccipui_perfsnap_init(psnap, 100);
+   EXPECT_EQ((btUnsigned32bitInt)CCIPUI_PERFSNAP_MAGIC, psnap->magic);
+   EXPECT_EQ(CCIPUI_PERFSNAP_VALUES, psnap->nvalues);
+   EXPECT_EQ(100, psnap->interval);
+
+   EXPECT_EQ(0, ccipui_perfsnap_read(psnap, &snap));
+
+   for ( btUnsigned64bitInt n = 1 ; n <= 5 ; ++n ) {
+      PublishSnapshot(psnap, n);
+      EXPECT_EQ(n, ccipui_perfsnap_read(psnap, &snap));
+      CheckSnapshot(&snap, n);
+   }
+
+   // The writer fills the buffer readers are not using.
+   EXPECT_NE(ccipui_perfsnap_next(psnap), &psnap->buf[psnap->gen & 1]);
+
+   delete psnap;
+}
+
+class CCIPPerfSnap_f : public ::testing::Test
+{
+public:
+   static void Writer(OSLThread * , void *pContext)
+   {
+      CCIPPerfSnap_f *f = reinterpret_cast<CCIPPerfSnap_f *>(pContext);
+      for ( btUnsigned64bitInt n = 1 ; n <= f->m_Count ; ++n ) {
+         PublishSnapshot(f->m_pSnap, n);
+      }
+   }
+
+   struct ccipui_perfsnap     *m_pSnap;
+   volatile btUnsigned64bitInt m_Count;
+};
+
+TEST_F(CCIPPerfSnap_f, aal0849)
+{
+   // With the writer on another thread, every read returns one whole
+   //  snapshot, never a mix of two, and snapshots are never seen to go back.
+
+   m_pSnap = new struct ccipui_perfsnap;
+   m_Count = 200000;
+   ccipui_perfsnap_init(m_pSnap, 1);
+
+   OSLThread *pThread = new OSLThread(CCIPPerfSnap_f::Writer, OSLThread::THREADPRIORITY_NORMAL, this);
+
+   struct ccipui_perfsnap_buf snap;
+   btUnsigned64bitInt         last  = 0;
+   btUnsigned64bitInt         reads = 0;
+
+   while ( last < m_Count ) {
+      btUnsigned64bitInt gen = ccipui_perfsnap_read(m_pSnap, &snap);
+      if ( 0 == gen ) {
+         continue;
+      }
+      CheckSnapshot(&snap, gen);
+      if ( HasFatalFailure() || ( gen < last ) ) {
+         EXPECT_GE(gen, last);
+         break;
+      }
+      last = gen;
+      ++reads;
+   }
+
+   pThread->Join();
+   delete pThread;
+
+   EXPECT_GT(reads, 0);
+   EXPECT_EQ((btUnsigned64bitInt)m_Count, ccipui_perfsnap_read(m_pSnap, &snap));
+   CheckSnapshot(&snap, m_Count);
+
+   delete m_pSnap;
+}
+
+#endif // __AAL_LINUX__
@@ -0,0 +1,166 @@
+// INTEL CONFIDENTIAL - For Intel Internal Use Only
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+#include "gtCommon.h"
+#include "GBSHeader.h"
+
+#if defined( __AAL_LINUX__ )
+#include <sys/mman.h>
+
+// Places test images so that they end exactly at a PROT_NONE page. Any read
+//  beyond the length given to GBSParseHeader() faults.
+class GBSHeader_f : public ::testing::Test
+{
+public:
+   GBSHeader_f() :
+      m_pPages(NULL),
+      m_PageSize(0)
+   {}
+
+   virtual void SetUp()
+   {
+      m_PageSize = (btWSSize)sysconf(_SC_PAGESIZE);
+      void *p = mmap(NULL, 2 * m_PageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      ASSERT_NE(MAP_FAILED, p);
+      m_pPages = reinterpret_cast<btByte *>(p);
+      ASSERT_EQ(0, mprotect(m_pPages + m_PageSize, m_PageSize, PROT_NONE));
+   }
+
+   virtual void TearDown()
+   {
+      if ( NULL != m_pPages ) {
+         munmap(m_pPages, 2 * m_PageSize);
+      }
+   }
+
+   // Returns a len-byte image that ends at the guard page.
+   btByte * Image(const btByte *src, btWSSize len)
+   {
+      btByte *p = m_pPages + m_PageSize - len;
+      memcpy(p, src, len);
+      return p;
+   }
+
+   static void ValidImage(btByte *p, btWSSize len)
+   {
+      btUnsigned32bitInt magic = GBS_HEADER_MAGIC;
+      for ( btWSSize i = 0 ; i < len ; ++i ) {
+         p[i] = (btByte)(i * 13);
+      }
+      memcpy(p, &magic, sizeof(magic));
+   }
+
+   btByte  *m_pPages;
+   btWSSize m_PageSize;
+};
+
+TEST_F(GBSHeader_f, aal0827)
+{
+   // A valid header is accepted at any alignment, and the payload is
+   //  everything after GBS_HEADER_LEN.
+
+   btByte src[64];
+   ValidImage(src, sizeof(src));
+
+   for ( btWSSize len = GBS_HEADER_LEN + 1 ; len <= sizeof(src) ; ++len ) {
+      GBSHeaderInfo info;
+      memset(&info, 0, sizeof(info));
+
+      btByte *p = Image(src, len);
+      ASSERT_EQ(gbsHeaderOK, GBSParseHeader(p, len, info)) << "len " << len;
+      EXPECT_EQ((btUnsigned32bitInt)GBS_HEADER_MAGIC, info.magic);
+      EXPECT_EQ((btWSSize)GBS_HEADER_LEN, info.payloadOffset);
+      EXPECT_EQ(len - GBS_HEADER_LEN, info.payloadLen);
+   }
+}
+
+TEST_F(GBSHeader_f, aal0828)
+{
+   // Every truncation of a valid image that leaves no payload is rejected,
+   //  as is a NULL buffer. The output is untouched on failure.
+
+   btByte src[GBS_HEADER_LEN];
+   ValidImage(src, sizeof(src));
+
+   GBSHeaderInfo info;
+   memset(&info, 0xa5, sizeof(info));
+   GBSHeaderInfo orig = info;
+
+   EXPECT_EQ(gbsHeaderNullBuffer, GBSParseHeader(NULL, 100, info));
+
+   for ( btWSSize len = 0 ; len <= GBS_HEADER_LEN ; ++len ) {
+      btByte *p = Image(src, len);
+      EXPECT_EQ(gbsHeaderTooShort, GBSParseHeader(p, len, info)) << "len " << len;
+   }
+
+   EXPECT_EQ(0, memcmp(&orig, &info, sizeof(info)));
+}
+
+TEST_F(GBSHeader_f, aal0829)
+{
+   // Any single-bit corruption of the magic sequence is rejected.
+
+   btByte src[GBS_HEADER_LEN + 16];
+   ValidImage(src, sizeof(src));
+
+   for ( int bit = 0 ; bit < 32 ; ++bit ) {
+      GBSHeaderInfo info;
+      btByte        tmp[sizeof(src)];
+
+      memcpy(tmp, src, sizeof(src));
+      tmp[bit / 8] ^= (btByte)(1 << (bit % 8));
+
+      btByte *p = Image(tmp, sizeof(tmp));
+      EXPECT_EQ(gbsHeaderBadMagic, GBSParseHeader(p, sizeof(tmp), info)) << "bit " << bit;
+   }
+}
+
+TEST_F(GBSHeader_f, aal0830)
+{
+   // Random images of random length: the result always agrees with the
+   //  header rules, and the parser never reads past the end of the image.
+
+   btUnsigned32bitInt seed = GlobalTestConfig::GetInstance().RandSeed();
+   btByte             src[2 * GBS_HEADER_LEN];
+   btUnsigned32bitInt magic = GBS_HEADER_MAGIC;
+   int                i;
+
+   for ( i = 0 ; i < 20000 ; ++i ) {
+      btWSSize len = GetRand(&seed) % ( sizeof(src) + 1 );
+      btWSSize j;
+
+      for ( j = 0 ; j < len ; ++j ) {
+         src[j] = (btByte)GetRand(&seed);
+      }
+
+      // Plant the magic sequence half of the time.
+      if ( ( len >= sizeof(magic) ) && ( GetRand(&seed) & 1 ) ) {
+         memcpy(src, &magic, sizeof(magic));
+      }
+
+      EGBSHeaderStatus expected;
+      btUnsigned32bitInt m = 0;
+      if ( len < sizeof(magic) ) {
+         expected = gbsHeaderTooShort;
+      } else {
+         memcpy(&m, src, sizeof(m));
+         if ( GBS_HEADER_MAGIC != m ) {
+            expected = gbsHeaderBadMagic;
+         } else if ( len <= GBS_HEADER_LEN ) {
+            expected = gbsHeaderTooShort;
+         } else {
+            expected = gbsHeaderOK;
+         }
+      }
+
+      GBSHeaderInfo info;
+      btByte       *p = Image(src, len);
+      ASSERT_EQ(expected, GBSParseHeader(p, len, info)) << "len " << len << " seed " << seed;
+      if ( gbsHeaderOK == expected ) {
+         EXPECT_EQ(len - GBS_HEADER_LEN, info.payloadLen);
+      }
+   }
+}
+
+#endif // __AAL_LINUX__
@@ -0,0 +1,282 @@
+// INTEL CONFIDENTIAL - For Intel Internal Use Only
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+#include "gtCommon.h"
+#include "aalsdk/aas/AALIPCServiceFactory.h"
+
+#if defined( __AAL_LINUX__ )
+
+// Exposes one end of a socketpair as a connected UDSxport.
+class TestUDSxport : public UDSxport
+{
+public:
+   TestUDSxport(int sock, btBool bServer)
+   {
+      m_sock    = sock;
+      m_bserver = bServer;
+   }
+};
+
+class IPCXport_f : public ::testing::Test
+{
+public:
+   IPCXport_f() :
+      m_pClient(NULL),
+      m_pServer(NULL),
+      m_pThread(NULL)
+   {}
+
+   virtual void SetUp()
+   {
+      int sv[2];
+      ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+      m_pClient = new TestUDSxport(sv[0], false);
+      m_pServer = new TestUDSxport(sv[1], true);
+   }
+
+   virtual void TearDown()
+   {
+      if ( NULL != m_pThread ) {
+         m_pThread->Join();
+         delete m_pThread;
+      }
+      delete m_pClient;
+      delete m_pServer;
+   }
+
+   // Echo n messages from the server end.
+   static void EchoThread(OSLThread * , void *pContext)
+   {
+      IPCXport_f *f = reinterpret_cast<IPCXport_f *>(pContext);
+      for ( int i = 0 ; i < f->m_EchoCount ; ++i ) {
+         btWSSize  len = 0;
+         btcString msg = f->m_pServer->getmsg(&len);
+         if ( NULL == msg ) {
+            return;
+         }
+         f->m_pServer->putmsg(msg, len);
+      }
+   }
+
+   void StartEcho(int n)
+   {
+      m_EchoCount = n;
+      m_pThread = new OSLThread(IPCXport_f::EchoThread, OSLThread::THREADPRIORITY_NORMAL, this);
+   }
+
+   TestUDSxport *m_pClient;
+   TestUDSxport *m_pServer;
+   OSLThread    *m_pThread;
+   int           m_EchoCount;
+};
+
+TEST_F(IPCXport_f, aal0822)
+{
+   // UDSxport delivers messages larger than the socket buffer (and larger
+   //  than TCPIPxport's MSG_BUFFER_SIZE) intact.
+
+   const btWSSize      sz = 256 * 1024;
+   std::vector<char> out(sz);
+   for ( btWSSize i = 0 ; i < sz ; ++i ) {
+      out[i] = (char)(i * 7);
+   }
+
+   StartEcho(1);
+
+   EXPECT_EQ((int)sz, m_pClient->putmsg(&out[0], sz));
+
+   btWSSize  len = 0;
+   btcString in  = m_pClient->getmsg(&len);
+   ASSERT_NONNULL(in);
+   ASSERT_EQ(sz, len);
+   EXPECT_EQ(0, memcmp(&out[0], in, sz));
+}
+
+TEST_F(IPCXport_f, aal0823)
+{
+   // Several requests may be outstanding. The server's responses carry the
+   //  correlation ID of the request they answer.
+
+   const int          n = 8;
+   btUnsigned64bitInt ids[n];
+   char               msg[32];
+   int                i;
+
+   StartEcho(n);
+
+   for ( i = 0 ; i < n ; ++i ) {
+      ids[i] = m_pClient->nextcorrid();
+      sprintf(msg, "request %d", i);
+      EXPECT_EQ((int)strlen(msg), m_pClient->putmsg(msg, strlen(msg), ids[i], -1));
+   }
+
+   for ( i = 0 ; i < n ; ++i ) {
+      btWSSize           len    = 0;
+      btUnsigned64bitInt corrid = 0;
+      btcString          in     = m_pClient->getmsg(&len, &corrid, NULL);
+
+      ASSERT_NONNULL(in);
+      EXPECT_EQ(ids[i], corrid);
+      sprintf(msg, "request %d", i);
+      EXPECT_STREQ(msg, in);
+   }
+
+   // IDs are unique.
+   for ( i = 1 ; i < n ; ++i ) {
+      EXPECT_NE(ids[i - 1], ids[i]);
+   }
+}
+
+TEST_F(IPCXport_f, aal0824)
+{
+   // A file descriptor sent with a message arrives as a usable descriptor.
+
+   int p[2];
+   ASSERT_EQ(0, pipe(p));
+
+   EXPECT_EQ(3, m_pClient->putmsg("fd!", 3, m_pClient->nextcorrid(), p[1]));
+
+   btWSSize  len = 0;
+   int       fd  = -1;
+   btcString in  = m_pServer->getmsg(&len, NULL, &fd);
+   ASSERT_NONNULL(in);
+   EXPECT_EQ(3, len);
+   ASSERT_GE(fd, 0);
+   EXPECT_NE(p[1], fd);
+
+   EXPECT_EQ(2, write(fd, "ok", 2));
+   close(fd);
+
+   char buf[2] = { 0, 0 };
+   EXPECT_EQ(2, read(p[0], buf, 2));
+   EXPECT_EQ(0, memcmp("ok", buf, 2));
+
+   close(p[0]);
+   close(p[1]);
+}
+
+TEST_F(IPCXport_f, aal0825)
+{
+   // getmsg() reports EOF as NULL with a zero length when the peer hangs up.
+
+   m_pClient->disconnect();
+
+   btWSSize len = 1;
+   EXPECT_NULL(m_pServer->getmsg(&len));
+   EXPECT_EQ(0, len);
+}
+
+TEST_F(IPCXport_f, aal0860)
+{
+   // A message returned by getmsg() is not overwritten by another thread's
+   //  getmsg(), and the server's implicit putmsg() echoes the correlation ID
+   //  of the last request received by the calling thread.
+
+   struct Ctx
+   {
+      static void Receiver(OSLThread * , void *pContext)
+      {
+         Ctx *c = reinterpret_cast<Ctx *>(pContext);
+         c->msg = c->pServer->getmsg(&c->len);
+      }
+
+      TestUDSxport *pServer;
+      btcString     msg;
+      btWSSize      len;
+   } ctx;
+
+   ctx.pServer = m_pServer;
+   ctx.msg     = NULL;
+   ctx.len     = 0;
+
+   const btUnsigned64bitInt first  = m_pClient->nextcorrid();
+   const btUnsigned64bitInt second = m_pClient->nextcorrid();
+   EXPECT_EQ(5, m_pClient->putmsg("first", 5, first, -1));
+   EXPECT_EQ(6, m_pClient->putmsg("second", 6, second, -1));
+
+   OSLThread t(Ctx::Receiver, OSLThread::THREADPRIORITY_NORMAL, &ctx);
+   t.Join();
+   ASSERT_NONNULL(ctx.msg);
+   EXPECT_EQ(5, ctx.len);
+
+   btWSSize  len = 0;
+   btcString in  = m_pServer->getmsg(&len);
+   ASSERT_NONNULL(in);
+   EXPECT_STREQ("second", in);
+   EXPECT_NE(ctx.msg, in);
+   EXPECT_STREQ("first", ctx.msg);
+
+   EXPECT_EQ(5, m_pServer->putmsg("reply", 5));
+
+   btUnsigned64bitInt corrid = 0;
+   in = m_pClient->getmsg(&len, &corrid, NULL);
+   ASSERT_NONNULL(in);
+   EXPECT_STREQ("reply", in);
+   EXPECT_EQ(second, corrid);
+}
+
+TEST(IPCXport, aal0826)
+{
+   // connectremote() / waitforconnect() rendezvous on AAL_SERVICE_COMM_PATH,
+   //  and a connection type other than conn_type_uds is rejected.
+
+   char path[64];
+   sprintf(path, "/tmp/gtIPCXport.%d", (int)GetProcessID());
+
+   NamedValueSet args;
+   NamedValueSet parms;
+   parms.Add(AAL_SERVICE_CONNECTION_TYPE, (btInt)conn_type_tcp);
+   parms.Add(AAL_SERVICE_COMM_PATH, path);
+   args.Add(AAL_SERVICE_CONNECTION_PARMS, &parms);
+
+   UDSxport wrong;
+   EXPECT_FALSE(wrong.connectremote(args));
+
+   parms.Delete(AAL_SERVICE_CONNECTION_TYPE);
+   parms.Add(AAL_SERVICE_CONNECTION_TYPE, (btInt)conn_type_uds);
+   args.Delete(AAL_SERVICE_CONNECTION_PARMS);
+   args.Add(AAL_SERVICE_CONNECTION_PARMS, &parms);
+
+   struct Ctx
+   {
+      static void Server(OSLThread * , void *pContext)
+      {
+         Ctx *c = reinterpret_cast<Ctx *>(pContext);
+         c->bConnected = c->server.waitforconnect(*c->pArgs);
+         if ( c->bConnected ) {
+            btWSSize len = 0;
+            btcString msg = c->server.getmsg(&len);
+            if ( NULL != msg ) {
+               c->server.putmsg(msg, len);
+            }
+         }
+      }
+
+      NamedValueSet *pArgs;
+      UDSxport       server;
+      btBool         bConnected;
+   } ctx;
+
+   ctx.pArgs      = &args;
+   ctx.bConnected = false;
+
+   OSLThread t(Ctx::Server, OSLThread::THREADPRIORITY_NORMAL, &ctx);
+
+   UDSxport client;
+   ASSERT_TRUE(client.connectremote(args));
+   EXPECT_EQ(5, client.putmsg("hello", 5));
+
+   btWSSize  len = 0;
+   btcString in  = client.getmsg(&len);
+   ASSERT_NONNULL(in);
+   EXPECT_STREQ("hello", in);
+
+   t.Join();
+   EXPECT_TRUE(ctx.bConnected);
+
+   ctx.server.disconnect();
+   EXPECT_NE(0, access(path, F_OK));
+}
+
+#endif // __AAL_LINUX__
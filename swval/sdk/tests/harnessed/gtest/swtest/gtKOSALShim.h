@@ -0,0 +1,118 @@
+// INTEL CONFIDENTIAL - For Intel Internal Use Only
+#ifndef __GTKOSALSHIM_H__
+#define __GTKOSALSHIM_H__
+#include "gtCommon.h"
+#include <cerrno>
+#include <cstddef>
+
+// User-space stand-ins for the kOSAL primitives used by driver code that is
+//  written to be built outside the kernel, such as the CCI driver's WSID
+//  table (cci_pcie_driver_wsid.h). Include this ahead of the driver header;
+//  the kernel headers it names are kept out by their include guards.
+
+#define __AALSDK_KERNEL_KOSAL_H__
+#define __AALSDK_KERNEL_AALWSSERVICE_H__
+#define __AALSDK_KERNEL_AALDEVICE_INTERFACE_H__
+#define __AALSDK_KERNEL_AALBUS_DEVICE_H__
+
+#define kosal_container_of(_ptr, _type, _memb) ( (_type *)( (char *)(_ptr) - offsetof(_type, _memb) ) )
+
+//
+// Semaphore
+//
+typedef CSemaphore kosal_semaphore, *pkosal_semaphore;
+#define kosal_mutex_init(sptr)              (sptr)->Create(1, 1)
+// Returns 0 once the count is taken.
+#define kosal_sem_get_krnl_alertable(sptr)  ( (sptr)->Wait() ? 0 : 1 )
+#define kosal_sem_put(sptr)                 (sptr)->Post(1)
+
+//
+// List
+//
+struct kosal_list_head
+{
+   kosal_list_head *next;
+   kosal_list_head *prev;
+};
+typedef kosal_list_head *pkosal_list_head;
+
+#define kosal_list_init(_h)      do{ (_h)->next = (_h); (_h)->prev = (_h); }while(0)
+#define kosal_list_is_empty(_h)  ( (_h)->next == (_h) )
+
+static inline void kosal_list_add_head(kosal_list_head *pnew, kosal_list_head *phead)
+{
+   pnew->next        = phead->next;
+   pnew->prev        = phead;
+   phead->next->prev = pnew;
+   phead->next       = pnew;
+}
+
+static inline void kosal_list_del(kosal_list_head *pentry)
+{
+   pentry->prev->next = pentry->next;
+   pentry->next->prev = pentry->prev;
+   pentry->next       = NULL;
+   pentry->prev       = NULL;
+}
+
+static inline void kosal_list_del_init(kosal_list_head *pentry)
+{
+   kosal_list_del(pentry);
+   kosal_list_init(pentry);
+}
+
+#define kosal_list_for_each_entry(_pos, _h, _memb, _cont_t)                   \
+   for ( (_pos) = kosal_container_of((_h)->next, _cont_t, _memb) ;           \
+         &(_pos)->_memb != (_h) ;                                            \
+         (_pos) = kosal_container_of((_pos)->_memb.next, _cont_t, _memb) )
+
+//
+// RCU - the tests are single-threaded, so readers need no protection.
+//
+#define kosal_rcu_read_lock()                                    do{}while(0)
+#define kosal_rcu_read_unlock()                                  do{}while(0)
+#define kosal_list_add_head_rcu(_new, _h)                        kosal_list_add_head(_new, _h)
+#define kosal_list_del_rcu(_h)                                   kosal_list_del(_h)
+#define kosal_list_for_each_entry_rcu(_pos, _h, _memb, _cont_t)  kosal_list_for_each_entry(_pos, _h, _memb, _cont_t)
+
+//
+// Reference counts
+//
+typedef btInt kosal_refcount;
+#define kosal_refcount_set(_r, _v)       ( *(_r) = (_v) )
+#define kosal_refcount_inc_not_zero(_r)  ( ( 0 != *(_r) ) ? ( ++*(_r), 1 ) : 0 )
+#define kosal_refcount_dec_and_test(_r)  ( 0 == --*(_r) )
+
+//
+// Device and workspace objects - only the members the WSID table and owner
+//  check use.
+//
+struct aaldev_ownerSession
+{
+   btObjectType    m_UIHandle;
+   kosal_list_head m_wshead;
+};
+
+struct aaldev_owner
+{
+   struct aaldev_ownerSession m_sess;
+   kosal_list_head            m_devicelist;
+};
+
+struct aal_wsid
+{
+   btWSID                      m_handle;
+   kosal_list_head             m_list;
+   struct aaldev_ownerSession *m_owner;
+   kosal_refcount              m_refs;
+   kosal_list_head             m_alloc_list;
+};
+
+#define aalsess_add_ws(os,ih)  do{ kosal_list_add_head(&ih, &(os)->m_wshead); \
+                                   kosal_container_of(&ih, struct aal_wsid, m_list)->m_owner = (os); }while(0)
+#define aalsess_del_ws(ih)     do{ kosal_list_del_init(&ih); \
+                                   kosal_container_of(&ih, struct aal_wsid, m_list)->m_owner = NULL; }while(0)
+
+#define wsid_to_wsidHandle(wsid)  ((btWSID)( (wsid) <<21 ))
+
+#endif // __GTKOSALSHIM_H__
@@ -0,0 +1,102 @@
+// INTEL CONFIDENTIAL - For Intel Internal Use Only
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+#include "gtCommon.h"
+#include "mmlink_ring.h"
+#include "mm_debug_link_fake.h"
+
+#if defined( __AAL_LINUX__ )
+
+TEST(MMLinkRing, aal0838)
+{
+   // mmlink_ring rounds its size up to a power of two, and data that wraps
+   //  the end of the buffer is described by two iovecs, in order.
+
+   mmlink_ring r(100);
+   EXPECT_EQ(128, r.size());
+   EXPECT_TRUE(r.empty());
+
+   struct iovec iov[2];
+   EXPECT_EQ(0, r.read_iov(iov));
+
+   btUnsigned32bitInt seed = GlobalTestConfig::GetInstance().RandSeed();
+   char               next = 0;   // next byte to write
+   char               want = 0;   // next byte expected out
+
+   for ( int pass = 0 ; pass < 1000 ; ++pass ) {
+      // Fill a random amount, one contiguous span at a time.
+      size_t fill = GetRand(&seed) % (r.space() + 1);
+      while ( fill > 0 ) {
+         size_t len = 0;
+         char  *p   = r.write_ptr(&len);
+         ASSERT_GT(len, 0);
+         len = std::min(len, fill);
+         for ( size_t i = 0 ; i < len ; ++i ) {
+            p[i] = next++;
+         }
+         r.commit(len);
+         fill -= len;
+      }
+      ASSERT_LE(r.used(), r.size());
+      EXPECT_EQ(r.size(), r.used() + r.space());
+
+      // Drain a random amount through the iovecs.
+      int    cnt   = r.read_iov(iov);
+      size_t total = 0;
+      ASSERT_LE(cnt, 2);
+      for ( int i = 0 ; i < cnt ; ++i ) {
+         ASSERT_GT(iov[i].iov_len, 0);
+         total += iov[i].iov_len;
+      }
+      ASSERT_EQ(r.used(), total);
+
+      size_t take = GetRand(&seed) % (total + 1);
+      size_t done = 0;
+      for ( int i = 0 ; i < cnt && done < take ; ++i ) {
+         const char *p = static_cast<const char *>(iov[i].iov_base);
+         for ( size_t j = 0 ; j < iov[i].iov_len && done < take ; ++j, ++done ) {
+            ASSERT_EQ(want, p[j]);
+            ++want;
+         }
+      }
+      r.consume(take);
+   }
+}
+
+TEST(MMLinkRing, aal0839)
+{
+   // mm_debug_link_fake models the debug link FIFOs: the source stream waits
+   //  for the host's first write, echoed bytes come back ahead of it, and the
+   //  write FIFO accepts no more than its capacity per call.
+
+   mm_debug_link_fake link;
+   char               buf[1024];
+
+   link.source(1000);
+   EXPECT_EQ(0, link.read(buf, sizeof(buf)));
+   EXPECT_EQ(1, link.stats().empty_reads);
+
+   char cmd[mm_debug_link_fake::WRITE_CAPACITY + 10];
+   memset(cmd, '|', sizeof(cmd));
+   EXPECT_EQ((ssize_t)mm_debug_link_fake::WRITE_CAPACITY, link.write(cmd, sizeof(cmd)));
+
+   // The level register tops out at 255, so the read takes several passes.
+   EXPECT_EQ(100, link.read(buf, 100));
+   for ( int i = 0 ; i < 64 ; ++i ) {
+      EXPECT_EQ('|', buf[i]);
+   }
+   for ( int i = 64 ; i < 100 ; ++i ) {
+      EXPECT_EQ(FakePattern(i - 64), buf[i]);
+   }
+
+   EXPECT_EQ(964, link.read(buf, sizeof(buf)));
+   EXPECT_EQ(FakePattern(36), buf[0]);
+   EXPECT_EQ(FakePattern(999), buf[963]);
+   EXPECT_EQ(0, link.read(buf, sizeof(buf)));
+
+   EXPECT_EQ(1064, link.stats().t2h_bytes);
+   EXPECT_EQ(64, link.stats().h2t_bytes);
+}
+
+#endif // __AAL_LINUX__
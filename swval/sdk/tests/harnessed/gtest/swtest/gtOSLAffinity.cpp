@@ -0,0 +1,82 @@
+// INTEL CONFIDENTIAL - For Intel Internal Use Only
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+#include "gtCommon.h"
+#include <aalsdk/osal/Affinity.h>
+#include <sched.h>
+
+#if defined( __AAL_LINUX__ )
+
+class OSLAffinity_f : public ::testing::Test
+{
+public:
+   static void Record(OSLThread * , void *pContext)
+   {
+      OSLAffinity_f *f = reinterpret_cast<OSLAffinity_f *>(pContext);
+      f->m_CPU = sched_getcpu();
+   }
+
+   virtual void TearDown()
+   {
+      // Leave the test thread free to run anywhere.
+      cpu_set_t all;
+      CPU_ZERO(&all);
+      for ( int i = 0 ; i < CPU_SETSIZE ; ++i ) {
+         CPU_SET(i, &all);
+      }
+      sched_setaffinity(0, sizeof(all), &all);
+   }
+
+   volatile int m_CPU;
+};
+
+TEST_F(OSLAffinity_f, aal0850)
+{
+   // A placement is a CPU list in cpulist format or "node:N", and prints
+   //  back in the same form. Malformed specs are rejected. A thread created
+   //  with a placement starts on one of its CPUs.
+
+   OSLAffinity none;
+   EXPECT_TRUE(none.IsOK());
+   EXPECT_FALSE(none.IsSet());
+   EXPECT_EQ(std::string(), none.ToString());
+   EXPECT_TRUE(none.Apply());
+
+   OSLAffinity list("0-3,8,10-11");
+   ASSERT_TRUE(list.IsOK());
+   EXPECT_TRUE(list.IsSet());
+   EXPECT_EQ(-1, list.Node());
+   EXPECT_TRUE(list.HasCPU(2));
+   EXPECT_FALSE(list.HasCPU(9));
+   EXPECT_EQ(std::string("0-3,8,10-11"), list.ToString());
+
+   OSLAffinity node("node:0");
+   ASSERT_TRUE(node.IsOK());
+   EXPECT_EQ(0, node.Node());
+   EXPECT_EQ(std::string("node:0"), node.ToString());
+
+   EXPECT_FALSE(OSLAffinity("3-1").IsOK());
+   EXPECT_FALSE(OSLAffinity("1,,2").IsOK());
+   EXPECT_FALSE(OSLAffinity("node:").IsOK());
+   EXPECT_FALSE(OSLAffinity("x").IsOK());
+
+   EXPECT_GE(OSLAffinity::NumNodes(), 1);
+
+   // Pick the CPU we are on, so that the placement is always satisfiable.
+   int cpu = sched_getcpu();
+   ASSERT_GE(cpu, 0);
+
+   OSLAffinity here;
+   ASSERT_TRUE(here.AddCPU((btUnsignedInt)cpu));
+   ASSERT_TRUE(here.Apply());
+   EXPECT_EQ(cpu, sched_getcpu());
+
+   m_CPU = -1;
+   OSLThread *pThread = new OSLThread(OSLAffinity_f::Record, OSLThread::THREADPRIORITY_NORMAL, this, false, here);
+   pThread->Join();
+   delete pThread;
+   EXPECT_EQ(cpu, m_CPU);
+}
+
+#endif // __AAL_LINUX__
@@ -0,0 +1,176 @@
+// INTEL CONFIDENTIAL - For Intel Internal Use Only
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+#include "gtCommon.h"
+#include "aalsdk/utils/SeqlockRing.h"
+#include "aalsdk/service/IALIAFU.h"
+
+struct RingValue
+{
+   btUnsigned64bitInt a;
+   btUnsigned64bitInt b[7];
+};
+
+static RingValue MakeRingValue(btUnsigned64bitInt n)
+{
+   RingValue v;
+   v.a = n;
+   for ( int i = 0 ; i < 7 ; ++i ) {
+      v.b[i] = n;
+   }
+   return v;
+}
+
+TEST(SeqlockRing, aal0831)
+{
+   // An empty ring reports nothing; Latest() is the newest value and
+   //  History() returns the newest values first.
+
+   SeqlockRing<RingValue, 4> ring;
+   RingValue                 v;
+   RingValue                 h[8];
+
+   EXPECT_FALSE(ring.Latest(v));
+   EXPECT_EQ(0, ring.History(h, 8));
+
+   ring.Publish(MakeRingValue(1));
+   ring.Publish(MakeRingValue(2));
+
+   ASSERT_TRUE(ring.Latest(v));
+   EXPECT_EQ(2, v.a);
+
+   ASSERT_EQ(2, ring.History(h, 8));
+   EXPECT_EQ(2, h[0].a);
+   EXPECT_EQ(1, h[1].a);
+   EXPECT_EQ(2, ring.Published());
+}
+
+TEST(SeqlockRing, aal0832)
+{
+   // Once full, the ring keeps only the N newest values.
+
+   SeqlockRing<RingValue, 4> ring;
+   RingValue                 h[8];
+   btUnsigned64bitInt        n;
+
+   for ( n = 1 ; n <= 10 ; ++n ) {
+      ring.Publish(MakeRingValue(n));
+   }
+
+   ASSERT_EQ(4, ring.History(h, 8));
+   for ( int i = 0 ; i < 4 ; ++i ) {
+      EXPECT_EQ(10 - i, h[i].a);
+   }
+
+   EXPECT_EQ(1, ring.History(h, 1));
+   EXPECT_EQ(10, h[0].a);
+
+   ring.Reset();
+   EXPECT_EQ(0, ring.History(h, 8));
+}
+
+class SeqlockRing_f : public ::testing::Test
+{
+public:
+   typedef SeqlockRing<RingValue, 8> Ring;
+
+   static void Writer(OSLThread * , void *pContext)
+   {
+      SeqlockRing_f *f = reinterpret_cast<SeqlockRing_f *>(pContext);
+      for ( btUnsigned64bitInt n = 1 ; n <= f->m_Writes ; ++n ) {
+         f->m_Ring.Publish(MakeRingValue(n));
+      }
+   }
+
+   static void Reader(OSLThread * , void *pContext)
+   {
+      SeqlockRing_f     *f    = reinterpret_cast<SeqlockRing_f *>(pContext);
+      btUnsigned64bitInt last = 0;
+      RingValue          v;
+
+      while ( last < f->m_Writes ) {
+         if ( !f->m_Ring.Latest(v) ) {
+            continue;
+         }
+         for ( int i = 0 ; i < 7 ; ++i ) {
+            if ( v.b[i] != v.a ) {
+               f->m_Torn.Post(1);
+               return;
+            }
+         }
+         if ( v.a < last ) {
+            f->m_Torn.Post(1);
+            return;
+         }
+         last = v.a;
+      }
+   }
+
+   virtual void SetUp()
+   {
+      m_Writes = 200000;
+      m_Torn.Create(0, INT_MAX);
+   }
+
+   Ring               m_Ring;
+   btUnsigned64bitInt m_Writes;
+   CSemaphore         m_Torn;
+};
+
+TEST_F(SeqlockRing_f, aal0833)
+{
+   // Concurrent readers never observe a partially written value, and the
+   //  newest value never moves backwards.
+
+   const int  nReaders = 4;
+   OSLThread *readers[nReaders];
+   int        i;
+
+   for ( i = 0 ; i < nReaders ; ++i ) {
+      readers[i] = new OSLThread(SeqlockRing_f::Reader, OSLThread::THREADPRIORITY_NORMAL, this);
+   }
+   OSLThread writer(SeqlockRing_f::Writer, OSLThread::THREADPRIORITY_NORMAL, this);
+
+   writer.Join();
+   for ( i = 0 ; i < nReaders ; ++i ) {
+      readers[i]->Join();
+      delete readers[i];
+   }
+
+   btInt cur = 0;
+   btInt max = 0;
+   EXPECT_TRUE(m_Torn.CurrCounts(cur, max));
+   EXPECT_EQ(0, cur);
+}
+
+TEST(ALIPerf, aal0834)
+{
+   // ALIPerfComputeRates() scales deltas to per-second values, handles a
+   //  64-bit counter wrap, and rejects samples that are not in time order.
+
+   ALIPerfSample prev;
+   ALIPerfSample cur;
+   ALIPerfRates  rates;
+
+   memset(&prev, 0, sizeof(prev));
+   memset(&cur, 0, sizeof(cur));
+
+   prev.timestamp = 1000000000ULL;
+   cur.timestamp  = 1500000000ULL;   // 0.5 s later
+
+   prev.counters[aliPerfReadHit] = 100;
+   cur.counters[aliPerfReadHit]  = 600;
+
+   prev.counters[aliPerfUPIWrite] = 0xfffffffffffffff0ULL;
+   cur.counters[aliPerfUPIWrite]  = 0x10ULL;
+
+   ASSERT_TRUE(ALIPerfComputeRates(prev, cur, rates));
+   EXPECT_EQ(500000000ULL, rates.interval);
+   EXPECT_DOUBLE_EQ(1000.0, rates.perSecond[aliPerfReadHit]);
+   EXPECT_DOUBLE_EQ(64.0, rates.perSecond[aliPerfUPIWrite]);
+   EXPECT_DOUBLE_EQ(0.0, rates.perSecond[aliPerfEvictions]);
+
+   EXPECT_FALSE(ALIPerfComputeRates(cur, prev, rates));
+   EXPECT_FALSE(ALIPerfComputeRates(cur, cur, rates));
+}
@@ -0,0 +1,142 @@
+// INTEL CONFIDENTIAL - For Intel Internal Use Only
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+#include "gtCommon.h"
+
+#include <aalsdk/aas/ServiceShutdown.h>
+
+// Stands in for a Service plug-in: Destroy() takes m_Millis, or until the
+//  test opens the gate when m_bHang, and records how many ran at once.
+class FakeServiceModule : public IServiceModule
+{
+public:
+   FakeServiceModule(btTime Millis=0, btBool bHang=false) :
+      m_Millis(Millis),
+      m_bHang(bHang),
+      m_bDestroyed(false)
+   {
+      m_Gate.Create(0, INT_MAX);
+   }
+
+   btBool Construct(IRuntime * , IBase * , TransactionID const & , NamedValueSet const & ) { return false; }
+
+   void Destroy()
+   {
+      {
+         AutoLock(&sm_Lock);
+         if ( ++sm_Inside > sm_MaxInside ) {
+            sm_MaxInside = sm_Inside;
+         }
+      }
+
+      if ( m_bHang ) {
+         m_Gate.Wait();
+      }
+      SleepMilli(m_Millis);
+
+      {
+         AutoLock(&sm_Lock);
+         --sm_Inside;
+      }
+      m_bDestroyed = true;
+   }
+
+   void OpenGate() { m_Gate.Post(1); }
+
+   btTime          m_Millis;
+   btBool          m_bHang;
+   volatile btBool m_bDestroyed;
+   CSemaphore      m_Gate;
+
+   static CriticalSection sm_Lock;
+   static btUnsignedInt   sm_Inside;
+   static btUnsignedInt   sm_MaxInside;
+};
+
+CriticalSection FakeServiceModule::sm_Lock;
+btUnsignedInt   FakeServiceModule::sm_Inside    = 0;
+btUnsignedInt   FakeServiceModule::sm_MaxInside = 0;
+
+TEST(ServiceShutdown, aal0852)
+{
+   // The providers are destroyed in parallel, and the report holds how long
+   //  each took, by name, in the order added. No thread outlives Run().
+
+   FakeServiceModule a(50), b(50), c(50);
+   FakeServiceModule::sm_MaxInside = 0;
+
+   ServiceShutdown Shutdown;
+   Shutdown.Add("a", &a);
+   Shutdown.Add("b", &b);
+   Shutdown.Add("c", &c);
+   ASSERT_EQ(3, Shutdown.Count());
+
+   EXPECT_EQ(0, Shutdown.Run(5000));
+   EXPECT_EQ(0, GlobalTestConfig::GetInstance().CurrentThreads());
+
+   EXPECT_TRUE(a.m_bDestroyed);
+   EXPECT_TRUE(b.m_bDestroyed);
+   EXPECT_TRUE(c.m_bDestroyed);
+   EXPECT_EQ(3, FakeServiceModule::sm_MaxInside);
+
+   ServiceShutdown::Record rec = Shutdown.Get(1);
+   EXPECT_STREQ("b", rec.Name.c_str());
+   EXPECT_EQ(&b, rec.pProvider);
+   EXPECT_EQ(ServiceShutdown::Done, rec.Result);
+   EXPECT_GE(rec.Nanos, 50000000ULL);
+
+   rec = Shutdown.Get(2);
+   EXPECT_STREQ("c", rec.Name.c_str());
+   EXPECT_EQ(ServiceShutdown::Done, rec.Result);
+   EXPECT_GE(rec.Nanos, 50000000ULL);
+
+   EXPECT_EQ(std::string::npos, Shutdown.ToString().find("forced"));
+
+   // Nothing to shut down.
+   ServiceShutdown Empty;
+   EXPECT_EQ(0, Empty.Run(AAL_INFINITE_WAIT));
+   EXPECT_EQ(0, Empty.Count());
+}
+
+TEST(ServiceShutdown, aal0853)
+{
+   // A provider that misses its deadline is forced, without holding up the
+   //  others. Should it finish later, nothing is left for it to disturb,
+   //  and its pool then goes away.
+
+   FakeServiceModule hung(0, true), quick(10);
+
+   {
+      ServiceShutdown Shutdown;
+      Shutdown.Add("hung",  &hung);
+      Shutdown.Add("quick", &quick);
+
+      Timer Begin;
+      EXPECT_EQ(1, Shutdown.Run(100));
+      btUnsigned64bitInt millis = 0;
+      (Timer() - Begin).AsMilliSeconds(millis);
+      EXPECT_GE(millis, 100ULL);
+      EXPECT_LT(millis, 2000ULL);
+
+      EXPECT_EQ(ServiceShutdown::Forced, Shutdown.Get(0).Result);
+      EXPECT_GE(Shutdown.Get(0).Nanos, 100000000ULL);
+      EXPECT_EQ(ServiceShutdown::Done,   Shutdown.Get(1).Result);
+      EXPECT_TRUE(quick.m_bDestroyed);
+      EXPECT_FALSE(hung.m_bDestroyed);
+
+      EXPECT_NE(std::string::npos, Shutdown.ToString().find("hung="));
+      EXPECT_NE(std::string::npos, Shutdown.ToString().find("(forced)"));
+   }
+
+   hung.OpenGate();
+   for ( int i = 0 ; ( i < 5000 ) && !hung.m_bDestroyed ; ++i ) {
+      SleepMilli(1);
+   }
+   EXPECT_TRUE(hung.m_bDestroyed);
+
+   for ( int i = 0 ; ( i < 5000 ) && ( GlobalTestConfig::GetInstance().CurrentThreads() > 0 ) ; ++i ) {
+      SleepMilli(1);
+   }
+   EXPECT_EQ(0, GlobalTestConfig::GetInstance().CurrentThreads());
+}
@@ -2113,6 +2113,248 @@ INSTANTIATE_TEST_CASE_P(My, OSAL_ThreadGroup_vp_uint_0,
                                              (AAL::btUnsignedInt)10,
                                              (AAL::btUnsignedInt)25));
 
+TEST_F(OSAL_ThreadGroup_f, aal0854)
+{
+   // A Thread Group created with uiMaxThreads > uiMinThreads adds a worker for each work item
+   // no idle worker will take, up to uiMaxThreads, and retires the extra workers after the
+   // keep-alive. GetStats() counts the queue and the workers.
+
+   ASSERT_TRUE(m_Sems[0].Create(0, INT_MAX));
+   ASSERT_TRUE(m_Sems[1].Create(0, INT_MAX));
+
+   OSLThreadGroup *g = Create(1,
+                              4,
+                              OSLThread::THREADPRIORITY_NORMAL,
+                              AAL_INFINITE_WAIT);
+   ASSERT_NONNULL(g);
+   ASSERT_TRUE(g->IsOK());
+   EXPECT_EQ(1, g->GetNumThreads());
+
+   g->SetScaling(OSLThreadGroupScaling(1, AAL_INFINITE_WAIT, 50));
+
+   // Four blockers, each on its own worker.
+   AAL::btInt i;
+   for ( i = 0 ; i < 4 ; ++i ) {
+      EXPECT_TRUE(Add( new PostThenWaitD(m_Sems[0], m_Sems[1]) ));
+   }
+   for ( i = 0 ; i < 4 ; ++i ) {
+      EXPECT_TRUE(m_Sems[0].Wait(5000));
+   }
+   EXPECT_EQ(4, g->GetNumThreads());
+   EXPECT_EQ(4, CurrentThreads());
+
+   // No more than uiMaxThreads.
+   EXPECT_TRUE(Add( new PostThenWaitD(m_Sems[0], m_Sems[1]) ));
+   EXPECT_TRUE(Add( new PostThenWaitD(m_Sems[0], m_Sems[1]) ));
+   EXPECT_EQ(4, g->GetNumThreads());
+
+   OSLThreadGroupStats stats;
+   g->GetStats(stats);
+   EXPECT_EQ(4, stats.Threads);
+   EXPECT_EQ(0, stats.IdleThreads);
+   EXPECT_EQ(4, stats.PeakThreads);
+   EXPECT_EQ(3, stats.Spawned);
+   EXPECT_EQ(0, stats.Retired);
+   EXPECT_EQ(2, stats.QueueDepth);
+   EXPECT_GE(stats.PeakQueueDepth, 2);
+   EXPECT_EQ(4, stats.Dispatched);
+
+   SleepMilli(10);
+   EXPECT_TRUE(m_Sems[1].Post(6));
+   EXPECT_TRUE(g->Drain());
+
+   // Back down to uiMinThreads once idle.
+   for ( i = 0 ; ( i < 5000 ) && ( g->GetNumThreads() > 1 ) ; ++i ) {
+      SleepMilli(1);
+   }
+   EXPECT_EQ(1, g->GetNumThreads());
+
+   g->GetStats(stats);
+   EXPECT_EQ(1, stats.Threads);
+   EXPECT_EQ(3, stats.Retired);
+   EXPECT_EQ(0, stats.QueueDepth);
+   EXPECT_EQ(6, stats.Dispatched);
+   EXPECT_GE(stats.MaxWaitNanos, 10000000ULL);
+   EXPECT_GE(stats.TotalWaitNanos, stats.MaxWaitNanos);
+   EXPECT_GE(stats.BusyNanos, 40000000ULL);
+   EXPECT_GT(stats.WorkerNanos, stats.BusyNanos);
+   EXPECT_GT(stats.Utilization(), 0.0);
+   EXPECT_LT(stats.Utilization(), 1.0);
+
+   // It grows again for the next burst.
+   EXPECT_TRUE(Add( new PostThenWaitD(m_Sems[0], m_Sems[1]) ));
+   EXPECT_TRUE(Add( new PostThenWaitD(m_Sems[0], m_Sems[1]) ));
+   EXPECT_TRUE(m_Sems[0].Wait(5000));
+   EXPECT_TRUE(m_Sems[0].Wait(5000));
+   EXPECT_EQ(2, g->GetNumThreads());
+   EXPECT_TRUE(m_Sems[1].Post(2));
+
+   EXPECT_TRUE(g->Destroy(AAL_INFINITE_WAIT));
+   EXPECT_EQ(0, CurrentThreads());
+}
+
+TEST_F(OSAL_ThreadGroup_f, aal0855)
+{
+   // With a QueueThreshold too high to reach, a worker is added once the oldest queued item
+   // has waited WaitThreshold. Join() runs what is queued and joins every worker, including
+   // those added, and a static group never grows.
+
+   ASSERT_TRUE(m_Sems[0].Create(0, INT_MAX));
+   ASSERT_TRUE(m_Sems[1].Create(0, INT_MAX));
+
+   OSLThreadGroup *g = Create(1,
+                              3,
+                              OSLThread::THREADPRIORITY_NORMAL,
+                              AAL_INFINITE_WAIT);
+   ASSERT_NONNULL(g);
+   ASSERT_TRUE(g->IsOK());
+
+   g->SetScaling(OSLThreadGroupScaling(100, 20, AAL_INFINITE_WAIT));
+
+   AAL::btInt counter = 0;
+
+   EXPECT_TRUE(Add( new PostThenWaitD(m_Sems[0], m_Sems[1]) ));
+   EXPECT_TRUE(m_Sems[0].Wait(5000));
+   EXPECT_TRUE(Add( new PostThenWaitD(m_Sems[0], m_Sems[1]) ));
+   EXPECT_EQ(1, g->GetNumThreads());
+
+   // The second blocker has now waited long enough.
+   SleepMilli(30);
+   EXPECT_TRUE(Add( new UnsafeCountUpD(counter) ));
+   EXPECT_TRUE(m_Sems[0].Wait(5000));
+   EXPECT_EQ(2, g->GetNumThreads());
+
+   EXPECT_TRUE(m_Sems[1].Post(2));
+   EXPECT_TRUE(g->Join(AAL_INFINITE_WAIT));
+   EXPECT_EQ(0, CurrentThreads());
+   EXPECT_EQ(1, counter);
+
+   EXPECT_TRUE(g->Destroy(AAL_INFINITE_WAIT));
+   delete m_pGroup;
+   m_pGroup = NULL;
+
+   g = Create(2,
+              2,
+              OSLThread::THREADPRIORITY_NORMAL,
+              AAL_INFINITE_WAIT);
+   ASSERT_NONNULL(g);
+   g->SetScaling(OSLThreadGroupScaling(1, 0, 1));
+
+   for ( AAL::btInt i = 0 ; i < 4 ; ++i ) {
+      EXPECT_TRUE(Add( new PostThenWaitD(m_Sems[0], m_Sems[1]) ));
+   }
+   EXPECT_TRUE(m_Sems[0].Wait(5000));
+   EXPECT_TRUE(m_Sems[0].Wait(5000));
+   EXPECT_EQ(2, g->GetNumThreads());
+   EXPECT_EQ(2, g->GetNumWorkItems());
+
+   EXPECT_TRUE(m_Sems[1].Post(4));
+   EXPECT_TRUE(g->Drain());
+   SleepMilli(10);
+   EXPECT_EQ(2, g->GetNumThreads());
+
+   OSLThreadGroupStats stats;
+   g->GetStats(stats);
+   EXPECT_EQ(0, stats.Spawned);
+   EXPECT_EQ(0, stats.Retired);
+   EXPECT_EQ(4, stats.Dispatched);
+}
+
+TEST_F(OSAL_ThreadGroup_f, aal0856)
+{
+   // With priority dispatch, workers take critical items, then normal, then bulk, each class
+   // in order. A lower class passed over StarvationLimit times is served next. GetStats()
+   // reports each class. Without priority dispatch, the class is ignored.
+
+   ASSERT_TRUE(m_Sems[0].Create(0, INT_MAX));
+   ASSERT_TRUE(m_Sems[1].Create(0, INT_MAX));
+
+   OSLThreadGroup *g = Create(1,
+                              1,
+                              OSLThread::THREADPRIORITY_NORMAL,
+                              AAL_INFINITE_WAIT);
+   ASSERT_NONNULL(g);
+   ASSERT_TRUE(g->IsOK());
+
+   std::string order;
+
+   g->SetPriorityDispatch(true, 0);
+
+   EXPECT_TRUE(Add( new PostThenWaitD(m_Sems[0], m_Sems[1]) ));
+   EXPECT_TRUE(m_Sems[0].Wait(5000));
+
+   EXPECT_TRUE(Add( new ClassRecordD(order, 'b', DispatchBulk) ));
+   EXPECT_TRUE(Add( new ClassRecordD(order, 'n', DispatchNormal) ));
+   EXPECT_TRUE(Add( new ClassRecordD(order, 'c', DispatchCritical) ));
+   EXPECT_TRUE(Add( new ClassRecordD(order, 'B', DispatchBulk) ));
+   EXPECT_TRUE(Add( new ClassRecordD(order, 'C', DispatchCritical) ));
+   EXPECT_TRUE(Add( new ClassRecordD(order, 'N', DispatchNormal) ));
+
+   OSLThreadGroupStats stats;
+   g->GetStats(stats);
+   EXPECT_EQ(6, stats.QueueDepth);
+   EXPECT_EQ(2, stats.Classes[DispatchCritical].QueueDepth);
+   EXPECT_EQ(2, stats.Classes[DispatchNormal].QueueDepth);
+   EXPECT_EQ(2, stats.Classes[DispatchBulk].QueueDepth);
+
+   SleepMilli(10);
+   EXPECT_TRUE(m_Sems[1].Post(1));
+   EXPECT_TRUE(g->Drain());
+   EXPECT_STREQ("cCnNbB", order.c_str());
+
+   g->GetStats(stats);
+   EXPECT_EQ(2, stats.Classes[DispatchCritical].Dispatched);
+   EXPECT_EQ(3, stats.Classes[DispatchNormal].Dispatched);
+   EXPECT_EQ(2, stats.Classes[DispatchBulk].Dispatched);
+   EXPECT_EQ(0, stats.Classes[DispatchBulk].Promoted);
+   EXPECT_GE(stats.Classes[DispatchCritical].MaxWaitNanos, 10000000ULL);
+   EXPECT_GE(stats.Classes[DispatchBulk].MaxWaitNanos, stats.Classes[DispatchCritical].MaxWaitNanos);
+   EXPECT_GE(stats.Classes[DispatchBulk].TotalWaitNanos, stats.Classes[DispatchBulk].MaxWaitNanos);
+   EXPECT_EQ(stats.MaxWaitNanos, stats.Classes[DispatchBulk].MaxWaitNanos);
+
+   // Bulk work is served after every two critical items taken while it waits.
+   g->SetPriorityDispatch(true, 2);
+   order.clear();
+
+   EXPECT_TRUE(Add( new PostThenWaitD(m_Sems[0], m_Sems[1]) ));
+   EXPECT_TRUE(m_Sems[0].Wait(5000));
+
+   EXPECT_TRUE(Add( new ClassRecordD(order, 'b', DispatchBulk) ));
+   EXPECT_TRUE(Add( new ClassRecordD(order, 'B', DispatchBulk) ));
+   EXPECT_TRUE(Add( new ClassRecordD(order, '1', DispatchCritical) ));
+   EXPECT_TRUE(Add( new ClassRecordD(order, '2', DispatchCritical) ));
+   EXPECT_TRUE(Add( new ClassRecordD(order, '3', DispatchCritical) ));
+   EXPECT_TRUE(Add( new ClassRecordD(order, '4', DispatchCritical) ));
+   EXPECT_TRUE(Add( new ClassRecordD(order, '5', DispatchCritical) ));
+
+   EXPECT_TRUE(m_Sems[1].Post(1));
+   EXPECT_TRUE(g->Drain());
+   EXPECT_STREQ("12b34B5", order.c_str());
+
+   g->GetStats(stats);
+   EXPECT_EQ(2, stats.Classes[DispatchBulk].Promoted);
+   EXPECT_EQ(0, stats.Classes[DispatchCritical].Promoted);
+
+   // In the order added once disabled.
+   g->SetPriorityDispatch(false);
+   order.clear();
+
+   EXPECT_TRUE(Add( new PostThenWaitD(m_Sems[0], m_Sems[1]) ));
+   EXPECT_TRUE(m_Sems[0].Wait(5000));
+
+   EXPECT_TRUE(Add( new ClassRecordD(order, 'b', DispatchBulk) ));
+   EXPECT_TRUE(Add( new ClassRecordD(order, 'c', DispatchCritical) ));
+
+   g->GetStats(stats);
+   EXPECT_EQ(2, stats.Classes[DispatchNormal].QueueDepth);
+
+   EXPECT_TRUE(m_Sems[1].Post(1));
+   EXPECT_TRUE(g->Drain());
+   EXPECT_STREQ("bc", order.c_str());
+
+   EXPECT_TRUE(g->Destroy(AAL_INFINITE_WAIT));
+   EXPECT_EQ(0, CurrentThreads());
+}
 
 TEST(FireAndWait, aal0691)
 {
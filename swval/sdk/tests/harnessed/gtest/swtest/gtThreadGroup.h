@@ -159,6 +159,30 @@ protected:
    AAL::btInt  m_incr;
 };
 
+// Records its Id when run, and reports Class to a Thread Group with priority dispatch.
+class ClassRecordD : public IDispatchable
+{
+public:
+   ClassRecordD(std::string   &Record,
+                char           Id,
+                DispatchClass  Class) :
+      m_Record(Record),
+      m_Id(Id),
+      m_Class(Class)
+   {}
+   virtual ~ClassRecordD() {}
+   virtual void operator() ()
+   {
+      m_Record += m_Id;
+   }
+   virtual DispatchClass GetDispatchClass() const { return m_Class; }
+
+protected:
+   std::string   &m_Record;
+   char           m_Id;
+   DispatchClass  m_Class;
+};
+
 class DelUnsafeCountUpD : public IDispatchable
 {
 public:
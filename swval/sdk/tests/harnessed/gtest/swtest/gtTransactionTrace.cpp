@@ -0,0 +1,131 @@
+// INTEL CONFIDENTIAL - For Intel Internal Use Only
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif // HAVE_CONFIG_H
+#include "gtCommon.h"
+#include <aalsdk/AALTransactionTrace.h>
+
+class TransactionTrace_f : public ::testing::Test
+{
+public:
+   virtual void SetUp()
+   {
+      TransactionTrace::Disable();
+      TransactionTrace::Reset();
+   }
+   virtual void TearDown()
+   {
+      TransactionTrace::Disable();
+      TransactionTrace::Reset();
+   }
+
+   // Stands in for the AIA message pump and dispatcher: the later stages of
+   //  each transaction happen on another thread.
+   static void Upstream(OSLThread * , void *pContext)
+   {
+      TransactionTrace_f *f = reinterpret_cast<TransactionTrace_f *>(pContext);
+      for ( btID id = 100 ; id < 100 + f->m_Count ; ++id ) {
+         AAL_TRACE_TRANSACTION(txtraceAIAUpstream, id);
+         SleepMicro(10);
+         AAL_TRACE_TRANSACTION(txtraceDispatch, id);
+      }
+   }
+
+   btUnsignedInt m_Count;
+};
+
+TEST_F(TransactionTrace_f, aal0851)
+{
+   // Tracepoints record nothing while tracing is disabled. Once enabled,
+   //  records are grouped by ID into time-ordered timelines, consecutive
+   //  stages give latency histograms, and the whole is written as Chrome
+   //  trace JSON.
+
+   std::vector<TransactionTraceRecord> records;
+
+   AAL_TRACE_TRANSACTION(txtraceAIASend, 1);
+   TransactionTrace::Snapshot(records);
+   EXPECT_TRUE(records.empty());
+
+   ASSERT_TRUE(TransactionTrace::Enable(1024));
+   EXPECT_TRUE(TransactionTrace::IsEnabled());
+
+   m_Count = 20;
+   for ( btID id = 100 ; id < 100 + m_Count ; ++id ) {
+      AAL_TRACE_TRANSACTION(txtraceAIASend, id);
+      AAL_TRACE_TRANSACTION(txtraceAIASent, id);
+   }
+
+   OSLThread *pThread = new OSLThread(TransactionTrace_f::Upstream, OSLThread::THREADPRIORITY_NORMAL, this);
+   pThread->Join();
+   delete pThread;
+
+   TransactionTrace::Disable();
+   AAL_TRACE_TRANSACTION(txtraceAIASend, 1);   // not recorded
+
+   EXPECT_EQ(4 * m_Count, TransactionTrace::Recorded());
+
+   TransactionTimelines timelines;
+   TransactionTrace::Timelines(timelines);
+   ASSERT_EQ(m_Count, timelines.size());
+   EXPECT_TRUE(timelines.end() == timelines.find(1));
+
+   const TransactionTimeline &t = timelines[105];
+   ASSERT_EQ(4, t.size());
+   EXPECT_EQ((btUnsigned32bitInt)txtraceAIASend,     t[0].Stage);
+   EXPECT_EQ((btUnsigned32bitInt)txtraceAIASent,     t[1].Stage);
+   EXPECT_EQ((btUnsigned32bitInt)txtraceAIAUpstream, t[2].Stage);
+   EXPECT_EQ((btUnsigned32bitInt)txtraceDispatch,    t[3].Stage);
+   EXPECT_EQ(t[0].Thread, t[1].Thread);
+   EXPECT_NE(t[1].Thread, t[2].Thread);
+   for ( size_t i = 1 ; i < t.size() ; ++i ) {
+      EXPECT_LE(t[i - 1].Nanos, t[i].Nanos);
+   }
+
+   std::vector<TransactionTraceHistogram> hists;
+   TransactionTrace::StageLatencies(hists);
+   ASSERT_EQ(3, hists.size());
+
+   const TransactionTraceHistogram &h = hists[2];   // upstream -> dispatch
+   EXPECT_EQ((btUnsigned32bitInt)txtraceAIAUpstream, h.From);
+   EXPECT_EQ((btUnsigned32bitInt)txtraceDispatch,    h.To);
+   EXPECT_EQ((btUnsigned64bitInt)m_Count, h.Count);
+   EXPECT_GE(h.MinNanos, 10000ULL);
+   EXPECT_LE(h.MinNanos, h.MaxNanos);
+   EXPECT_GE(h.Percentile(0.5), h.MinNanos);
+   EXPECT_LE(h.Percentile(0.5), h.MaxNanos);
+
+   btUnsigned64bitInt n = 0;
+   for ( btUnsigned32bitInt i = 0 ; i < TransactionTraceHistogram::Buckets ; ++i ) {
+      n += h.Bucket[i];
+   }
+   EXPECT_EQ(h.Count, n);
+
+   std::ostringstream os;
+   ASSERT_TRUE(TransactionTrace::WriteChromeTrace(os));
+   const std::string json = os.str();
+   EXPECT_EQ(0, json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+   EXPECT_NE(std::string::npos, json.find("\"name\":\"txn 105\""));
+   EXPECT_NE(std::string::npos, json.find("\"name\":\"aia.upstream -> dispatch\",\"cat\":\"aal\",\"ph\":\"X\""));
+   EXPECT_EQ(json.size() - 3, json.rfind("]}"));
+
+   EXPECT_STREQ("runtime.allocService", TransactionTrace::StageName(txtraceRuntimeAllocService));
+   EXPECT_STREQ("user.1",               TransactionTrace::StageName(txtraceUser + 1));
+   EXPECT_STREQ("unknown",              TransactionTrace::StageName(txtraceMaxStage));
+
+   // The ring keeps the newest records.
+   TransactionTrace::Reset();
+   ASSERT_TRUE(TransactionTrace::Enable());
+
+   const btUnsigned64bitInt cap = TransactionTrace::Capacity();
+   ASSERT_GE(cap, 1024ULL);
+   const btID total = cap + cap / 2;
+
+   for ( btID id = 0 ; id < total ; ++id ) {
+      AAL_TRACE_TRANSACTION(txtraceUser, id);
+   }
+   TransactionTrace::Snapshot(records);
+   ASSERT_EQ(cap, records.size());
+   EXPECT_EQ(total - cap, records.front().ID);
+   EXPECT_EQ(total - 1,   records.back().ID);
+}
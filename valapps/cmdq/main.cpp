@@ -17,6 +17,8 @@ int main(int argc, char* argv[])
     argparse("ase",         'A', no_argument);
     argparse("perfc",       'P', no_argument);
     argparse("stats",       'S', optional_argument);
+    argparse("depth",       'd', optional_argument);
+    argparse("jobs",        'j', optional_argument);
 
     if (!argparse.parse(argc, argv))
     {
@@ -48,6 +50,29 @@ int main(int argc, char* argv[])
 
     nlb->configure(test_mode, argparse.get_string("config"));
 
+    if (argparse.have("depth"))
+    {
+        // pipelined mode, measured against one command at a time
+        auto depth = argparse.get_int("depth", 2);
+        auto jobs = argparse.get_int("jobs", 1000);
+        nlb->command_pipeline(cachelines, 1, jobs);
+        nlb->command_pipeline(cachelines, depth, jobs);
+
+        if (stats == "stdout")
+        {
+            nlb->write_pipeline_stats(std::cout);
+        }
+        else
+        {
+            std::ofstream fout;
+            fout.open(stats + "-pipeline.csv");
+            nlb->write_pipeline_stats(fout);
+            fout.close();
+        }
+        sm->shutdown();
+        return 0;
+    }
+
     if (argparse.have("input"))
     {
         auto input = argparse.get_string("input");
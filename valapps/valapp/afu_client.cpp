@@ -1,9 +1,11 @@
 #include "afu_client.h"
 #include <functional>
+#include <chrono>
 
 using namespace AAL;
 
 afu_client::afu_client() : service_client()
+, cmpl_(0)
 {
 }
 
@@ -19,6 +21,7 @@ void afu_client::serviceAllocated(IBase *pServiceBase, TransactionID const &rTra
     perf_ = dynamic_ptr<IALIPerf>(iidALI_PERF_Service, pServiceBase);
     reset_ = dynamic_ptr<IALIReset>(iidALI_RSET_Service, pServiceBase);
     stap_ = dynamic_ptr<IALISignalTap>(iidALI_STAP_Service, pServiceBase);
+    cmpl_ = dynamic_ptr<IALICompletion>(iidALI_CMPL_Service, pServiceBase);
     service_client::serviceAllocated(pServiceBase, rTransID);
 }
 
@@ -71,6 +74,27 @@ long long unsigned int afu_client::mmio_read64(unsigned int offset)
     return value;
 }
 
+bool afu_client::wait_for_dsm(volatile bt32bitCSR *word, uint32_t mask, uint32_t value, btTime timeout_ms)
+{
+    if (cmpl_)
+    {
+        return IALICompletion::e_Done == cmpl_->completionWaitFor(word, mask, value, timeout_ms);
+    }
+
+    // no IALICompletion (it is only published on Linux), so poll
+    auto start = std::chrono::steady_clock::now();
+    while (((*word) & mask) != value)
+    {
+        if (AAL_INFINITE_WAIT != timeout_ms &&
+            std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(timeout_ms))
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(10));
+    }
+    return true;
+}
+
 bool afu_client::feature_id_offset(uint32_t feature_id, uint32_t &offset)
 {
     NamedValueSet request;
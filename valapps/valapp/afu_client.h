@@ -47,6 +47,9 @@ class afu_client : public service_client
 
         long long unsigned int mmio_read64(unsigned int offset);
 
+        /// @brief wait up to timeout_ms for (*word & mask) == value
+        bool wait_for_dsm(volatile AAL::bt32bitCSR *word, uint32_t mask, uint32_t value, AAL::btTime timeout_ms);
+
         bool feature_id_offset(uint32_t feature_id, uint32_t &offset);
 
         bool feature_type_offset(uint32_t feature_type, uint32_t &type);
@@ -78,6 +81,7 @@ class afu_client : public service_client
         AAL::IALIPerf *perf_;
         AAL::IALIReset *reset_;
         AAL::IALISignalTap *stap_;
+        AAL::IALICompletion *cmpl_;
 
 
 };
@@ -2,8 +2,14 @@
 #include "test_manager.h"
 #include "test_args.h"
 //#include <aalsdk/service/IALIAFU.h> 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <string>
+#include <climits>
+#include <unistd.h>
 #include "afu_test.h"
 #include "arguments.h"
 
@@ -12,12 +18,54 @@ int main(int argc, char* argv[])
     int exit_code = 0;
     arguments argparse;
     argparse("services", 's', optional_argument, "service spec file")
-            ("testspec", 'x', optional_argument, "test spec file");
+            ("testspec", 'x', optional_argument, "test spec file")
+            ("jobs",     'j', optional_argument, "run the test spec in child processes, this many at once")
+            ("timeout",  't', optional_argument, "seconds a child process test may run")
+            ("output",   'o', optional_argument, "directory for the output of child process tests")
+            ("report",   'r', optional_argument, "report file name (.xml and .json are added)");
 
     argparse.parse(argc, argv);
 
     std::string services_file = argparse.get_string("services", "services.json");
 
+    if (argparse.have("testspec") && argparse.have("jobs"))
+    {
+        // each test starts its own runtime in a child process
+        // so this one does not start one at all
+        char self[PATH_MAX] = { 0 };
+        if (readlink("/proc/self/exe", self, sizeof(self) - 1) <= 0)
+        {
+            std::strncpy(self, argv[0], sizeof(self) - 1);
+        }
+        test_manager::run_options options;
+        options.program = self;
+        options.services = services_file;
+        options.jobs = argparse.get_int("jobs", 1);
+        options.timeout = argparse.get_double("timeout", 600.0);
+        options.output_dir = argparse.get_string("output", "test-output");
+
+        auto tm = test_manager::instance();
+        auto start = std::chrono::steady_clock::now();
+        auto results = tm->run_tests(argparse.get_string("testspec"), options);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        auto report = argparse.get_string("report", "valapp-results");
+        std::ofstream junit(report + ".xml");
+        tm->write_junit(junit, results);
+        std::ofstream json(report + ".json");
+        tm->write_json(json, results);
+
+        for (auto result : results)
+        {
+            if (result.status != afu_test::status_pass && result.status != afu_test::status_skipped)
+            {
+                exit_code = -1;
+            }
+        }
+        std::cerr << results.size() << " tests in " << elapsed.count() << " seconds, report in " << report << ".xml" << std::endl;
+        return exit_code;
+    }
+
     
     service_manager::ptr_t manager = service_manager::instance();
     manager->define_services(services_file);
@@ -34,12 +82,12 @@ int main(int argc, char* argv[])
         {
             tm->load_testlib(leftover[0]);
             auto results = tm->run_test(leftover[1], leftover[2], leftover.size()-2, &leftover[2]); 
+            // the worst status is the exit code, which is how the child
+            // process tests of a parallel run report back
+            exit_code = results.empty() ? afu_test::status_notfound : afu_test::status_pass;
             for (auto result : results)
             {
-                if (std::get<1>(result) != afu_test::status_pass)
-                {
-                    exit_code = -1;
-                }
+                exit_code = std::max(exit_code, static_cast<int>(std::get<1>(result)));
                 std::cerr << "Test: " << std::get<0>(result) << " " << std::get<1>(result) << " " << std::get<2>(result) << std::endl;
             }
         }
@@ -1,6 +1,7 @@
 #include "nlb_client.h"
 #include "afu_test.h"
 #include "utils.h"
+#include <algorithm>
 #include <chrono>
 #include <functional>
 #include "client_factory.h"
@@ -16,6 +17,9 @@ using usec = microseconds;
 namespace
 {
     static bool b = client_factory::register_client<nlb_client>();
+
+    // how long a DSM wait runs before the caller checks for cancellation
+    const AAL::btTime dsm_wait_ms = 1;
 }
 
 static std::map<std::string, uint32_t> read_ch_names =
@@ -104,7 +108,6 @@ void nlb_client::setup(uint32_t test_mode, uint32_t dsm_size, uint32_t buffer_si
 
 bool nlb_client::loopback1( uint32_t dsm_size, uint32_t buffer_size)
 {
-    using usec = microseconds;
     setup(0x200, dsm_size, buffer_size);
 
     ::memset(dsm_->address(), 0,    dsm_size);
@@ -117,10 +120,7 @@ bool nlb_client::loopback1( uint32_t dsm_size, uint32_t buffer_size)
     // start the test
     mmio_write32(static_cast<uint32_t>(nlb_client::csr::ctl), 3);
 
-    while ( 0 == ((*status_addr)&0x1))
-    {
-        std::this_thread::sleep_for(usec(10));
-    }
+    wait_for_dsm(status_addr, 0x1, 0x1, AAL_INFINITE_WAIT);
     // stop the device
     mmio_write32(static_cast<uint32_t>(nlb_client::csr::ctl), 7);
 
@@ -378,26 +378,17 @@ uint32_t nlb_client::hwvalid_loop(cmdq_t &fifo1, cmdq_t &fifo2)
                 // Wait for status bit to be set to 1
                 // Becasue NLB uses dsm number as zero based, 
                 // for the first iteration, wait until the status is 1
-                while ( 0 == ((*dsm_status_addr)&0x1) )
+                while ( !cancel_ && !wait_for_dsm(dsm_status_addr, 0x1, 0x1, dsm_wait_ms) )
                 {
-                    if (cancel_)
-                    {
-                        break;
-                    }
-                    std::this_thread::sleep_for(usec(10));
                 }
                 //std::cout << "dsm_status 0x" << ((*dsm_status_addr)&0x1) << std::endl;
             }
             else
             {
                 // Othersize, wait for NLB to write index to dsm number
-                while ( iteration != ((*dsm_status_addr)>>0x1))
+                while ( !(continuous_ && cancel_) &&
+                        !wait_for_dsm(dsm_status_addr, ~0x1u, iteration<<1, dsm_wait_ms) )
                 {
-                    if (continuous_ && cancel_)
-                    {
-                        break;
-                    }
-                    std::this_thread::sleep_for(usec(10));
                 }
                 if (!cancel_)
                 {
@@ -442,9 +433,9 @@ bool nlb_client::wait_for_done(uint32_t allocations)
     volatile bt32bitCSR *dsm_status_addr = (volatile bt32bitCSR*)(dsm_->address() + offset);
 
     // wait until NLB writes the allocation index (0 based)
-    while ( allocations > ((*dsm_status_addr)>>0x1)+1)
+    while ( allocations > 0 && !cancel_ &&
+            !wait_for_dsm(dsm_status_addr, ~0x1u, (allocations-1)<<1, dsm_wait_ms) )
     {
-        std::this_thread::sleep_for(usec(10));
     }
     while ( true )
     {
@@ -533,10 +524,174 @@ void nlb_client::do_commands(cmdq_t &fifo)
 }
 
 
+namespace
+{
+    // One set of buffers of the pipeline. The job using it is prepared as
+    // soon as the job before it in the same slot has been verified.
+    struct pipeline_slot
+    {
+        mmio_buffer::ptr_t inp;
+        mmio_buffer::ptr_t out;
+        steady_clock::time_point issued;
+    };
+
+    // idle polls before the polling loop starts yielding the cpu
+    const uint32_t pipeline_spins = 1024;
+}
+
+nlb_client::pipeline_stat nlb_client::command_pipeline(uint32_t cache_lines, uint32_t depth, uint32_t jobs)
+{
+    depth = std::max(depth, 1u);
+    uint32_t buffer_size = CL(1)*cache_lines;
+    bool loopback = (cfg_ & 0xE) == 0;
+
+    // allocate every slot up front so no job waits on an allocation
+    std::vector<pipeline_slot> slots(depth);
+    for (pipeline_slot &slot : slots)
+    {
+        slot.inp = allocate_buffer(buffer_size);
+        slot.out = allocate_buffer(buffer_size);
+    }
+
+    auto prepare = [&](uint32_t job)
+    {
+        if (loopback)
+        {
+            // a pattern of its own per job, so a stale output never verifies
+            uint8_t pattern = static_cast<uint8_t>(job*0x1D + 1);
+            pipeline_slot &slot = slots[job % depth];
+            ::memset(slot.inp->address(), pattern, buffer_size);
+            ::memset(slot.out->address(), pattern ^ 0xFF, buffer_size);
+        }
+    };
+
+    reset();
+    dsm_ = allocate_buffer(dsm_size);
+    ::memset(dsm_->address(), 0, dsm_size);
+    // set dsm base, high then low
+    mmio_write64(static_cast<uint32_t>(nlb_client::dsm::basel), dsm_->physical());
+    // assert afu reset
+    mmio_write32(static_cast<uint32_t>(nlb_client::csr::ctl), 0);
+    // de-assert afu reset
+    mmio_write32(static_cast<uint32_t>(nlb_client::csr::ctl), 1);
+    // set the test mode
+    mmio_write32(static_cast<uint32_t>(nlb_client::csr::cfg), cfg_);
+
+    // NLB alternates the status of consecutive commands between two DSM
+    // slots, writing (index << 1) | 1 when a command completes. With more
+    // than two in flight a slot may already hold a later index.
+    volatile bt32bitCSR *status[2] =
+    {
+        (volatile bt32bitCSR*)(dsm_->address() + static_cast<uint32_t>(nlb_client::dsm::test_complete)),
+        (volatile bt32bitCSR*)(dsm_->address() + 2*static_cast<uint32_t>(nlb_client::dsm::test_complete))
+    };
+
+    for (uint32_t job = 0; job < std::min(depth, jobs); ++job)
+    {
+        prepare(job);
+    }
+
+    pipeline_stat stat = { depth, 0, 0, 0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    uint32_t issued = 0, completed = 0, idle = 0;
+    // the last command written has not been taken yet (SWVALID is still 1)
+    bool accepting = false;
+    double total_latency = 0.0;
+    auto start = steady_clock::now();
+    auto last_progress = start;
+
+    while (completed < jobs)
+    {
+        bool progress = false;
+        if (accepting && (mmio_read32(static_cast<uint32_t>(nlb_client::csr::cmdq_sw)) & 1) == 0)
+        {
+            accepting = false;
+            progress = true;
+        }
+
+        if (!accepting && issued < jobs && issued - completed < depth)
+        {
+            pipeline_slot &slot = slots[issued % depth];
+            slot.issued = steady_clock::now();
+            copy_command(std::make_tuple(CACHELINE_ALIGNED_ADDR(slot.inp->physical()),
+                                         CACHELINE_ALIGNED_ADDR(slot.out->physical()),
+                                         cache_lines,
+                                         slot.inp->address(),
+                                         slot.out->address()));
+            accepting = true;
+            ++issued;
+            progress = true;
+        }
+
+        bt32bitCSR value = *status[completed % 2];
+        if (completed < issued && (value & 0x1) && (value >> 1) >= completed)
+        {
+            pipeline_slot &slot = slots[completed % depth];
+            auto now = steady_clock::now();
+            double latency = duration_cast<duration<double, std::micro>>(now - slot.issued).count();
+            total_latency += latency;
+            stat.max_latency = std::max(stat.max_latency, latency);
+
+            bool passed = !loopback || verify(std::make_tuple(0, 0, cache_lines,
+                                                              slot.inp->address(),
+                                                              slot.out->address()));
+            if (passed)
+            {
+                ++stat.passed;
+            }
+            else
+            {
+                ++stat.failed;
+            }
+
+            // the slot is free again, ready it for the job that reuses it
+            if (completed + depth < jobs)
+            {
+                prepare(completed + depth);
+            }
+            ++completed;
+            progress = true;
+        }
+
+        if (progress)
+        {
+            idle = 0;
+            last_progress = steady_clock::now();
+        }
+        else if (++idle >= pipeline_spins)
+        {
+            idle = 0;
+            if (steady_clock::now() - last_progress > seconds(1))
+            {
+                Log() << "Error waiting for command " << completed << " of " << jobs << std::endl;
+                stat.failed += issued - completed;
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    stat.seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    // stop the device
+    mmio_write32(static_cast<uint32_t>(nlb_client::csr::ctl), 7);
+
+    stat.jobs = completed;
+    if (completed > 0)
+    {
+        stat.avg_latency = total_latency/completed;
+    }
+    if (stat.seconds > 0.0)
+    {
+        stat.jobs_per_sec = completed/stat.seconds;
+        stat.bandwidth = (static_cast<double>(completed)*buffer_size)/(stat.seconds*1024.*1024.*1024.);
+    }
+    pipeline_stats_.push_back(stat);
+    return stat;
+}
+
 bool nlb_client::wait_for_register(uint32_t offset, uint32_t mask, uint32_t value)
 {
     auto ctl = mmio_read32(offset);
-    while (!cancel_ && ctl & mask != value)
+    while (!cancel_ && (ctl & mask) != value)
     {
         std::this_thread::sleep_for(usec(10));
         ctl = mmio_read32(offset);
@@ -601,6 +756,36 @@ void nlb_client::write_stats(std::ostream & stream)
 
 }
 
+void nlb_client::write_pipeline_stats(std::ostream & stream)
+{
+    // speedup is against the first run with a single command in flight
+    double serial = 0.0;
+    for (const pipeline_stat &stat : pipeline_stats_)
+    {
+        if (stat.depth == 1)
+        {
+            serial = stat.jobs_per_sec;
+            break;
+        }
+    }
+
+    stream << std::dec;
+    stream << "depth, jobs, passed, failed, seconds, jobs_per_sec, bandwidth, avg_latency_us, max_latency_us, speedup" << std::endl;
+    for (const pipeline_stat &stat : pipeline_stats_)
+    {
+        stream << stat.depth        << ", ";
+        stream << stat.jobs         << ", ";
+        stream << stat.passed       << ", ";
+        stream << stat.failed       << ", ";
+        stream << stat.seconds      << ", ";
+        stream << stat.jobs_per_sec << ", ";
+        stream << stat.bandwidth    << ", ";
+        stream << stat.avg_latency  << ", ";
+        stream << stat.max_latency  << ", ";
+        stream << (serial > 0.0 ? stat.jobs_per_sec/serial : 0.0) << std::endl;
+    }
+}
+
 void nlb_client::write_summary(std::ostream & stream)
 {
     stream << std::dec;
@@ -63,6 +63,19 @@ class nlb_client : public afu_client
             double   write_bw;
         };
 
+        struct pipeline_stat
+        {
+            uint32_t depth;
+            uint32_t jobs;
+            uint32_t passed;
+            uint32_t failed;
+            double   seconds;
+            double   jobs_per_sec;
+            double   bandwidth;     // GB/s of source lines moved
+            double   avg_latency;   // usec from issue to completion
+            double   max_latency;
+        };
+
         const uint32_t dsm_size = 2048;
 
         nlb_client();
@@ -90,6 +103,8 @@ class nlb_client : public afu_client
         bool verify(const cmdq_entry_t &entry);
 
         void do_commands(cmdq_t &fifo);
+        /// @brief run jobs through the command queue keeping depth of them in flight
+        pipeline_stat command_pipeline(uint32_t cache_lines, uint32_t depth, uint32_t jobs);
         uint32_t hwvalid_loop(cmdq_t &fifo1, cmdq_t &fifo2);
         uint32_t swvalid_loop(cmdq_t &fifo1, cmdq_t &fifo2);
         bool wait_for_done(uint32_t allocations);
@@ -104,6 +119,7 @@ class nlb_client : public afu_client
         void write_stats(std::ostream & stream);
         void write_summary(std::ostream & stream);
         void save_stat(uint32_t iteration, bool passed);
+        void write_pipeline_stats(std::ostream & stream);
     private:
         void add_option(uint32_t opt);
         void add_option(test_mode_t opt);
@@ -116,6 +132,7 @@ class nlb_client : public afu_client
         std::thread timeout_thread_;
         AAL::IALIPerf *perf_;
         std::vector<run_stat> stats_;
+        std::vector<pipeline_stat> pipeline_stats_;
         run_stat summary_;
         mmio_buffer::ptr_t dsm_;
         mmio_buffer::ptr_t inp_;
@@ -4,6 +4,7 @@
 #include <thread>
 #include <iostream>
 #include <unistd.h>
+#include <fcntl.h>
 #include <wait.h>
 #include <signal.h>
 #include <sys/types.h>
@@ -52,6 +53,31 @@ namespace utils
         return fv.get();
     }
 
+    bool process::poll(int &code)
+    {
+        siginfo_t info;
+        info.si_pid = 0;
+        if (waitid(P_PID, pid_, &info, WEXITED | WNOHANG) != 0)
+        {
+            // no such child (anymore)
+            code = -1;
+            return true;
+        }
+        if (info.si_pid == 0)
+        {
+            return false;
+        }
+        if (info.si_code == CLD_KILLED || info.si_code == CLD_DUMPED)
+        {
+            code = 128 + info.si_status;
+        }
+        else
+        {
+            code = info.si_status;
+        }
+        return true;
+    }
+
     void process::terminate()
     {
         kill(pid_, SIGINT);
@@ -62,7 +88,7 @@ namespace utils
         kill(pid_, signal);
     }
 
-    process process::start(const string &file, const vector<string> &args)
+    process process::start(const string &file, const vector<string> &args, const string &output)
     {
         // new args are first the program name,
         // followed by the arguments
@@ -93,6 +119,16 @@ namespace utils
         // else (in addition), invoke external application in the child process
         else
         {
+            if (!output.empty())
+            {
+                int fd = open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                if (fd >= 0)
+                {
+                    dup2(fd, STDOUT_FILENO);
+                    dup2(fd, STDERR_FILENO);
+                    close(fd);
+                }
+            }
             execvp(file.c_str(), cargs);
             // shouldn't be here
             cerr << "We shouldn't be here after exec" << endl;
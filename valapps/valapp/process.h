@@ -11,11 +11,23 @@ namespace utils
         public:
             ~process();
             typedef std::shared_ptr<process> ptr_t;
+            /// @brief start a program in a child process
+            /// @param[in] output file receiving the child's stdout and stderr
+            /// (inherits the parent's when empty)
             static process start(const std::string &file,
-                                 const std::vector<std::string> &args);
+                                 const std::vector<std::string> &args,
+                                 const std::string &output = "");
 
             
             int wait(int timeout_msec = -1);
+            /// @brief check, without blocking, whether the child has exited
+            /// @param[out] code the exit code, or 128 + signal if it was killed
+            /// @returns true once the child has exited (and been reaped)
+            bool poll(int &code);
+            int pid() const
+            {
+                return pid_;
+            }
             void terminate(int signal);
             void terminate();
         private:
@@ -16,6 +16,7 @@ service_client::service_client()
     register_interface<IALIPerf>(iidALI_PERF_Service);
     register_interface<IALIReset>(iidALI_RSET_Service);
     register_interface<IALISignalTap>(iidALI_STAP_Service);
+    register_interface<IALICompletion>(iidALI_CMPL_Service);
 }
 
 void service_client::register_interface(const std::string &ifname, btIID ifid)
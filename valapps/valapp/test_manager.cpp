@@ -1,10 +1,89 @@
 #include "test_manager.h"
 #include "afu_test.h"
+#include "process.h"
 #include <dlfcn.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <list>
+#include <sstream>
+#include <thread>
 #include "json/json.h"
 #include "utils.h"
 
 using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+    // One test of a spec on its way through test_manager::run_tests.
+    struct test_job
+    {
+        size_t index;
+        std::string suite;
+        std::string test;
+        std::string libname;
+        std::vector<std::string> args;
+        std::set<std::string> resources;
+        bool exclusive;
+        double timeout;
+        std::string output;
+        std::shared_ptr<utils::process> child;
+        steady_clock::time_point started;
+        steady_clock::time_point terminated_at;
+        bool terminated;
+    };
+
+    // seconds a test that timed out has to exit after SIGTERM
+    const double kill_grace = 5.0;
+
+    const char* status_name(afu_test::test_status status)
+    {
+        switch(status)
+        {
+            case afu_test::status_pass:     return "pass";
+            case afu_test::status_fail:     return "fail";
+            case afu_test::status_error:    return "error";
+            case afu_test::status_notfound: return "notfound";
+            case afu_test::status_skipped:  return "skipped";
+            default:                        return "notrun";
+        }
+    }
+
+    std::string xml_escape(const std::string &str)
+    {
+        std::string out;
+        out.reserve(str.size());
+        for (char c : str)
+        {
+            switch(c)
+            {
+                case '&':  out += "&amp;";  break;
+                case '<':  out += "&lt;";   break;
+                case '>':  out += "&gt;";   break;
+                case '"':  out += "&quot;"; break;
+                default:
+                    // control characters other than tab and newline are not allowed in XML
+                    if (static_cast<unsigned char>(c) >= 0x20 || c == '\t' || c == '\n')
+                    {
+                        out += c;
+                    }
+                    break;
+            }
+        }
+        return out;
+    }
+
+    std::string read_file(const std::string &path)
+    {
+        std::ifstream stream(path);
+        std::stringstream ss;
+        ss << stream.rdbuf();
+        return ss.str();
+    }
+}
 
 test_manager::ptr_t test_manager::instance_ = test_manager::ptr_t(0);
 
@@ -197,3 +276,337 @@ void test_manager::_run_suite(Json::Value *value_ptr)
     }
     
 }
+
+std::map<std::string, std::set<std::string>> test_manager::_load_resources(const std::string &services)
+{
+    // every service is on the one FPGA unless the services file
+    // splits it up with a "resources" list
+    std::map<std::string, std::set<std::string>> resources;
+    Json::Value root;
+    Json::Reader reader;
+    std::ifstream stream(services);
+    if (!reader.parse(stream, root))
+    {
+        Log() << "Could not parse services file (" << services << "): " << reader.getFormattedErrorMessages() << std::endl;
+        return resources;
+    }
+    for (auto service : root["services"])
+    {
+        auto alias = service["alias"].asString();
+        if (service.isMember("resources"))
+        {
+            for (auto resource : service["resources"])
+            {
+                resources[alias].insert(resource.asString());
+            }
+        }
+        else
+        {
+            resources[alias].insert("fpga");
+        }
+    }
+    return resources;
+}
+
+test_manager::run_results_t test_manager::run_tests(const std::string &test_spec, const run_options &options)
+{
+    run_results_t results;
+    Json::Value root;
+    Json::Reader reader;
+    std::ifstream stream(test_spec);
+    if (!reader.parse(stream, root))
+    {
+        Log() << "Could not parse test spec file (" << test_spec << "): " << reader.getFormattedErrorMessages() << std::endl;
+        return results;
+    }
+
+    Json::Value suites(Json::arrayValue);
+    if (root.isMember("suites"))
+    {
+        suites = root["suites"];
+    }
+    else if (root.isMember("class"))
+    {
+        suites.append(root);
+    }
+
+    auto service_resources = _load_resources(options.services);
+    std::map<size_t, run_result> finished;
+    std::list<test_job> pending, running;
+    size_t index = 0;
+    for (auto suite : suites)
+    {
+        for (auto test : suite["tests"])
+        {
+            test_job job;
+            job.index = index++;
+            job.suite = suite["class"].asString();
+            job.libname = suite["libname"].asString();
+            job.test = test["test"].asString();
+            job.terminated = false;
+            if (test.get("disabled", false).asBool())
+            {
+                finished[job.index] = run_result{ job.suite, job.test, afu_test::status_skipped, 0, 0.0, "", "disabled" };
+                continue;
+            }
+
+            Json::Value noargs(Json::arrayValue);
+            auto args = test.get("args", noargs);
+            if (args.isArray())
+            {
+                for (auto arg : args)
+                {
+                    job.args.push_back(arg.asString());
+                }
+            }
+            else if (args.isString())
+            {
+                job.args = utils::split<std::string>(args.asString(), " ");
+            }
+
+            // a test that does not say what it uses may use anything
+            job.exclusive = !test.isMember("services");
+            for (auto service : test.get("services", noargs))
+            {
+                auto it = service_resources.find(service.asString());
+                if (it == service_resources.end())
+                {
+                    Log() << "WARNING: " << job.test << " uses unknown service " << service.asString() << ", running it on its own" << std::endl;
+                    job.exclusive = true;
+                }
+                else
+                {
+                    job.resources.insert(it->second.begin(), it->second.end());
+                }
+            }
+            job.timeout = test.get("timeout", options.timeout).asDouble();
+            pending.push_back(job);
+        }
+    }
+
+    mkdir(options.output_dir.c_str(), 0755);
+
+    std::set<std::string> busy;
+    bool exclusive_running = false;
+    uint32_t jobs = std::max(options.jobs, 1u);
+    while (!pending.empty() || !running.empty())
+    {
+        // start what fits, in spec order. A test that has to wait holds its
+        // resources against the tests after it, so it is not starved.
+        std::set<std::string> held(busy);
+        bool waiting = false;
+        for (auto it = pending.begin(); !exclusive_running && it != pending.end() && running.size() < jobs; )
+        {
+            if (it->exclusive)
+            {
+                if (!running.empty() || waiting)
+                {
+                    break;
+                }
+            }
+            else if (std::any_of(it->resources.begin(), it->resources.end(),
+                                 [&held](const std::string &r) { return held.count(r) > 0; }))
+            {
+                held.insert(it->resources.begin(), it->resources.end());
+                waiting = true;
+                ++it;
+                continue;
+            }
+
+            std::vector<std::string> child_args = { "--services=" + options.services, "--",
+                                                    it->libname, it->suite, it->test };
+            child_args.insert(child_args.end(), it->args.begin(), it->args.end());
+            it->output = options.output_dir + "/" + it->suite + "." + it->test + ".log";
+            it->child = std::make_shared<utils::process>(utils::process::start(options.program, child_args, it->output));
+            it->started = steady_clock::now();
+            busy.insert(it->resources.begin(), it->resources.end());
+            held.insert(it->resources.begin(), it->resources.end());
+            exclusive_running = it->exclusive;
+            Log() << "Test: " << it->suite << "." << it->test << " started" << std::endl;
+            running.splice(running.end(), pending, it++);
+        }
+
+        auto now = steady_clock::now();
+        for (auto it = running.begin(); it != running.end(); )
+        {
+            double elapsed = duration_cast<duration<double>>(now - it->started).count();
+            int code = 0;
+            if (it->child->poll(code))
+            {
+                run_result result{ it->suite, it->test, afu_test::status_error, code, elapsed, it->output, "None" };
+                if (it->terminated)
+                {
+                    std::ostringstream comment;
+                    comment << "timed out after " << it->timeout << " seconds";
+                    result.comment = comment.str();
+                }
+                else if (code == afu_test::status_pass)
+                {
+                    result.status = afu_test::status_pass;
+                }
+                else if (code == afu_test::status_fail)
+                {
+                    result.status = afu_test::status_fail;
+                    result.comment = "test failed";
+                }
+                else if (code == afu_test::status_notfound)
+                {
+                    result.status = afu_test::status_notfound;
+                    result.comment = "test not found";
+                }
+                else if (code > 128)
+                {
+                    result.comment = "killed by signal " + std::to_string(code - 128);
+                }
+                else
+                {
+                    result.comment = "exit code " + std::to_string(code);
+                }
+                Log() << "Test: " << it->suite << "." << it->test << " " << status_name(result.status)
+                      << " (" << elapsed << " s)" << std::endl;
+                finished[it->index] = result;
+
+                for (const auto &resource : it->resources)
+                {
+                    busy.erase(resource);
+                }
+                if (it->exclusive)
+                {
+                    exclusive_running = false;
+                }
+                it = running.erase(it);
+                continue;
+            }
+
+            if (!it->terminated && it->timeout > 0.0 && elapsed > it->timeout)
+            {
+                Log() << "Test: " << it->suite << "." << it->test << " timed out" << std::endl;
+                it->child->terminate(SIGTERM);
+                it->terminated = true;
+                it->terminated_at = now;
+            }
+            else if (it->terminated &&
+                     duration_cast<duration<double>>(now - it->terminated_at).count() > kill_grace)
+            {
+                it->child->terminate(SIGKILL);
+            }
+            ++it;
+        }
+
+        if (!running.empty())
+        {
+            std::this_thread::sleep_for(milliseconds(10));
+        }
+    }
+
+    for (auto &result : finished)
+    {
+        results.push_back(result.second);
+    }
+    return results;
+}
+
+void test_manager::write_junit(std::ostream &stream, const run_results_t &results)
+{
+    // group by suite, keeping the order of the spec
+    std::vector<std::string> suites;
+    for (const auto &result : results)
+    {
+        if (std::find(suites.begin(), suites.end(), result.suite) == suites.end())
+        {
+            suites.push_back(result.suite);
+        }
+    }
+
+    auto count = [&results](const std::string *suite, afu_test::test_status status)
+    {
+        return std::count_if(results.begin(), results.end(),
+                             [&](const run_result &r)
+                             {
+                                 return (!suite || r.suite == *suite) && r.status == status;
+                             });
+    };
+    auto errors = [&](const std::string *suite)
+    {
+        return count(suite, afu_test::status_error) + count(suite, afu_test::status_notfound);
+    };
+    auto seconds = [&results](const std::string *suite)
+    {
+        double total = 0.0;
+        for (const auto &r : results)
+        {
+            if (!suite || r.suite == *suite)
+            {
+                total += r.seconds;
+            }
+        }
+        return total;
+    };
+
+    stream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << std::endl;
+    stream << "<testsuites name=\"valapp\" tests=\"" << results.size()
+           << "\" failures=\"" << count(nullptr, afu_test::status_fail)
+           << "\" errors=\"" << errors(nullptr)
+           << "\" skipped=\"" << count(nullptr, afu_test::status_skipped)
+           << "\" time=\"" << seconds(nullptr) << "\">" << std::endl;
+    for (const auto &suite : suites)
+    {
+        auto tests = std::count_if(results.begin(), results.end(),
+                                   [&suite](const run_result &r) { return r.suite == suite; });
+        stream << "  <testsuite name=\"" << xml_escape(suite) << "\" tests=\"" << tests
+               << "\" failures=\"" << count(&suite, afu_test::status_fail)
+               << "\" errors=\"" << errors(&suite)
+               << "\" skipped=\"" << count(&suite, afu_test::status_skipped)
+               << "\" time=\"" << seconds(&suite) << "\">" << std::endl;
+        for (const auto &r : results)
+        {
+            if (r.suite != suite)
+            {
+                continue;
+            }
+            stream << "    <testcase classname=\"" << xml_escape(r.suite) << "\" name=\"" << xml_escape(r.test)
+                   << "\" time=\"" << r.seconds << "\">" << std::endl;
+            switch(r.status)
+            {
+                case afu_test::status_pass:
+                    break;
+                case afu_test::status_fail:
+                    stream << "      <failure message=\"" << xml_escape(r.comment) << "\"/>" << std::endl;
+                    break;
+                case afu_test::status_skipped:
+                    stream << "      <skipped message=\"" << xml_escape(r.comment) << "\"/>" << std::endl;
+                    break;
+                default:
+                    stream << "      <error message=\"" << xml_escape(r.comment) << "\"/>" << std::endl;
+                    break;
+            }
+            if (!r.output.empty())
+            {
+                stream << "      <system-out>" << xml_escape(read_file(r.output)) << "</system-out>" << std::endl;
+            }
+            stream << "    </testcase>" << std::endl;
+        }
+        stream << "  </testsuite>" << std::endl;
+    }
+    stream << "</testsuites>" << std::endl;
+}
+
+void test_manager::write_json(std::ostream &stream, const run_results_t &results)
+{
+    Json::Value root;
+    root["tests"] = Json::Value(Json::arrayValue);
+    for (const auto &r : results)
+    {
+        Json::Value test;
+        test["suite"] = r.suite;
+        test["test"] = r.test;
+        test["status"] = status_name(r.status);
+        test["exit_code"] = r.exit_code;
+        test["seconds"] = r.seconds;
+        test["output"] = r.output;
+        test["comment"] = r.comment;
+        root["tests"].append(test);
+    }
+    Json::StyledStreamWriter writer;
+    writer.write(stream, root);
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <memory>
 #include <map>
+#include <set>
 #include <functional>
 
 #include "Loggable.h"
@@ -20,6 +21,30 @@ class test_manager : public Loggable
 {
     public:
         typedef std::shared_ptr<test_manager> ptr_t;
+
+        /// @brief options for running a test spec with each test in a child process
+        struct run_options
+        {
+            std::string program;     ///< executable that runs a single test (valapp)
+            std::string services;    ///< services file, for the resource graph and the children
+            uint32_t    jobs;        ///< most tests running at once
+            double      timeout;     ///< seconds, for tests that do not set their own
+            std::string output_dir;  ///< each test's output is captured here
+        };
+
+        /// @brief the outcome of one test run in a child process
+        struct run_result
+        {
+            std::string           suite;
+            std::string           test;
+            afu_test::test_status status;
+            int                   exit_code;
+            double                seconds;
+            std::string           output;   ///< file holding the captured output
+            std::string           comment;
+        };
+        typedef std::vector<run_result> run_results_t;
+
         using test_factory = std::function<afu_test*(test_context::ptr_t)>;
         //typedef afu_test* (* test_factory)(test_context::ptr_t);
 
@@ -62,12 +87,23 @@ class test_manager : public Loggable
         void run_tests(const std::string &test_spec);
         afu_test::results_t run_test(const std::string &suite_name, const std::string & test_name,int argc, char* argv[]); 
 
+        /// @brief run the tests of a spec concurrently, each in its own process
+        /// @details
+        /// A test may run alongside any other that uses none of the same resources.
+        /// The resources of a test are those of the services it lists, as given by
+        /// the services file. A test that lists no services is run on its own.
+        run_results_t run_tests(const std::string &test_spec, const run_options &options);
+
+        void write_junit(std::ostream &stream, const run_results_t &results);
+        void write_json(std::ostream &stream, const run_results_t &results);
+
 
     private:
         test_manager();
         arguments args_;
         std::vector<std::string> raw_args_;
         void _run_suite(Json::Value *value);
+        std::map<std::string, std::set<std::string>> _load_resources(const std::string &services);
         static ptr_t instance_;
         std::map<std::string, test_factory> test_factory_map_;
         std::map<std::string, void*> lib_map_;